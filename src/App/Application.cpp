@@ -564,6 +564,7 @@ Document* Application::openDocument(const char * FileName)
     FC_TIME_INIT(t);
 
     bool isMainDoc = true;
+    bool reopen = false;
     while(true) {
         const char *name = _pendingDocs.front();
         _pendingDocs.pop_front();
@@ -577,7 +578,7 @@ Document* Application::openDocument(const char * FileName)
             }
             FC_TIME_INIT(t1);
             DocTiming timing;
-            auto doc = openDocumentPrivate(name,isMainDoc,allowPartial,objNames);
+            auto doc = openDocumentPrivate(name,isMainDoc,allowPartial,objNames,reopen);
             FC_DURATION_PLUS(timing.d1,t1);
             if(doc)
                 newDocs.emplace_front(doc,timing);
@@ -596,7 +597,7 @@ Document* Application::openDocument(const char * FileName)
         if(_pendingDocs.empty()) {
             if(_pendingDocsReopen.empty())
                 break;
-            allowPartial = false;
+            reopen = true;
             _pendingDocs.swap(_pendingDocsReopen);
         }
     }
@@ -623,7 +624,7 @@ Document* Application::openDocument(const char * FileName)
 }
 
 Document* Application::openDocumentPrivate(const char * FileName, 
-        bool isMainDoc, bool allowPartial, const std::set<std::string> &objNames)
+        bool isMainDoc, bool allowPartial, const std::set<std::string> &objNames, bool reopen)
 {
     FileInfo File(FileName);
 
@@ -633,6 +634,9 @@ Document* Application::openDocumentPrivate(const char * FileName,
         throw Base::FileSystemError(str.str().c_str());
     }
 
+    // the objects to load, empty to load the whole document
+    std::set<std::string> names(objNames);
+
     // Before creating a new document we check whether the document is already open
     std::string filepath = File.filePath();
     for (std::map<std::string,Document*>::iterator it = DocMap.begin(); it != DocMap.end(); ++it) {
@@ -651,21 +655,37 @@ Document* Application::openDocumentPrivate(const char * FileName,
                 break;
             }
 
-            if(allowPartial) {
-                bool reopen = false;
+            if(allowPartial && objNames.size()) {
+                bool missing = false;
                 for(auto &name : objNames) {
                     auto obj = it->second->getObject(name.c_str());
                     if(!obj || obj->testStatus(App::PartialObject)) {
-                        reopen = true;
+                        missing = true;
                         break;
                     }
                 }
-                if(!reopen)
+                if(!missing)
                     return 0;
+
+                // Load the missing objects in addition to the ones other
+                // documents already use instead of the whole document
+                for(auto obj : it->second->getObjects()) {
+                    if(!obj->testStatus(App::PartialObject))
+                        names.insert(obj->getNameInDocument());
+                }
             }
-            auto &names = _pendingDocMap[FileName];
-            names.clear();
-            _pendingDocsReopen.push_back(FileName);
+            else
+                names.clear();
+
+            if(reopen) {
+                closeDocument(it->first.c_str());
+                break;
+            }
+
+            // reopen after the other pending documents are loaded
+            auto &entry = *_pendingDocMap.emplace(FileName,std::set<std::string>()).first;
+            entry.second = names;
+            _pendingDocsReopen.push_back(entry.first.c_str());
             return 0;
         }
 
@@ -685,7 +705,7 @@ Document* Application::openDocumentPrivate(const char * FileName,
 
     try {
         // read the document
-        newDoc->restore(true,objNames);
+        newDoc->restore(true,names);
         return newDoc;
     }
     // if the project file itself is corrupt then
@@ -336,7 +336,8 @@ protected:
 
     /// open single document only
     App::Document* openDocumentPrivate(const char * FileName, 
-            bool isMainDoc, bool allowPartial, const std::set<std::string> &objNames);
+            bool isMainDoc, bool allowPartial, const std::set<std::string> &objNames,
+            bool reopen=false);
 
 private:
     /// Constructor
@@ -25,12 +25,14 @@
 
 #ifndef _PreComp_
 # include <cstdlib>
+# include <cstring>
+# include <algorithm>
 #endif
 
+#include <atomic>
+#include <mutex>
+
 #include <boost/algorithm/string/predicate.hpp>
-#include <boost/bimap.hpp>
-#include <boost/bimap/multiset_of.hpp>
-#include <boost/bimap/unordered_set_of.hpp>
 #include <Base/Writer.h>
 #include <Base/Reader.h>
 #include <Base/Exception.h>
@@ -42,11 +44,436 @@ FC_LOG_LEVEL_INIT("ComplexGeoData", true,true);
 using namespace Data;
 
 namespace Data {
-typedef boost::bimap<
-            boost::bimaps::set_of<std::string>,
-            boost::bimaps::multiset_of<std::string>,
-            boost::bimaps::with_info<std::vector<App::StringIDRef> > > ElementMapBase;
-class ElementMap: public ElementMapBase {};
+
+/** Compact bidirectional element map
+ *
+ * Maps a mapped element name to its original \c Type + \c Index element name.
+ * A mapped name can only be mapped to one element, while an element can have
+ * multiple mapped names, which are chained in insertion order.
+ *
+ * All strings are interned in a single character pool, and the entries are
+ * stored contiguously. Both lookup directions use open addressing hash tables
+ * of 32 bit indices, so that adding a mapping costs no more than a few
+ * amortized allocations, regardless of the map size.
+ *
+ * Erased entries are reclaimed, together with their strings and string IDs,
+ * once they make up half of the entries. String pointers and entry indices
+ * returned by this class are therefore invalidated by any following insert()
+ * or erase().
+ *
+ * The map may be shared by several TopoShape copies read concurrently, so
+ * the const members must not modify anything but the lazily sorted entry
+ * list, which is built under a lock.
+ */
+class ElementMap {
+public:
+    enum {
+        NoIndex = 0xffffffff,
+        Tombstone = 0xfffffffe,
+    };
+
+    ElementMap()
+        :_count(0), _tombstones(0), _sorted(false)
+    {}
+
+    ElementMap(const ElementMap &) = delete;
+    ElementMap &operator=(const ElementMap &) = delete;
+
+    size_t size() const {
+        return _count;
+    }
+
+    bool empty() const {
+        return _count == 0;
+    }
+
+    const char *name(uint32_t idx) const {
+        return &_pool[_entries[idx].name];
+    }
+
+    const char *element(uint32_t idx) const {
+        return &_pool[_elements[_entries[idx].element].name];
+    }
+
+    void getSids(uint32_t idx, std::vector<App::StringIDRef> &sids) const {
+        const auto &entry = _entries[idx];
+        sids.insert(sids.end(), _sids.begin()+entry.sidOffset,
+                _sids.begin()+entry.sidOffset+entry.sidCount);
+    }
+
+    std::vector<App::StringIDRef> sids(uint32_t idx) const {
+        std::vector<App::StringIDRef> ret;
+        getSids(idx, ret);
+        return ret;
+    }
+
+    /// Find the entry of a mapped name
+    uint32_t findName(const char *name) const {
+        return findName(name, hashString(name));
+    }
+
+    /// Find the first entry mapped to the given element
+    uint32_t findElement(const char *element) const {
+        uint32_t idx = findElementInfo(element, hashString(element));
+        return idx==NoIndex ? idx : _elements[idx].head;
+    }
+
+    /// Return the next entry mapped to the same element
+    uint32_t next(uint32_t idx) const {
+        return _entries[idx].next;
+    }
+
+    /** Add a new mapping
+     * @return Returns the entry of the name and whether it is newly inserted.
+     */
+    std::pair<uint32_t,bool> insert(const char *name, const char *element,
+            const std::vector<App::StringIDRef> &sids)
+    {
+        // the pool may be reallocated below
+        std::string _name, _element;
+        if(owns(name)) {
+            _name = name;
+            name = _name.c_str();
+        }
+        if(owns(element)) {
+            _element = element;
+            element = _element.c_str();
+        }
+
+        uint32_t hash = hashString(name);
+        uint32_t idx = findName(name, hash);
+        if(idx != NoIndex)
+            return std::make_pair(idx, false);
+
+        uint32_t elementIdx = internElement(element);
+        reserveNames();
+        idx = (uint32_t)_entries.size();
+        Entry entry;
+        entry.name = addString(name);
+        entry.hash = hash;
+        entry.element = elementIdx;
+        entry.next = NoIndex;
+        entry.sidOffset = (uint32_t)_sids.size();
+        entry.sidCount = (uint32_t)sids.size();
+        _sids.insert(_sids.end(), sids.begin(), sids.end());
+        _entries.push_back(entry);
+
+        auto &info = _elements[elementIdx];
+        if(info.head == NoIndex)
+            info.head = idx;
+        else
+            _entries[info.tail].next = idx;
+        info.tail = idx;
+
+        insertSlot(_nameTable, hash, idx);
+        ++_count;
+        _sorted = false;
+        return std::make_pair(idx, true);
+    }
+
+    void erase(uint32_t idx) {
+        eraseEntry(idx);
+        compact();
+    }
+
+    void eraseElement(const char *element) {
+        uint32_t idx = findElement(element);
+        while(idx != NoIndex) {
+            uint32_t next = _entries[idx].next;
+            eraseEntry(idx);
+            idx = next;
+        }
+        compact();
+    }
+
+    /// Call \a func with the index of each entry in insertion order
+    template<class Func>
+    void forEach(Func func) const {
+        for(uint32_t i=0; i<(uint32_t)_entries.size(); ++i) {
+            if(_entries[i].element != NoIndex)
+                func(i);
+        }
+    }
+
+    /// Return the entries sorted by their names
+    const std::vector<uint32_t> &sortedEntries() const {
+        if(!_sorted.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(_sortMutex);
+            if(!_sorted.load(std::memory_order_relaxed)) {
+                std::vector<uint32_t> entries;
+                entries.reserve(_count);
+                forEach([&entries](uint32_t idx) {entries.push_back(idx);});
+                std::sort(entries.begin(), entries.end(),
+                    [this](uint32_t a, uint32_t b) {
+                        return std::strcmp(name(a), name(b)) < 0;
+                    });
+                _sortedEntries.swap(entries);
+                _sorted.store(true, std::memory_order_release);
+            }
+        }
+        return _sortedEntries;
+    }
+
+    /// Check if the given string is stored inside this map
+    bool owns(const char *s) const {
+        return !_pool.empty() && s>=&_pool.front() && s<=&_pool.back();
+    }
+
+    unsigned int getMemSize() const {
+        std::lock_guard<std::mutex> lock(_sortMutex);
+        return (unsigned int)(_pool.capacity()
+                + _entries.capacity()*sizeof(Entry)
+                + _elements.capacity()*sizeof(ElementInfo)
+                + (_nameTable.capacity()+_elementTable.capacity()+_sortedEntries.capacity())*sizeof(uint32_t)
+                + _sids.capacity()*sizeof(App::StringIDRef));
+    }
+
+private:
+    void eraseEntry(uint32_t idx) {
+        auto &entry = _entries[idx];
+        if(entry.element == NoIndex)
+            return;
+
+        size_t mask = _nameTable.size()-1;
+        for(size_t i=entry.hash&mask;;i=(i+1)&mask) {
+            if(_nameTable[i] == idx) {
+                _nameTable[i] = Tombstone;
+                ++_tombstones;
+                break;
+            }
+        }
+
+        auto &info = _elements[entry.element];
+        uint32_t prev = NoIndex;
+        for(uint32_t cur=info.head; cur!=idx; cur=_entries[cur].next)
+            prev = cur;
+        if(prev == NoIndex)
+            info.head = entry.next;
+        else
+            _entries[prev].next = entry.next;
+        if(info.tail == idx)
+            info.tail = prev;
+
+        // release the string ID references, so that they can be pruned
+        for(uint32_t i=0; i<entry.sidCount; ++i)
+            _sids[entry.sidOffset+i] = App::StringIDRef();
+        entry.sidCount = 0;
+        entry.element = NoIndex;
+        --_count;
+        _sorted = false;
+    }
+
+    /// Reclaim the erased entries once they make up half of the map
+    void compact() {
+        if(_entries.size() < 64 || _count*2 > _entries.size())
+            return;
+
+        std::vector<char> pool;
+        std::vector<Entry> entries;
+        std::vector<ElementInfo> elements;
+        std::vector<App::StringIDRef> sids;
+        entries.reserve(_count);
+        sids.reserve(_sids.size()/2);
+
+        auto copyString = [&](uint32_t offset) {
+            const char *s = &_pool[offset];
+            uint32_t res = (uint32_t)pool.size();
+            pool.insert(pool.end(), s, s+std::strlen(s)+1);
+            return res;
+        };
+
+        // Keep the entries in insertion order, and the elements that are
+        // still mapped
+        for(auto &info : _elements) {
+            if(info.head == NoIndex)
+                continue;
+            ElementInfo newInfo;
+            newInfo.name = copyString(info.name);
+            newInfo.hash = info.hash;
+            newInfo.head = newInfo.tail = NoIndex;
+            info.head = (uint32_t)elements.size();
+            elements.push_back(newInfo);
+        }
+        for(auto &entry : _entries) {
+            if(entry.element == NoIndex)
+                continue;
+            Entry newEntry;
+            newEntry.name = copyString(entry.name);
+            newEntry.hash = entry.hash;
+            newEntry.element = _elements[entry.element].head;
+            newEntry.next = NoIndex;
+            newEntry.sidOffset = (uint32_t)sids.size();
+            newEntry.sidCount = entry.sidCount;
+            sids.insert(sids.end(), _sids.begin()+entry.sidOffset,
+                    _sids.begin()+entry.sidOffset+entry.sidCount);
+
+            uint32_t idx = (uint32_t)entries.size();
+            auto &info = elements[newEntry.element];
+            if(info.head == NoIndex)
+                info.head = idx;
+            else
+                entries[info.tail].next = idx;
+            info.tail = idx;
+            entries.push_back(newEntry);
+        }
+
+        _pool.swap(pool);
+        _entries.swap(entries);
+        _elements.swap(elements);
+        _sids.swap(sids);
+        _nameTable.clear();
+        _elementTable.clear();
+        _tombstones = 0;
+        reserveNames();
+        reserveElements();
+        _sorted = false;
+    }
+
+private:
+    struct Entry {
+        uint32_t name;      ///< offset of the mapped name in the pool
+        uint32_t hash;      ///< hash of the mapped name
+        uint32_t element;   ///< index of the element info, NoIndex if erased
+        uint32_t next;      ///< next entry of the same element
+        uint32_t sidOffset; ///< offset of the string IDs
+        uint32_t sidCount;  ///< number of string IDs
+    };
+
+    struct ElementInfo {
+        uint32_t name;      ///< offset of the element name in the pool
+        uint32_t hash;      ///< hash of the element name
+        uint32_t head;      ///< first entry mapped to this element
+        uint32_t tail;      ///< last entry mapped to this element
+    };
+
+    // FNV-1a
+    static uint32_t hashString(const char *s) {
+        uint32_t hash = 2166136261u;
+        for(;*s;++s) {
+            hash ^= (unsigned char)*s;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    uint32_t addString(const char *s) {
+        std::string tmp;
+        if(owns(s)) {
+            tmp = s;
+            s = tmp.c_str();
+        }
+        uint32_t offset = (uint32_t)_pool.size();
+        _pool.insert(_pool.end(), s, s+std::strlen(s)+1);
+        return offset;
+    }
+
+    uint32_t findName(const char *name, uint32_t hash) const {
+        if(_nameTable.empty())
+            return NoIndex;
+        size_t mask = _nameTable.size()-1;
+        for(size_t i=hash&mask;;i=(i+1)&mask) {
+            uint32_t idx = _nameTable[i];
+            if(idx == NoIndex)
+                return NoIndex;
+            if(idx == Tombstone)
+                continue;
+            const auto &entry = _entries[idx];
+            if(entry.hash == hash && std::strcmp(&_pool[entry.name], name) == 0)
+                return idx;
+        }
+    }
+
+    uint32_t findElementInfo(const char *element, uint32_t hash) const {
+        if(_elementTable.empty())
+            return NoIndex;
+        size_t mask = _elementTable.size()-1;
+        for(size_t i=hash&mask;;i=(i+1)&mask) {
+            uint32_t idx = _elementTable[i];
+            if(idx == NoIndex)
+                return NoIndex;
+            const auto &info = _elements[idx];
+            if(info.hash == hash && std::strcmp(&_pool[info.name], element) == 0)
+                return idx;
+        }
+    }
+
+    uint32_t internElement(const char *element) {
+        uint32_t hash = hashString(element);
+        uint32_t idx = findElementInfo(element, hash);
+        if(idx != NoIndex)
+            return idx;
+        reserveElements();
+        idx = (uint32_t)_elements.size();
+        ElementInfo info;
+        info.name = addString(element);
+        info.hash = hash;
+        info.head = info.tail = NoIndex;
+        _elements.push_back(info);
+        insertSlot(_elementTable, hash, idx);
+        return idx;
+    }
+
+    void insertSlot(std::vector<uint32_t> &table, uint32_t hash, uint32_t idx) {
+        size_t mask = table.size()-1;
+        for(size_t i=hash&mask;;i=(i+1)&mask) {
+            if(table[i] == NoIndex) {
+                table[i] = idx;
+                return;
+            }
+            if(table[i] == Tombstone) {
+                table[i] = idx;
+                --_tombstones;
+                return;
+            }
+        }
+    }
+
+    // Keep the table load factor (including tombstones) below 3/4. Return
+    // true if the table has to be rebuilt, with its new size in 'size'.
+    static bool needRehash(const std::vector<uint32_t> &table, size_t used, size_t live, size_t &size) {
+        if(used*4 < table.size()*3)
+            return false;
+        size = 64;
+        while(live*2 >= size)
+            size *= 2;
+        return true;
+    }
+
+    void reserveNames() {
+        size_t size;
+        if(!needRehash(_nameTable, _count+_tombstones+1, _count+1, size))
+            return;
+        _nameTable.assign(size, NoIndex);
+        _tombstones = 0;
+        for(uint32_t i=0; i<(uint32_t)_entries.size(); ++i) {
+            if(_entries[i].element != NoIndex)
+                insertSlot(_nameTable, _entries[i].hash, i);
+        }
+    }
+
+    void reserveElements() {
+        size_t size;
+        if(!needRehash(_elementTable, _elements.size()+1, _elements.size()+1, size))
+            return;
+        _elementTable.assign(size, NoIndex);
+        for(uint32_t i=0; i<(uint32_t)_elements.size(); ++i)
+            insertSlot(_elementTable, _elements[i].hash, i);
+    }
+
+private:
+    std::vector<char> _pool;
+    std::vector<Entry> _entries;
+    std::vector<ElementInfo> _elements;
+    std::vector<App::StringIDRef> _sids;
+    std::vector<uint32_t> _nameTable;
+    std::vector<uint32_t> _elementTable;
+    mutable std::vector<uint32_t> _sortedEntries;
+    mutable std::mutex _sortMutex;
+    size_t _count;
+    size_t _tombstones;
+    mutable std::atomic<bool> _sorted;
+};
+
 }
 
 TYPESYSTEM_SOURCE_ABSTRACT(Data::Segment , Base::BaseClass);
@@ -267,11 +694,11 @@ const char *ComplexGeoData::getElementName(const char *name, int direction,
     }
 
     if(direction==1) {
-        auto it = _ElementMap->right.find(name);
-        if(it == _ElementMap->right.end())
+        auto idx = _ElementMap->findElement(name);
+        if(idx == ElementMap::NoIndex)
             return name;
-        if(sid) sid->insert(sid->end(),it->info.begin(),it->info.end());
-        return it->second.c_str();
+        if(sid) _ElementMap->getSids(idx,*sid);
+        return _ElementMap->name(idx);
     }
     const char *txt = isMappedElement(name);
     if(!txt) {
@@ -286,25 +713,21 @@ const char *ComplexGeoData::getElementName(const char *name, int direction,
         _txt = std::string(txt,dot-txt);
         txt = _txt.c_str();
     }
-    auto it = _ElementMap->left.find(txt);
-    if(it == _ElementMap->left.end())
+    auto idx = _ElementMap->findName(txt);
+    if(idx == ElementMap::NoIndex)
         return name;
-    if(sid) sid->insert(sid->end(),it->info.begin(),it->info.end());
-    return it->second.c_str();
+    if(sid) _ElementMap->getSids(idx,*sid);
+    return _ElementMap->element(idx);
 }
 
 std::vector<std::pair<std::string, std::vector<App::StringIDRef> > >
 ComplexGeoData::getElementMappedNames(const char *element, bool needUnmapped) const {
     std::vector<std::pair<std::string, std::vector<App::StringIDRef> > > names;
     if(_ElementMap) {
-        auto ret = _ElementMap->right.equal_range(element);
-        size_t count=0;
-        for(auto it=ret.first;it!=ret.second;++it)
-            ++count;
-        if(count) {
-            names.reserve(count);
-            for(auto it=ret.first;it!=ret.second;++it)
-                names.emplace_back(it->second,it->info);
+        auto idx = _ElementMap->findElement(element);
+        if(idx != ElementMap::NoIndex) {
+            for(;idx!=ElementMap::NoIndex;idx=_ElementMap->next(idx))
+                names.emplace_back(_ElementMap->name(idx),_ElementMap->sids(idx));
             return names;
         }
     }
@@ -321,9 +744,16 @@ ComplexGeoData::getElementNamesWithPrefix(const char *prefix) const {
     const auto &p = elementMapPrefix();
     if(boost::starts_with(prefix,p))
         prefix += p.size();
-    for(auto it=_ElementMap->left.lower_bound(prefix);it!=_ElementMap->left.end();++it) {
-        if(boost::starts_with(it->first,prefix))
-            names.emplace_back(it->first,it->second);
+    const auto &entries = _ElementMap->sortedEntries();
+    auto it = std::lower_bound(entries.begin(),entries.end(),prefix,
+        [this](uint32_t idx, const char *key) {
+            return std::strcmp(_ElementMap->name(idx),key) < 0;
+        });
+    for(;it!=entries.end();++it) {
+        const char *name = _ElementMap->name(*it);
+        if(!boost::starts_with(name,prefix))
+            break;
+        names.emplace_back(name,_ElementMap->element(*it));
     }
     return names;
 }
@@ -331,8 +761,8 @@ ComplexGeoData::getElementNamesWithPrefix(const char *prefix) const {
 std::map<std::string, std::string> ComplexGeoData::getElementMap() const {
     std::map<std::string, std::string> ret;
     if(!_ElementMap) return ret;
-    for(auto &v : _ElementMap->left)
-        ret.emplace_hint(ret.cend(),v.first,v.second);
+    for(auto idx : _ElementMap->sortedEntries())
+        ret.emplace_hint(ret.cend(),_ElementMap->name(idx),_ElementMap->element(idx));
     return ret;
 }
 
@@ -353,20 +783,25 @@ void ComplexGeoData::copyElementMap(const ComplexGeoData &data, const char *post
     if(!Hasher)
         Hasher = data.Hasher;
 
-    for(const auto &v : data._ElementMap->left) {
-        auto name = v.first.c_str();
+    ElementMapPtr elementMap = data._ElementMap;
+    std::vector<App::StringIDRef> sids;
+    elementMap->forEach([&](uint32_t idx) {
+        auto name = elementMap->name(idx);
+        auto element = elementMap->element(idx);
         if(Hasher==data.Hasher || !data.Hasher) {
-            setElementName(v.second.c_str(), name, postfix, &v.info);
-            continue;
+            sids.clear();
+            elementMap->getSids(idx,sids);
+            setElementName(element, name, postfix, &sids);
+            return;
         }
         if(postfix)
-            setElementName(v.second.c_str(),name,postfix);
+            setElementName(element,name,postfix);
         else {
             // In case we have different hasher, but no additional postfix. 
             // Copy the element name as it is without hashing.
-            setElementName(v.second.c_str(),name,0,false,true);
+            setElementName(element,name,0,false,true);
         }
-    }
+    });
 }
 
 const char *ComplexGeoData::setElementName(const char *element, const char *name, 
@@ -440,7 +875,7 @@ const char *ComplexGeoData::setElementName(const char *element, const char *name
         throw Base::ValueError("Invalid input");
     if(!name || !name[0])  {
         if(_ElementMap)
-            _ElementMap->right.erase(element);
+            _ElementMap->eraseElement(element);
         return element;
     }
     std::vector<App::StringIDRef> _sid;
@@ -448,7 +883,17 @@ const char *ComplexGeoData::setElementName(const char *element, const char *name
     if(mapped)
         name = mapped;
     if(!_ElementMap) _ElementMap = std::make_shared<ElementMap>();
+    std::string _element;
+    if(_ElementMap->owns(element)) {
+        // adding or erasing mapping may invalidate the string
+        _element = element;
+        element = _element.c_str();
+    }
     std::string _name;
+    if(_ElementMap->owns(name)) {
+        _name = name;
+        name = _name.c_str();
+    }
     if((!sid||sid->empty()) && Hasher && !nohash) {
         sid = &_sid;
         _name = hashElementName(name,_sid);
@@ -463,21 +908,22 @@ const char *ComplexGeoData::setElementName(const char *element, const char *name
     std::ostringstream ss;
     std::string retry_name;
     while(1) {
-        auto ret = _ElementMap->left.insert(ElementMap::left_map::value_type(mapped,element,*sid));
-        if(ret.second || ret.first->second==element) {
+        auto ret = _ElementMap->insert(mapped,element,*sid);
+        if(ret.second || strcmp(_ElementMap->element(ret.first),element)==0) {
             FC_TRACE(element << " -> " << name);
-            return ret.first->first.c_str();
+            return _ElementMap->name(ret.first);
         }
         if(overwrite) {
             overwrite = false;
-            _ElementMap->left.erase(ret.first);
+            _ElementMap->erase(ret.first);
             continue;
         }
         if(sid!=&_sid)
             _sid.insert(_sid.end(),sid->begin(),sid->end());
-        retry_name = renameDuplicateElement(retry++,element,ret.first->second.c_str(),name,_sid);
+        std::string element2(_ElementMap->element(ret.first));
+        retry_name = renameDuplicateElement(retry++,element,element2.c_str(),name,_sid);
         if(retry_name.empty())
-            return ret.first->first.c_str();
+            return _ElementMap->name(ret.first);
         mapped = retry_name.c_str();
         sid = &_sid;
     }
@@ -656,15 +1102,18 @@ void ComplexGeoData::Save(Base::Writer &writer) const {
     if(!_ElementMap || _ElementMap->empty())
         writer.Stream() << "/>" << std::endl;
     else {
-        writer.Stream() << " count=\"" << _ElementMap->left.size() << "\">" << std::endl;
-        for(auto &v : _ElementMap->left) {
+        writer.Stream() << " count=\"" << _ElementMap->size() << "\">" << std::endl;
+        std::vector<App::StringIDRef> sids;
+        for(auto idx : _ElementMap->sortedEntries()) {
             // We are omitting indentation here to save some space in case of long list of elements
             writer.Stream() << "<Element key=\"" <<  
-                v.first <<"\" value=\"" << v.second;
-            if(v.info.size()) {
-                writer.Stream() << "\" sid=\"" << v.info.front()->value();
-                for(size_t i=1;i<v.info.size();++i)
-                    writer.Stream() << '.' << v.info[i]->value();
+                _ElementMap->name(idx) <<"\" value=\"" << _ElementMap->element(idx);
+            sids.clear();
+            _ElementMap->getSids(idx,sids);
+            if(sids.size()) {
+                writer.Stream() << "\" sid=\"" << sids.front()->value();
+                for(size_t i=1;i<sids.size();++i)
+                    writer.Stream() << '.' << sids[i]->value();
             }
             writer.Stream() << "\"/>" << std::endl;
         }
@@ -708,6 +1157,6 @@ void ComplexGeoData::Restore(Base::XMLReader &reader) {
 
 unsigned int ComplexGeoData::getMemSize(void) const {
     if(_ElementMap)
-        return _ElementMap->size()*10;
+        return _ElementMap->getMemSize();
     return 0;
 }
@@ -197,7 +197,7 @@ public:
      * elementMapPrefix() or not.
      *
      * @return Returns the found mapping, or else return the original input. The
-     * return pointer maybe invalidated when new element mapping is added.
+     * return pointer maybe invalidated when element mapping is added or removed.
      */
     const char *getElementName(const char *name, int direction=0, 
             std::vector<App::StringIDRef> *sid=0) const;
@@ -231,7 +231,8 @@ public:
      * @param overwrite: if true, it will overwrite existing names
      *
      * @return Returns the stored mapped element name. Note that if hasher is
-     * provided the stored name will be different from the input name.
+     * provided the stored name will be different from the input name. The
+     * return pointer maybe invalidated when element mapping is added or removed.
      *
      * An element can have multiple mapped names. However, a name can only be
      * mapped to one element
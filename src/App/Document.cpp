@@ -76,10 +76,13 @@ recompute path. Also enables more complicated dependencies beyond trees.
 #include <unordered_set>
 #include <unordered_map>
 #include <random>
+#include <mutex>
+#include <thread>
 
 #include <QMap>
 #include <QCoreApplication>
 #include <QCryptographicHash>
+#include <QtConcurrentMap>
 
 #include "Document.h"
 #include "Application.h"
@@ -171,6 +174,23 @@ struct DocumentP
     unsigned int UndoMemSize;
     unsigned int UndoMaxStackSize;
     mutable HasherMap hashers;
+    // Parallel recompute support. The mutex guards the recompute log, the
+    // undo transaction and the deferred change list while worker threads
+    // are running.
+    std::mutex recomputeMutex;
+    bool concurrentRecompute;
+    std::thread::id mainThreadId;
+    std::vector<std::pair<const DocumentObject*, const Property*> > deferredChanges;
+    // Dependency order of objectArray maintained incrementally across
+    // recomputes. Dependencies are always positioned before their dependents.
+    // Removed objects leave a null hole in depOrder until compaction.
+    std::vector<DocumentObject*> depOrder;
+    std::unordered_map<const DocumentObject*, size_t> depPositions;
+    std::unordered_set<const DocumentObject*> depDirty;
+    std::unordered_set<const DocumentObject*> depPending;
+    std::unordered_set<const DocumentObject*> depExternal;
+    size_t depHoles;
+    bool depCyclic;
 #ifdef USE_OLD_DAG
     DependencyList DepList;
     std::map<DocumentObject*,Vertex> VertexObjectList;
@@ -190,6 +210,9 @@ struct DocumentP
         iTransactionMode = 0;
         rollback = false;
         undoing = false;
+        concurrentRecompute = false;
+        depHoles = 0;
+        depCyclic = false;
         StatusBits.set((size_t)Document::Closable, true);
         StatusBits.set((size_t)Document::KeepTrailingDigits, true);
         StatusBits.set((size_t)Document::Restoring, false);
@@ -205,6 +228,40 @@ struct DocumentP
     topologicalSort(const std::vector<App::DocumentObject*>& objects) const;
     std::vector<App::DocumentObject*>
     partialTopologicalSort(const std::vector<App::DocumentObject*>& objects) const;
+
+    void markDependencyChanged(const DocumentObject *obj) {
+        if(depPositions.count(obj))
+            depDirty.insert(obj);
+    }
+    void addDependencyOrder(DocumentObject *obj) {
+        // New objects have no validated links yet, so they can go anywhere
+        if (depPositions.emplace(obj, depOrder.size()).second) {
+            depOrder.push_back(obj);
+            depDirty.insert(obj);
+        }
+    }
+    void removeDependencyOrder(const DocumentObject *obj) {
+        auto it = depPositions.find(obj);
+        if(it == depPositions.end())
+            return;
+        depOrder[it->second] = 0;
+        ++depHoles;
+        depPositions.erase(it);
+        depDirty.erase(obj);
+        depExternal.erase(obj);
+    }
+    void clearDependencyOrder() {
+        depOrder.clear();
+        depPositions.clear();
+        depDirty.clear();
+        depExternal.clear();
+        depHoles = 0;
+    }
+    bool rebuildDependencyOrder();
+    bool reorderDependency(DocumentObject *obj, DocumentObject *dep);
+    bool updateDependencyOrder();
+    bool getSortedDependencyList(const std::vector<App::DocumentObject*> &objs,
+            std::vector<App::DocumentObject*> &res);
 };
 
 } // namespace App
@@ -1301,6 +1358,9 @@ void Document::onChanged(const Property* prop)
 void Document::onBeforeChangeProperty(const TransactionalObject *Who, const Property *What)
 {
     if(!d->rollback) {
+        std::unique_lock<std::mutex> lock(d->recomputeMutex, std::defer_lock);
+        if(d->concurrentRecompute)
+            lock.lock();
         _checkTransaction(0,What,__LINE__);
         if (d->activeUndoTransaction)
             d->activeUndoTransaction->addObjectChange(Who,What);
@@ -1309,6 +1369,19 @@ void Document::onBeforeChangeProperty(const TransactionalObject *Who, const Prop
 
 void Document::onChangedProperty(const DocumentObject *Who, const Property *What)
 {
+    bool depChanged = What == &Who->ExpressionEngine
+        || What->isDerivedFrom(PropertyLinkBase::getClassTypeId());
+    if(d->concurrentRecompute && std::this_thread::get_id()!=d->mainThreadId) {
+        // Signal handlers (e.g. view providers) are not thread safe, so
+        // postpone the signal until the worker pool is joined.
+        std::lock_guard<std::mutex> lock(d->recomputeMutex);
+        if(depChanged)
+            d->markDependencyChanged(Who);
+        d->deferredChanges.emplace_back(Who,What);
+        return;
+    }
+    if(depChanged)
+        d->markDependencyChanged(Who);
     signalChangedObject(*Who, *What);
 }
 
@@ -1444,6 +1517,7 @@ Document::~Document()
 #endif
 
     d->objectArray.clear();
+    d->clearDependencyOrder();
     for (it = d->objectMap.begin(); it != d->objectMap.end(); ++it) {
         it->second->setStatus(ObjectStatus::Destroy, true);
         delete(it->second);
@@ -2100,9 +2174,11 @@ bool Document::save (void)
 
             writer.setComment("FreeCAD Document");
             writer.setLevel(compression);
+            writer.setParallelSave(hGrp->GetBool("ParallelSave", true));
+            writer.setDeduplicateFiles(hGrp->GetBool("DeduplicateFiles", false));
             writer.putNextEntry("Document.xml");
 
-            if (hGrp->GetBool("SaveBinaryBrep", false))
+            if (hGrp->GetBool("SaveBinaryBrep", true))
                 writer.setMode("BinaryBrep");
 
             Document::Save(writer);
@@ -2208,6 +2284,7 @@ void Document::restore (bool delaySignal, const std::set<std::string> &objNames)
         delete *obj;
     }
     d->objectArray.clear();
+    d->clearDependencyOrder();
     d->objectMap.clear();
     d->objectIdMap.clear();
     d->lastObjectId = 0;
@@ -2246,6 +2323,8 @@ void Document::restore (bool delaySignal, const std::set<std::string> &objNames)
     // Note: This file doesn't need to be available if the document has been created
     // without GUI. But if available then follow after all data files of the App document.
     signalRestoreDocument(reader);
+    reader.setParallelRestore(GetApplication().GetParameterGroupByPath(
+                "User parameter:BaseApp/Preferences/Document")->GetBool("ParallelRestore",true));
     reader.readFiles(zipstream);
 
     if(!delaySignal)
@@ -2752,9 +2831,6 @@ int Document::recompute(const std::vector<App::DocumentObject*> &objs, bool forc
 int Document::recompute(const std::vector<App::DocumentObject*> &objs, bool force) {
     int objectCount = 0;
 
-    if (testStatus(Document::PartialDoc))
-        throw Base::RuntimeError("Cannot recompute a partially loaded document");
-
     if (testStatus(Document::Recomputing)) {
         // this is clearly a bug in the calling instance
         throw Base::RuntimeError("Nested recomputes of a document are not allowed");
@@ -2797,22 +2873,45 @@ int Document::recompute(const std::vector<App::DocumentObject*> &objs, bool forc
     std::reverse(topoSortedObjects.begin(),topoSortedObjects.end());
 #else
     vector<DocumentObject*> topoSortedObjects;
-    try {
-        topoSortedObjects = getDependencyList(objs.empty()?d->objectArray:objs,DepSort);
-    }catch (Base::Exception &e) {
-        e.ReportException();
-        topoSortedObjects = d->partialTopologicalSort(getDependencyList(objs.empty()?d->objectArray:objs));
-        std::reverse(topoSortedObjects.begin(),topoSortedObjects.end());
+    // Use the incrementally maintained dependency order if possible. Fall back
+    // to a full sort for cyclic dependency or external (xlinked) objects.
+    if(!d->getSortedDependencyList(objs,topoSortedObjects)) {
+        try {
+            topoSortedObjects = getDependencyList(objs.empty()?d->objectArray:objs,DepSort);
+        }catch (Base::Exception &e) {
+            e.ReportException();
+            topoSortedObjects = d->partialTopologicalSort(getDependencyList(objs.empty()?d->objectArray:objs));
+            std::reverse(topoSortedObjects.begin(),topoSortedObjects.end());
+        }
     }
 #endif
     for(auto obj : topoSortedObjects)
         obj->setStatus(ObjectStatus::PendingRecompute,true);
 
+    bool parallel = testStatus(Document::ParallelRecompute)
+        || App::GetApplication().GetParameterGroupByPath(
+                "User parameter:BaseApp/Preferences/Document")->GetBool("ParallelRecompute",false);
+
     std::set<App::DocumentObject *> filter;
+    if (testStatus(Document::PartialDoc)) {
+        // In a partially loaded document only objects whose dependencies are
+        // all restored can be recomputed
+        for(auto obj : topoSortedObjects) {
+            if(obj->testStatus(ObjectStatus::PartialObject)) {
+                obj->getInListEx(filter,true);
+                filter.insert(obj);
+            }
+        }
+    }
+
     size_t idx = 0;
     // maximum two passes to allow some form of dependency inversion
     for(int passes=0; passes<2 && idx<topoSortedObjects.size(); ++passes) {
         FC_LOG("Recompute pass " << passes);
+        if(parallel) {
+            objectCount += _recomputeConcurrent(topoSortedObjects,idx,filter);
+            idx = topoSortedObjects.size();
+        }
         for (;idx<topoSortedObjects.size();++idx) {
             auto obj = topoSortedObjects[idx];
             if(!obj->getNameInDocument() || filter.find(obj)!=filter.end())
@@ -2868,112 +2967,480 @@ int Document::recompute(const std::vector<App::DocumentObject*> &objs, bool forc
 
 #endif // USE_OLD_DAG
 
+// Recompute the objects in the queue starting at 'start' in dependency order,
+// running objects whose out-list dependencies are all finished on a worker
+// pool. Objects that do not support concurrent recompute are executed in the
+// main thread. The failure handling is the same as the serial loop in
+// recompute(), i.e. the in-list of a failed object is added to 'filter'.
+int Document::_recomputeConcurrent(const std::vector<App::DocumentObject*> &objs,
+        size_t start, std::set<App::DocumentObject*> &filter)
+{
+    struct RecomputeJob {
+        Document *doc;
+        DocumentObject *obj;
+        bool failed;
+
+        void run() {
+            failed = doc->_recomputeFeature(obj);
+        }
+    };
+
+    int objectCount = 0;
+    if(start >= objs.size())
+        return objectCount;
+
+    std::unordered_map<DocumentObject*, size_t> indices;
+    for(size_t i=start; i<objs.size(); ++i)
+        indices.emplace(objs[i],i);
+
+    // count the unfinished dependencies of each queued object
+    std::vector<int> pending(objs.size(),0);
+    std::vector<std::vector<size_t> > dependents(objs.size());
+    for(size_t i=start; i<objs.size(); ++i) {
+        auto obj = objs[i];
+        if(!obj->getNameInDocument())
+            continue;
+        auto outList = obj->getOutList();
+        std::sort(outList.begin(), outList.end());
+        outList.erase(std::unique(outList.begin(), outList.end()), outList.end());
+        for(auto dep : outList) {
+            auto it = indices.find(dep);
+            if(it == indices.end() || it->second == i)
+                continue;
+            ++pending[i];
+            dependents[it->second].push_back(i);
+        }
+    }
+
+    // Ready objects are kept sorted by their queue position, so that objects
+    // are visited in the same order as the serial recompute whenever possible
+    std::set<size_t> ready;
+    for(size_t i=start; i<objs.size(); ++i) {
+        if(!pending[i])
+            ready.insert(i);
+    }
+
+    std::vector<bool> done(objs.size(),false);
+    size_t remaining = objs.size() - start;
+    size_t first = start;
+
+    while(remaining) {
+        if(ready.empty()) {
+            // Cyclic dependency. Fall back to the (partial) topological order
+            // of the queue.
+            for(;first<objs.size() && done[first];++first);
+            ready.insert(first);
+        }
+
+        std::vector<size_t> wave(ready.begin(),ready.end());
+        ready.clear();
+
+        std::vector<RecomputeJob> jobs;
+        std::vector<size_t> serial;
+        for(auto i : wave) {
+            auto obj = objs[i];
+            if(!obj->getNameInDocument() || filter.count(obj))
+                continue;
+            // ask the object if it should be recomputed
+            if (!obj->isTouched() && obj->mustExecute() != 1)
+                continue;
+            if(obj->getDocument()==this && obj->canRecomputeConcurrently())
+                jobs.push_back({this,obj,false});
+            else
+                serial.push_back(i);
+        }
+
+        if(jobs.size() > 1) {
+            FC_LOG("Concurrent recompute of " << jobs.size() << " objects");
+            d->mainThreadId = std::this_thread::get_id();
+            d->concurrentRecompute = true;
+            try {
+                // Workers lock Python themselves where needed, so make sure
+                // the GIL is released here whether we held it or not.
+                Base::PyGILStateLocker lock;
+                Base::PyGILStateRelease unlock;
+                QtConcurrent::blockingMap(jobs, &RecomputeJob::run);
+            } catch (...) {
+                d->concurrentRecompute = false;
+                throw;
+            }
+            d->concurrentRecompute = false;
+
+            // now signal the property changes made by the workers
+            std::vector<std::pair<const DocumentObject*, const Property*> > changes;
+            changes.swap(d->deferredChanges);
+            for(auto &v : changes) {
+                if(v.first->getNameInDocument())
+                    signalChangedObject(*v.first,*v.second);
+            }
+        } else {
+            for(auto &job : jobs)
+                job.run();
+        }
+
+        auto handleResult = [&](DocumentObject *obj, bool failed) {
+            if (failed) {
+                // if something happened filter all object in its
+                // inListRecursive from the queue then proceed
+                obj->getInListEx(filter,true);
+                filter.insert(obj);
+            }
+            else{
+                objectCount++;
+                obj->purgeTouched();
+                // set all dependent object touched to force recompute
+                for (auto inObjIt : obj->getInList())
+                    inObjIt->touch();
+            }
+        };
+
+        for(auto &job : jobs)
+            handleResult(job.obj,job.failed);
+
+        for(auto i : serial) {
+            auto obj = objs[i];
+            if(!obj->getNameInDocument() || filter.count(obj))
+                continue;
+            handleResult(obj,_recomputeFeature(obj));
+        }
+
+        for(auto i : wave) {
+            if(done[i])
+                continue;
+            done[i] = true;
+            --remaining;
+            for(auto dependent : dependents[i]) {
+                if(--pending[dependent] == 0 && !done[dependent])
+                    ready.insert(dependent);
+            }
+        }
+    }
+    return objectCount;
+}
+
 /*!
-  Does almost the same as topologicalSort() until no object with an input degree of zero
-  can be found. It then searches for objects with an output degree of zero until neither
-  an object with input or output degree can be found. The remaining objects form one or
-  multiple cycles.
-  An alternative to this method might be:
-  https://en.wikipedia.org/wiki/Tarjan%E2%80%99s_strongly_connected_components_algorithm
+  Sorts the objects using Tarjan's strongly connected components algorithm
+  (https://en.wikipedia.org/wiki/Tarjan%27s_strongly_connected_components_algorithm).
+  Unlike topologicalSort() it also works if there are cyclic dependencies. Each
+  cycle is reported and its objects are kept together in the result. As with
+  topologicalSort() the dependent objects come before their dependencies.
  */
 std::vector<App::DocumentObject*> DocumentP::partialTopologicalSort(const std::vector<App::DocumentObject*>& objects) const
 {
-    vector < App::DocumentObject* > ret;
-    ret.reserve(objects.size());
-    // pairs of input and output degree
-    map < App::DocumentObject*, std::pair<int, int> > countMap;
+    struct TarjanNode {
+        App::DocumentObject *obj;
+        std::vector<size_t> outList;
+        int index;
+        int lowLink;
+        bool onStack;
+    };
 
-    for (auto objectIt : objects) {
-        //we need inlist with unique entries
-        auto in = objectIt->getInList();
-        std::sort(in.begin(), in.end());
-        in.erase(std::unique(in.begin(), in.end()), in.end());
+    std::vector<TarjanNode> nodes;
+    nodes.reserve(objects.size());
+    std::unordered_map<App::DocumentObject*, size_t> nodeMap;
+    for (auto obj : objects) {
+        if (nodeMap.emplace(obj, nodes.size()).second)
+            nodes.push_back({obj, {}, -1, 0, false});
+    }
 
+    for (auto &node : nodes) {
         //we need outlist with unique entries
-        auto out = objectIt->getOutList();
+        auto out = node.obj->getOutList();
         std::sort(out.begin(), out.end());
         out.erase(std::unique(out.begin(), out.end()), out.end());
-
-        countMap[objectIt] = std::make_pair(in.size(), out.size());
+        for (auto outObj : out) {
+            auto it = nodeMap.find(outObj);
+            if (it != nodeMap.end())
+                node.outList.push_back(it->second);
+        }
     }
 
-    std::list<App::DocumentObject*> degIn;
-    std::list<App::DocumentObject*> degOut;
+    vector < App::DocumentObject* > ret;
+    ret.reserve(nodes.size());
+
+    // iterative version of the algorithm to avoid stack overflow on deep
+    // dependency chains
+    int counter = 0;
+    std::vector<size_t> stack;
+    std::vector<std::pair<size_t, size_t> > callStack; // node, next out list index
+    for (size_t root=0; root<nodes.size(); ++root) {
+        if (nodes[root].index >= 0)
+            continue;
+        nodes[root].index = nodes[root].lowLink = counter++;
+        nodes[root].onStack = true;
+        stack.push_back(root);
+        callStack.emplace_back(root, 0);
+
+        while (!callStack.empty()) {
+            size_t current = callStack.back().first;
+            auto &node = nodes[current];
+            if (callStack.back().second < node.outList.size()) {
+                size_t next = node.outList[callStack.back().second++];
+                auto &child = nodes[next];
+                if (child.index < 0) {
+                    child.index = child.lowLink = counter++;
+                    child.onStack = true;
+                    stack.push_back(next);
+                    callStack.emplace_back(next, 0);
+                }
+                else if (child.onStack) {
+                    node.lowLink = std::min(node.lowLink, child.index);
+                }
+                continue;
+            }
 
-    bool removeVertex = true;
-    while (removeVertex) {
-        removeVertex = false;
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                auto &parent = nodes[callStack.back().first];
+                parent.lowLink = std::min(parent.lowLink, node.lowLink);
+            }
+            if (node.lowLink != node.index)
+                continue;
 
-        // try input degree
-        auto degInIt = find_if(countMap.begin(), countMap.end(),
-                               [](pair< App::DocumentObject*, pair<int, int> > vertex)->bool {
-            return vertex.second.first == 0;
-        });
+            // 'current' is the root of a strongly connected component
+            size_t first = ret.size();
+            size_t member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                nodes[member].onStack = false;
+                ret.push_back(nodes[member].obj);
+            } while (member != current);
+
+            if (ret.size()-first > 1
+                    || std::find(node.outList.begin(), node.outList.end(), current) != node.outList.end())
+            {
+                std::ostringstream ss;
+                for (size_t i=first; i<ret.size(); ++i) {
+                    if (i != first)
+                        ss << ", ";
+                    ss << ret[i]->getExportName(true);
+                }
+                FC_WARN("Cyclic dependency detected: " << ss.str());
+            }
+        }
+    }
 
-        if (degInIt != countMap.end()) {
-            removeVertex = true;
-            degIn.push_back(degInIt->first);
-            degInIt->second.first = degInIt->second.first - 1;
+    // Tarjan's algorithm emits the dependencies first
+    std::reverse(ret.begin(), ret.end());
+    return ret;
+}
+
+bool DocumentP::rebuildDependencyOrder()
+{
+    clearDependencyOrder();
 
-            //we need outlist with unique entries
-            auto out = degInIt->first->getOutList();
-            std::sort(out.begin(), out.end());
-            out.erase(std::unique(out.begin(), out.end()), out.end());
+    // Kahn's algorithm restricted to the objects of this document
+    std::unordered_map<const DocumentObject*, int> counts;
+    std::unordered_map<const DocumentObject*, std::vector<DocumentObject*> > dependents;
+    counts.reserve(objectArray.size());
+    for (auto obj : objectArray)
+        counts[obj] = 0;
 
-            for (auto outListIt : out) {
-                auto outListMapIt = countMap.find(outListIt);
-                if (outListMapIt != countMap.end())
-                    outListMapIt->second.first = outListMapIt->second.first - 1;
+    for (auto obj : objectArray) {
+        auto out = obj->getOutList();
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        for (auto dep : out) {
+            if (!dep || !dep->getNameInDocument())
+                continue;
+            if (!counts.count(dep)) {
+                depExternal.insert(obj);
+                continue;
             }
+            ++counts[obj];
+            dependents[dep].push_back(obj);
         }
     }
 
-    // make the output degree negative if input degree is negative
-    // to mark the vertex as processed
-    for (auto& countIt : countMap) {
-        if (countIt.second.first < 0) {
-            countIt.second.second = -1;
+    std::vector<DocumentObject*> queue;
+    queue.reserve(objectArray.size());
+    for (auto obj : objectArray) {
+        if (!counts[obj])
+            queue.push_back(obj);
+    }
+    for (size_t i=0; i<queue.size(); ++i) {
+        auto it = dependents.find(queue[i]);
+        if (it == dependents.end())
+            continue;
+        for (auto obj : it->second) {
+            if (--counts[obj] == 0)
+                queue.push_back(obj);
         }
     }
 
-    removeVertex = degIn.size() != objects.size();
-    while (removeVertex) {
-        removeVertex = false;
+    if (queue.size() != objectArray.size()) {
+        clearDependencyOrder();
+        depCyclic = true;
+        return false;
+    }
 
-        auto degOutIt = find_if(countMap.begin(), countMap.end(),
-                               [](pair< App::DocumentObject*, pair<int, int> > vertex)->bool {
-            return vertex.second.second == 0;
-        });
+    depCyclic = false;
+    depOrder.swap(queue);
+    for (size_t i=0; i<depOrder.size(); ++i)
+        depPositions[depOrder[i]] = i;
+    return true;
+}
 
-        if (degOutIt != countMap.end()) {
-            removeVertex = true;
-            degOut.push_front(degOutIt->first);
-            degOutIt->second.second = degOutIt->second.second - 1;
+// Pearce-Kelly dynamic topological order update. Called when 'obj' gained a
+// dependency 'dep' that is currently positioned after it. Only the objects
+// positioned in between are touched.
+bool DocumentP::reorderDependency(DocumentObject *obj, DocumentObject *dep)
+{
+    size_t lower = depPositions[obj];
+    size_t upper = depPositions[dep];
+
+    std::unordered_set<const DocumentObject*> visited;
+    std::vector<DocumentObject*> stack;
+
+    // 'obj' and its dependents positioned before 'dep'
+    std::vector<DocumentObject*> forward;
+    stack.push_back(obj);
+    visited.insert(obj);
+    while (!stack.empty()) {
+        auto current = stack.back();
+        stack.pop_back();
+        forward.push_back(current);
+        for (auto inObj : current->getInList()) {
+            // links of pending objects are not validated yet, skip them
+            if (depPending.count(inObj))
+                continue;
+            auto it = depPositions.find(inObj);
+            if (it == depPositions.end())
+                continue;
+            if (it->second == upper)
+                return false; // cyclic dependency
+            if (it->second < upper && visited.insert(inObj).second)
+                stack.push_back(inObj);
+        }
+    }
 
-            //we need inlist with unique entries
-            auto in = degOutIt->first->getInList();
-            std::sort(in.begin(), in.end());
-            in.erase(std::unique(in.begin(), in.end()), in.end());
+    // 'dep' and its dependencies positioned after 'obj'
+    std::vector<DocumentObject*> backward;
+    stack.push_back(dep);
+    visited.insert(dep);
+    while (!stack.empty()) {
+        auto current = stack.back();
+        stack.pop_back();
+        backward.push_back(current);
+        if (depPending.count(current))
+            continue;
+        for (auto outObj : current->getOutList()) {
+            auto it = depPositions.find(outObj);
+            if (it == depPositions.end())
+                continue;
+            if (it->second > lower && visited.insert(outObj).second)
+                stack.push_back(outObj);
+        }
+    }
 
-            for (auto inListIt : in) {
-                auto inListMapIt = countMap.find(inListIt);
-                if (inListMapIt != countMap.end())
-                    inListMapIt->second.second = inListMapIt->second.second - 1;
+    auto sorter = [this](const DocumentObject *a, const DocumentObject *b) {
+        return depPositions[a] < depPositions[b];
+    };
+    std::sort(forward.begin(), forward.end(), sorter);
+    std::sort(backward.begin(), backward.end(), sorter);
+
+    std::vector<size_t> slots;
+    slots.reserve(forward.size() + backward.size());
+    for (auto o : backward)
+        slots.push_back(depPositions[o]);
+    for (auto o : forward)
+        slots.push_back(depPositions[o]);
+    std::sort(slots.begin(), slots.end());
+
+    size_t i = 0;
+    for (auto o : backward) {
+        depOrder[slots[i]] = o;
+        depPositions[o] = slots[i++];
+    }
+    for (auto o : forward) {
+        depOrder[slots[i]] = o;
+        depPositions[o] = slots[i++];
+    }
+    return true;
+}
+
+bool DocumentP::updateDependencyOrder()
+{
+    // Objects are added to and removed from the order as they are added to
+    // and removed from the document, so only the dirty objects are visited
+    // here. Any mismatch means the order was cleared in between.
+    if (depCyclic || depPositions.size() != objectArray.size())
+        return rebuildDependencyOrder();
+
+    if (depDirty.size() > objectArray.size()/2)
+        return rebuildDependencyOrder();
+
+    // Holes are skipped by the readers, compact only once they dominate
+    if (depHoles > depOrder.size()/2) {
+        size_t i = 0;
+        for (auto obj : depOrder) {
+            if (!obj)
+                continue;
+            depPositions[obj] = i;
+            depOrder[i++] = obj;
+        }
+        depOrder.resize(i);
+        depHoles = 0;
+    }
+
+    depPending.swap(depDirty);
+    depDirty.clear();
+    std::vector<const DocumentObject*> pending(depPending.begin(), depPending.end());
+    for (auto cobj : pending) {
+        auto obj = const_cast<DocumentObject*>(cobj);
+        depPending.erase(obj);
+        depExternal.erase(obj);
+        for (auto dep : obj->getOutList()) {
+            if (!dep || !dep->getNameInDocument())
+                continue;
+            if (dep == obj) {
+                depPending.clear();
+                return rebuildDependencyOrder();
+            }
+            auto it = depPositions.find(dep);
+            if (it == depPositions.end()) {
+                depExternal.insert(obj);
+                continue;
+            }
+            if (it->second > depPositions[obj] && !reorderDependency(obj, dep)) {
+                depPending.clear();
+                return rebuildDependencyOrder();
             }
         }
     }
+    return true;
+}
+
+bool DocumentP::getSortedDependencyList(const std::vector<App::DocumentObject*> &objs,
+        std::vector<App::DocumentObject*> &res)
+{
+    if (!updateDependencyOrder())
+        return false;
 
-    // at this point we have no root object any more
-    for (auto countIt : countMap) {
-        if (countIt.second.first > 0 && countIt.second.second > 0) {
-            degIn.push_back(countIt.first);
+    res.clear();
+    if (objs.empty()) {
+        if (!depExternal.empty())
+            return false;
+        res.reserve(depOrder.size());
+        for (auto obj : depOrder) {
+            if (obj)
+                res.push_back(obj);
         }
+        return true;
     }
 
-    ret.insert(ret.end(), degIn.begin(), degIn.end());
-    ret.insert(ret.end(), degOut.begin(), degOut.end());
-
-    return ret;
+    res = Document::getDependencyList(objs);
+    for (auto obj : res) {
+        if (!depPositions.count(obj) || depExternal.count(obj)) {
+            res.clear();
+            return false;
+        }
+    }
+    std::sort(res.begin(), res.end(), [this](const DocumentObject *a, const DocumentObject *b) {
+        return depPositions[a] < depPositions[b];
+    });
+    return true;
 }
 
 std::vector<App::DocumentObject*> DocumentP::topologicalSort(const std::vector<App::DocumentObject*>& objects) const
@@ -3046,6 +3513,13 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
 {
     FC_LOG("Recomputing " << Feat->getDocument()->getName() << '#' << Feat->getNameInDocument());
 
+    auto addLog = [this](DocumentObjectExecReturn *ret) {
+        std::unique_lock<std::mutex> lock(d->recomputeMutex, std::defer_lock);
+        if(d->concurrentRecompute)
+            lock.lock();
+        _RecomputeLog.push_back(ret);
+    };
+
     DocumentObjectExecReturn  *returnCode = 0;
     try {
         returnCode = Feat->ExpressionEngine.execute(0);
@@ -3057,32 +3531,32 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
     }
     catch(Base::AbortException &e){
         e.ReportException();
-        _RecomputeLog.push_back(new DocumentObjectExecReturn("User abort",Feat));
+        addLog(new DocumentObjectExecReturn("User abort",Feat));
         Feat->setError();
         return true;
     }
     catch (const Base::MemoryException& e) {
         Base::Console().Error("Memory exception in feature '%s' thrown: %s\n",Feat->getNameInDocument(),e.what());
-        _RecomputeLog.push_back(new DocumentObjectExecReturn("Out of memory exception",Feat));
+        addLog(new DocumentObjectExecReturn("Out of memory exception",Feat));
         Feat->setError();
         return true;
     }
     catch (Base::Exception &e) {
         e.ReportException();
-        _RecomputeLog.push_back(new DocumentObjectExecReturn(e.what(),Feat));
+        addLog(new DocumentObjectExecReturn(e.what(),Feat));
         Feat->setError();
         return true;
     }
     catch (std::exception &e) {
         Base::Console().Warning("exception in Feature \"%s\" thrown: %s\n",Feat->getNameInDocument(),e.what());
-        _RecomputeLog.push_back(new DocumentObjectExecReturn(e.what(),Feat));
+        addLog(new DocumentObjectExecReturn(e.what(),Feat));
         Feat->setError();
         return true;
     }
 #ifndef FC_DEBUG
     catch (...) {
         Base::Console().Error("App::Document::_RecomputeFeature(): Unknown exception in Feature \"%s\" thrown\n",Feat->getNameInDocument());
-        _RecomputeLog.push_back(new DocumentObjectExecReturn("Unknown exception!"));
+        addLog(new DocumentObjectExecReturn("Unknown exception!"));
         Feat->setError();
         return true;
     }
@@ -3092,7 +3566,7 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
         Feat->resetError();
     }else{
         returnCode->Which = Feat;
-        _RecomputeLog.push_back(returnCode);
+        addLog(returnCode);
 #ifdef FC_DEBUG
         FC_ERR("Failed to recompute " << Feat->getExportName(true) << ": " << returnCode->Why);
 #else
@@ -3164,6 +3638,7 @@ DocumentObject * Document::addObject(const char* sType, const char* pObjectName,
     pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
     // insert in the vector
     d->objectArray.push_back(pcObject);
+    d->addDependencyOrder(pcObject);
     // insert in the adjacence list and reference through the ConectionMap
     //_DepConMap[pcObject] = add_vertex(_DepList);
 
@@ -3265,6 +3740,7 @@ std::vector<DocumentObject *> Document::addObjects(const char* sType, const std:
         pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
         // insert in the vector
         d->objectArray.push_back(pcObject);
+        d->addDependencyOrder(pcObject);
 
         pcObject->Label.setValue(ObjectName);
 
@@ -3329,6 +3805,7 @@ void Document::addObject(DocumentObject* pcObject, const char* pObjectName)
     pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
     // insert in the vector
     d->objectArray.push_back(pcObject);
+    d->addDependencyOrder(pcObject);
 
     pcObject->Label.setValue( ObjectName );
 
@@ -3356,6 +3833,7 @@ void Document::_addObject(DocumentObject* pcObject, const char* pObjectName)
     if(!pcObject->_Id) pcObject->_Id = ++d->lastObjectId;
     d->objectIdMap[pcObject->_Id] = pcObject;
     d->objectArray.push_back(pcObject);
+    d->addDependencyOrder(pcObject);
     // cache the pointer to the name string in the Object (for performance of DocumentObject::getNameInDocument())
     pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
 
@@ -3483,6 +3961,7 @@ void Document::removeObject(const char* sName)
             break;
         }
     }
+    d->removeDependencyOrder(pos->second);
 
     pos->second->setStatus(ObjectStatus::Remove, false); // Unset the bit to be on the safe side
     d->objectIdMap.erase(pos->second->_Id);
@@ -3557,6 +4036,7 @@ void Document::_removeObject(DocumentObject* pcObject)
             break;
         }
     }
+    d->removeDependencyOrder(pcObject);
 
     // for a rollback delete the object
     if (d->rollback) {
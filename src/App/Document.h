@@ -35,6 +35,7 @@
 
 #include <memory>
 #include <map>
+#include <set>
 #include <vector>
 #include <stack>
 #include <functional>
@@ -76,6 +77,7 @@ public:
         Importing = 5,
         PartialDoc = 6,
         AllowPartialRecompute = 7, // allow recomputing editing object if SkipRecompute is set
+        ParallelRecompute = 8, // recompute independent objects concurrently, see DocumentObject::canRecomputeConcurrently()
     };
 
     /** @name Properties */
@@ -529,6 +531,10 @@ protected:
     /// helper which Recompute only this feature
     /// @return True if the recompute process of the Document shall be stopped, False if it shall be continued.
     bool _recomputeFeature(DocumentObject* Feat);
+    /// helper which recomputes the queued objects starting at \a start on a worker pool
+    /// @return The number of successfully recomputed objects
+    int _recomputeConcurrent(const std::vector<App::DocumentObject*> &objs,
+            size_t start, std::set<App::DocumentObject*> &filter);
     void _clearRedos();
 
     /// refresh the internal dependency graph
@@ -547,7 +547,8 @@ void DocumentObject::onChanged(const Property* prop)
     if(!GetApplication().isRestoring() && 
        prop && !prop->testStatus(Property::PartialTrigger) &&
        getDocument() && 
-       getDocument()->testStatus(Document::PartialDoc))
+       getDocument()->testStatus(Document::PartialDoc) &&
+       !getDocument()->testStatus(Document::Recomputing))
     {
         FC_WARN("Changes to partial loaded document will not be saved");
     }
@@ -364,6 +364,17 @@ public:
     /// Return a list object to be copied together with this object
     virtual std::vector<App::DocumentObject*> getCopyObjects() const { return {}; }
 
+    /** Return true if this object can be recomputed in a worker thread
+     *
+     * This is used by Document::recompute() when the document has
+     * Document::ParallelRecompute status set. An object returning true here
+     * promises that its execute() does not call into Python, and only
+     * modifies its own properties. Property change signals emitted by the
+     * worker thread are deferred and signaled in the main thread once the
+     * object finishes.
+     */
+    virtual bool canRecomputeConcurrently() const {return false;}
+
     friend class Document;
     friend class Transaction;
     friend class ObjectExecution;
@@ -345,8 +345,6 @@ Expression * OperatorExpression::eval() const
     NumberExpression * v1;
     std::unique_ptr<Expression> e2(right->eval());
     NumberExpression * v2;
-    Expression * output;
-    const double epsilon = std::numeric_limits<double>::epsilon();
 
     v1 = freecad_dynamic_cast<NumberExpression>(e1.get());
     v2 = freecad_dynamic_cast<NumberExpression>(e2.get());
@@ -354,71 +352,80 @@ Expression * OperatorExpression::eval() const
     if (v1 == 0 || v2 == 0)
         throw ExpressionError("Invalid expression");
 
+    Quantity result = evalOperator(op, v1->getQuantity(), v2->getQuantity());
+
+    switch (op) {
+    case EQ:
+    case NEQ:
+    case LT:
+    case GT:
+    case LTE:
+    case GTE:
+        return new BooleanExpression(owner, result.getValue() > 0.5);
+    default:
+        return new NumberExpression(owner, result);
+    }
+}
+
+/**
+  * Apply the operator \a op to the values \a q1 and \a q2. Comparisons return 1 or 0.
+  * Throws an ExpressionError exception if the units don't fit to the operator.
+  */
+
+Quantity OperatorExpression::evalOperator(Operator op, const Quantity &q1, const Quantity &q2)
+{
+    const double epsilon = std::numeric_limits<double>::epsilon();
+
     switch (op) {
     case ADD:
-        if (v1->getUnit() != v2->getUnit())
+        if (q1.getUnit() != q2.getUnit())
             throw ExpressionError("Incompatible units for + operator");
-        output = new NumberExpression(owner, v1->getQuantity() + v2->getQuantity());
-        break;
+        return q1 + q2;
     case SUB:
-        if (v1->getUnit() != v2->getUnit())
+        if (q1.getUnit() != q2.getUnit())
             throw ExpressionError("Incompatible units for - operator");
-        output = new NumberExpression(owner, v1->getQuantity()- v2->getQuantity());
-        break;
+        return q1 - q2;
     case MUL:
     case UNIT:
-        output = new NumberExpression(owner, v1->getQuantity() * v2->getQuantity());
-        break;
+        return q1 * q2;
     case DIV:
-        output = new NumberExpression(owner, v1->getQuantity() / v2->getQuantity());
-        break;
+        return q1 / q2;
     case POW:
-        output = new NumberExpression(owner, v1->getQuantity().pow(v2->getQuantity()) );
-        break;
+        return q1.pow(q2);
     case EQ:
-        if (v1->getUnit() != v2->getUnit())
+        if (q1.getUnit() != q2.getUnit())
             throw ExpressionError("Incompatible units for the = operator");
-        output = new BooleanExpression(owner, essentiallyEqual(v1->getValue(), v2->getValue(), epsilon) );
-        break;
+        return Quantity(essentiallyEqual(q1.getValue(), q2.getValue(), epsilon) ? 1.0 : 0.0);
     case NEQ:
-        if (v1->getUnit() != v2->getUnit())
+        if (q1.getUnit() != q2.getUnit())
             throw ExpressionError("Incompatible units for the != operator");
-        output = new BooleanExpression(owner, !essentiallyEqual(v1->getValue(), v2->getValue(), epsilon) );
-        break;
+        return Quantity(!essentiallyEqual(q1.getValue(), q2.getValue(), epsilon) ? 1.0 : 0.0);
     case LT:
-        if (v1->getUnit() != v2->getUnit())
+        if (q1.getUnit() != q2.getUnit())
             throw ExpressionError("Incompatible units for the < operator");
-        output = new BooleanExpression(owner, definitelyLessThan(v1->getValue(), v2->getValue(), epsilon) );
-        break;
+        return Quantity(definitelyLessThan(q1.getValue(), q2.getValue(), epsilon) ? 1.0 : 0.0);
     case GT:
-        if (v1->getUnit() != v2->getUnit())
+        if (q1.getUnit() != q2.getUnit())
             throw ExpressionError("Incompatible units for the > operator");
-        output = new BooleanExpression(owner, definitelyGreaterThan(v1->getValue(), v2->getValue(), epsilon) );
-        break;
+        return Quantity(definitelyGreaterThan(q1.getValue(), q2.getValue(), epsilon) ? 1.0 : 0.0);
     case LTE:
-        if (v1->getUnit() != v2->getUnit())
+        if (q1.getUnit() != q2.getUnit())
             throw ExpressionError("Incompatible units for the <= operator");
-        output = new BooleanExpression(owner, definitelyLessThan(v1->getValue(), v2->getValue(), epsilon) ||
-                                       essentiallyEqual(v1->getValue(), v2->getValue(), epsilon));
-        break;
+        return Quantity(definitelyLessThan(q1.getValue(), q2.getValue(), epsilon) ||
+                        essentiallyEqual(q1.getValue(), q2.getValue(), epsilon) ? 1.0 : 0.0);
     case GTE:
-        if (v1->getUnit() != v2->getUnit())
+        if (q1.getUnit() != q2.getUnit())
             throw ExpressionError("Incompatible units for the >= operator");
-        output = new BooleanExpression(owner, essentiallyEqual(v1->getValue(), v2->getValue(), epsilon) ||
-                                       definitelyGreaterThan(v1->getValue(), v2->getValue(), epsilon));
-        break;
+        return Quantity(essentiallyEqual(q1.getValue(), q2.getValue(), epsilon) ||
+                        definitelyGreaterThan(q1.getValue(), q2.getValue(), epsilon) ? 1.0 : 0.0);
     case NEG:
-        output = new NumberExpression(owner, -v1->getQuantity() );
-        break;
+        return -q1;
     case POS:
-        output = new NumberExpression(owner, v1->getQuantity() );
-        break;
+        return q1;
     default:
-        output = 0;
         assert(0);
+        return Quantity();
     }
-
-    return output;
 }
 
 /**
@@ -850,53 +857,63 @@ public:
     }
 };
 
-Expression * FunctionExpression::evalAggregate() const
-{
-    boost::shared_ptr<Collector> c;
+/**
+  * Create the collector for the aggregate function \a f.
+  */
 
+static Collector * createCollector(FunctionExpression::Function f)
+{
     switch (f) {
-    case SUM:
-        c = boost::shared_ptr<Collector>(new SumCollector());
-        break;
-    case AVERAGE:
-        c = boost::shared_ptr<Collector>(new AverageCollector());
-        break;
-    case STDDEV:
-        c = boost::shared_ptr<Collector>(new StdDevCollector());
-        break;
-    case COUNT:
-        c = boost::shared_ptr<Collector>(new CountCollector());
-        break;
-    case MIN:
-        c = boost::shared_ptr<Collector>(new MinCollector());
-        break;
-    case MAX:
-        c = boost::shared_ptr<Collector>(new MaxCollector());
-        break;
+    case FunctionExpression::SUM:
+        return new SumCollector();
+    case FunctionExpression::AVERAGE:
+        return new AverageCollector();
+    case FunctionExpression::STDDEV:
+        return new StdDevCollector();
+    case FunctionExpression::COUNT:
+        return new CountCollector();
+    case FunctionExpression::MIN:
+        return new MinCollector();
+    case FunctionExpression::MAX:
+        return new MaxCollector();
     default:
         assert(false);
+        return new Collector();
     }
+}
+
+/**
+  * Collect the values of the cells of \a range, looked up in \a owner.
+  */
+
+static void collectRange(Collector & c, const DocumentObject * owner, Range range)
+{
+    do {
+        Property * p = owner->getPropertyByName(range.address().c_str());
+        PropertyQuantity * qp;
+        PropertyFloat * fp;
+
+        if (!p)
+            continue;
+
+        if ((qp = freecad_dynamic_cast<PropertyQuantity>(p)) != 0)
+            c.collect(qp->getQuantityValue());
+        else if ((fp = freecad_dynamic_cast<PropertyFloat>(p)) != 0)
+            c.collect(Quantity(fp->getValue()));
+        else
+            throw Expression::Exception("Invalid property type for aggregate");
+    } while (range.next());
+}
+
+Expression * FunctionExpression::evalAggregate() const
+{
+    boost::shared_ptr<Collector> c(createCollector(f));
 
     for (size_t i = 0; i< args.size(); ++i) {
         if (args[i]->isDerivedFrom(RangeExpression::getClassTypeId())) {
             RangeExpression * v = static_cast<RangeExpression*>(args[i]);
-            Range range(v->getRange());
 
-            do {
-                Property * p = owner->getPropertyByName(range.address().c_str());
-                PropertyQuantity * qp;
-                PropertyFloat * fp;
-
-                if (!p)
-                    continue;
-
-                if ((qp = freecad_dynamic_cast<PropertyQuantity>(p)) != 0)
-                    c->collect(qp->getQuantityValue());
-                else if ((fp = freecad_dynamic_cast<PropertyFloat>(p)) != 0)
-                    c->collect(Quantity(fp->getValue()));
-                else
-                    throw Exception("Invalid property type for aggregate");
-            } while (range.next());
+            collectRange(*c, owner, v->getRange());
         }
         else {
             std::unique_ptr<Expression> e(args[i]->eval());
@@ -929,6 +946,24 @@ Expression * FunctionExpression::eval() const
     NumberExpression * v1 = freecad_dynamic_cast<NumberExpression>(e1.get());
     NumberExpression * v2 = freecad_dynamic_cast<NumberExpression>(e2.get());
     NumberExpression * v3 = freecad_dynamic_cast<NumberExpression>(e3.get());
+
+    return new NumberExpression(owner, evalFunction(f, args.size(),
+                                                    v1 ? &v1->getQuantity() : 0,
+                                                    v2 ? &v2->getQuantity() : 0,
+                                                    v3 ? &v3->getQuantity() : 0));
+}
+
+/**
+  * Compute the function \a f for the first three of its \a nargs arguments. The arguments
+  * \a v1, \a v2 and \a v3 are null if they are missing or not numbers.
+  * Throws an ExpressionError exception if something fails.
+  *
+  * @returns The result.
+  */
+
+Quantity FunctionExpression::evalFunction(Function f, std::size_t nargs,
+                                          const Quantity * v1, const Quantity * v2, const Quantity * v3)
+{
     double output;
     Unit unit;
     double scaler = 1;
@@ -1038,7 +1073,7 @@ Expression * FunctionExpression::eval() const
         if (v1->getUnit() != v2->getUnit())
             throw ExpressionError("Units must be equal");
 
-        if (args.size() > 2) {
+        if (nargs > 2) {
             if (v3 == 0)
                 throw ExpressionError("Invalid second argument.");
             if (v2->getUnit() != v3->getUnit())
@@ -1131,7 +1166,7 @@ Expression * FunctionExpression::eval() const
         assert(0);
     }
 
-    return new NumberExpression(owner, Quantity(scaler * output, unit));
+    return Quantity(scaler * output, unit);
 }
 
 /**
@@ -1374,37 +1409,11 @@ App::DocumentObject * VariableExpression::getDocumentObject() const
 Expression * VariableExpression::eval() const
 {
     boost::any value = var.getValue(true);
+    Quantity qvalue;
 
-    if (value.type() == typeid(Quantity)) {
-        Quantity qvalue = boost::any_cast<Quantity>(value);
-
+    if (toQuantity(value, qvalue)) {
         return new NumberExpression(owner, qvalue);
     }
-    else if (value.type() == typeid(double)) {
-        double dvalue = boost::any_cast<double>(value);
-
-        return new NumberExpression(owner, Quantity(dvalue));
-    }
-    else if (value.type() == typeid(float)) {
-        double fvalue = boost::any_cast<float>(value);
-
-        return new NumberExpression(owner, Quantity(fvalue));
-    }
-    else if (value.type() == typeid(int)) {
-        int ivalue = boost::any_cast<int>(value);
-
-        return new NumberExpression(owner, Quantity(ivalue));
-    }
-    else if (value.type() == typeid(long)) {
-        long lvalue = boost::any_cast<long>(value);
-
-        return new NumberExpression(owner, Quantity(lvalue));
-    }
-    else if (value.type() == typeid(bool)) {
-        double bvalue = boost::any_cast<bool>(value) ? 1.0 : 0.0;
-
-        return new NumberExpression(owner, Quantity(bvalue));
-    }
     else if (value.type() == typeid(std::string)) {
         std::string svalue = boost::any_cast<std::string>(value);
 
@@ -1427,6 +1436,32 @@ Expression * VariableExpression::eval() const
     throw ExpressionError("Property is of invalid type.");
 }
 
+/**
+  * Convert the value of a property to a quantity. Quantities are taken as they are,
+  * int and floats are converted to a quantity without unit.
+  *
+  * @returns False if the value is not a number.
+  */
+
+bool VariableExpression::toQuantity(const boost::any & value, Quantity & q)
+{
+    if (value.type() == typeid(Quantity))
+        q = boost::any_cast<Quantity>(value);
+    else if (value.type() == typeid(double))
+        q = Quantity(boost::any_cast<double>(value));
+    else if (value.type() == typeid(float))
+        q = Quantity(boost::any_cast<float>(value));
+    else if (value.type() == typeid(int))
+        q = Quantity(boost::any_cast<int>(value));
+    else if (value.type() == typeid(long))
+        q = Quantity(boost::any_cast<long>(value));
+    else if (value.type() == typeid(bool))
+        q = Quantity(boost::any_cast<bool>(value) ? 1.0 : 0.0);
+    else
+        return false;
+    return true;
+}
+
 /**
   * Simplify the expression. Simplification of VariableExpression objects is
   * not possible (if it is instantiated it would be an evaluation instead).
@@ -1765,6 +1800,274 @@ void RangeExpression::setRange(const Range &r)
     range = r;
 }
 
+//
+// ExpressionProgram class
+//
+
+/**
+  * Compile the expression tree \a expr.
+  */
+
+ExpressionProgram::ExpressionProgram(const Expression *expr)
+    : expression(expr)
+    , depth(0)
+    , running(false)
+    , valid(false)
+{
+    std::size_t size = 0;
+
+    if (expr && compile(expr, false, size)) {
+        stack.reserve(depth);
+        valid = true;
+    }
+    else {
+        code.clear();
+        constants.clear();
+        nodes.clear();
+    }
+}
+
+/**
+  * Append the instructions for \a expr, which push its value onto the stack. Operands may
+  * evaluate to other values than numbers, as the operator then fails like in the tree.
+  * \a size is the size of the stack.
+  *
+  * @returns False if the expression can't be compiled.
+  */
+
+bool ExpressionProgram::compile(const Expression *expr, bool operand, std::size_t &size)
+{
+    Instruction instr;
+
+    if (freecad_dynamic_cast<OperatorExpression>(expr)) {
+        const OperatorExpression * e = static_cast<const OperatorExpression*>(expr);
+
+        if (!compile(e->getLeft(), true, size) || !compile(e->getRight(), true, size))
+            return false;
+        instr.code = OPERATOR;
+        instr.op = e->getOperator();
+        instr.arg = 0;
+        code.push_back(instr);
+        size -= 1;
+    }
+    else if (freecad_dynamic_cast<FunctionExpression>(expr)) {
+        const FunctionExpression * e = static_cast<const FunctionExpression*>(expr);
+        const std::vector<Expression*> & args = e->getArgs();
+
+        if (e->getFunction() > FunctionExpression::AGGREGATES) {
+            int count = 0;
+            for (std::vector<Expression*>::const_iterator it = args.begin(); it != args.end(); ++it) {
+                if ((*it)->isDerivedFrom(RangeExpression::getClassTypeId()))
+                    continue;
+                if (!compile(*it, true, size))
+                    return false;
+                ++count;
+            }
+            instr.code = AGGREGATE;
+            instr.op = count;
+            instr.arg = static_cast<int>(nodes.size());
+            nodes.push_back(e);
+            code.push_back(instr);
+            size = size - count + 1;
+        }
+        else {
+            // like the tree, only the first three arguments are evaluated
+            int count = static_cast<int>(std::min<std::size_t>(args.size(), 3));
+            if (count == 0)
+                return false;
+            for (int i = 0; i < count; ++i) {
+                if (!compile(args[i], true, size))
+                    return false;
+            }
+            instr.code = FUNCTION;
+            instr.op = e->getFunction();
+            instr.arg = count;
+            code.push_back(instr);
+            size = size - count + 1;
+        }
+    }
+    else if (freecad_dynamic_cast<VariableExpression>(expr)) {
+        // a variable can also be a string or an object
+        if (!operand)
+            return false;
+        instr.code = LOAD;
+        instr.op = 0;
+        instr.arg = static_cast<int>(nodes.size());
+        nodes.push_back(expr);
+        code.push_back(instr);
+        size += 1;
+    }
+    else if (freecad_dynamic_cast<ConditionalExpression>(expr)) {
+        const ConditionalExpression * e = static_cast<const ConditionalExpression*>(expr);
+
+        if (!compile(e->getCondition(), true, size))
+            return false;
+        std::size_t jumpToFalse = code.size();
+        instr.code = JUMP_IF_FALSE;
+        instr.op = 0;
+        instr.arg = 0;
+        code.push_back(instr);
+        size -= 1;
+
+        if (!compile(e->getTrueExpr(), operand, size))
+            return false;
+        std::size_t jumpToEnd = code.size();
+        instr.code = JUMP;
+        code.push_back(instr);
+        size -= 1;
+
+        code[jumpToFalse].arg = static_cast<int>(code.size());
+        if (!compile(e->getFalseExpr(), operand, size))
+            return false;
+        code[jumpToEnd].arg = static_cast<int>(code.size());
+    }
+    else if (freecad_dynamic_cast<UnitExpression>(expr)) {
+        // numbers, constants and units
+        instr.code = PUSH;
+        instr.op = 0;
+        instr.arg = static_cast<int>(constants.size());
+        constants.push_back(static_cast<const UnitExpression*>(expr)->getQuantity());
+        code.push_back(instr);
+        size += 1;
+    }
+    else
+        return false;
+
+    depth = std::max(depth, size);
+    return true;
+}
+
+void ExpressionProgram::run(std::vector<Value> &stack) const
+{
+    stack.clear();
+
+    std::size_t pc = 0;
+    while (pc < code.size()) {
+        const Instruction & instr = code[pc++];
+
+        switch (instr.code) {
+        case PUSH: {
+            Value v;
+            v.quantity = constants[instr.arg];
+            v.isNumber = true;
+            stack.push_back(v);
+            break;
+        }
+        case LOAD: {
+            const VariableExpression * e = static_cast<const VariableExpression*>(nodes[instr.arg]);
+            boost::any value = e->getPath().getValue(true);
+            Value v;
+
+            v.isNumber = VariableExpression::toQuantity(value, v.quantity);
+            if (!v.isNumber && value.type() != typeid(std::string) && value.type() != typeid(char*) &&
+                value.type() != typeid(const char*) && value.type() != typeid(Py::Object))
+                throw ExpressionError("Property is of invalid type.");
+            stack.push_back(v);
+            break;
+        }
+        case OPERATOR: {
+            Value & v1 = stack[stack.size() - 2];
+            const Value & v2 = stack.back();
+
+            if (!v1.isNumber || !v2.isNumber)
+                throw ExpressionError("Invalid expression");
+            v1.quantity = OperatorExpression::evalOperator(static_cast<OperatorExpression::Operator>(instr.op),
+                                                           v1.quantity, v2.quantity);
+            stack.pop_back();
+            break;
+        }
+        case FUNCTION: {
+            std::size_t first = stack.size() - instr.arg;
+            const Value * v = &stack[first];
+            Quantity result = FunctionExpression::evalFunction(static_cast<FunctionExpression::Function>(instr.op), instr.arg,
+                                                               v[0].isNumber ? &v[0].quantity : 0,
+                                                               instr.arg > 1 && v[1].isNumber ? &v[1].quantity : 0,
+                                                               instr.arg > 2 && v[2].isNumber ? &v[2].quantity : 0);
+            stack.resize(first + 1);
+            stack[first].quantity = result;
+            stack[first].isNumber = true;
+            break;
+        }
+        case AGGREGATE: {
+            const FunctionExpression * e = static_cast<const FunctionExpression*>(nodes[instr.arg]);
+            const std::vector<Expression*> & args = e->getArgs();
+            std::unique_ptr<Collector> c(createCollector(e->getFunction()));
+            std::size_t first = stack.size() - instr.op;
+            std::size_t next = first;
+
+            for (std::vector<Expression*>::const_iterator it = args.begin(); it != args.end(); ++it) {
+                if ((*it)->isDerivedFrom(RangeExpression::getClassTypeId()))
+                    collectRange(*c, e->getOwner(), static_cast<const RangeExpression*>(*it)->getRange());
+                else if (stack[next++].isNumber)
+                    c->collect(stack[next - 1].quantity);
+            }
+
+            Value v;
+            v.quantity = c->getQuantity();
+            v.isNumber = true;
+            stack.resize(first);
+            stack.push_back(v);
+            break;
+        }
+        case JUMP:
+            pc = instr.arg;
+            break;
+        case JUMP_IF_FALSE: {
+            const Value & v = stack.back();
+
+            if (!v.isNumber)
+                throw ExpressionError("Invalid expression");
+            if (!(fabs(v.quantity.getValue()) > 0.5))
+                pc = instr.arg;
+            stack.pop_back();
+            break;
+        }
+        }
+    }
+}
+
+/**
+  * Evaluate the program. Throws an exception like Expression::eval() if the
+  * evaluation fails.
+  *
+  * @returns The resulting number.
+  */
+
+Quantity ExpressionProgram::eval() const
+{
+    assert(valid);
+
+    if (running) {
+        // evaluated again while reading a variable
+        std::vector<Value> local;
+        run(local);
+        return local.back().quantity;
+    }
+
+    running = true;
+    try {
+        run(stack);
+    }
+    catch (...) {
+        running = false;
+        throw;
+    }
+    running = false;
+
+    return stack.back().quantity;
+}
+
+/**
+  * Evaluate the program and return the value like NumberExpression::getValueAsAny().
+  */
+
+boost::any ExpressionProgram::getValueAsAny() const
+{
+    Quantity q = eval();
+
+    return q.getUnit().isEmpty() ? boost::any(q.getValue()) : boost::any(q);
+}
+
 namespace App {
 
 namespace ExpressionParser {
@@ -252,6 +252,8 @@ public:
 
     Expression * getRight() const { return right; }
 
+    static Base::Quantity evalOperator(Operator op, const Base::Quantity &q1, const Base::Quantity &q2);
+
 protected:
 
     virtual bool isCommutative() const;
@@ -288,6 +290,12 @@ public:
 
     virtual void visit(ExpressionVisitor & v);
 
+    Expression * getCondition() const { return condition; }
+
+    Expression * getTrueExpr() const { return trueExpr; }
+
+    Expression * getFalseExpr() const { return falseExpr; }
+
 protected:
 
     Expression * condition;  /**< Condition */
@@ -365,6 +373,13 @@ public:
 
     virtual void visit(ExpressionVisitor & v);
 
+    Function getFunction() const { return f; }
+
+    const std::vector<Expression *> & getArgs() const { return args; }
+
+    static Base::Quantity evalFunction(Function f, std::size_t nargs, const Base::Quantity * v1,
+                                       const Base::Quantity * v2, const Base::Quantity * v3);
+
 protected:
     Expression *evalAggregate() const;
 
@@ -403,7 +418,7 @@ public:
 
     std::string name() const { return var.getPropertyName(); }
 
-    ObjectIdentifier getPath() const { return var; }
+    const ObjectIdentifier & getPath() const { return var; }
 
     void setPath(const ObjectIdentifier & path);
 
@@ -421,6 +436,8 @@ public:
 
     virtual boost::any getValueAsAny() const { return var.getValue(); }
 
+    static bool toQuantity(const boost::any & value, Base::Quantity & q);
+
 protected:
 
     ObjectIdentifier var; /**< Variable name  */
@@ -509,6 +526,65 @@ protected:
     Py::Object pyObj;
 };
 
+/**
+  * Class implementing a compiled form of an expression tree that evaluates to a number.
+  *
+  * The tree is flattened into a list of instructions working on a stack of quantities, so an
+  * evaluation doesn't create any intermediate expressions. Variables and ranges are read from
+  * their nodes of the tree, which therefore must exist as long as the program, and changing
+  * their paths (e.g. by renaming an object) also applies to the program.
+  *
+  * Only expressions that always evaluate to a number can be compiled, not e.g. a single
+  * variable or a string. isValid() is false for them, and the expression itself must be
+  * evaluated instead. Errors are reported in the same way as by Expression::eval().
+  */
+
+class AppExport ExpressionProgram {
+public:
+    ExpressionProgram(const Expression * expr);
+
+    bool isValid() const { return valid; }
+
+    const Expression * getExpression() const { return expression; }
+
+    Base::Quantity eval() const;
+
+    boost::any getValueAsAny() const;
+
+private:
+    enum OpCode {
+        PUSH,          /**< Push the constant arg */
+        LOAD,          /**< Push the value of the variable of node arg */
+        OPERATOR,      /**< Apply the operator op to the two topmost values */
+        FUNCTION,      /**< Apply the function op to the arg topmost values */
+        AGGREGATE,     /**< Apply the aggregate function of node arg to its ranges and its other arguments on the stack */
+        JUMP,          /**< Continue with the instruction arg */
+        JUMP_IF_FALSE  /**< Continue with the instruction arg if the topmost value is false */
+    };
+
+    struct Instruction {
+        OpCode code;
+        int op;
+        int arg;
+    };
+
+    struct Value {
+        Base::Quantity quantity;
+        bool isNumber;
+    };
+
+    bool compile(const Expression * expr, bool operand, std::size_t & size);
+    void run(std::vector<Value> & stack) const;
+
+    const Expression * expression;
+    std::vector<Instruction> code;
+    std::vector<Base::Quantity> constants;
+    std::vector<const Expression *> nodes; /**< Variables and aggregate functions */
+    std::size_t depth;                     /**< Maximum size of the stack */
+    mutable std::vector<Value> stack;
+    mutable bool running;
+    bool valid;
+};
 
 namespace ExpressionParser {
 AppExport Expression * parse(const App::DocumentObject *owner, const char *buffer);
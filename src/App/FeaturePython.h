@@ -290,6 +290,11 @@ public:
         return FeatureT::canLoadPartial();
     }
 
+    virtual bool canRecomputeConcurrently() const override {
+        // execute() calls into Python
+        return false;
+    }
+
     PyObject *getPyObject(void) {
         if (FeatureT::PythonObject.is(Py::_None())) {
             // ref counter is set to 1
@@ -626,11 +626,19 @@ DocumentObjectExecReturn *App::PropertyExpressionEngine::execute(int output)
         if (parent != docObj)
             throw Base::RuntimeError("Invalid property owner.");
 
-        // Evaluate expression
-        std::unique_ptr<Expression> e(expressions[*it].expression->eval());
+        const ExpressionInfo & info = expressions[*it];
 
-        /* Set value of property */
-        prop->setPathValue(*it, e->getValueAsAny());
+        // Numeric expressions are evaluated by their compiled program
+        if (info.program && info.program->isValid() && info.program->getExpression() == info.expression.get()) {
+            prop->setPathValue(*it, info.program->getValueAsAny());
+        }
+        else {
+            // Evaluate expression
+            std::unique_ptr<Expression> e(info.expression->eval());
+
+            /* Set value of property */
+            prop->setPathValue(*it, e->getValueAsAny());
+        }
 
         ++it;
     }
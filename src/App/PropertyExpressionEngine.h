@@ -59,21 +59,26 @@ public:
     struct ExpressionInfo {
         boost::shared_ptr<App::Expression> expression; /**< The actual expression tree */
         std::string comment; /**< Optional comment for this expression */
+        boost::shared_ptr<App::ExpressionProgram> program; /**< The compiled expression, if it is a numeric one */
 
         ExpressionInfo(boost::shared_ptr<App::Expression> expression = boost::shared_ptr<App::Expression>(), const char * comment = 0) {
             this->expression = expression;
             if (comment)
                 this->comment = comment;
+            if (expression)
+                program.reset(new ExpressionProgram(expression.get()));
         }
 
         ExpressionInfo(const ExpressionInfo & other) {
             expression = other.expression;
             comment = other.comment;
+            program = other.program;
         }
 
         ExpressionInfo & operator=(const ExpressionInfo & other) {
             expression = other.expression;
             comment = other.comment;
+            program = other.program;
             return *this;
         }
     };
@@ -1762,7 +1762,8 @@ public:
                         }
                     }
                 }
-            }
+            }else
+                loadPartial(info->pcDoc,info->getFullPath(),objName);
         } else {
             info = std::make_shared<DocInfo>();
             auto ret = _DocInfoMap.insert(std::make_pair(path,info));
@@ -1772,6 +1773,17 @@ public:
         return info;
     }
 
+    static void loadPartial(App::Document *doc, const QString &fullpath, const char *objName) {
+        // A partially loaded document may lack the object or not have it
+        // restored, in which case it is reopened with the object after the
+        // documents being opened are loaded
+        if(!objName || !objName[0] || !doc->testStatus(App::Document::PartialDoc))
+            return;
+        auto obj = doc->getObject(objName);
+        if(!obj || obj->testStatus(App::PartialObject))
+            App::GetApplication().addPendingDocument(fullpath.toUtf8().constData(),objName);
+    }
+
     static QString getFullPath(const char *p) {
         if(!p) return QString();
         return QFileInfo(QString::fromUtf8(p)).canonicalFilePath();
@@ -1824,6 +1836,7 @@ public:
             for(App::Document *doc : App::GetApplication().getDocuments()) {
                 if(getFullPath(doc->FileName.getValue()) == fullpath) {
                     attach(doc);
+                    loadPartial(doc,fullpath,objName);
                     return;
                 }
             }
@@ -24,11 +24,13 @@
 #include "PreCompiled.h"
 
 #ifndef _PreComp_
+# include <algorithm>
 #endif
 
-#include <boost/bimap.hpp>
-#include <boost/bimap/unordered_set_of.hpp>
-#include <boost/bimap/set_of.hpp>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
 #include <QHash>
 #include <QCryptographicHash>
 #include <Base/Console.h>
@@ -82,26 +84,380 @@ std::string StringID::dataToText() const {
 }
 
 ///////////////////////////////////////////////////////////
-//
-namespace boost {
-template<>
-struct hash<QByteArray> {
+
+namespace {
+struct ByteArrayHasher {
     size_t operator()(const QByteArray &data) const {
         return qHash(data);
     }
 };
+
+// Binary string table layout (all integers are LEB128 varints unless noted)
+//
+//      magic "FCSH", uint8 version
+//      count
+//      entries, sorted by ID, each of
+//          ID delta, uint8 flags, shared prefix length, suffix length, suffix
+//      restart count, restart offset deltas
+//      hash index, count records of uint32 data hash and uint32 entry
+//          index (little endian), sorted by hash (since version 2)
+//      uint32 (little endian) offset of the hash index (since version 2)
+//      uint32 (little endian) offset of the restart index
+//
+// Every RestartInterval entries, the ID delta is stored relative to zero and
+// the prefix is not shared, so that decoding can start from any restart point.
+// The hash index finds the entries of a given data without decoding the table.
+const char StringTableMagic[] = {'F','C','S','H'};
+const int StringTableVersion = 2;
+const int RestartInterval = 16;
+const int HashRecordSize = 8;
+
+enum StringTableFlag {
+    StringTableBinary = 1,
+    StringTableHashed = 2,
+};
+
+void writeVarint(std::string &buf, unsigned long long v) {
+    while(v >= 0x80) {
+        buf.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    buf.push_back((char)v);
+}
+
+void writeUInt32(std::string &buf, uint32_t v) {
+    for(int i=0;i<4;++i)
+        buf.push_back((char)((v >> (i*8)) & 0xff));
+}
+
+uint32_t readUInt32(const char *p) {
+    uint32_t v = 0;
+    for(int i=0;i<4;++i)
+        v |= (uint32_t)(unsigned char)p[i] << (i*8);
+    return v;
+}
+
+// FNV-1a, unlike qHash() it doesn't depend on the Qt version or seed
+uint32_t hashStringTableData(const QByteArray &data) {
+    uint32_t h = 2166136261u;
+    for(int i=0;i<data.size();++i) {
+        h ^= (unsigned char)data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool readVarint(const char *&p, const char *end, unsigned long long &v) {
+    v = 0;
+    for(int shift=0; p<end && shift<64; shift+=7) {
+        unsigned char c = (unsigned char)*p++;
+        v |= (unsigned long long)(c & 0x7f) << shift;
+        if(!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+struct StringTableEntry {
+    long id = 0;
+    int flags = 0;
+    QByteArray data;
+};
+
+// Decode one entry at 'p', using 'prev' for the shared prefix
+bool readStringTableEntry(const char *&p, const char *end,
+        const StringTableEntry &prev, StringTableEntry &entry)
+{
+    unsigned long long delta, shared, len;
+    if(!readVarint(p,end,delta) || p>=end)
+        return false;
+    entry.flags = (unsigned char)*p++;
+    if(!readVarint(p,end,shared) || !readVarint(p,end,len)
+            || shared>(unsigned long long)prev.data.size()
+            || len>(unsigned long long)(end-p))
+        return false;
+    entry.id = prev.id + (long)delta;
+    entry.data = prev.data.left((int)shared);
+    entry.data.append(p,(int)len);
+    p += len;
+    return true;
 }
 
-typedef boost::bimap<
-    boost::bimaps::unordered_set_of<QByteArray>,
-    boost::bimaps::set_of<long>, 
-    boost::bimaps::with_info<StringIDRef> > HashMapBase;
+}
 
-class StringHasher::HashMap: public HashMapBase 
+// The string table is split into shards, each guarded by its own mutex, so
+// that threads building element maps concurrently rarely contend with each
+// other. The data and ID indices are sharded separately. When both are
+// needed, the data shard is always locked first.
+//
+// IDs are allocated from an atomic counter, and never change once assigned.
+// The ID index holds a plain pointer, so that the reference count of an
+// unused StringID stays at one.
+//
+// A binary string table is restored lazily. Until the table file is read,
+// unknown IDs are handed out as placeholders. After that, entries are decoded
+// from the kept buffer on demand, by ID through the restart index and by data
+// through the hash index. The whole table is only decoded once a full listing
+// is requested, or on a lookup by data in a table without hash index. The
+// entry count stored in the table header is kept, so that the size can be
+// queried without decoding.
+class StringHasher::HashMap
 {
 public:
-    bool SaveAll = false;
-    int Threshold = 0;
+    enum { ShardCount = 32 };
+
+    enum RestoreState {
+        Restored,
+        PendingFile,
+        LazyBuffer,
+    };
+
+    struct DataShard {
+        std::mutex mutex;
+        std::unordered_map<QByteArray, StringIDRef, ByteArrayHasher> hashes;
+    };
+
+    struct IDShard {
+        std::mutex mutex;
+        std::unordered_map<long, StringID*> ids;
+    };
+
+    HashMap()
+        :SaveAll(false), Threshold(0), LastID(0), State(Restored)
+    {}
+
+    DataShard &dataShard(const QByteArray &data) {
+        return dataShards[qHash(data) % ShardCount];
+    }
+
+    IDShard &idShard(long id) {
+        return idShards[(unsigned long)id % ShardCount];
+    }
+
+    void insert(const QByteArray &data, const StringIDRef &sid) {
+        auto &shard = dataShard(data);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        insert(shard, data, sid);
+    }
+
+    // Caller must hold the lock of 'shard'
+    void insert(DataShard &shard, const QByteArray &data, const StringIDRef &sid) {
+        auto &ids = idShard(sid->value());
+        {
+            std::lock_guard<std::mutex> lock(ids.mutex);
+            ids.ids[sid->value()] = sid;
+        }
+        shard.hashes[data] = sid;
+
+        long id = LastID;
+        while(id < sid->value() && !LastID.compare_exchange_weak(id, sid->value()));
+    }
+
+    StringIDRef findID(long id) {
+        auto &shard = idShard(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.ids.find(id);
+        if(it == shard.ids.end())
+            return StringIDRef();
+        return it->second;
+    }
+
+    // Resolve an ID not found in the index while the table is not fully restored
+    StringIDRef lazyGetID(long id) {
+        std::lock_guard<std::mutex> lock(lazyMutex);
+        StringIDRef sid = findID(id);
+        if(sid)
+            return sid;
+        if(State == PendingFile) {
+            sid = new StringID(id,QByteArray(),false,false);
+            Placeholders.push_back(sid);
+            auto &shard = idShard(id);
+            std::lock_guard<std::mutex> idlock(shard.mutex);
+            shard.ids[id] = sid;
+            return sid;
+        }
+        StringTableEntry entry;
+        if(State == LazyBuffer && decodeID(id,entry)) {
+            sid = newID(entry);
+            insert(entry.data,sid);
+            ++Decoded;
+        }
+        return sid;
+    }
+
+    // Decode a single entry from the kept buffer. Caller must hold lazyMutex.
+    bool decodeID(long id, StringTableEntry &entry) const {
+        // locate the last restart point not after the given id
+        auto it = std::upper_bound(RestartIDs.begin(), RestartIDs.end(), id);
+        if(it == RestartIDs.begin())
+            return false;
+        const char *p = Buffer.constData() + Restarts[it - RestartIDs.begin() - 1];
+        const char *end = Buffer.constData() + IndexStart;
+        StringTableEntry prev;
+        for(int i=0; i<RestartInterval; ++i) {
+            if(!readStringTableEntry(p,end,prev,entry) || entry.id > id)
+                break;
+            if(entry.id == id)
+                return true;
+            prev = std::move(entry);
+        }
+        return false;
+    }
+
+    // Decode the entry at the given position in the table. Caller must hold lazyMutex.
+    bool decodeIndex(unsigned long index, StringTableEntry &entry) const {
+        size_t restart = index / RestartInterval;
+        if(restart >= Restarts.size())
+            return false;
+        const char *p = Buffer.constData() + Restarts[restart];
+        const char *end = Buffer.constData() + IndexStart;
+        StringTableEntry prev;
+        for(unsigned long i=0;;++i) {
+            if(!readStringTableEntry(p,end,prev,entry))
+                return false;
+            if(i == index % RestartInterval)
+                return true;
+            prev = std::move(entry);
+        }
+    }
+
+    // Resolve data not found in the index while the table is kept encoded
+    StringIDRef lazyFindData(const QByteArray &data) {
+        if(!HashIndexStart) {
+            materialize();
+            return StringIDRef();
+        }
+        std::lock_guard<std::mutex> lock(lazyMutex);
+        if(State != LazyBuffer)
+            return StringIDRef();
+        {
+            auto &shard = dataShard(data);
+            std::lock_guard<std::mutex> datalock(shard.mutex);
+            auto it = shard.hashes.find(data);
+            if(it != shard.hashes.end())
+                return it->second;
+        }
+
+        // binary search of the first record with the hash of the data
+        uint32_t hash = hashStringTableData(data);
+        const char *records = Buffer.constData() + HashIndexStart;
+        int lo = 0, hi = HashCount;
+        while(lo < hi) {
+            int mid = lo + (hi-lo)/2;
+            if(readUInt32(records + mid*HashRecordSize) < hash)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        for(;lo<HashCount;++lo) {
+            const char *record = records + lo*HashRecordSize;
+            if(readUInt32(record) != hash)
+                break;
+            StringTableEntry entry;
+            if(!decodeIndex(readUInt32(record+4),entry) || entry.data != data)
+                continue;
+            StringIDRef sid = findID(entry.id);
+            if(!sid) {
+                sid = newID(entry);
+                insert(entry.data,sid);
+                ++Decoded;
+            }
+            return sid;
+        }
+        return StringIDRef();
+    }
+
+    static StringIDRef newID(const StringTableEntry &entry) {
+        return new StringID(entry.id, entry.data,
+                (entry.flags & StringTableBinary)?true:false,
+                (entry.flags & StringTableHashed)?true:false);
+    }
+
+    // Decode the remaining entries of a lazily restored table
+    void materialize() {
+        if(State != LazyBuffer)
+            return;
+        std::lock_guard<std::mutex> lock(lazyMutex);
+        if(State != LazyBuffer)
+            return;
+        const char *p = Buffer.constData() + BufferStart;
+        const char *end = Buffer.constData() + IndexStart;
+        StringTableEntry prev, entry;
+        for(int i=0; p<end; ++i) {
+            if(i % RestartInterval == 0)
+                prev = StringTableEntry();
+            if(!readStringTableEntry(p,end,prev,entry)) {
+                Base::Console().Error("Corrupted string table\n");
+                break;
+            }
+            if(!findID(entry.id))
+                insert(entry.data, newID(entry));
+            prev = std::move(entry);
+        }
+        Buffer.clear();
+        Restarts.clear();
+        RestartIDs.clear();
+        HashIndexStart = HashCount = 0;
+        TableCount = Decoded = 0;
+        State = Restored;
+    }
+
+    // Return all the string IDs sorted by their ID value
+    std::vector<StringIDRef> getIDs() {
+        materialize();
+        std::vector<StringIDRef> ret;
+        for(auto &shard : idShards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for(auto &v : shard.ids)
+                ret.push_back(v.second);
+        }
+        std::sort(ret.begin(), ret.end(), [](const StringIDRef &a, const StringIDRef &b) {
+            return a->value() < b->value();
+        });
+        return ret;
+    }
+
+    void clear() {
+        for(auto &shard : dataShards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.hashes.clear();
+        }
+        for(auto &shard : idShards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.ids.clear();
+        }
+        LastID = 0;
+
+        std::lock_guard<std::mutex> lock(lazyMutex);
+        State = Restored;
+        Placeholders.clear();
+        Buffer.clear();
+        Restarts.clear();
+        RestartIDs.clear();
+        HashIndexStart = HashCount = 0;
+        TableCount = Decoded = 0;
+    }
+
+    DataShard dataShards[ShardCount];
+    IDShard idShards[ShardCount];
+    bool SaveAll;
+    int Threshold;
+    std::atomic<long> LastID;
+
+    std::atomic<int> State;
+    std::mutex lazyMutex;
+    std::vector<StringIDRef> Placeholders;
+    QByteArray Buffer;
+    int BufferStart = 0;
+    int IndexStart = 0;
+    std::vector<int> Restarts;
+    std::vector<long> RestartIDs;
+    // start and record count of the hash index, zero for tables without it
+    int HashIndexStart = 0;
+    int HashCount = 0;
+    // entry count from the table header, and how many of them are decoded
+    size_t TableCount = 0;
+    size_t Decoded = 0;
 };
 
 ///////////////////////////////////////////////////////////
@@ -132,11 +488,7 @@ int StringHasher::getThreshold() const {
 }
 
 long StringHasher::lastID() const {
-    if(_hashes->right.empty())
-        return 0;
-    auto it = _hashes->right.end();
-    --it;
-    return it->first;
+    return _hashes->LastID;
 }
 
 StringIDRef StringHasher::getID(const char *text, int len) {
@@ -154,9 +506,18 @@ StringIDRef StringHasher::getID(QByteArray data, bool binary) {
     }else
         hash = data;
 
-    auto it = _hashes->left.find(hash);
-    if(it!=_hashes->left.end())
-        return it->info;
+    if(_hashes->State == HashMap::LazyBuffer) {
+        StringIDRef sid = _hashes->lazyFindData(hash);
+        if(sid)
+            return sid;
+    }
+
+    auto &shard = _hashes->dataShard(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.hashes.find(hash);
+    if(it!=shard.hashes.end())
+        return it->second;
 
     StringIDRef sid;
     if(hashed) {
@@ -167,36 +528,46 @@ StringIDRef StringHasher::getID(QByteArray data, bool binary) {
         data = QByteArray(data.constData(),data.size());
         hash = data;
     }
-    sid = new StringID(lastID()+1,data,binary,hashed);
-    _hashes->right.insert(_hashes->right.end(),HashMap::right_map::value_type(sid->value(),hash,sid));
+    sid = new StringID(++_hashes->LastID,data,binary,hashed);
+    _hashes->insert(shard,hash,sid);
     return sid;
 }
 
 StringIDRef StringHasher::getID(long id) const {
     if(id<=0)
         return _StringIDNull;
-    auto it = _hashes->right.find(id);
-    if(it == _hashes->right.end())
-        return StringIDRef();
-    return it->info;
+    StringIDRef sid = _hashes->findID(id);
+    if(!sid && _hashes->State != HashMap::Restored)
+        sid = _hashes->lazyGetID(id);
+    return sid;
 }
 
 void StringHasher::Save(Base::Writer &writer) const {
     size_t count = _hashes->SaveAll?this->size():this->count();
     writer.incInd();
+    if(!writer.isForceXML()) {
+        writer.Stream() << writer.ind() << "<StringHasher count=\"" << count
+            << "\" saveall=\"" << _hashes->SaveAll
+            << "\" threshold=\"" << _hashes->Threshold
+            << "\" lastid=\"" << lastID()
+            << "\" file=\"" << writer.addFile("StringHasher.bin", this) << "\"/>" << std::endl;
+        writer.decInd();
+        return;
+    }
     writer.Stream() << writer.ind() << "<StringHasher count=\""<< count 
         << "\" saveall=\"" << _hashes->SaveAll
         << "\" threshold=\"" << _hashes->Threshold << "\">" << std::endl;
-    for(auto &v : _hashes->right) {
-        if(_hashes->SaveAll || v.info.getRefCount()>1) {
+    for(auto &sid : _hashes->getIDs()) {
+        // one extra reference is held by the vector returned by getIDs()
+        if(_hashes->SaveAll || sid.getRefCount()>2) {
             // We are omiting the indentation to save some space in case of long list of hashes
-            if(v.info->isHashed()) 
-                writer.Stream() <<"<Item hash=\""<< v.second.toBase64().constData();
-            else if(v.info->isBinary())
-                writer.Stream() <<"<Item data=\""<< v.second.toBase64().constData();
+            if(sid->isHashed()) 
+                writer.Stream() <<"<Item hash=\""<< sid->data().toBase64().constData();
+            else if(sid->isBinary())
+                writer.Stream() <<"<Item data=\""<< sid->data().toBase64().constData();
             else
-                writer.Stream() <<"<Item text=\""<< encodeAttribute(v.second.constData());
-            writer.Stream() << "\" id=\""<<v.first<<"\"/>" << std::endl;
+                writer.Stream() <<"<Item text=\""<< encodeAttribute(sid->data().constData());
+            writer.Stream() << "\" id=\""<<sid->value()<<"\"/>" << std::endl;
         }
     }
     writer.Stream() << writer.ind() << "</StringHasher>" << std::endl;
@@ -208,14 +579,31 @@ void StringHasher::clear() {
 }
 
 size_t StringHasher::size() const {
-    return _hashes->size();
+    // Hold the lazy restore lock, so that entries decoded in the meantime
+    // are not counted twice
+    std::unique_lock<std::mutex> lazyLock(_hashes->lazyMutex, std::defer_lock);
+    if(_hashes->State != HashMap::Restored)
+        lazyLock.lock();
+    size_t count = 0;
+    if(_hashes->State == HashMap::LazyBuffer)
+        count = _hashes->TableCount - _hashes->Decoded;
+    for(auto &shard : _hashes->idShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.ids.size();
+    }
+    return count;
 }
 
 size_t StringHasher::count() const {
+    // Entries still encoded in a lazily restored table are not referenced
+    // by anyone, so they need not be decoded here.
     size_t count = 0;
-    for(auto &v : _hashes->right) 
-        if(v.info.getRefCount()>1)
-            ++count;
+    for(auto &shard : _hashes->dataShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for(auto &v : shard.hashes) 
+            if(v.second.getRefCount()>1)
+                ++count;
+    }
     return count;
 }
 
@@ -225,6 +613,18 @@ void StringHasher::Restore(Base::XMLReader &reader) {
     int count = reader.getAttributeAsInteger("count");
     _hashes->SaveAll = reader.getAttributeAsInteger("saveall")?true:false;
     _hashes->Threshold = reader.getAttributeAsInteger("threshold");
+    if(reader.hasAttribute("file")) {
+        std::string file(reader.getAttribute("file"));
+        if(!file.empty()) {
+            long lastid = reader.getAttributeAsInteger("lastid");
+            if(lastid > _hashes->LastID)
+                _hashes->LastID = lastid;
+            _hashes->State = HashMap::PendingFile;
+            reader.addFile(file.c_str(),this);
+        }
+        reader.readEndElement("StringHasher");
+        return;
+    }
     for(int i=0;i<count;++i) {
         reader.readElement("Item");
         StringIDRef sid;
@@ -239,11 +639,165 @@ void StringHasher::Restore(Base::XMLReader &reader) {
             data = QByteArray(reader.getAttribute("text"));
             sid = new StringID(id,data,false,false);
         }
-        _hashes->right.insert(_hashes->right.end(),HashMap::right_map::value_type(sid->value(),data,sid));
+        _hashes->insert(data,sid);
     }
     reader.readEndElement("StringHasher");
 }
 
+void StringHasher::SaveDocFile (Base::Writer &writer) const {
+    std::string buf;
+    buf.append(StringTableMagic,sizeof(StringTableMagic));
+    buf.push_back((char)StringTableVersion);
+
+    std::vector<StringIDRef> sids;
+    for(auto &sid : _hashes->getIDs()) {
+        // one extra reference is held by the vector returned by getIDs()
+        if(_hashes->SaveAll || sid.getRefCount()>2)
+            sids.push_back(sid);
+    }
+    writeVarint(buf,sids.size());
+
+    std::vector<size_t> restarts;
+    StringIDRef prev;
+    for(size_t i=0;i<sids.size();++i) {
+        const auto &sid = sids[i];
+        if(i % RestartInterval == 0) {
+            restarts.push_back(buf.size());
+            prev = StringIDRef();
+        }
+        const QByteArray &data = sid->data();
+        int shared = 0;
+        if(prev) {
+            const QByteArray &prevData = prev->data();
+            int len = std::min(data.size(),prevData.size());
+            while(shared<len && data[shared]==prevData[shared])
+                ++shared;
+        }
+        writeVarint(buf,sid->value() - (prev?prev->value():0));
+        buf.push_back((char)((sid->isBinary()?StringTableBinary:0)
+                    | (sid->isHashed()?StringTableHashed:0)));
+        writeVarint(buf,shared);
+        writeVarint(buf,data.size()-shared);
+        buf.append(data.constData()+shared,data.size()-shared);
+        prev = sid;
+    }
+
+    uint32_t indexStart = (uint32_t)buf.size();
+    writeVarint(buf,restarts.size());
+    size_t offset = 0;
+    for(auto restart : restarts) {
+        writeVarint(buf,restart-offset);
+        offset = restart;
+    }
+
+    std::vector<std::pair<uint32_t,uint32_t> > hashes;
+    hashes.reserve(sids.size());
+    for(size_t i=0;i<sids.size();++i)
+        hashes.emplace_back(hashStringTableData(sids[i]->data()),(uint32_t)i);
+    std::sort(hashes.begin(),hashes.end());
+    uint32_t hashIndexStart = (uint32_t)buf.size();
+    for(auto &v : hashes) {
+        writeUInt32(buf,v.first);
+        writeUInt32(buf,v.second);
+    }
+
+    writeUInt32(buf,hashIndexStart);
+    writeUInt32(buf,indexStart);
+
+    writer.Stream().write(buf.c_str(),buf.size());
+}
+
+void StringHasher::RestoreDocFile(Base::Reader &reader) {
+    QByteArray buf;
+    char tmp[4096];
+    while(reader) {
+        reader.read(tmp,sizeof(tmp));
+        buf.append(tmp,(int)reader.gcount());
+    }
+
+    std::lock_guard<std::mutex> lock(_hashes->lazyMutex);
+    _hashes->State = HashMap::Restored;
+
+    const int headerSize = (int)sizeof(StringTableMagic) + 1;
+    const char *start = buf.constData();
+    const char *end = start + buf.size();
+    uint32_t indexStart = 0, hashIndexStart = 0;
+    unsigned long long count = 0, restartCount = 0;
+    const char *p = start + headerSize;
+    bool valid = buf.size() >= headerSize + 4
+        && memcmp(start,StringTableMagic,sizeof(StringTableMagic))==0
+        && start[sizeof(StringTableMagic)] <= StringTableVersion
+        && readVarint(p,end,count);
+    // end of the restart index
+    const char *indexEnd = end - 4;
+    if(valid) {
+        indexStart = readUInt32(end-4);
+        _hashes->BufferStart = (int)(p - start);
+        if(start[sizeof(StringTableMagic)] >= 2) {
+            valid = buf.size() >= headerSize + 8;
+            if(valid) {
+                hashIndexStart = readUInt32(end-8);
+                indexEnd = start + hashIndexStart;
+                valid = hashIndexStart >= indexStart
+                    && hashIndexStart <= (uint32_t)buf.size() - 8
+                    && (buf.size() - 8 - hashIndexStart) % HashRecordSize == 0;
+            }
+        }
+    }
+    if(valid) {
+        p = start + indexStart;
+        valid = indexStart >= (uint32_t)_hashes->BufferStart
+            && indexStart <= (uint32_t)(indexEnd - start)
+            && readVarint(p,indexEnd,restartCount);
+    }
+    if(!valid) {
+        Base::Console().Error("Invalid string table\n");
+        return;
+    }
+
+    unsigned long long offset = 0;
+    for(unsigned long long i=0;i<restartCount;++i) {
+        unsigned long long delta, id;
+        if(!readVarint(p,indexEnd,delta))
+            break;
+        offset += delta;
+        const char *q = start + offset;
+        if(offset >= indexStart || !readVarint(q,start+indexStart,id))
+            break;
+        _hashes->Restarts.push_back((int)offset);
+        _hashes->RestartIDs.push_back((long)id);
+    }
+    _hashes->Buffer = buf;
+    _hashes->IndexStart = (int)indexStart;
+    _hashes->HashIndexStart = (int)hashIndexStart;
+    _hashes->HashCount = hashIndexStart ? (buf.size() - 8 - (int)hashIndexStart) / HashRecordSize : 0;
+    _hashes->TableCount = (size_t)count;
+    _hashes->Decoded = 0;
+    _hashes->State = HashMap::LazyBuffer;
+
+    // Fill in the placeholders handed out before the table is read. Those
+    // not found in the table are kept alive, as the ID index does not own
+    // its entries.
+    std::vector<StringIDRef> missing;
+    for(auto &sid : _hashes->Placeholders) {
+        StringTableEntry entry;
+        if(!_hashes->decodeID(sid->value(),entry)) {
+            missing.push_back(sid);
+            continue;
+        }
+        ++_hashes->Decoded;
+        sid->_data = entry.data;
+        sid->_binary = (entry.flags & StringTableBinary)?true:false;
+        sid->_hashed = (entry.flags & StringTableHashed)?true:false;
+        auto &shard = _hashes->dataShard(entry.data);
+        std::lock_guard<std::mutex> datalock(shard.mutex);
+        shard.hashes[entry.data] = sid;
+    }
+    if(missing.size())
+        Base::Console().Warning("%d string id(s) missing from string table\n",(int)missing.size());
+    _hashes->Placeholders = std::move(missing);
+}
+
 unsigned int StringHasher::getMemSize (void) const {
     return (_hashes->SaveAll?size():count());
 }
@@ -254,7 +808,7 @@ PyObject *StringHasher::getPyObject() {
 
 std::map<long,StringIDRef> StringHasher::getIDMap() const {
     std::map<long,StringIDRef> ret;
-    for(auto &v : _hashes->right)
-        ret.emplace_hint(ret.end(),v.first,v.info);
+    for(auto &sid : _hashes->getIDs())
+        ret.emplace_hint(ret.end(),sid->value(),sid);
     return ret;
 }
@@ -52,6 +52,10 @@ public:
     bool isNull() const;
 
     std::string dataToText() const;
+
+private:
+    friend class StringHasher;
+
 private:
     long _id;
     QByteArray _data;
@@ -70,6 +74,8 @@ public:
     virtual unsigned int getMemSize (void) const override;
     virtual void Save (Base::Writer &/*writer*/) const override;
     virtual void Restore(Base::XMLReader &/*reader*/) override;
+    virtual void SaveDocFile (Base::Writer &/*writer*/) const override;
+    virtual void RestoreDocFile(Base::Reader &/*reader*/) override;
 
     /** Maps an arbitary string to an integer
      *
@@ -81,6 +87,9 @@ public:
      *
      * The purpose of function is to provide a short form of a stable string
      * hash.
+     *
+     * The getID() functions are thread safe, and can be called concurrently
+     * with each other, e.g. when building element maps in worker threads.
      */
     StringIDRef getID(const char *text, int len=-1);
 
@@ -92,6 +101,11 @@ public:
      * This function exists because the string hash is a one way function, and
      * the original text is not persistent. The caller use this function to
      * retieve the reference count ID object after restore
+     *
+     * When restoring from a binary string table, the table is decoded on
+     * demand. IDs requested before the table is read (e.g. by element maps
+     * restored from the XML) are returned as placeholders, whose data is
+     * filled in once the table is read.
      */
     StringIDRef getID(long id) const;
 
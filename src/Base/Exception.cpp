@@ -26,6 +26,7 @@
 #include "PreCompiled.h"
 
 #include <typeinfo>
+#include <mutex>
 
 #include "Exception.h"
 #include "Console.h"
@@ -833,13 +834,28 @@ CADKernelError::CADKernelError(const CADKernelError &inst)
 #include <stdexcept>
 #include <iostream>
 
+// The SIGSEGV handler is process wide, while SignalException may be used by
+// several threads at once, e.g. during concurrent recompute. Only the first
+// instance installs the handler and only the last one restores the old one.
+static std::mutex _SignalMutex;
+static int _SignalCount;
+static struct sigaction _SignalOldAction;
+
 SignalException::SignalException()
 {
     memset (&new_action, 0, sizeof (new_action));
     new_action.sa_handler = throw_signal;
     sigemptyset (&new_action.sa_mask);
     new_action.sa_flags = 0;
-    ok = (sigaction (SIGSEGV, &new_action, &old_action) < 0);
+    std::lock_guard<std::mutex> lock(_SignalMutex);
+    if (_SignalCount++ == 0) {
+        ok = (sigaction (SIGSEGV, &new_action, &old_action) < 0);
+        _SignalOldAction = old_action;
+    }
+    else {
+        old_action = _SignalOldAction;
+        ok = false;
+    }
 #ifdef _DEBUG
     std::cout << "Set new signal handler" << std::endl;
 #endif
@@ -847,7 +863,9 @@ SignalException::SignalException()
 
 SignalException::~SignalException()
 {
-    sigaction (SIGSEGV, &old_action, NULL);
+    std::lock_guard<std::mutex> lock(_SignalMutex);
+    if (--_SignalCount == 0)
+        sigaction (SIGSEGV, &_SignalOldAction, NULL);
 #ifdef _DEBUG
     std::cout << "Restore old signal handler" << std::endl;
 #endif
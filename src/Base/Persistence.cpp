@@ -69,6 +69,34 @@ void Persistence::RestoreDocFile(Reader &/*reader*/)
 {
 }
 
+bool Persistence::canRestoreDocFileConcurrently() const
+{
+    return false;
+}
+
+void Persistence::ReadDocFile(Reader &/*reader*/)
+{
+}
+
+void Persistence::FinishRestoreDocFile()
+{
+}
+
+bool Persistence::canSaveDocFileConcurrently(const Writer &/*writer*/) const
+{
+    return false;
+}
+
+void Persistence::WriteDocFile(Writer &writer) const
+{
+    SaveDocFile(writer);
+}
+
+bool Persistence::canDeduplicateDocFile(const Writer &/*writer*/) const
+{
+    return false;
+}
+
 std::string Persistence::encodeAttribute(const std::string& str)
 {
     std::string tmp;
@@ -146,6 +146,51 @@ public:
      * @see Base::Reader,Base::XMLReader
      */
     virtual void RestoreDocFile(Reader &/*reader*/);
+    /** @name Concurrent restore of files
+     * When a document is read with XMLReader::setParallelRestore() the files of objects
+     * that return true in canRestoreDocFileConcurrently() are read in two steps instead
+     * of RestoreDocFile(): ReadDocFile() gets called from a worker thread and parses the
+     * data into a temporary buffer. It must neither change the state of the object nor
+     * access any other object, the application or the console. Afterwards
+     * FinishRestoreDocFile() is called in the main thread, in the order of the files,
+     * and moves the data into the object. If ReadDocFile() throws an exception
+     * FinishRestoreDocFile() isn't called.
+     */
+    //@{
+    /// Returns true if ReadDocFile() and FinishRestoreDocFile() can be used instead of RestoreDocFile()
+    virtual bool canRestoreDocFileConcurrently() const;
+    /// Parses the file in a worker thread
+    virtual void ReadDocFile(Reader &/*reader*/);
+    /// Applies the data parsed by ReadDocFile() in the main thread
+    virtual void FinishRestoreDocFile();
+    //@}
+
+    /** @name Concurrent saving of files
+     * When a document is written with ZipWriter::setParallelSave() the files of objects
+     * that return true in canSaveDocFileConcurrently() are written with WriteDocFile()
+     * instead of SaveDocFile(). It's called from a worker thread with a writer of its
+     * own whose content is compressed in the same thread. WriteDocFile() must only read
+     * the data of the object and must not add files or access any other object, the
+     * application or the console. The files are still stored in their original order.
+     */
+    //@{
+    /// Returns true if WriteDocFile() can be called from a worker thread for \a writer
+    virtual bool canSaveDocFileConcurrently(const Writer &/*writer*/) const;
+    /// Writes the file in a worker thread, the default implementation calls SaveDocFile()
+    virtual void WriteDocFile(Writer &writer) const;
+    //@}
+
+    /** @name Deduplication of files
+     * When a document is written with ZipWriter::setDeduplicateFiles() the files of objects
+     * that return true in canDeduplicateDocFile() are written with WriteDocFile() and hashed
+     * by worker threads. If another object has written exactly the same data before, the
+     * data is stored only once. The same restrictions as for concurrent saving apply to
+     * WriteDocFile(). When reading the document both objects are restored from the data.
+     */
+    //@{
+    /// Returns true if the file can be shared with other objects that write the same data
+    virtual bool canDeduplicateDocFile(const Writer &/*writer*/) const;
+    //@}
     /// Encodes an attribute upon saving.
     static std::string encodeAttribute(const std::string&);
 };
@@ -51,6 +51,12 @@
 
 #include "XMLTools.h"
 
+#include <deque>
+#include <map>
+#include <sstream>
+#include <QThread>
+#include <QtConcurrentRun>
+
 XERCES_CPP_NAMESPACE_USE
 
 using namespace std;
@@ -64,7 +70,7 @@ using namespace std;
 Base::XMLReader::XMLReader(const char* FileName, std::istream& str) 
   : DocumentSchema(0), ProgramVersion(""), FileVersion(0), Level(0),
     CharacterCount(0), ReadType(None), _File(FileName), _valid(false),
-    _verbose(true)
+    _verbose(true), _parallel(false)
 {
 #ifdef _MSC_VER
     str.imbue(std::locale::empty());
@@ -289,6 +295,71 @@ void Base::XMLReader::readBinFile(const char* filename)
     to.close();
 }
 
+namespace {
+/// A file that is parsed by a worker thread while the next entries are inflated
+struct DocFileJob
+{
+    Base::Persistence* Object;
+    std::string FileName;
+    std::string EntryName;
+    std::string Data;
+    int FileVersion;
+    bool Failed;
+    QFuture<void> Future;
+
+    void Run()
+    {
+        try {
+            std::istringstream str(Data);
+            Base::Reader reader(str, FileName, FileVersion);
+            Object->ReadDocFile(reader);
+        }
+        catch (...) {
+            Failed = true;
+        }
+        std::string().swap(Data);
+    }
+};
+
+/// Reads the remaining data of the current entry
+void readEntryData(std::istream& zipstream, const zipios::ConstEntryPointer& entry, std::string& data)
+{
+    if (entry->getSize() > 0)
+        data.reserve(entry->getSize());
+    char buf[0x10000];
+    while (zipstream.read(buf, sizeof(buf)) || zipstream.gcount() > 0)
+        data.append(buf, zipstream.gcount());
+}
+
+/// Waits for the oldest job and applies its data in the main thread
+void finishDocFileJob(std::deque<DocFileJob>& jobs)
+{
+    DocFileJob& job = jobs.front();
+    job.Future.waitForFinished();
+    if (!job.Failed) {
+        try {
+            job.Object->FinishRestoreDocFile();
+        }
+        catch (...) {
+            job.Failed = true;
+        }
+    }
+    if (job.Failed)
+        Base::Console().Error("Reading failed from embedded file: %s\n", job.EntryName.c_str());
+    jobs.pop_front();
+}
+
+/// Makes sure no worker accesses a job after the queue is gone, e.g. if the user aborts
+struct DocFileJobQueue : std::deque<DocFileJob>
+{
+    ~DocFileJobQueue()
+    {
+        for (iterator it = begin(); it != end(); ++it)
+            it->Future.waitForFinished();
+    }
+};
+}
+
 void Base::XMLReader::readFiles(zipios::ZipInputStream &zipstream) const
 {
     // It's possible that not all objects inside the document could be created, e.g. if a module
@@ -308,6 +379,37 @@ void Base::XMLReader::readFiles(zipios::ZipInputStream &zipstream) const
         // project file was created without GUI
         return;
     }
+
+    // In parallel mode the inflated files wait in this queue until they are applied. Its
+    // length is limited to keep the memory usage low.
+    DocFileJobQueue jobs;
+    std::size_t maxJobs = 4 * std::max(1, QThread::idealThreadCount());
+
+    // Files whose data is stored in another file, see Base::ZipWriter::setDeduplicateFiles()
+    std::map<std::string, std::string> sharedFiles;
+    if (entry->isValid() && entry->getName() == "SharedFiles.txt") {
+        std::string line;
+        while (std::getline(zipstream, line)) {
+            std::string::size_type pos = line.find('\t');
+            if (pos != std::string::npos)
+                sharedFiles[line.substr(0, pos)] = line.substr(pos + 1);
+        }
+
+        try {
+            entry = zipstream.getNextEntry();
+        }
+        catch (const std::exception&) {
+            return;
+        }
+    }
+
+    // The registered files that are restored from the data of an entry
+    std::map<std::string, std::vector<const FileEntry*> > files;
+    for (std::vector<FileEntry>::const_iterator ft = FileList.begin(); ft != FileList.end(); ++ft) {
+        std::map<std::string, std::string>::iterator st = sharedFiles.find(ft->FileName);
+        files[st != sharedFiles.end() ? st->second : ft->FileName].push_back(&*ft);
+    }
+
     std::vector<FileEntry>::const_iterator it = FileList.begin();
     Base::SequencerLauncher seq("Importing project files...", FileList.size());
     while (entry->isValid() && it != FileList.end()) {
@@ -317,24 +419,86 @@ void Base::XMLReader::readFiles(zipios::ZipInputStream &zipstream) const
         while (jt != FileList.end() && entry->getName() != jt->FileName)
             ++jt;
         // If this condition is true both file names match and we can read-in the data, otherwise
-        // no file name for the current entry in the zip was registered.
-        if (jt != FileList.end()) {
-            try {
-                Base::Reader reader(zipstream, jt->FileName, FileVersion);
-                jt->Object->RestoreDocFile(reader);
+        // no file name for the current entry in the zip was registered. The data of a shared file
+        // is needed even if its own object wasn't registered.
+        std::map<std::string, std::vector<const FileEntry*> >::const_iterator ft = files.end();
+        if (jt != FileList.end())
+            ft = files.find(jt->FileName);
+        else if (!sharedFiles.empty())
+            ft = files.find(entry->getName());
+        if (ft != files.end()) {
+            // A shared file is read once and restores all objects that refer to it
+            const std::vector<const FileEntry*>& objects = ft->second;
+            bool shared = objects.size() > 1;
+            bool sharedFailed = false;
+            std::string sharedData;
+            if (shared) {
+                try {
+                    readEntryData(zipstream, entry, sharedData);
+                }
+                catch (...) {
+                    sharedFailed = true;
+                }
             }
-            catch(...) {
-                // For any exception we just continue with the next file.
-                // It doesn't matter if the last reader has read more or
-                // less data than the file size would allow.
-                // All what we need to do is to notify the user about the
-                // failure.
-                Base::Console().Error("Reading failed from embedded file: %s\n", entry->toString().c_str());
+
+            for (std::vector<const FileEntry*>::const_iterator ot = objects.begin(); ot != objects.end(); ++ot) {
+                if (sharedFailed) {
+                    Base::Console().Error("Reading failed from embedded file: %s\n", entry->toString().c_str());
+                }
+                else if (_parallel && (*ot)->Object->canRestoreDocFileConcurrently()) {
+                    if (jobs.size() >= maxJobs)
+                        finishDocFileJob(jobs);
+
+                    jobs.push_back(DocFileJob());
+                    DocFileJob& job = jobs.back();
+                    job.Object = (*ot)->Object;
+                    job.FileName = (*ot)->FileName;
+                    job.EntryName = entry->toString();
+                    job.FileVersion = FileVersion;
+                    job.Failed = false;
+                    try {
+                        if (shared)
+                            job.Data = sharedData;
+                        else
+                            readEntryData(zipstream, entry, job.Data);
+                        job.Future = QtConcurrent::run(&job, &DocFileJob::Run);
+                    }
+                    catch (...) {
+                        job.Failed = true;
+                    }
+                }
+                else {
+                    // keep the order of the files
+                    while (!jobs.empty())
+                        finishDocFileJob(jobs);
+
+                    try {
+                        if (shared) {
+                            std::istringstream str(sharedData);
+                            Base::Reader reader(str, (*ot)->FileName, FileVersion);
+                            (*ot)->Object->RestoreDocFile(reader);
+                        }
+                        else {
+                            Base::Reader reader(zipstream, (*ot)->FileName, FileVersion);
+                            (*ot)->Object->RestoreDocFile(reader);
+                        }
+                    }
+                    catch(...) {
+                        // For any exception we just continue with the next file.
+                        // It doesn't matter if the last reader has read more or
+                        // less data than the file size would allow.
+                        // All what we need to do is to notify the user about the
+                        // failure.
+                        Base::Console().Error("Reading failed from embedded file: %s\n", entry->toString().c_str());
+                    }
+                }
             }
-            // Go to the next registered file name
-            it = jt + 1;
         }
 
+        // Go to the next registered file name
+        if (jt != FileList.end())
+            it = jt + 1;
+
         seq.next();
 
         // In either case we must go to the next entry
@@ -346,6 +510,9 @@ void Base::XMLReader::readFiles(zipios::ZipInputStream &zipstream) const
             break;
         }
     }
+
+    while (!jobs.empty())
+        finishDocFileJob(jobs);
 }
 
 const char *Base::XMLReader::addFile(const char* Name, Base::Persistence *Object)
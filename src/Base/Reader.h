@@ -122,6 +122,9 @@ public:
     bool isValid() const { return _valid; }
     bool isVerbose() const { return _verbose; }
     void setVerbose(bool on) { _verbose = on; }
+    bool isParallelRestore() const { return _parallel; }
+    /// let readFiles() read the files of objects that support it with several threads
+    void setParallelRestore(bool on) { _parallel = on; }
 
     /** @name Parser handling */
     //@{
@@ -156,7 +159,14 @@ public:
     //@{
     /// add a read request of a persistent object
     const char *addFile(const char* Name, Base::Persistence *Object);
-    /// process the requested file writes
+    /** process the requested file reads
+     * In parallel restore mode the files of objects whose canRestoreDocFileConcurrently()
+     * returns true are inflated into memory and parsed with ReadDocFile() by worker threads.
+     * FinishRestoreDocFile() and RestoreDocFile() of all other objects are still called in
+     * the main thread in the order of the files.
+     * If the document was saved with ZipWriter::setDeduplicateFiles() the files listed in
+     * the entry SharedFiles.txt are restored from the data of the file they refer to.
+     */
     void readFiles(zipios::ZipInputStream &zipstream) const;
     /// get all registered file names
     const std::vector<std::string>& getFilenames() const;
@@ -245,6 +255,7 @@ protected:
     XERCES_CPP_NAMESPACE_QUALIFIER XMLPScanToken token;
     bool _valid;
     bool _verbose;
+    bool _parallel;
 
     struct FileEntry {
         std::string FileName;
@@ -32,6 +32,7 @@
 # include <string>
 # include <cstdio>
 # include <cstring>
+# include <algorithm>
 #ifdef __GNUC__
 # include <stdint.h>
 #endif
@@ -61,6 +62,40 @@ void Stream::setByteOrder(ByteOrder bo)
     _swap = (bo == BigEndian);
 }
 
+namespace {
+template <typename T>
+void writeArray(std::ostream& out, const T* values, std::size_t count, bool swap)
+{
+    if (!swap) {
+        out.write(reinterpret_cast<const char*>(values), count * sizeof(T));
+        return;
+    }
+
+    // swap a copy of the values block-wise
+    T buffer[1024];
+    while (count > 0) {
+        std::size_t num = std::min<std::size_t>(count, 1024);
+        for (std::size_t i = 0; i < num; i++) {
+            buffer[i] = values[i];
+            SwapEndian<T>(buffer[i]);
+        }
+        out.write(reinterpret_cast<const char*>(buffer), num * sizeof(T));
+        values += num;
+        count -= num;
+    }
+}
+
+template <typename T>
+void readArray(std::istream& in, T* values, std::size_t count, bool swap)
+{
+    in.read(reinterpret_cast<char*>(values), count * sizeof(T));
+    if (swap) {
+        for (std::size_t i = 0; i < count; i++)
+            SwapEndian<T>(values[i]);
+    }
+}
+}
+
 OutputStream::OutputStream(std::ostream &rout) : _out(rout)
 {
 }
@@ -143,6 +178,30 @@ OutputStream& OutputStream::operator << (double d)
     return *this;
 }
 
+OutputStream& OutputStream::write(const int32_t* values, std::size_t count)
+{
+    writeArray<int32_t>(_out, values, count, _swap);
+    return *this;
+}
+
+OutputStream& OutputStream::write(const uint32_t* values, std::size_t count)
+{
+    writeArray<uint32_t>(_out, values, count, _swap);
+    return *this;
+}
+
+OutputStream& OutputStream::write(const float* values, std::size_t count)
+{
+    writeArray<float>(_out, values, count, _swap);
+    return *this;
+}
+
+OutputStream& OutputStream::write(const double* values, std::size_t count)
+{
+    writeArray<double>(_out, values, count, _swap);
+    return *this;
+}
+
 InputStream::InputStream(std::istream &rin) : _in(rin)
 {
 }
@@ -225,6 +284,30 @@ InputStream& InputStream::operator >> (double& d)
     return *this;
 }
 
+InputStream& InputStream::read(int32_t* values, std::size_t count)
+{
+    readArray<int32_t>(_in, values, count, _swap);
+    return *this;
+}
+
+InputStream& InputStream::read(uint32_t* values, std::size_t count)
+{
+    readArray<uint32_t>(_in, values, count, _swap);
+    return *this;
+}
+
+InputStream& InputStream::read(float* values, std::size_t count)
+{
+    readArray<float>(_in, values, count, _swap);
+    return *this;
+}
+
+InputStream& InputStream::read(double* values, std::size_t count)
+{
+    readArray<double>(_in, values, count, _swap);
+    return *this;
+}
+
 // ----------------------------------------------------------------------
 
 ByteArrayOStreambuf::ByteArrayOStreambuf(QByteArray& ba) : _buffer(new QBuffer(&ba))
@@ -81,6 +81,16 @@ public:
     OutputStream& operator << (float f);
     OutputStream& operator << (double d);
 
+    /** @name Arrays
+     * Write \a count values with one call. The bytes are only swapped if needed.
+     */
+    //@{
+    OutputStream& write(const int32_t* values, std::size_t count);
+    OutputStream& write(const uint32_t* values, std::size_t count);
+    OutputStream& write(const float* values, std::size_t count);
+    OutputStream& write(const double* values, std::size_t count);
+    //@}
+
 private:
     OutputStream (const OutputStream&);
     void operator = (const OutputStream&);
@@ -111,6 +121,16 @@ public:
     InputStream& operator >> (float& f);
     InputStream& operator >> (double& d);
 
+    /** @name Arrays
+     * Read \a count values with one call. The bytes are only swapped if needed.
+     */
+    //@{
+    InputStream& read(int32_t* values, std::size_t count);
+    InputStream& read(uint32_t* values, std::size_t count);
+    InputStream& read(float* values, std::size_t count);
+    InputStream& read(double* values, std::size_t count);
+    //@}
+
     operator bool() const
     {
         // test if _Ipfx succeeded
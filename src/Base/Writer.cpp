@@ -36,7 +36,15 @@
 #include "Tools.h"
 
 #include <algorithm>
+#include <deque>
+#include <exception>
 #include <locale>
+#include <map>
+#include <memory>
+#include <zlib.h>
+#include <QCryptographicHash>
+#include <QThread>
+#include <QtConcurrentRun>
 
 using namespace Base;
 using namespace std;
@@ -214,6 +222,17 @@ const std::vector<std::string>& Writer::getFilenames() const
     return FileNames;
 }
 
+void Writer::initFileWriter(Writer &writer)
+{
+    writer.setFileVersion(getFileVersion());
+    writer.setModes(getModes());
+    writer.setForceXML(forceXML);
+    writer.ObjectName = ObjectName;
+    writer.Stream().imbue(Stream().getloc());
+    writer.Stream().precision(Stream().precision());
+    writer.Stream().flags(Stream().flags());
+}
+
 void Writer::incInd(void)
 {
     if (indent < 1020) {
@@ -240,7 +259,7 @@ void Writer::decInd(void)
 // ----------------------------------------------------------------------------
 
 ZipWriter::ZipWriter(const char* FileName) 
-  : ZipStream(FileName)
+  : ZipStream(FileName), parallel(false), deduplicate(false)
 {
 #ifdef _MSC_VER
     ZipStream.imbue(std::locale::empty());
@@ -253,7 +272,7 @@ ZipWriter::ZipWriter(const char* FileName)
 }
 
 ZipWriter::ZipWriter(std::ostream& os) 
-  : ZipStream(os)
+  : ZipStream(os), parallel(false), deduplicate(false)
 {
 #ifdef _MSC_VER
     ZipStream.imbue(std::locale::empty());
@@ -265,16 +284,198 @@ ZipWriter::ZipWriter(std::ostream& os)
     ZipStream.setf(ios::fixed,ios::floatfield);
 }
 
+namespace {
+/// Compressed data that the files of objects that can share their data may keep until they are stored
+const std::size_t maxSharedSize = 0x10000000;
+
+/// A file that is serialized and compressed by a worker thread
+struct ZipFileJob
+{
+    const Base::Persistence* Object;
+    std::string FileName;
+    std::unique_ptr<Base::StringWriter> Writer;
+    std::vector<std::string> Errors;
+    bool Hash;
+    std::string Key;
+    int Level;
+    std::string Data;
+    uLong Size;
+    uLong Crc;
+    std::exception_ptr Error;
+    QFuture<void> Future;
+
+    void Run()
+    {
+        try {
+            Object->WriteDocFile(*Writer);
+            std::string str = Writer->getString();
+            Errors = Writer->getErrors();
+            Writer.reset();
+            Size = static_cast<uLong>(str.size());
+            Crc = crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(str.data()), static_cast<uInt>(str.size()));
+
+            // files with identical data have the same key, see ZipWriter::setDeduplicateFiles()
+            if (Hash) {
+                QCryptographicHash hash(QCryptographicHash::Sha1);
+                hash.addData(str.data(), static_cast<int>(str.size()));
+                std::stringstream key;
+                key << hash.result().toHex().constData() << " " << str.size();
+                Key = key.str();
+            }
+
+            // raw deflate with the settings of zipios::DeflateOutputStreambuf
+            z_stream zs;
+            zs.zalloc = Z_NULL;
+            zs.zfree = Z_NULL;
+            zs.opaque = Z_NULL;
+            if (deflateInit2(&zs, Level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                throw Base::MemoryException();
+            Data.resize(deflateBound(&zs, Size));
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(str.data()));
+            zs.avail_in = static_cast<uInt>(str.size());
+            zs.next_out = reinterpret_cast<Bytef*>(&Data[0]);
+            zs.avail_out = static_cast<uInt>(Data.size());
+            int err = deflate(&zs, Z_FINISH);
+            Data.resize(zs.total_out);
+            deflateEnd(&zs);
+            if (err != Z_STREAM_END)
+                throw Base::RuntimeError("Failed to compress file");
+        }
+        catch (...) {
+            Error = std::current_exception();
+        }
+    }
+};
+
+/// Makes sure no worker accesses a job after the queue is gone, e.g. if an exception is thrown
+struct ZipFileJobQueue : std::deque<ZipFileJob>
+{
+    ~ZipFileJobQueue()
+    {
+        for (iterator it = begin(); it != end(); ++it)
+            it->Future.waitForFinished();
+    }
+};
+}
+
 void ZipWriter::writeFiles(void)
 {
+    std::size_t maxJobs = 4 * std::max(1, QThread::idealThreadCount());
+    auto startJob = [&](ZipFileJobQueue& queue, const FileEntry& entry, bool hash) {
+        queue.emplace_back();
+        ZipFileJob& job = queue.back();
+        job.Object = entry.Object;
+        job.FileName = entry.FileName;
+        job.Writer.reset(new StringWriter());
+        initFileWriter(*job.Writer);
+        job.Hash = hash;
+        job.Level = ZipStream.getLevel();
+        job.Future = QtConcurrent::run(&job, &ZipFileJob::Run);
+    };
+    auto storeJob = [&](ZipFileJob& job) {
+        job.Future.waitForFinished();
+        if (job.Error)
+            std::rethrow_exception(job.Error);
+        for (std::vector<std::string>::iterator it = job.Errors.begin(); it != job.Errors.end(); ++it)
+            addError(*it);
+        ZipStream.putDeflatedEntry(job.FileName, job.Data.data(),
+            static_cast<zipios::uint32>(job.Data.size()),
+            static_cast<zipios::uint32>(job.Size),
+            static_cast<zipios::uint32>(job.Crc));
+        std::string().swap(job.Data);
+    };
+
+    // The files of objects that can share their data are written and hashed by worker threads
+    // first, because the files that are stored only once must be listed before all others. The
+    // compressed data of the unique files is kept until they are stored in their original order.
+    ZipFileJobQueue shared;
+    std::map<std::size_t, ZipFileJob*> prepared;
+    std::set<std::size_t> skipped;
+    if (deduplicate && ZipStream.getMethod() == zipios::DEFLATED) {
+        std::map<std::string, std::string> names;
+        std::stringstream list;
+        std::size_t sharedSize = 0;
+        std::size_t index = 0, count = FileList.size();
+        while (index < count && sharedSize <= maxSharedSize) {
+            std::vector<std::pair<std::size_t, ZipFileJob*> > batch;
+            for (; index < count && batch.size() < maxJobs; index++) {
+                if (FileList[index].Object->canDeduplicateDocFile(*this)) {
+                    startJob(shared, FileList[index], true);
+                    batch.push_back(std::make_pair(index, &shared.back()));
+                }
+            }
+
+            for (std::vector<std::pair<std::size_t, ZipFileJob*> >::iterator it = batch.begin(); it != batch.end(); ++it) {
+                ZipFileJob& job = *it->second;
+                job.Future.waitForFinished();
+                std::map<std::string, std::string>::iterator jt = job.Error ? names.end() : names.find(job.Key);
+                if (jt != names.end()) {
+                    list << job.FileName << '\t' << jt->second << '\n';
+                    skipped.insert(it->first);
+                    std::string().swap(job.Data);
+                }
+                else {
+                    // a failed job rethrows its exception when it's stored
+                    if (!job.Error)
+                        names[job.Key] = job.FileName;
+                    prepared[it->first] = &job;
+                    sharedSize += job.Data.size();
+                }
+            }
+        }
+
+        // XMLReader::readFiles() restores the listed files from the data of the other file
+        if (!skipped.empty()) {
+            ZipStream.putNextEntry("SharedFiles.txt");
+            ZipStream << list.str();
+        }
+    }
+
+    // In parallel mode the files of objects that support it are written to memory buffers
+    // and compressed by worker threads. They are stored in their original order, so at
+    // most a limited number of files wait for being stored.
+    ZipFileJobQueue jobs;
+    bool useJobs = parallel && ZipStream.getMethod() == zipios::DEFLATED;
+
     // use a while loop because it is possible that while
     // processing the files new ones can be added
     size_t index = 0;
-    while (index < FileList.size()) {
-        FileEntry entry = FileList.begin()[index];
-        ZipStream.putNextEntry(entry.FileName);
-        entry.Object->SaveDocFile(*this);
-        index++;
+    while (index < FileList.size() || !jobs.empty()) {
+        if (skipped.find(index) != skipped.end()) {
+            // the data is stored with another file
+            index++;
+            continue;
+        }
+
+        ZipFileJob* ready = 0;
+        bool concurrent = false;
+        if (index < FileList.size()) {
+            std::map<std::size_t, ZipFileJob*>::iterator it = prepared.find(index);
+            if (it != prepared.end())
+                ready = it->second;
+            else if (useJobs)
+                concurrent = FileList[index].Object->canSaveDocFileConcurrently(*this);
+        }
+
+        if (concurrent && jobs.size() < maxJobs) {
+            startJob(jobs, FileList[index], false);
+            index++;
+        }
+        else if (!jobs.empty()) {
+            // store the oldest file if the queue is full or the next file is written directly
+            storeJob(jobs.front());
+            jobs.pop_front();
+        }
+        else if (ready) {
+            storeJob(*ready);
+            index++;
+        }
+        else {
+            FileEntry entry = FileList.begin()[index];
+            ZipStream.putNextEntry(entry.FileName);
+            entry.Object->SaveDocFile(*this);
+            index++;
+        }
     }
 }
 
@@ -120,6 +120,8 @@ public:
 
 protected:
     std::string getUniqueFileName(const char *Name);
+    /// prepare a writer for the data of a file that is written into memory
+    void initFileWriter(Writer &writer);
     struct FileEntry {
         std::string FileName;
         const Base::Persistence *Object;
@@ -157,9 +159,22 @@ public:
     void setComment(const char* str){ZipStream.setComment(str);}
     void setLevel(int level){ZipStream.setLevel( level );}
     void putNextEntry(const char* str){ZipStream.putNextEntry(str);}
+    bool isParallelSave() const {return parallel;}
+    /** Let writeFiles() serialize and compress the files of objects that support it
+     * with several threads. See Persistence::canSaveDocFileConcurrently().
+     */
+    void setParallelSave(bool on){parallel = on;}
+    bool isDeduplicateFiles() const {return deduplicate;}
+    /** Let writeFiles() store files with identical data only once. The entry SharedFiles.txt
+     * lists the files that refer to the data of another one, which XMLReader::readFiles()
+     * needs to restore them. See Persistence::canDeduplicateDocFile().
+     */
+    void setDeduplicateFiles(bool on){deduplicate = on;}
 
 private:
     zipios::ZipOutputStream ZipStream;
+    bool parallel;
+    bool deduplicate;
 };
 
 /** The StringWriter class 
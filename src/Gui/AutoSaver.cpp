@@ -186,6 +186,8 @@ void AutoSaver::saveDocument(const std::string& name, AutoSaveProperty& saver)
 
                     writer.setComment("AutoRecovery file");
                     writer.setLevel(1); // apparently the fastest compression
+                    writer.setParallelSave(hGrp->GetBool("ParallelSave", true));
+                    writer.setDeduplicateFiles(hGrp->GetBool("DeduplicateFiles", false));
                     writer.putNextEntry("Document.xml");
 
                     doc->Save(writer);
@@ -27,20 +27,22 @@
 #include <BRepBuilderAPI_MakeVertex.hxx>
 #include <BRepClass3d_SolidClassifier.hxx>
 #include <BRepGProp_Face.hxx>
+#include <Standard.hxx>
+#include <Standard_Version.hxx>
 #include <TopoDS.hxx>
 #include <TopoDS_Vertex.hxx>
 
-#include <QEventLoop>
 #include <QFuture>
-#include <QFutureWatcher>
-#include <QtConcurrentMap>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <atomic>
+#include <exception>
 
 #include <boost/signals.hpp>
-#include <boost/bind.hpp>
 
 #include <Base/Console.h>
 #include <Base/Exception.h>
-#include <Base/FutureWatcherProgress.h>
 #include <Base/Parameter.h>
 #include <Base/Sequencer.h>
 #include <Base/Tools.h>
@@ -48,6 +50,7 @@
 #include <Mod/Mesh/App/Mesh.h>
 #include <Mod/Mesh/App/MeshFeature.h>
 #include <Mod/Mesh/App/Core/Algorithm.h>
+#include <Mod/Mesh/App/Core/BVH.h>
 #include <Mod/Mesh/App/Core/Grid.h>
 #include <Mod/Mesh/App/Core/Iterator.h>
 #include <Mod/Mesh/App/Core/MeshKernel.h>
@@ -75,10 +78,12 @@ unsigned long InspectActualMesh::countPoints() const
     return this->_count;
 }
 
-Base::Vector3f InspectActualMesh::getPoint(unsigned long index)
+Base::Vector3f InspectActualMesh::getPoint(unsigned long index) const
 {
-    _iter.Set(index);
-    return *_iter;
+    // use a copy of the iterator because this may be called from several threads
+    MeshCore::MeshPointIterator iter(_iter);
+    iter.Set(index);
+    return *iter;
 }
 
 // ----------------------------------------------------------------
@@ -92,7 +97,7 @@ unsigned long InspectActualPoints::countPoints() const
     return _rKernel.size();
 }
 
-Base::Vector3f InspectActualPoints::getPoint(unsigned long index)
+Base::Vector3f InspectActualPoints::getPoint(unsigned long index) const
 {
     Base::Vector3d p = _rKernel.getPoint(index);
     return Base::Vector3f((float)p.x,(float)p.y,(float)p.z);
@@ -118,7 +123,7 @@ unsigned long InspectActualShape::countPoints() const
     return points.size();
 }
 
-Base::Vector3f InspectActualShape::getPoint(unsigned long index)
+Base::Vector3f InspectActualShape::getPoint(unsigned long index) const
 {
     return Base::toVector<float>(points[index]);
 }
@@ -179,7 +184,7 @@ namespace Inspection {
             assert((rulX < _ulCtGridsX) && (rulY < _ulCtGridsY) && (rulZ < _ulCtGridsZ));
         }
 
-        void AddFacet (const MeshCore::MeshGeomFacet &rclFacet, unsigned long ulFacetIndex)
+        void AddFacet (const MeshCore::MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, CellFill &rclFill)
         {
             unsigned long ulX, ulY, ulZ;
             unsigned long ulX1, ulY1, ulZ1, ulX2, ulY2, ulZ2;
@@ -198,19 +203,17 @@ namespace Inspection {
                     for (ulY = ulY1; ulY <= ulY2; ulY++) {
                         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++) {
                             if (rclFacet.IntersectBoundingBox(GetBoundBox(ulX, ulY, ulZ)))
-                                _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+                                AddElement(ulX, ulY, ulZ, ulFacetIndex, rclFill);
                         }
                     }
                 }
             }
             else
-                _aulGrid[ulX1][ulY1][ulZ1].insert(ulFacetIndex);
+                AddElement(ulX1, ulY1, ulZ1, ulFacetIndex, rclFill);
         }
 
         void InitGrid (void)
         {
-            unsigned long i, j;
-
             Base::BoundBox3f clBBMesh = _pclMesh->GetBoundBox().Transformed(_transform);
 
             float fLengthX = clBBMesh.LengthX(); 
@@ -226,25 +229,23 @@ namespace Inspection {
             _fGridLenZ = (1.0f + fLengthZ) / float(_ulCtGridsZ);
             _fMinZ = clBBMesh.MinZ - 0.5f;
 
-            _aulGrid.clear();
-            _aulGrid.resize(_ulCtGridsX);
-            for (i = 0; i < _ulCtGridsX; i++) {
-                _aulGrid[i].resize(_ulCtGridsY);
-                for (j = 0; j < _ulCtGridsY; j++)
-                    _aulGrid[i][j].resize(_ulCtGridsZ);
-            }
+            ClearCells();
         }
 
         void RebuildGrid (void)
         {
             _ulCtElements = _pclMesh->CountFacets();
             InitGrid();
- 
-            unsigned long i = 0;
+            FillCells(_ulCtElements);
+        }
+
+        void AddElements (unsigned long ulBegin, unsigned long ulEnd, CellFill &rclFill)
+        {
             MeshCore::MeshFacetIterator clFIter(*_pclMesh);
             clFIter.Transform(_transform);
-            for (clFIter.Init(); clFIter.More(); clFIter.Next()) {
-                AddFacet(*clFIter, i++);
+            unsigned long i = ulBegin;
+            for (clFIter.Set(ulBegin); i < ulEnd; clFIter.Next()) {
+                AddFacet(*clFIter, i++, rclFill);
             }
         }
 
@@ -253,14 +254,29 @@ namespace Inspection {
     };
 }
 
-InspectNominalMesh::InspectNominalMesh(const Mesh::MeshObject& rMesh, float offset) : _iter(rMesh.getKernel())
+InspectNominalMesh::InspectNominalMesh(const Mesh::MeshObject& rMesh, float offset)
+  : _iter(rMesh.getKernel()), _pGrid(0), _pTree(0)
 {
     const MeshCore::MeshKernel& kernel = rMesh.getKernel();
     _iter.Transform(rMesh.getTransform());
 
+    Base::BoundBox3f box = kernel.GetBoundBox().Transformed(rMesh.getTransform());
+    _box = box;
+    _box.Enlarge(offset);
+
+    // The tree is built in the local system of the mesh. The nearest facet doesn't change
+    // as long as the placement doesn't scale non-uniformly.
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Mesh");
+    if (hGrp->GetBool("UseBVH", false) && rMesh.getTransform().hasScale() >= 0) {
+        _pTree = new MeshCore::MeshFacetBVH(kernel);
+        _inverse = rMesh.getTransform();
+        _inverse.inverseGauss();
+        return;
+    }
+
     // Max. limit of grid elements
     float fMaxGridElements=8000000.0f;
-    Base::BoundBox3f box = kernel.GetBoundBox().Transformed(rMesh.getTransform());
 
     // estimate the minimum allowed grid length
     float fMinGridLen = (float)pow((box.LengthX()*box.LengthY()*box.LengthZ()/fMaxGridElements), 0.3333f);
@@ -274,36 +290,40 @@ InspectNominalMesh::InspectNominalMesh(const Mesh::MeshObject& rMesh, float offs
 
     // build up grid structure to speed up algorithms
     _pGrid = new MeshInspectGrid(kernel, fGridLen, rMesh.getTransform());
-    _box = box;
-    _box.Enlarge(offset);
 }
 
 InspectNominalMesh::~InspectNominalMesh()
 {
     delete this->_pGrid;
+    delete this->_pTree;
 }
 
-float InspectNominalMesh::getDistance(const Base::Vector3f& point)
+float InspectNominalMesh::getDistance(const Base::Vector3f& point) const
 {
     if (!_box.IsInBox(point))
         return FLT_MAX; // must be inside bbox
 
     std::vector<unsigned long> indices;
-    //_pGrid->GetElements(point, indices);
-    if (indices.empty()) {
-        std::set<unsigned long> inds;
-        _pGrid->MeshGrid::SearchNearestFromPoint(point, inds);
-        indices.insert(indices.begin(), inds.begin(), inds.end());
+    if (_pTree) {
+        unsigned long index = _pTree->SearchNearestFromPoint(_inverse * point);
+        if (index != ULONG_MAX)
+            indices.push_back(index);
+    }
+    else {
+        //_pGrid->GetElements(point, indices);
+        _pGrid->MeshGrid::SearchNearestFromPoint(point, indices);
     }
 
+    // use a copy of the iterator because this may be called from several threads
+    MeshCore::MeshFacetIterator iter(_iter);
     float fMinDist=FLT_MAX;
     bool positive = true;
     for (std::vector<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
-        _iter.Set(*it);
-        float fDist = _iter->DistanceToPoint(point);
+        iter.Set(*it);
+        float fDist = iter->DistanceToPoint(point);
         if (fabs(fDist) < fabs(fMinDist)) {
             fMinDist = fDist;
-            positive = point.DistanceToPlane(_iter->_aclPoints[0], _iter->GetNormal()) > 0;
+            positive = point.DistanceToPlane(iter->_aclPoints[0], iter->GetNormal()) > 0;
         }
     }
 
@@ -349,16 +369,14 @@ InspectNominalFastMesh::~InspectNominalFastMesh()
  * This algorithm is not that exact as that from InspectNominalMesh but is by
  * factors faster and sufficient for many cases.
  */
-float InspectNominalFastMesh::getDistance(const Base::Vector3f& point)
+float InspectNominalFastMesh::getDistance(const Base::Vector3f& point) const
 {
     if (!_box.IsInBox(point))
         return FLT_MAX; // must be inside bbox
 
-    std::set<unsigned long> indices;
+    std::vector<unsigned long> indices;
 #if 0 // a point in a neighbour grid can be nearer
-    std::vector<unsigned long> elements;
-    _pGrid->GetElements(point, elements);
-    indices.insert(elements.begin(), elements.end());
+    _pGrid->GetElements(point, indices);
 #else
     unsigned long ulX, ulY, ulZ;
     _pGrid->Position(point, ulX, ulY, ulZ);
@@ -369,14 +387,16 @@ float InspectNominalFastMesh::getDistance(const Base::Vector3f& point)
         _pGrid->GetHull(ulX, ulY, ulZ, ulLevel, indices);
 #endif
 
+    // use a copy of the iterator because this may be called from several threads
+    MeshCore::MeshFacetIterator iter(_iter);
     float fMinDist=FLT_MAX;
     bool positive = true;
-    for (std::set<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
-        _iter.Set(*it);
-        float fDist = _iter->DistanceToPoint(point);
+    for (std::vector<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
+        iter.Set(*it);
+        float fDist = iter->DistanceToPoint(point);
         if (fabs(fDist) < fabs(fMinDist)) {
             fMinDist = fDist;
-            positive = point.DistanceToPlane(_iter->_aclPoints[0], _iter->GetNormal()) > 0;
+            positive = point.DistanceToPlane(iter->_aclPoints[0], iter->GetNormal()) > 0;
         }
     }
 
@@ -399,17 +419,17 @@ InspectNominalPoints::~InspectNominalPoints()
     delete this->_pGrid;
 }
 
-float InspectNominalPoints::getDistance(const Base::Vector3f& point)
+float InspectNominalPoints::getDistance(const Base::Vector3f& point) const
 {
     //TODO: Make faster
-    std::set<unsigned long> indices;
+    std::vector<unsigned long> indices;
     unsigned long x,y,z;
     Base::Vector3d pointd(point.x,point.y,point.z);
     _pGrid->Position(pointd, x, y, z);
     _pGrid->GetElements(x,y,z,indices);
 
     double fMinDist=DBL_MAX;
-    for (std::set<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
+    for (std::vector<unsigned long>::iterator it = indices.begin(); it != indices.end(); ++it) {
         Base::Vector3d pt = _rKernel.getPoint(*it);
         double fDist = Base::Distance(pointd, pt);
         if (fDist < fMinDist) {
@@ -426,37 +446,81 @@ InspectNominalShape::InspectNominalShape(const TopoDS_Shape& shape, float /*radi
     : _rShape(shape)
     , isSolid(false)
 {
-    distss = new BRepExtrema_DistShapeShape();
-    distss->LoadS1(_rShape);
-
     // When having a solid then use its shell because otherwise the distance
     // for inner points will always be zero
     if (!_rShape.IsNull() && _rShape.ShapeType() == TopAbs_SOLID) {
         TopExp_Explorer xp;
         xp.Init(_rShape, TopAbs_SHELL);
         if (xp.More()) {
-           distss->LoadS1(xp.Current());
            isSolid = true;
         }
 
     }
-    //distss->SetDeflection(radius);
+
+    distss.push_back(acquireDistShapeShape());
 }
 
 InspectNominalShape::~InspectNominalShape()
 {
-    delete distss;
+    for (std::vector<BRepExtrema_DistShapeShape*>::iterator it = distss.begin(); it != distss.end(); ++it)
+        delete *it;
+}
+
+BRepExtrema_DistShapeShape* InspectNominalShape::acquireDistShapeShape() const
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (!distss.empty()) {
+            BRepExtrema_DistShapeShape* dist = distss.back();
+            distss.pop_back();
+            return dist;
+        }
+    }
+
+    BRepExtrema_DistShapeShape* dist = new BRepExtrema_DistShapeShape();
+    if (isSolid) {
+        TopExp_Explorer xp;
+        xp.Init(_rShape, TopAbs_SHELL);
+        dist->LoadS1(xp.Current());
+    }
+    else {
+        dist->LoadS1(_rShape);
+    }
+    //dist->SetDeflection(radius);
+    return dist;
+}
+
+void InspectNominalShape::releaseDistShapeShape(BRepExtrema_DistShapeShape* dist) const
+{
+    QMutexLocker locker(&mutex);
+    distss.push_back(dist);
 }
 
-float InspectNominalShape::getDistance(const Base::Vector3f& point)
+float InspectNominalShape::getDistance(const Base::Vector3f& point) const
 {
     gp_Pnt pnt3d(point.x,point.y,point.z);
     BRepBuilderAPI_MakeVertex mkVert(pnt3d);
-    distss->LoadS2(mkVert.Vertex());
+
+    // the algorithm keeps the state of the computation, so each thread uses one of its own
+    BRepExtrema_DistShapeShape* dist = acquireDistShapeShape();
+    try {
+        float fMinDist = getDistance(*dist, mkVert.Vertex(), pnt3d);
+        releaseDistShapeShape(dist);
+        return fMinDist;
+    }
+    catch (...) {
+        releaseDistShapeShape(dist);
+        throw;
+    }
+}
+
+float InspectNominalShape::getDistance(BRepExtrema_DistShapeShape& dist, const TopoDS_Vertex& vertex, const gp_Pnt& pnt3d) const
+{
+    dist.LoadS2(vertex);
 
     float fMinDist=FLT_MAX;
-    if (distss->Perform() && distss->NbSolution() > 0) {
-        fMinDist = (float)distss->Value();
+    if (dist.Perform() && dist.NbSolution() > 0) {
+        fMinDist = (float)dist.Value();
         // the shape is a solid, check if the vertex is inside
         if (isSolid) {
             const Standard_Real tol = 0.001;
@@ -469,12 +533,12 @@ float InspectNominalShape::getDistance(const Base::Vector3f& point)
         }
         else if (fMinDist > 0) {
             // check if the distance was compued from a face
-            for (Standard_Integer index = 1; index <= distss->NbSolution(); index++) {
-                if (distss->SupportTypeShape1(index) == BRepExtrema_IsInFace) {
-                    TopoDS_Shape face = distss->SupportOnShape1(index);
+            for (Standard_Integer index = 1; index <= dist.NbSolution(); index++) {
+                if (dist.SupportTypeShape1(index) == BRepExtrema_IsInFace) {
+                    TopoDS_Shape face = dist.SupportOnShape1(index);
                     Standard_Real u, v;
-                    distss->ParOnFaceS1(index, u, v);
-                    //gp_Pnt pnt = distss->PointOnShape1(index);
+                    dist.ParOnFaceS1(index, u, v);
+                    //gp_Pnt pnt = dist.PointOnShape1(index);
                     BRepGProp_Face props(TopoDS::Face(face));
                     gp_Vec normal;
                     gp_Pnt center;
@@ -639,21 +703,56 @@ unsigned int PropertyDistanceList::getMemSize (void) const
 
 // ----------------------------------------------------------------
 
-// helper class to use Qt's concurrent framework
-struct DistanceInspection
-{
+namespace Inspection {
+// helper class to distribute the inspection of the points over several threads
+class DistanceInspection
+{
+public:
+    DistanceInspection(float radius, const InspectActualGeometry* a,
+                       const std::vector<InspectNominalGeometry*>& n,
+                       std::vector<float>& v)
+        : radius(radius), actual(a), nominal(n), values(v)
+        , numChunks((v.size() + chunkSize - 1) / chunkSize)
+        , nextChunk(0), finishedChunks(0), canceled(false)
+    {
+    }
+
+    std::size_t countChunks() const
+    {
+        return numChunks;
+    }
+    std::size_t countFinishedChunks() const
+    {
+        return finishedChunks;
+    }
+    void cancel()
+    {
+        canceled = true;
+    }
 
-    DistanceInspection(float radius, InspectActualGeometry*  a,
-                       std::vector<InspectNominalGeometry*> n)
-                    : radius(radius), actual(a), nominal(n)
+    /// Inspects the points of the next unprocessed chunk, returns false if there is none
+    bool processChunk()
     {
+        if (canceled)
+            return false;
+        std::size_t chunk = nextChunk++;
+        if (chunk >= numChunks)
+            return false;
+
+        std::size_t end = std::min<std::size_t>((chunk + 1) * chunkSize, values.size());
+        for (std::size_t index = chunk * chunkSize; index < end; index++)
+            values[index] = mapped(index);
+        finishedChunks++;
+        return true;
     }
-    float mapped(unsigned long index)
+
+private:
+    float mapped(unsigned long index) const
     {
         Base::Vector3f pnt = actual->getPoint(index);
 
         float fMinDist=FLT_MAX;
-        for (std::vector<InspectNominalGeometry*>::iterator it = nominal.begin(); it != nominal.end(); ++it) {
+        for (std::vector<InspectNominalGeometry*>::const_iterator it = nominal.begin(); it != nominal.end(); ++it) {
             float fDist = (*it)->getDistance(pnt);
             if (fabs(fDist) < fabs(fMinDist))
                 fMinDist = fDist;
@@ -667,11 +766,39 @@ struct DistanceInspection
         return fMinDist;
     }
 
+private:
+    static const std::size_t chunkSize = 256;
     float radius;
-    InspectActualGeometry*  actual;
-    std::vector<InspectNominalGeometry*> nominal;
+    const InspectActualGeometry*  actual;
+    const std::vector<InspectNominalGeometry*>& nominal;
+    std::vector<float>& values;
+    std::size_t numChunks;
+    std::atomic<std::size_t> nextChunk;
+    std::atomic<std::size_t> finishedChunks;
+    std::atomic<bool> canceled;
 };
 
+// a worker thread of the inspection
+struct DistanceInspectionWorker
+{
+    DistanceInspection* check;
+    std::exception_ptr error;
+    QFuture<void> future;
+
+    void Run()
+    {
+        try {
+            while (check->processChunk()) {
+            }
+        }
+        catch (...) {
+            error = std::current_exception();
+            check->cancel();
+        }
+    }
+};
+}
+
 PROPERTY_SOURCE(Inspection::Feature, App::DocumentObject)
 
 Feature::Feature()
@@ -745,52 +872,51 @@ App::DocumentObjectExecReturn* Feature::execute(void)
             inspectNominal.push_back(nominal);
     }
 
-#if 0 // test with some huge data sets
-    Standard::SetReentrant(Standard_True);
-    std::vector<unsigned long> index(actual->countPoints());
-    std::generate(index.begin(), index.end(), Base::iotaGen<unsigned long>(0));
-    DistanceInspection check(this->SearchRadius.getValue(), actual, inspectNominal);
-    QFuture<float> future = QtConcurrent::mapped
-        (index, boost::bind(&DistanceInspection::mapped, &check, _1));
-    //future.waitForFinished(); // blocks the GUI
-    Base::FutureWatcherProgress progress("Inspecting...", actual->countPoints());
-    QFutureWatcher<float> watcher;
-    QObject::connect(&watcher, SIGNAL(progressValueChanged(int)),
-                     &progress, SLOT(progressValueChanged(int)));
-    watcher.setFuture(future);
-
-    // keep it responsive during computation
-    QEventLoop loop;
-    QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
-    loop.exec();
-
-    std::vector<float> vals;
-    vals.insert(vals.end(), future.begin(), future.end());
-#else
     unsigned long count = actual->countPoints();
+    std::vector<float> vals(count);
+    DistanceInspection check(this->SearchRadius.getValue(), actual, inspectNominal, vals);
+
     std::stringstream str;
     str << "Inspecting " << this->Label.getValue() << "...";
-    Base::SequencerLauncher seq(str.str().c_str(), count);
-
-    std::vector<float> vals(count);
-    for (unsigned long index = 0; index < count; index++) {
-        Base::Vector3f pnt = actual->getPoint(index);
+    Base::SequencerLauncher seq(str.str().c_str(), check.countChunks());
+
+    // The points are inspected in chunks by worker threads and the main thread. Only the
+    // main thread reports the progress, so the user can cancel the inspection.
+    std::vector<DistanceInspectionWorker> workers(std::max(0, QThread::idealThreadCount() - 1));
+#if OCC_VERSION_HEX < 0x070000
+    if (!workers.empty())
+        Standard::SetReentrant(Standard_True);
+#endif
+    for (std::vector<DistanceInspectionWorker>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->check = &check;
+        it->future = QtConcurrent::run(&*it, &DistanceInspectionWorker::Run);
+    }
 
-        float fMinDist=FLT_MAX;
-        for (std::vector<InspectNominalGeometry*>::iterator it = inspectNominal.begin(); it != inspectNominal.end(); ++it) {
-            float fDist = (*it)->getDistance(pnt);
-            if (fabs(fDist) < fabs(fMinDist))
-                fMinDist = fDist;
+    try {
+        std::size_t reported = 0;
+        bool more = true;
+        while (more) {
+            more = check.processChunk();
+            for (; reported < check.countFinishedChunks(); reported++)
+                seq.next(true);
+        }
+        for (std::vector<DistanceInspectionWorker>::iterator it = workers.begin(); it != workers.end(); ++it) {
+            it->future.waitForFinished();
+            for (; reported < check.countFinishedChunks(); reported++)
+                seq.next(true);
+            if (it->error)
+                std::rethrow_exception(it->error);
         }
-
-        if (fMinDist > this->SearchRadius.getValue())
-            fMinDist = FLT_MAX;
-        else if (-fMinDist > this->SearchRadius.getValue())
-            fMinDist = -FLT_MAX;
-        vals[index] = fMinDist;
-        seq.next();
     }
-#endif
+    catch (...) {
+        check.cancel();
+        for (std::vector<DistanceInspectionWorker>::iterator it = workers.begin(); it != workers.end(); ++it)
+            it->future.waitForFinished();
+        delete actual;
+        for (std::vector<InspectNominalGeometry*>::iterator it = inspectNominal.begin(); it != inspectNominal.end(); ++it)
+            delete *it;
+        throw;
+    }
 
     Distances.setValues(vals);
 
@@ -24,6 +24,8 @@
 #ifndef INSPECTION_FEATURE_H
 #define INSPECTION_FEATURE_H
 
+#include <QMutex>
+
 #include <App/DocumentObject.h>
 #include <App/PropertyLinks.h>
 #include <App/DocumentObjectGroup.h>
@@ -32,11 +34,14 @@
 #include <Mod/Points/App/Points.h>
 
 class TopoDS_Shape;
+class TopoDS_Vertex;
+class gp_Pnt;
 class BRepExtrema_DistShapeShape;
 
 namespace MeshCore {
 class MeshKernel;
 class MeshGrid;
+class MeshFacetBVH;
 }
 
 namespace Mesh   { class MeshObject; }
@@ -46,7 +51,9 @@ namespace Part   { class TopoShape;  }
 namespace Inspection
 {
 
-/** Delivers the number of points to be checked and returns the appropriate point to an index. */
+/** Delivers the number of points to be checked and returns the appropriate point to an index.
+ * getPoint() may be called from several threads at the same time.
+ */
 class InspectionExport InspectActualGeometry
 {
 public:
@@ -54,7 +61,7 @@ public:
     virtual ~InspectActualGeometry() {}
     /// Number of points to be checked
     virtual unsigned long countPoints() const = 0;
-    virtual Base::Vector3f getPoint(unsigned long) = 0;
+    virtual Base::Vector3f getPoint(unsigned long) const = 0;
 };
 
 class InspectionExport InspectActualMesh : public InspectActualGeometry
@@ -63,7 +70,7 @@ public:
     InspectActualMesh(const Mesh::MeshObject& rMesh);
     ~InspectActualMesh();
     virtual unsigned long countPoints() const;
-    virtual Base::Vector3f getPoint(unsigned long);
+    virtual Base::Vector3f getPoint(unsigned long) const;
 
 private:
     MeshCore::MeshPointIterator _iter;
@@ -75,7 +82,7 @@ class InspectionExport InspectActualPoints : public InspectActualGeometry
 public:
     InspectActualPoints(const Points::PointKernel&);
     virtual unsigned long countPoints() const;
-    virtual Base::Vector3f getPoint(unsigned long);
+    virtual Base::Vector3f getPoint(unsigned long) const;
 
 private:
     const Points::PointKernel& _rKernel;
@@ -86,20 +93,22 @@ class InspectionExport InspectActualShape : public InspectActualGeometry
 public:
     InspectActualShape(const Part::TopoShape&);
     virtual unsigned long countPoints() const;
-    virtual Base::Vector3f getPoint(unsigned long);
+    virtual Base::Vector3f getPoint(unsigned long) const;
 
 private:
     const Part::TopoShape& _rShape;
     std::vector<Base::Vector3d> points;
 };
 
-/** Calculates the shortest distance of the underlying geometry to a given point. */
+/** Calculates the shortest distance of the underlying geometry to a given point.
+ * getDistance() may be called from several threads at the same time.
+ */
 class InspectionExport InspectNominalGeometry
 {
 public:
     InspectNominalGeometry() {}
     virtual ~InspectNominalGeometry() {}
-    virtual float getDistance(const Base::Vector3f&) = 0;
+    virtual float getDistance(const Base::Vector3f&) const = 0;
 };
 
 class InspectionExport InspectNominalMesh : public InspectNominalGeometry
@@ -107,11 +116,13 @@ class InspectionExport InspectNominalMesh : public InspectNominalGeometry
 public:
     InspectNominalMesh(const Mesh::MeshObject& rMesh, float offset);
     ~InspectNominalMesh();
-    virtual float getDistance(const Base::Vector3f&);
+    virtual float getDistance(const Base::Vector3f&) const;
 
 private:
     MeshCore::MeshFacetIterator _iter;
     MeshCore::MeshGrid* _pGrid;
+    MeshCore::MeshFacetBVH* _pTree;
+    Base::Matrix4D _inverse;
     Base::BoundBox3f _box;
 };
 
@@ -120,7 +131,7 @@ class InspectionExport InspectNominalFastMesh : public InspectNominalGeometry
 public:
     InspectNominalFastMesh(const Mesh::MeshObject& rMesh, float offset);
     ~InspectNominalFastMesh();
-    virtual float getDistance(const Base::Vector3f&);
+    virtual float getDistance(const Base::Vector3f&) const;
 
 protected:
     MeshCore::MeshFacetIterator _iter;
@@ -134,7 +145,7 @@ class InspectionExport InspectNominalPoints : public InspectNominalGeometry
 public:
     InspectNominalPoints(const Points::PointKernel&, float offset);
     ~InspectNominalPoints();
-    virtual float getDistance(const Base::Vector3f&);
+    virtual float getDistance(const Base::Vector3f&) const;
 
 private:
     const Points::PointKernel& _rKernel;
@@ -146,10 +157,17 @@ class InspectionExport InspectNominalShape : public InspectNominalGeometry
 public:
     InspectNominalShape(const TopoDS_Shape&, float offset);
     ~InspectNominalShape();
-    virtual float getDistance(const Base::Vector3f&);
+    virtual float getDistance(const Base::Vector3f&) const;
+
+private:
+    float getDistance(BRepExtrema_DistShapeShape&, const TopoDS_Vertex&, const gp_Pnt&) const;
+    BRepExtrema_DistShapeShape* acquireDistShapeShape() const;
+    void releaseDistShapeShape(BRepExtrema_DistShapeShape*) const;
 
 private:
-    BRepExtrema_DistShapeShape* distss;
+    /// Algorithms that are currently unused, each thread needs one of its own
+    mutable std::vector<BRepExtrema_DistShapeShape*> distss;
+    mutable QMutex mutex;
     const TopoDS_Shape& _rShape;
     bool isSolid;
 };
@@ -32,6 +32,7 @@
 #include "Elements.h"
 #include "Iterator.h"
 #include "Grid.h"
+#include "BVH.h"
 #include "Triangulation.h"
 
 #include <Base/Console.h>
@@ -140,6 +141,12 @@ bool MeshAlgorithm::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::
     return false;
 }
 
+bool MeshAlgorithm::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const MeshFacetBVH &rclTree,
+                                       Base::Vector3f &rclRes, unsigned long &rulFacet) const
+{
+    return rclTree.NearestFacetOnRay(rclPt, rclDir, rclRes, rulFacet);
+}
+
 bool MeshAlgorithm::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const std::vector<unsigned long> &raulFacets,
                                        Base::Vector3f &rclRes, unsigned long &rulFacet) const
 {
@@ -1412,6 +1419,26 @@ bool MeshAlgorithm::NearestPointFromPoint (const Base::Vector3f &rclPt, const Me
   return true;
 }
 
+bool MeshAlgorithm::NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetBVH& rclTree, unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const
+{
+  return NearestPointFromPoint(rclPt, rclTree, FLOAT_MAX, rclResFacetIndex, rclResPoint);
+}
+
+bool MeshAlgorithm::NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetBVH& rclTree, float fMaxSearchArea,
+                                           unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const
+{
+  unsigned long ulInd = rclTree.SearchNearestFromPoint(rclPt, fMaxSearchArea);
+
+  if (ulInd == ULONG_MAX)
+    return false;  // no facets inside search area
+
+  MeshGeomFacet rclSFacet = _rclMesh.GetFacet(ulInd);
+  rclSFacet.DistanceToPoint(rclPt, rclResPoint);
+  rclResFacetIndex = ulInd;
+
+  return true;
+}
+
 bool MeshAlgorithm::CutWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const MeshFacetGrid &rclGrid,
                                   std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps, bool bConnectPolygons) const
 {
@@ -1430,10 +1457,30 @@ bool MeshAlgorithm::CutWithPlane (const Base::Vector3f &clBase, const Base::Vect
   std::sort(aulFacets.begin(), aulFacets.end());
   aulFacets.erase(std::unique(aulFacets.begin(), aulFacets.end()), aulFacets.end());  
 
+  return CutFacetsWithPlane(clBase, clNormal, aulFacets, rclResult, fMinEps, bConnectPolygons);
+}
+
+bool MeshAlgorithm::CutWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const MeshFacetBVH &rclTree,
+                                  std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps, bool bConnectPolygons) const
+{
+  std::vector<unsigned long> aulFacets;
+  rclTree.Select([&](const Base::BoundBox3f& rclBox) {
+    return rclBox.IsCutPlane(clBase, clNormal);
+  }, aulFacets);
+
+  // keep the order of the grid based search
+  std::sort(aulFacets.begin(), aulFacets.end());
+
+  return CutFacetsWithPlane(clBase, clNormal, aulFacets, rclResult, fMinEps, bConnectPolygons);
+}
+
+bool MeshAlgorithm::CutFacetsWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const std::vector<unsigned long> &aulFacets,
+                                        std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps, bool bConnectPolygons) const
+{
   // alle Facets mit Ebene schneiden
   std::list<std::pair<Base::Vector3f, Base::Vector3f> > clTempPoly;  // Feld mit Schnittlinien (unsortiert, nicht verkettet)
 
-  for (std::vector<unsigned long>::iterator pF = aulFacets.begin(); pF != aulFacets.end(); ++pF)
+  for (std::vector<unsigned long>::const_iterator pF = aulFacets.begin(); pF != aulFacets.end(); ++pF)
   {
     Base::Vector3f  clE1, clE2;
     const MeshGeomFacet clF(_rclMesh.GetFacet(*pF));
@@ -1669,7 +1716,7 @@ bool MeshAlgorithm::Distance (const Base::Vector3f &rclPt, unsigned long ulFacet
 {
   const MeshFacetArray &rclFAry = _rclMesh._aclFacetArray;
   const MeshPointArray &rclPAry = _rclMesh._aclPointArray;
-  const unsigned long *pulIdx = rclFAry[ulFacetIdx]._aulPoints;
+  const MeshIndex *pulIdx = rclFAry[ulFacetIdx]._aulPoints;
 
   BoundBox3f clBB;
   clBB.Add(rclPAry[*(pulIdx++)]);
@@ -45,6 +45,7 @@ class MeshGeomFacet;
 class MeshGeomEdge;
 class MeshKernel;
 class MeshFacetGrid;
+class MeshFacetBVH;
 class MeshFacetArray;
 class MeshRefPointToFacets;
 class AbstractPolygonTriangulator;
@@ -100,6 +101,17 @@ public:
    */
   bool NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, float fMaxSearchArea,
                           const MeshFacetGrid &rclGrid, Base::Vector3f &rclRes, unsigned long &rulFacet) const;
+  /**
+   * Searches for the nearest facet to the ray defined by
+   * (\a rclPt, \a rclDir).
+   * The point \a rclRes holds the intersection point with the ray and the
+   * nearest facet with index \a rulFacet.
+   * \note This method is optimized by using a bounding volume hierarchy. It gives
+   * the same result as the version without grid and stays fast for meshes with
+   * very different facet sizes.
+   */
+  bool NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const MeshFacetBVH &rclTree,
+                          Base::Vector3f &rclRes, unsigned long &rulFacet) const;
   /**
    * Searches for the first facet of the grid element (\a rclGrid) in that the point \a rclPt lies into which is a distance not
    * higher than \a fMaxDistance. Of no such facet is found \a rulFacet is undefined and false is returned, otherwise true.
@@ -276,9 +288,16 @@ public:
                               unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
   bool NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetGrid& rclGrid, float fMaxSearchArea,
                               unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
+  bool NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetBVH& rclTree,
+                              unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
+  bool NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetBVH& rclTree, float fMaxSearchArea,
+                              unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
   /** Cuts the mesh with a plane. The result is a list of polylines. */
   bool CutWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const MeshFacetGrid &rclGrid,
                      std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps = 1.0e-2f, bool bConnectPolygons = false) const;
+  /** Cuts the mesh with a plane using a bounding volume hierarchy. The result is the same as with a grid. */
+  bool CutWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const MeshFacetBVH &rclTree,
+                     std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps = 1.0e-2f, bool bConnectPolygons = false) const;
   /** 
    * Gets all facets that cut the plane (N,d) and that lie between the two points left and right. 
    * The plane is defined by it normalized normal and the signed distance to the origin.
@@ -302,6 +321,9 @@ protected:
                     float fMinEps) const;
   bool ConnectPolygons(std::list<std::vector<Base::Vector3f> > &clPolyList, std::list<std::pair<Base::Vector3f,
                        Base::Vector3f> > &rclLines) const;
+  /** Cuts the sorted facets \a raulFacets with a plane. The result is a list of polylines. */
+  bool CutFacetsWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const std::vector<unsigned long> &raulFacets,
+                           std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps, bool bConnectPolygons) const;
   /** Searches the nearest facet in \a raulFacets to the ray (\a rclPt, \a rclDir). */
   bool RayNearestField (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const std::vector<unsigned long> &raulFacets,
                         Base::Vector3f &rclRes, unsigned long &rulFacet, float fMaxAngle = F_PI) const;
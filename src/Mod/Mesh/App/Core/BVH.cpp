@@ -0,0 +1,414 @@
+/***************************************************************************
+ *   Copyright (c) 2026 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+#ifndef _PreComp_
+# include <algorithm>
+# include <climits>
+#endif
+
+#include "BVH.h"
+#include "MeshKernel.h"
+
+using namespace MeshCore;
+
+#define MESH_BVH_BINS     16 // Number of bins to evaluate the split costs
+#define MESH_BVH_MAX_LEAF 4  // Maximum number of facets of a leaf
+
+namespace {
+
+// Half the surface area of a box, the SAH only needs relative values
+float HalfArea (const Base::BoundBox3f& rBox)
+{
+    float dx = rBox.LengthX(), dy = rBox.LengthY(), dz = rBox.LengthZ();
+    return dx * dy + dy * dz + dz * dx;
+}
+
+// Checks whether the line through rPt with the inverse direction rInv hits the box.
+// In this case rT is the smallest absolute line parameter inside the box.
+bool LineHitsBox (const Base::BoundBox3f& rBox, const Base::Vector3f& rPt, const Base::Vector3f& rInv, float& rT)
+{
+    float t0 = -FLOAT_MAX, t1 = FLOAT_MAX;
+    float ta, tb;
+
+    // a NaN from a zero direction and a point on the plane is ignored by min/max
+    ta = (rBox.MinX - rPt.x) * rInv.x; tb = (rBox.MaxX - rPt.x) * rInv.x;
+    if (ta > tb) std::swap(ta, tb);
+    t0 = std::max<float>(t0, ta); t1 = std::min<float>(t1, tb);
+
+    ta = (rBox.MinY - rPt.y) * rInv.y; tb = (rBox.MaxY - rPt.y) * rInv.y;
+    if (ta > tb) std::swap(ta, tb);
+    t0 = std::max<float>(t0, ta); t1 = std::min<float>(t1, tb);
+
+    ta = (rBox.MinZ - rPt.z) * rInv.z; tb = (rBox.MaxZ - rPt.z) * rInv.z;
+    if (ta > tb) std::swap(ta, tb);
+    t0 = std::max<float>(t0, ta); t1 = std::min<float>(t1, tb);
+
+    if (t0 > t1)
+        return false;
+    if (t0 > 0.0f)
+        rT = t0;
+    else if (t1 < 0.0f)
+        rT = -t1;
+    else
+        rT = 0.0f;
+    return true;
+}
+
+// Squared distance between a point and a box, zero if the point is inside
+float DistanceP2 (const Base::BoundBox3f& rBox, const Base::Vector3f& rPt)
+{
+    float dx = std::max<float>(std::max<float>(rBox.MinX - rPt.x, rPt.x - rBox.MaxX), 0.0f);
+    float dy = std::max<float>(std::max<float>(rBox.MinY - rPt.y, rPt.y - rBox.MaxY), 0.0f);
+    float dz = std::max<float>(std::max<float>(rBox.MinZ - rPt.z, rPt.z - rBox.MaxZ), 0.0f);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+struct BuildItem
+{
+    unsigned long ulParent; // ULONG_MAX for the root and for first children
+    unsigned long ulBegin;
+    unsigned long ulEnd;
+    int           iDepth;
+};
+
+struct CenterLess
+{
+    const std::vector<Base::Vector3f>& centers;
+    int axis;
+    float split;
+    CenterLess(const std::vector<Base::Vector3f>& c, int a, float s) : centers(c), axis(a), split(s) {}
+    bool operator()(unsigned long i) const
+    { return centers[i][axis] < split; }
+};
+
+}
+
+MeshFacetBVH::MeshFacetBVH (const MeshKernel &rclM)
+  : _rclMesh(rclM), _ulCtElements(0)
+{
+    Rebuild();
+}
+
+MeshFacetBVH::~MeshFacetBVH ()
+{
+}
+
+void MeshFacetBVH::Validate ()
+{
+    if (_rclMesh.CountFacets() != _ulCtElements)
+        Rebuild();
+}
+
+Base::BoundBox3f MeshFacetBVH::GetBoundBox () const
+{
+    if (_aclNodes.empty())
+        return Base::BoundBox3f();
+    return _aclNodes.front().clBox;
+}
+
+void MeshFacetBVH::Rebuild ()
+{
+    const MeshPointArray& rPoints = _rclMesh.GetPoints();
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    unsigned long ulCtFacets = rFacets.size();
+
+    _ulCtElements = ulCtFacets;
+    _aclNodes.clear();
+    _aulFacets.resize(ulCtFacets);
+    _aclFacetBoxes.clear();
+    if (ulCtFacets == 0)
+        return;
+
+    // the boxes are slightly enlarged so that flat, axis-aligned facets are not missed by rounding errors
+    float fEps = 1.0e-6f * _rclMesh.GetBoundBox().CalcDiagonalLength();
+
+    std::vector<Base::BoundBox3f> aclBoxes(ulCtFacets);
+    std::vector<Base::Vector3f> aclCenters(ulCtFacets);
+    for (unsigned long i = 0; i < ulCtFacets; i++) {
+        const MeshFacet& rFacet = rFacets[i];
+        Base::BoundBox3f& rBox = aclBoxes[i];
+        rBox.Add(rPoints[rFacet._aulPoints[0]]);
+        rBox.Add(rPoints[rFacet._aulPoints[1]]);
+        rBox.Add(rPoints[rFacet._aulPoints[2]]);
+        rBox.Enlarge(fEps);
+        aclCenters[i] = rBox.GetCenter();
+        _aulFacets[i] = i;
+    }
+
+    _aclNodes.reserve(2 * ulCtFacets / MESH_BVH_MAX_LEAF + 1);
+
+    std::vector<BuildItem> aclStack;
+    BuildItem root = { ULONG_MAX, 0, ulCtFacets, 0 };
+    aclStack.push_back(root);
+    while (!aclStack.empty()) {
+        BuildItem item = aclStack.back();
+        aclStack.pop_back();
+
+        unsigned long ulNode = _aclNodes.size();
+        if (item.ulParent != ULONG_MAX)
+            _aclNodes[item.ulParent].ulIndex = ulNode;
+        _aclNodes.push_back(Node());
+
+        Base::BoundBox3f clBox, clCenterBox;
+        for (unsigned long i = item.ulBegin; i < item.ulEnd; i++) {
+            clBox.Add(aclBoxes[_aulFacets[i]]);
+            clCenterBox.Add(aclCenters[_aulFacets[i]]);
+        }
+
+        Node& rNode = _aclNodes.back();
+        rNode.clBox = clBox;
+        rNode.ulIndex = item.ulBegin;
+        rNode.ulCount = item.ulEnd - item.ulBegin;
+
+        // the query stacks hold one entry per level
+        if (rNode.ulCount <= 1 || item.iDepth >= MESH_BVH_MAX_DEPTH - 2)
+            continue;
+
+        // split along the longest axis of the centers
+        int iAxis = 0;
+        float fExtent = clCenterBox.LengthX();
+        if (clCenterBox.LengthY() > fExtent) { iAxis = 1; fExtent = clCenterBox.LengthY(); }
+        if (clCenterBox.LengthZ() > fExtent) { iAxis = 2; fExtent = clCenterBox.LengthZ(); }
+        if (fExtent <= 0.0f)
+            continue; // all centers coincide
+        float fMin = iAxis == 0 ? clCenterBox.MinX : (iAxis == 1 ? clCenterBox.MinY : clCenterBox.MinZ);
+        float fScale = float(MESH_BVH_BINS) / fExtent;
+
+        Base::BoundBox3f aclBinBoxes[MESH_BVH_BINS];
+        unsigned long aulBinCounts[MESH_BVH_BINS] = {0};
+        for (unsigned long i = item.ulBegin; i < item.ulEnd; i++) {
+            unsigned long ulFacet = _aulFacets[i];
+            int iBin = std::min<int>(MESH_BVH_BINS - 1, int((aclCenters[ulFacet][iAxis] - fMin) * fScale));
+            aulBinCounts[iBin]++;
+            aclBinBoxes[iBin].Add(aclBoxes[ulFacet]);
+        }
+
+        // costs of all splits between two bins, sweeping from the right first
+        float afRightCost[MESH_BVH_BINS];
+        Base::BoundBox3f clRight;
+        unsigned long ulRight = 0;
+        for (int b = MESH_BVH_BINS - 1; b > 0; b--) {
+            if (aulBinCounts[b] > 0)
+                clRight.Add(aclBinBoxes[b]);
+            ulRight += aulBinCounts[b];
+            afRightCost[b] = ulRight > 0 ? HalfArea(clRight) * float(ulRight) : 0.0f;
+        }
+
+        int iBestSplit = -1;
+        float fBestCost = FLOAT_MAX;
+        Base::BoundBox3f clLeft;
+        unsigned long ulLeft = 0;
+        for (int b = 0; b < MESH_BVH_BINS - 1; b++) {
+            if (aulBinCounts[b] > 0)
+                clLeft.Add(aclBinBoxes[b]);
+            ulLeft += aulBinCounts[b];
+            if (ulLeft == 0 || ulLeft == rNode.ulCount)
+                continue;
+            float fCost = HalfArea(clLeft) * float(ulLeft) + afRightCost[b + 1];
+            if (fCost < fBestCost) {
+                fBestCost = fCost;
+                iBestSplit = b;
+            }
+        }
+
+        if (iBestSplit < 0)
+            continue;
+
+        // a traversal step costs about as much as one facet test
+        float fArea = HalfArea(clBox);
+        float fLeafCost = float(rNode.ulCount);
+        float fSplitCost = 1.0f + (fArea > 0.0f ? fBestCost / fArea : 0.0f);
+        if (rNode.ulCount <= MESH_BVH_MAX_LEAF && fLeafCost <= fSplitCost)
+            continue;
+
+        float fSplit = fMin + float(iBestSplit + 1) / fScale;
+        std::vector<unsigned long>::iterator itMid = std::partition(
+            _aulFacets.begin() + item.ulBegin, _aulFacets.begin() + item.ulEnd,
+            CenterLess(aclCenters, iAxis, fSplit));
+        unsigned long ulMid = itMid - _aulFacets.begin();
+        if (ulMid == item.ulBegin || ulMid == item.ulEnd)
+            ulMid = (item.ulBegin + item.ulEnd) / 2; // rounding of the bin border
+
+        rNode.ulCount = 0;
+
+        // the first child is built next so that it follows its parent
+        BuildItem second = { ulNode, ulMid, item.ulEnd, item.iDepth + 1 };
+        BuildItem first = { ULONG_MAX, item.ulBegin, ulMid, item.iDepth + 1 };
+        aclStack.push_back(second);
+        aclStack.push_back(first);
+    }
+
+    _aclFacetBoxes.resize(ulCtFacets);
+    for (unsigned long i = 0; i < ulCtFacets; i++)
+        _aclFacetBoxes[i] = aclBoxes[_aulFacets[i]];
+}
+
+bool MeshFacetBVH::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, Base::Vector3f &rclRes,
+                                      unsigned long &rulFacet, float fMaxAngle) const
+{
+    float fDirLen = rclDir.Length();
+    if (_aclNodes.empty() || fDirLen == 0.0f)
+        return false;
+
+    Base::Vector3f clInv(1.0f / rclDir.x, 1.0f / rclDir.y, 1.0f / rclDir.z);
+    Base::Vector3f clRes;
+    float fMinDist = FLOAT_MAX;
+    unsigned long ulInd = ULONG_MAX;
+
+    float fT;
+    if (!LineHitsBox(_aclNodes[0].clBox, rclPt, clInv, fT))
+        return false;
+
+    std::pair<unsigned long, float> aclStack[MESH_BVH_MAX_DEPTH];
+    int iTop = 0;
+    aclStack[iTop++] = std::make_pair(0ul, fT * fDirLen);
+    while (iTop > 0) {
+        std::pair<unsigned long, float> top = aclStack[--iTop];
+        if (top.second > fMinDist)
+            continue;
+
+        const Node& rNode = _aclNodes[top.first];
+        if (rNode.ulCount > 0) {
+            for (unsigned long i = rNode.ulIndex; i < rNode.ulIndex + rNode.ulCount; i++) {
+                if (!LineHitsBox(_aclFacetBoxes[i], rclPt, clInv, fT) || fT * fDirLen > fMinDist)
+                    continue;
+                unsigned long ulFacet = _aulFacets[i];
+                if (_rclMesh.GetFacet(ulFacet).Foraminate(rclPt, rclDir, clRes, fMaxAngle)) {
+                    // on equal distance take the lower index like the search without tree does
+                    float fDist = (clRes - rclPt).Length();
+                    if (fDist < fMinDist || (fDist == fMinDist && ulFacet < ulInd)) {
+                        fMinDist = fDist;
+                        ulInd = ulFacet;
+                        rclRes = clRes;
+                    }
+                }
+            }
+        }
+        else {
+            // visit the nearer child first
+            unsigned long ulFirst = top.first + 1, ulSecond = rNode.ulIndex;
+            float fFirst, fSecond;
+            bool bFirst = LineHitsBox(_aclNodes[ulFirst].clBox, rclPt, clInv, fFirst);
+            bool bSecond = LineHitsBox(_aclNodes[ulSecond].clBox, rclPt, clInv, fSecond);
+            if (bFirst && bSecond && fSecond < fFirst) {
+                std::swap(ulFirst, ulSecond);
+                std::swap(fFirst, fSecond);
+            }
+            else if (!bFirst) {
+                ulFirst = ulSecond;
+                fFirst = fSecond;
+                bFirst = bSecond;
+                bSecond = false;
+            }
+            if (bSecond)
+                aclStack[iTop++] = std::make_pair(ulSecond, fSecond * fDirLen);
+            if (bFirst)
+                aclStack[iTop++] = std::make_pair(ulFirst, fFirst * fDirLen);
+        }
+    }
+
+    if (ulInd == ULONG_MAX)
+        return false;
+    rulFacet = ulInd;
+    return true;
+}
+
+unsigned long MeshFacetBVH::SearchNearestFromPoint (const Base::Vector3f &rclPt) const
+{
+    return SearchNearestFromPoint(rclPt, FLOAT_MAX);
+}
+
+unsigned long MeshFacetBVH::SearchNearestFromPoint (const Base::Vector3f &rclPt, float fMaxSearchArea) const
+{
+    if (_aclNodes.empty())
+        return ULONG_MAX;
+
+    float fMinDist = fMaxSearchArea;
+    float fMinDist2 = fMaxSearchArea < 1.0e15f ? fMaxSearchArea * fMaxSearchArea : FLOAT_MAX;
+    unsigned long ulInd = ULONG_MAX;
+
+    std::pair<unsigned long, float> aclStack[MESH_BVH_MAX_DEPTH];
+    int iTop = 0;
+    aclStack[iTop++] = std::make_pair(0ul, DistanceP2(_aclNodes[0].clBox, rclPt));
+    while (iTop > 0) {
+        std::pair<unsigned long, float> top = aclStack[--iTop];
+        if (top.second > fMinDist2)
+            continue;
+
+        const Node& rNode = _aclNodes[top.first];
+        if (rNode.ulCount > 0) {
+            for (unsigned long i = rNode.ulIndex; i < rNode.ulIndex + rNode.ulCount; i++) {
+                if (DistanceP2(_aclFacetBoxes[i], rclPt) > fMinDist2)
+                    continue;
+                unsigned long ulFacet = _aulFacets[i];
+                float fDist = _rclMesh.GetFacet(ulFacet).DistanceToPoint(rclPt);
+                // on equal distance take the lower index like the search without tree does
+                if (fDist < fMinDist || (fDist == fMinDist && ulFacet < ulInd)) {
+                    fMinDist = fDist;
+                    fMinDist2 = fDist * fDist;
+                    ulInd = ulFacet;
+                }
+            }
+        }
+        else {
+            // visit the nearer child first
+            unsigned long ulFirst = top.first + 1, ulSecond = rNode.ulIndex;
+            float fFirst = DistanceP2(_aclNodes[ulFirst].clBox, rclPt);
+            float fSecond = DistanceP2(_aclNodes[ulSecond].clBox, rclPt);
+            if (fSecond < fFirst) {
+                std::swap(ulFirst, ulSecond);
+                std::swap(fFirst, fSecond);
+            }
+            aclStack[iTop++] = std::make_pair(ulSecond, fSecond);
+            aclStack[iTop++] = std::make_pair(ulFirst, fFirst);
+        }
+    }
+
+    return ulInd;
+}
+
+namespace {
+struct BoxIntersects
+{
+    const Base::BoundBox3f& box;
+    BoxIntersects(const Base::BoundBox3f& b) : box(b) {}
+    bool operator()(const Base::BoundBox3f& rBox) const
+    { return box && rBox; }
+};
+}
+
+unsigned long MeshFacetBVH::Inside (const Base::BoundBox3f &rclBB, std::vector<unsigned long> &raulFacets) const
+{
+    std::size_t ulStart = raulFacets.size();
+    Select(BoxIntersects(rclBB), raulFacets);
+
+    // keep only facets that really touch the box
+    std::vector<unsigned long>::iterator itOut = raulFacets.begin() + ulStart;
+    for (std::vector<unsigned long>::iterator it = itOut; it != raulFacets.end(); ++it) {
+        if (_rclMesh.GetFacet(*it).ContainedByOrIntersectBoundingBox(rclBB))
+            *itOut++ = *it;
+    }
+    raulFacets.erase(itOut, raulFacets.end());
+    return raulFacets.size() - ulStart;
+}
@@ -0,0 +1,142 @@
+/***************************************************************************
+ *   Copyright (c) 2026 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_BVH_H
+#define MESH_BVH_H
+
+#include <vector>
+
+#include "Elements.h"
+#include <Base/BoundBox.h>
+#include <Base/Vector3D.h>
+
+#define MESH_BVH_MAX_DEPTH 64 // Maximum depth of the tree
+
+namespace MeshCore
+{
+
+class MeshKernel;
+
+/**
+ * The MeshFacetBVH class is a bounding volume hierarchy over the facets of a mesh.
+ * It can be used instead of a MeshFacetGrid for ray, distance and box queries. Unlike
+ * the uniform grid it adapts to the distribution of the facets, so it stays fast for
+ * meshes that mix very large and very small facets, like tessellations of CAD models.
+ *
+ * The tree is built with the surface area heuristic (SAH). All queries are const and
+ * can be run from several threads at the same time.
+ */
+class MeshExport MeshFacetBVH
+{
+public:
+    /// Construction, builds the tree for the facets of \a rclM
+    MeshFacetBVH (const MeshKernel &rclM);
+    /// Destruction
+    ~MeshFacetBVH ();
+
+    /** Rebuilds the tree. */
+    void Rebuild ();
+    /** Rebuilds the tree if the number of facets of the mesh has changed. */
+    void Validate ();
+    /** Returns the bounding box of all facets. */
+    Base::BoundBox3f GetBoundBox () const;
+
+    /** @name Search */
+    //@{
+    /**
+     * Searches for the nearest facet to the ray defined by (\a rclPt, \a rclDir).
+     * As with MeshAlgorithm::NearestFacetOnRay() the ray is treated as a line, so intersections
+     * behind \a rclPt are found, too. The point \a rclRes holds the intersection point and
+     * \a rulFacet the index of the facet. Facets whose normal has an angle higher than
+     * \a fMaxAngle to \a rclDir are ignored.
+     */
+    bool NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, Base::Vector3f &rclRes,
+                            unsigned long &rulFacet, float fMaxAngle = F_PI) const;
+    /** Searches for the nearest facet from a point. ULONG_MAX is returned for an empty mesh. */
+    unsigned long SearchNearestFromPoint (const Base::Vector3f &rclPt) const;
+    /** Searches for the nearest facet from a point with a distance not higher than \a fMaxSearchArea.
+     * If there is no such facet ULONG_MAX is returned. */
+    unsigned long SearchNearestFromPoint (const Base::Vector3f &rclPt, float fMaxSearchArea) const;
+    /** Appends the indices of all facets that intersect or lie inside the box \a rclBB and returns
+     * their number. */
+    unsigned long Inside (const Base::BoundBox3f &rclBB, std::vector<unsigned long> &raulFacets) const;
+    /** Appends the indices of all facets whose bounding box passes \a pred. The predicate is called with
+     * the bounding boxes of the nodes and of the facets and must accept each box that contains an
+     * accepted box. Returns the number of appended facets. */
+    template <class BoxPredicate>
+    unsigned long Select (BoxPredicate pred, std::vector<unsigned long> &raulFacets) const;
+    //@}
+
+private:
+    /** A node of the tree. Inner nodes have their first child directly after them. */
+    struct Node
+    {
+        Base::BoundBox3f clBox;   /**< Bounding box of all facets below the node. */
+        unsigned long    ulIndex; /**< First facet of a leaf, second child of an inner node. */
+        unsigned long    ulCount; /**< Number of facets of a leaf, 0 for inner nodes. */
+    };
+
+    std::vector<Node>             _aclNodes;     /**< The nodes in depth-first order. */
+    std::vector<unsigned long>    _aulFacets;    /**< Facet indices in the order of the leaves. */
+    std::vector<Base::BoundBox3f> _aclFacetBoxes;/**< Bounding boxes of the facets in the order of the leaves. */
+    const MeshKernel&             _rclMesh;      /**< The mesh kernel. */
+    unsigned long                 _ulCtElements; /**< Number of facets for validation issues. */
+
+    // no copying
+    MeshFacetBVH (const MeshFacetBVH&);
+    void operator= (const MeshFacetBVH&);
+};
+
+template <class BoxPredicate>
+unsigned long MeshFacetBVH::Select (BoxPredicate pred, std::vector<unsigned long> &raulFacets) const
+{
+    std::size_t ulCount = raulFacets.size();
+    if (_aclNodes.empty())
+        return 0;
+
+    unsigned long aulStack[MESH_BVH_MAX_DEPTH];
+    int iTop = 0;
+    aulStack[iTop++] = 0;
+    while (iTop > 0) {
+        const Node& rNode = _aclNodes[aulStack[--iTop]];
+        if (!pred(rNode.clBox))
+            continue;
+        if (rNode.ulCount > 0) {
+            for (unsigned long i = rNode.ulIndex; i < rNode.ulIndex + rNode.ulCount; i++) {
+                if (pred(_aclFacetBoxes[i]))
+                    raulFacets.push_back(_aulFacets[i]);
+            }
+        }
+        else {
+            aulStack[iTop++] = rNode.ulIndex;
+            aulStack[iTop++] = static_cast<unsigned long>(&rNode - &_aclNodes[0]) + 1;
+        }
+    }
+
+    return raulFacets.size() - ulCount;
+}
+
+} // namespace MeshCore
+
+
+#endif  // MESH_BVH_H
@@ -25,6 +25,8 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <climits>
+# include <cstring>
 #endif
 
 #include <Base/Sequencer.h>
@@ -32,8 +34,9 @@
 
 #include "Builder.h"
 #include "MeshKernel.h"
-#include "Functional.h"
-#include <QVector>
+#include "MeshIO.h"
+#include <QThread>
+#include <QtConcurrentMap>
 
 using namespace MeshCore;
 
@@ -258,30 +261,224 @@ void MeshBuilder::Finish (bool freeMemory)
 
 // ----------------------------------------------------------------------------
 
-struct MeshFastBuilder::Private {
-    struct Vertex
+namespace MeshCore {
+
+/**
+ * Merges equal points of a facet list. The points are distributed over a number of shards
+ * by their hash value and every shard gets its own hash table, so the tables can be filled
+ * by several threads without locking. The merged points are numbered in the order of their
+ * first occurrence, so the result doesn't depend on the number of threads.
+ */
+class MeshPointWelder
+{
+public:
+    MeshPointWelder(const std::vector<Base::Vector3f>& points)
+      : _points(points)
     {
-        Vertex() : x(0), y(0), z(0), i(0) {}
-        Vertex(float x, float y, float z) : x(x), y(y), z(z), i(0) {}
+    }
 
-        float x, y, z;
-        size_t i;
+    /**
+     * Sets for each point the index of its merged point and returns the number of merged points.
+     */
+    unsigned long Weld(std::vector<unsigned long>& indices)
+    {
+        unsigned long ulCtPts = _points.size();
+        unsigned long ulThreads = std::max<int>(1, QThread::idealThreadCount());
+        ulThreads = std::max<unsigned long>(1, std::min<unsigned long>(ulThreads, ulCtPts / MinPointsPerThread));
+        _ulShardBits = ulThreads > 1 ? 6 : 0;
+        unsigned long ulCtShards = 1ul << _ulShardBits;
+
+        _hashes.resize(ulCtPts);
+        _order.resize(ulCtPts);
+        _first.resize(ulCtPts);
+
+        std::vector<Range> ranges(ulThreads);
+        unsigned long ulStep = ulCtPts / ulThreads;
+        for (unsigned long t = 0; t < ulThreads; t++) {
+            ranges[t].welder = this;
+            ranges[t].begin = t * ulStep;
+            ranges[t].end = (t + 1 < ulThreads) ? (t + 1) * ulStep : ulCtPts;
+            ranges[t].pos.assign(ulCtShards, 0);
+            ranges[t].step = Range::Count;
+        }
 
-        bool operator!=(const Vertex& rhs) const
-        {
-            return x != rhs.x || y != rhs.y || z != rhs.z;
+        // count the points of each shard and range
+        QtConcurrent::blockingMap(ranges, &Range::Run);
+
+        // inside a shard the ranges are stored one after the other, so the points keep their order
+        std::vector<Shard> shards(ulCtShards);
+        unsigned long ulPos = 0;
+        for (unsigned long i = 0; i < ulCtShards; i++) {
+            shards[i].welder = this;
+            shards[i].begin = ulPos;
+            for (unsigned long t = 0; t < ulThreads; t++) {
+                unsigned long ulCt = ranges[t].pos[i];
+                ranges[t].pos[i] = ulPos;
+                ulPos += ulCt;
+            }
+            shards[i].end = ulPos;
         }
-        bool operator<(const Vertex& rhs) const
-        {
-            if      (x != rhs.x)    return x < rhs.x;
-            else if (y != rhs.y)    return y < rhs.y;
-            else if (z != rhs.z)    return z < rhs.z;
-            else                    return false;
+
+        for (unsigned long t = 0; t < ulThreads; t++)
+            ranges[t].step = Range::Scatter;
+        QtConcurrent::blockingMap(ranges, &Range::Run);
+
+        // merge the points of each shard
+        QtConcurrent::blockingMap(shards, &Shard::Run);
+        std::vector<uint32_t>().swap(_hashes);
+
+        // number the merged points in the order of their first occurrence
+        for (unsigned long t = 0; t < ulThreads; t++)
+            ranges[t].step = Range::CountFirst;
+        QtConcurrent::blockingMap(ranges, &Range::Run);
+
+        unsigned long ulCtUnique = 0;
+        for (unsigned long t = 0; t < ulThreads; t++) {
+            unsigned long ulCt = ranges[t].pos[0];
+            ranges[t].pos[0] = ulCtUnique;
+            ulCtUnique += ulCt;
         }
+
+        // '_order' is not needed any more and takes the indices of the merged points
+        for (unsigned long t = 0; t < ulThreads; t++)
+            ranges[t].step = Range::NumberFirst;
+        QtConcurrent::blockingMap(ranges, &Range::Run);
+        for (unsigned long t = 0; t < ulThreads; t++)
+            ranges[t].step = Range::NumberOthers;
+        QtConcurrent::blockingMap(ranges, &Range::Run);
+
+        std::vector<unsigned long>().swap(_first);
+        indices.swap(_order);
+        std::vector<unsigned long>().swap(_order);
+        return ulCtUnique;
+    }
+
+private:
+    enum { MinPointsPerThread = 100000 };
+
+    struct Range
+    {
+        enum Step { Count, Scatter, CountFirst, NumberFirst, NumberOthers };
+
+        MeshPointWelder* welder;
+        unsigned long begin, end;
+        std::vector<unsigned long> pos;
+        Step step;
+
+        void Run() { welder->Process(*this); }
+    };
+
+    struct Shard
+    {
+        MeshPointWelder* welder;
+        unsigned long begin, end;
+
+        void Run() { welder->Merge(*this); }
     };
 
-    // Hint: Using a QVector instead of std::vector is a bit faster
-    QVector<Vertex> verts;
+    static uint32_t Hash(const Base::Vector3f& rclPt)
+    {
+        const float coords[3] = {rclPt.x, rclPt.y, rclPt.z};
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < 3; i++) {
+            // -0.0 and 0.0 are equal coordinates and must have the same hash value
+            float f = coords[i] == 0.0f ? 0.0f : coords[i];
+            uint32_t u;
+            std::memcpy(&u, &f, sizeof(u));
+            h = (h ^ u) * 16777619u;
+        }
+
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    unsigned long ShardOf(uint32_t h) const
+    {
+        return _ulShardBits > 0 ? (h >> (32 - _ulShardBits)) : 0;
+    }
+
+    void Process(Range& range)
+    {
+        switch (range.step) {
+        case Range::Count:
+            for (unsigned long i = range.begin; i < range.end; i++) {
+                _hashes[i] = Hash(_points[i]);
+                range.pos[ShardOf(_hashes[i])]++;
+            }
+            break;
+        case Range::Scatter:
+            for (unsigned long i = range.begin; i < range.end; i++)
+                _order[range.pos[ShardOf(_hashes[i])]++] = i;
+            break;
+        case Range::CountFirst:
+            range.pos[0] = 0;
+            for (unsigned long i = range.begin; i < range.end; i++) {
+                if (_first[i] == i)
+                    range.pos[0]++;
+            }
+            break;
+        case Range::NumberFirst:
+            for (unsigned long i = range.begin; i < range.end; i++) {
+                if (_first[i] == i)
+                    _order[i] = range.pos[0]++;
+            }
+            break;
+        case Range::NumberOthers:
+            // the first occurrence lies in front of the point and is already numbered
+            for (unsigned long i = range.begin; i < range.end; i++) {
+                if (_first[i] != i)
+                    _order[i] = _order[_first[i]];
+            }
+            break;
+        }
+    }
+
+    void Merge(const Shard& shard)
+    {
+        unsigned long ulSize = 16;
+        while (ulSize < 2 * (shard.end - shard.begin))
+            ulSize *= 2;
+        unsigned long ulMask = ulSize - 1;
+
+        // open addressing with linear probing, the table holds the first occurrence of a point
+        std::vector<unsigned long> table(ulSize, ULONG_MAX);
+        for (unsigned long i = shard.begin; i < shard.end; i++) {
+            unsigned long ulPt = _order[i];
+            const Base::Vector3f& rclPt = _points[ulPt];
+            unsigned long ulSlot = _hashes[ulPt] & ulMask;
+            for (;;) {
+                unsigned long ulOther = table[ulSlot];
+                if (ulOther == ULONG_MAX) {
+                    table[ulSlot] = ulPt;
+                    _first[ulPt] = ulPt;
+                    break;
+                }
+                const Base::Vector3f& rclOther = _points[ulOther];
+                if (rclOther.x == rclPt.x && rclOther.y == rclPt.y && rclOther.z == rclPt.z) {
+                    _first[ulPt] = ulOther;
+                    break;
+                }
+                ulSlot = (ulSlot + 1) & ulMask;
+            }
+        }
+    }
+
+private:
+    const std::vector<Base::Vector3f>& _points;
+    std::vector<uint32_t> _hashes;
+    std::vector<unsigned long> _order;
+    std::vector<unsigned long> _first;
+    unsigned long _ulShardBits;
+};
+
+} // namespace MeshCore
+
+struct MeshFastBuilder::Private {
+    std::vector<Base::Vector3f> verts;
 };
 
 MeshFastBuilder::MeshFastBuilder(MeshKernel &rclM) : _meshKernel(rclM), p(new Private)
@@ -300,63 +497,55 @@ void MeshFastBuilder::Initialize (unsigned long ctFacets)
 
 void MeshFastBuilder::AddFacet (const Base::Vector3f* facetPoints)
 {
-    Private::Vertex v;
     for (int i=0; i<3; i++) {
-        v.x = facetPoints[i].x;
-        v.y = facetPoints[i].y;
-        v.z = facetPoints[i].z;
-        p->verts.push_back(v);
+        p->verts.push_back(facetPoints[i]);
     }
 }
 
 void MeshFastBuilder::AddFacet (const MeshGeomFacet& facetPoints)
 {
-    Private::Vertex v;
     for (int i=0; i<3; i++) {
-        v.x = facetPoints._aclPoints[i].x;
-        v.y = facetPoints._aclPoints[i].y;
-        v.z = facetPoints._aclPoints[i].z;
-        p->verts.push_back(v);
+        p->verts.push_back(facetPoints._aclPoints[i]);
     }
 }
 
-void MeshFastBuilder::Finish ()
+void MeshFastBuilder::AddFacets (std::vector<Base::Vector3f>& facetPoints)
 {
-    QVector<Private::Vertex>& verts = p->verts;
-    size_t ulCtPts = verts.size();
-    for (size_t i=0; i < ulCtPts; ++i) {
-        verts[i].i = i;
+    if (p->verts.empty()) {
+        p->verts.swap(facetPoints);
     }
+    else {
+        p->verts.insert(p->verts.end(), facetPoints.begin(), facetPoints.end());
+    }
+    std::vector<Base::Vector3f>().swap(facetPoints);
+}
 
-    //std::sort(verts.begin(), verts.end());
-    int threads = std::max(1, QThread::idealThreadCount());
-    MeshCore::parallel_sort(verts.begin(), verts.end(), std::less<Private::Vertex>(), threads);
-
-    QVector<unsigned long> indices(ulCtPts);
-
-    size_t vertex_count = 0;
-    for (QVector<Private::Vertex>::iterator v = verts.begin(); v != verts.end(); ++v) {
-        if (!vertex_count || *v != verts[vertex_count-1])
-            verts[vertex_count++] = *v;
+void MeshFastBuilder::Finish ()
+{
+    std::vector<Base::Vector3f>& verts = p->verts;
+    std::vector<unsigned long> indices;
+    unsigned long ulCtPts = MeshPointWelder(verts).Weld(indices);
 
-        indices[v->i] = vertex_count - 1;
+    // a point is new if its index equals the number of points found so far
+    MeshPointArray rPoints;
+    rPoints.reserve(ulCtPts);
+    std::size_t ulCtVerts = verts.size();
+    for (std::size_t i=0; i < ulCtVerts; ++i) {
+        if (indices[i] == rPoints.size())
+            rPoints.push_back(MeshPoint(verts[i]));
     }
+    std::vector<Base::Vector3f>().swap(verts);
 
-    size_t ulCt = verts.size()/3;
+    size_t ulCt = ulCtVerts/3;
     MeshFacetArray rFacets(ulCt);
     for (size_t i=0; i < ulCt; ++i) {
         rFacets[i]._aulPoints[0] = indices[3*i];
         rFacets[i]._aulPoints[1] = indices[3*i + 1];
         rFacets[i]._aulPoints[2] = indices[3*i + 2];
     }
+    std::vector<unsigned long>().swap(indices);
 
-    verts.resize(vertex_count);
-
-    MeshPointArray rPoints;
-    rPoints.reserve(vertex_count);
-    for (QVector<Private::Vertex>::iterator v = verts.begin(); v != verts.end(); ++v) {
-        rPoints.push_back(MeshPoint(v->x, v->y, v->z));
-    }
-
-    _meshKernel.Adopt(rPoints, rFacets, true);
+    MeshPointFacetAdjacency meshAdj(rPoints.size(), rFacets);
+    meshAdj.SetFacetNeighbourhood();
+    _meshKernel.Adopt(rPoints, rFacets, false);
 }
@@ -179,6 +179,8 @@ private:
  * ...
  * builder.Finish();
  * \endcode
+ * Points with equal coordinates are merged with a hash table that is filled by several
+ * threads, and the neighbourhood of the facets is set in the same run.
  * @author Werner Mayer
  */
 class MeshExport MeshFastBuilder
@@ -200,6 +202,11 @@ public:
     /** Add new facet
      */
     void AddFacet (const MeshGeomFacet& facetPoints);
+    /** Add new facets
+     * @param facetPoints the corner points with three points per facet. Afterwards
+     * the array is empty because the builder takes over its data where possible.
+     */
+    void AddFacets (std::vector<Base::Vector3f>& facetPoints);
 
     /** Finishes building up the mesh structure. Must be done after adding facets.
      */
@@ -98,7 +98,8 @@ void MeshPointArray::Transform(const Base::Matrix4D& mat)
 
 void MeshFacetArray::Erase (_TIterator pIter)
 {
-  unsigned long i, *pulN;
+  unsigned long i;
+  MeshIndex *pulN;
   _TIterator  pPass, pEnd;
   unsigned long ulInd = pIter - begin();
   erase(pIter);
@@ -24,9 +24,12 @@
 #ifndef MESH_ELEMENTS_H
 #define MESH_ELEMENTS_H
 
+#include <algorithm>
 #include <functional>
+#include <iterator>
 #include <vector>
 #include <climits>
+#include <cstdint>
 #include <cstring>
 
 #include "Definitions.h"
@@ -45,6 +48,53 @@ namespace MeshCore {
 class MeshHelpEdge;
 class MeshPoint;
 
+#if defined(MESH_USE_32BIT_INDICES)
+/**
+ * Compact storage of a point or facet index of a facet. It behaves like an
+ * unsigned long, so that the existing algorithms work unchanged, but only
+ * takes four bytes. ULONG_MAX, which marks a missing neighbour, is mapped to
+ * the largest 32-bit value and back.
+ */
+class MeshIndex32
+{
+public:
+  MeshIndex32() : _index(UINT32_MAX) {}
+  explicit MeshIndex32(unsigned long ulIndex) : _index(pack(ulIndex)) {}
+
+  operator unsigned long() const
+  { return _index == UINT32_MAX ? ULONG_MAX : _index; }
+  MeshIndex32& operator = (unsigned long ulIndex)
+  { _index = pack(ulIndex); return *this; }
+  MeshIndex32& operator += (unsigned long ulIndex)
+  { return *this = static_cast<unsigned long>(*this) + ulIndex; }
+  MeshIndex32& operator -= (unsigned long ulIndex)
+  { return *this = static_cast<unsigned long>(*this) - ulIndex; }
+  MeshIndex32& operator ++ ()
+  { return *this += 1; }
+  MeshIndex32& operator -- ()
+  { return *this -= 1; }
+  unsigned long operator ++ (int)
+  { unsigned long ulIndex = *this; *this += 1; return ulIndex; }
+  unsigned long operator -- (int)
+  { unsigned long ulIndex = *this; *this -= 1; return ulIndex; }
+
+private:
+  // indices that don't fit, like ULONG_MAX, become invalid instead of wrapping
+  // around, so that the range checks of MeshEvalRangePoint still find them
+  static uint32_t pack(unsigned long ulIndex)
+  { return ulIndex >= UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(ulIndex); }
+
+private:
+  uint32_t _index;
+};
+
+/** Index type stored in a facet. Meshes are limited to 2^32-1 points and facets. */
+typedef MeshIndex32 MeshIndex;
+#else
+/** Index type stored in a facet. */
+typedef unsigned long MeshIndex;
+#endif
+
 /**
  * Helper class providing an operator for comparison 
  * of two edges. The class holds the point indices of the
@@ -295,8 +345,8 @@ public:
 public:
   unsigned char _ucFlag; /**< Flag member. */
   unsigned long _ulProp; /**< Free usable property. */
-  unsigned long _aulPoints[3];     /**< Indices of corner points. */
-  unsigned long _aulNeighbours[3]; /**< Indices of neighbour facets. */
+  MeshIndex _aulPoints[3];     /**< Indices of corner points. */
+  MeshIndex _aulNeighbours[3]; /**< Indices of neighbour facets. */
 };
 
 /**
@@ -814,8 +864,8 @@ inline MeshFacet::MeshFacet (void)
 : _ucFlag(0),
   _ulProp(0)
 {
-    memset(_aulNeighbours, 0xff, sizeof(ULONG_MAX) * 3);
-    memset(_aulPoints, 0xff, sizeof(ULONG_MAX) * 3);
+    std::fill(std::begin(_aulNeighbours), std::end(_aulNeighbours), MeshIndex(ULONG_MAX));
+    std::fill(std::begin(_aulPoints), std::end(_aulPoints), MeshIndex(ULONG_MAX));
 }
 
 inline MeshFacet::MeshFacet(const MeshFacet &rclF)
@@ -27,6 +27,9 @@
 # include <algorithm>
 #endif
 
+#include <QThread>
+#include <QtConcurrentMap>
+
 #include "Grid.h"
 #include "Iterator.h"
 
@@ -43,6 +46,9 @@ MeshGrid::MeshGrid (const MeshKernel &rclM)
   _fGridLenX(0.0f), _fGridLenY(0.0f), _fGridLenZ(0.0f),
   _fMinX(0.0f), _fMinY(0.0f), _fMinZ(0.0f)
 {
+  _clFill.pclGrid = this;
+  _clFill.ulBegin = _clFill.ulEnd = 0;
+  _clFill.bStore = false;
 }
 
 MeshGrid::MeshGrid (void)
@@ -52,6 +58,9 @@ MeshGrid::MeshGrid (void)
   _fGridLenX(0.0f), _fGridLenY(0.0f), _fGridLenZ(0.0f),
   _fMinX(0.0f), _fMinY(0.0f), _fMinZ(0.0f)
 {
+  _clFill.pclGrid = this;
+  _clFill.ulBegin = _clFill.ulEnd = 0;
+  _clFill.bStore = false;
 }
 
 void MeshGrid::Attach (const MeshKernel &rclM)
@@ -62,7 +71,9 @@ void MeshGrid::Attach (const MeshKernel &rclM)
 
 void MeshGrid::Clear (void)
 {
-  _aulGrid.clear();
+  _aulGridOffsets.clear();
+  _aulGridElements.clear();
+  _clFill.aulPos.clear();
   _pclMesh = NULL;  
 }
 
@@ -93,8 +104,6 @@ void MeshGrid::InitGrid (void)
 {
   assert(_pclMesh != NULL);
 
-  unsigned long i, j;
-
   // Grid Laengen berechnen wenn nicht initialisiert
   //
   if ((_ulCtGridsX == 0) || (_ulCtGridsY == 0) || (_ulCtGridsZ == 0))
@@ -128,14 +137,89 @@ void MeshGrid::InitGrid (void)
   }
 
   // Daten-Struktur anlegen
-  _aulGrid.clear();
-  _aulGrid.resize(_ulCtGridsX);
-  for (i = 0; i < _ulCtGridsX; i++)
+  ClearCells();
+}
+
+void MeshGrid::ClearCells (void)
+{
+  unsigned long ulCtCells = _ulCtGridsX * _ulCtGridsY * _ulCtGridsZ;
+  _aulGridOffsets.assign(ulCtCells + 1, 0);
+  _aulGridElements.clear();
+  _clFill.pclGrid = this;
+  _clFill.aulPos.assign(ulCtCells, 0);
+  _clFill.bStore = false;
+}
+
+void MeshGrid::StoreCells (void)
+{
+  // the counts become the start positions of each grid
+  unsigned long ulCtCells = _aulGridOffsets.size() - 1;
+  for (unsigned long i = 0; i < ulCtCells; i++)
   {
-    _aulGrid[i].resize(_ulCtGridsY);
-    for (j = 0; j < _ulCtGridsY; j++)
-      _aulGrid[i][j].resize(_ulCtGridsZ);
+    _aulGridOffsets[i+1] = _aulGridOffsets[i] + _clFill.aulPos[i];
+    _clFill.aulPos[i] = _aulGridOffsets[i];
   }
+  _aulGridElements.resize(_aulGridOffsets.back());
+  _clFill.bStore = true;
+}
+
+void MeshGrid::FinishCells (void)
+{
+  std::vector<unsigned long>().swap(_clFill.aulPos);
+  _clFill.bStore = false;
+}
+
+void MeshGrid::FillCells (unsigned long ulCtElements)
+{
+  unsigned long ulCtCells = _aulGridOffsets.size() - 1;
+
+  // every thread needs its own counters for all grids, so split only if there are enough elements
+  unsigned long ulThreads = std::max<int>(1, QThread::idealThreadCount());
+  ulThreads = std::min<unsigned long>(ulThreads, ulCtElements / std::max<unsigned long>(MESH_MIN_FILL_PER_THREAD, ulCtCells));
+  if (ulThreads < 2)
+  {
+    AddElements(0, ulCtElements, _clFill);
+    StoreCells();
+    AddElements(0, ulCtElements, _clFill);
+    FinishCells();
+    return;
+  }
+
+  std::vector<CellFill> aclFill(ulThreads);
+  unsigned long ulStep = ulCtElements / ulThreads;
+  for (unsigned long t = 0; t < ulThreads; t++)
+  {
+    aclFill[t].pclGrid = this;
+    aclFill[t].ulBegin = t * ulStep;
+    aclFill[t].ulEnd   = (t + 1 < ulThreads) ? (t + 1) * ulStep : ulCtElements;
+    aclFill[t].aulPos.assign(ulCtCells, 0);
+    aclFill[t].bStore  = false;
+  }
+
+  // count the elements of each range
+  QtConcurrent::blockingMap(aclFill, &CellFill::Run);
+
+  // inside a grid the ranges are stored one after the other, so the elements keep their order
+  unsigned long ulPos = 0;
+  for (unsigned long i = 0; i < ulCtCells; i++)
+  {
+    _aulGridOffsets[i] = ulPos;
+    for (unsigned long t = 0; t < ulThreads; t++)
+    {
+      unsigned long ulCt = aclFill[t].aulPos[i];
+      aclFill[t].aulPos[i] = ulPos;
+      ulPos += ulCt;
+    }
+  }
+  _aulGridOffsets[ulCtCells] = ulPos;
+  _aulGridElements.resize(ulPos);
+
+  // store the elements of each range
+  for (unsigned long t = 0; t < ulThreads; t++)
+    aclFill[t].bStore = true;
+  QtConcurrent::blockingMap(aclFill, &CellFill::Run);
+
+  FinishCells();
 }
 
 unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsigned long> &raulElements,
@@ -155,7 +239,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -190,7 +274,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
         if (Base::DistanceP2(GetBoundBox(i, j, k).GetCenter(), rclOrg) < fMinDistP2)
-          raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+          GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -221,7 +305,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::set<unsigned
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(_aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -450,6 +534,14 @@ void MeshGrid::CalculateGridLength (int iCtGridPerAxis)
 }
 
 void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<unsigned long> &raclInd) const
+{
+  std::vector<unsigned long> aulInd;
+  SearchNearestFromPoint(rclPt, aulInd);
+  raclInd.clear();
+  raclInd.insert(aulInd.begin(), aulInd.end());
+}
+
+void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::vector<unsigned long> &raclInd) const
 {
   raclInd.clear();
   Base::BoundBox3f  clBB = GetBoundBox();
@@ -478,7 +570,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              GetElements(nX, i, j, raclInd);
           }
           nX++;
         }
@@ -492,9 +584,9 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              GetElements(nX, i, j, raclInd);
           }
-          nX++;
+          nX--;
         }
         break;
       }
@@ -506,7 +598,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              GetElements(i, nY, j, raclInd);
           }
           nY++;
         }
@@ -520,7 +612,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              GetElements(i, nY, j, raclInd);
           }
           nY--;
         }
@@ -534,7 +626,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              GetElements(i, j, nZ, raclInd);
           }
           nZ++;
         }
@@ -548,7 +640,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              GetElements(i, j, nZ, raclInd);
           }
           nZ--;
         }
@@ -559,10 +651,22 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
         break;
     }
   }
+
+  // an element can lie in several grids
+  std::sort(raclInd.begin(), raclInd.end());
+  raclInd.erase(std::unique(raclInd.begin(), raclInd.end()), raclInd.end());
 }
 
 void MeshGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, 
                         unsigned long ulDistance, std::set<unsigned long> &raclInd) const
+{
+  std::vector<unsigned long> aulInd;
+  GetHull(ulX, ulY, ulZ, ulDistance, aulInd);
+  raclInd.insert(aulInd.begin(), aulInd.end());
+}
+
+void MeshGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, 
+                        unsigned long ulDistance, std::vector<unsigned long> &raclInd) const
 {
   int nX1 = std::max<int>(0, int(ulX) - int(ulDistance));
   int nY1 = std::max<int>(0, int(ulY) - int(ulDistance));
@@ -614,14 +718,19 @@ void MeshGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ,
 unsigned long MeshGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
                                      std::set<unsigned long> &raclInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  if (rclSet.size() > 0)
-  {
-    raclInd.insert(rclSet.begin(), rclSet.end());
-    return rclSet.size();
-  }
+  unsigned long ulCell = GetCellIndex(ulX, ulY, ulZ);
+  unsigned long ulBegin = _aulGridOffsets[ulCell], ulEnd = _aulGridOffsets[ulCell + 1];
+  raclInd.insert(_aulGridElements.begin() + ulBegin, _aulGridElements.begin() + ulEnd);
+  return ulEnd - ulBegin;
+}
 
-  return 0;
+unsigned long MeshGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
+                                     std::vector<unsigned long> &raulInd) const
+{
+  unsigned long ulCell = GetCellIndex(ulX, ulY, ulZ);
+  unsigned long ulBegin = _aulGridOffsets[ulCell], ulEnd = _aulGridOffsets[ulCell + 1];
+  raulInd.insert(raulInd.end(), _aulGridElements.begin() + ulBegin, _aulGridElements.begin() + ulEnd);
+  return ulEnd - ulBegin;
 }
 
 unsigned long MeshGrid::GetElements(const Base::Vector3f &rclPoint, std::vector<unsigned long>& aulFacets) const
@@ -630,10 +739,8 @@ unsigned long MeshGrid::GetElements(const Base::Vector3f &rclPoint, std::vector<
   if (!CheckPosition(rclPoint, ulX, ulY, ulZ))
     return 0;
 
-  aulFacets.resize(_aulGrid[ulX][ulY][ulZ].size());
-
-  std::copy(_aulGrid[ulX][ulY][ulZ].begin(), _aulGrid[ulX][ulY][ulZ].end(), aulFacets.begin());
-  return aulFacets.size();
+  aulFacets.clear();
+  return GetElements(ulX, ulY, ulZ, aulFacets);
 }
 
 unsigned long MeshGrid::GetIndexToPosition(unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
@@ -737,15 +844,19 @@ void MeshFacetGrid::RebuildGrid (void)
   InitGrid();
  
   // Daten-Struktur fuellen
+  FillCells(_ulCtElements);
+}
+
+void MeshFacetGrid::AddElements (unsigned long ulBegin, unsigned long ulEnd, CellFill &rclFill)
+{
   MeshFacetIterator clFIter(*_pclMesh);
 
-  unsigned long i = 0;
-  for (clFIter.Init(); clFIter.More(); clFIter.Next())
+  unsigned long i = ulBegin;
+  for (clFIter.Set(ulBegin); i < ulEnd; clFIter.Next())
   {
 //    AddFacet(*clFIter, i++, 2.0f);
-    AddFacet(*clFIter, i++);
+    AddFacet(*clFIter, i++, rclFill);
   }
-
 }
 
 unsigned long MeshFacetGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt) const
@@ -946,8 +1057,10 @@ void MeshFacetGrid::SearchNearestFacetInGrid(unsigned long ulX, unsigned long ul
                                              const Base::Vector3f &rclPt, float &rfMinDist,
                                              unsigned long &rulFacetInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  for (std::set<unsigned long>::const_iterator pI = rclSet.begin(); pI != rclSet.end(); ++pI)
+  unsigned long ulCell = GetCellIndex(ulX, ulY, ulZ);
+  std::vector<unsigned long>::const_iterator pBegin = _aulGridElements.begin() + _aulGridOffsets[ulCell];
+  std::vector<unsigned long>::const_iterator pEnd = _aulGridElements.begin() + _aulGridOffsets[ulCell + 1];
+  for (std::vector<unsigned long>::const_iterator pI = pBegin; pI != pEnd; ++pI)
   {
     float fDist = _pclMesh->GetFacet(*pI).DistanceToPoint(rclPt);
     if (fDist < rfMinDist)
@@ -992,13 +1105,12 @@ MeshPointGrid::MeshPointGrid (const MeshKernel &rclM, float fGridLen)
           std::max<unsigned long>((unsigned long)(clBBMesh.LengthZ() / fGridLen), 1));
 }
 
-void MeshPointGrid::AddPoint (const MeshPoint &rclPt, unsigned long ulPtIndex, float fEpsilon)
+void MeshPointGrid::AddPoint (const MeshPoint &rclPt, unsigned long ulPtIndex, CellFill &rclFill)
 {
-  (void)fEpsilon;
   unsigned long ulX, ulY, ulZ;
   Pos(Base::Vector3f(rclPt.x, rclPt.y, rclPt.z), ulX, ulY, ulZ);
   if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
-    _aulGrid[ulX][ulY][ulZ].insert(ulPtIndex);
+    AddElement(ulX, ulY, ulZ, ulPtIndex, rclFill);
 }
 
 void MeshPointGrid::Validate (const MeshKernel &rclMesh)
@@ -1049,13 +1161,17 @@ void MeshPointGrid::RebuildGrid (void)
   InitGrid();
  
   // Daten-Struktur fuellen
+  FillCells(_ulCtElements);
+}
 
+void MeshPointGrid::AddElements (unsigned long ulBegin, unsigned long ulEnd, CellFill &rclFill)
+{
   MeshPointIterator cPIter(*_pclMesh);
 
-  unsigned long i = 0;
-  for (cPIter.Init(); cPIter.More(); cPIter.Next())
+  unsigned long i = ulBegin;
+  for (cPIter.Set(ulBegin); i < ulEnd; cPIter.Next())
   {
-    AddPoint(*cPIter, i++);
+    AddPoint(*cPIter, i++, rclFill);
   }
 }
 
@@ -1080,6 +1196,20 @@ unsigned long MeshPointGrid::FindElements (const Base::Vector3f &rclPoint, std::
   return 0;
 }
 
+unsigned long MeshPointGrid::FindElements (const Base::Vector3f &rclPoint, std::vector<unsigned long>& aulElements) const
+{
+  unsigned long ulX, ulY, ulZ;
+  Pos(rclPoint, ulX, ulY, ulZ);
+
+  // check if the given point is inside the grid structure
+  if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
+  {
+    return GetElements(ulX, ulY, ulZ, aulElements);
+  }
+
+  return 0;
+}
+
 // ----------------------------------------------------------------
 
 MeshGridIterator::MeshGridIterator (const MeshGrid &rclG)
@@ -1118,7 +1248,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
   if ((_rclGrid.GetBoundBox().IsInBox(rclPt)) == true)
   {  // Voxel bestimmen, indem der Startpunkt liegt
     _rclGrid.Position(rclPt, _ulX, _ulY, _ulZ);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
     _bValidRay = true;
   }
   else
@@ -1131,7 +1261,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
       else
         _rclGrid.Position(cP1, _ulX, _ulY, _ulZ);
 
-      raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+      _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
       _bValidRay = true;
     }
   }
@@ -1182,7 +1312,7 @@ bool MeshGridIterator::NextOnRay (std::vector<unsigned long> &raulElements)
   if ((_bValidRay == true) && (_rclGrid.CheckPos(_ulX, _ulY, _ulZ) == true))
   {
     GridElement pos(_ulX, _ulY, _ulZ); _cSearchPositions.insert(pos);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end()); 
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements); 
   }
   else
     _bValidRay = false;  // Strahl ausgetreten
@@ -33,6 +33,7 @@
 #define  MESH_CT_GRID          256     // Default value for number of elements per grid
 #define  MESH_MAX_GRIDS        100000  // Default value for maximum number of grids
 #define  MESH_CT_GRID_PER_AXIS 20
+#define  MESH_MIN_FILL_PER_THREAD 20000 // Minimum number of elements each thread adds when building a grid
 
 
 namespace MeshCore {
@@ -89,12 +90,17 @@ public:
                                 const Base::Vector3f &rclOrg, float fMaxDist, bool bDelDoubles = true) const;
   /** Searches for the nearest grids that contain elements from a point, the result are grid indices. */
   void SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<unsigned long> &rclInd) const;
+  /** Searches for the nearest grids that contain elements from a point. The element indices are sorted
+   * and without duplicates. */
+  void SearchNearestFromPoint (const Base::Vector3f &rclPt, std::vector<unsigned long> &raulInd) const;
   //@}
 
   /** @name Getters */
   //@{
   /** Returns the indices of the elements in the given grid. */
   unsigned long GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  std::set<unsigned long> &raclInd) const;
+  /** Appends the indices of the elements in the given grid, which are sorted in ascending order. */
+  unsigned long GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  std::vector<unsigned long> &raulInd) const;
   unsigned long GetElements (const Base::Vector3f &rclPoint, std::vector<unsigned long>& aulFacets) const;
   //@}
 
@@ -125,7 +131,7 @@ public:
   bool GetPositionToIndex(unsigned long id, unsigned long& ulX, unsigned long& ulY, unsigned long& ulZ) const;
   /** Returns the number of elements in a given grid. */
   unsigned long GetCtElements(unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
-  { return _aulGrid[ulX][ulY][ulZ].size(); }
+  { unsigned long ulCell = GetCellIndex(ulX, ulY, ulZ); return _aulGridOffsets[ulCell + 1] - _aulGridOffsets[ulCell]; }
   /** Validates the grid structure and rebuilds it if needed. Must be implemented in sub-classes. */
   virtual void Validate (const MeshKernel &rclM) = 0;
   /** Verifies the grid structure and returns false if inconsistencies are found. */
@@ -141,10 +147,49 @@ public:
   inline bool CheckPos (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const;
   /** Get the indices of all elements lying in the grids around a given grid with distance \a ulDistance. */
   void GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulDistance, std::set<unsigned long> &raclInd) const;
+  /** Appends the indices of all elements lying in the grids around a given grid with distance \a ulDistance.
+   * An element that lies in several of these grids is appended several times. */
+  void GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulDistance, std::vector<unsigned long> &raulInd) const;
 
 protected:
   /** Initializes the size of the internal structure. */
   virtual void InitGrid (void);
+  /** @name Filling
+   * The grid is filled in two passes. After ClearCells() AddElement() only counts the elements of each grid,
+   * after StoreCells() it stores them. Both passes must add the same elements in the same order, and 
+   * FinishCells() must be called at the end. FillCells() does all of this and splits large meshes into
+   * ranges of elements that are added by several threads.
+   */
+  //@{
+  /** Counters or insert positions of the elements of one range while the grid is filled. */
+  struct CellFill
+  {
+    MeshGrid*                  pclGrid;  /**< The grid to fill. */
+    unsigned long              ulBegin;  /**< First element of the range. */
+    unsigned long              ulEnd;    /**< End of the range. */
+    std::vector<unsigned long> aulPos;   /**< Number of elements or next insert position per grid. */
+    bool                       bStore;   /**< The elements are stored, not counted. */
+    /** Counts or stores the elements of the range. */
+    void Run (void) { pclGrid->AddElements(ulBegin, ulEnd, *this); }
+  };
+  /** Removes all elements and starts counting them for the current number of grids. */
+  void ClearCells (void);
+  /** Allocates the counted elements and starts storing them. */
+  void StoreCells (void);
+  /** Finishes filling the grid. */
+  void FinishCells (void);
+  /** Fills the grid with the first \a ulCtElements elements using AddElements(). The grid must have been 
+   * cleared. The elements of each grid are in the same order as if they were added by a single thread. */
+  void FillCells (unsigned long ulCtElements);
+  /** Counts or stores the elements in the range [\a ulBegin, \a ulEnd[ using \a rclFill. This is called 
+   * concurrently for different ranges. Must be implemented in sub-classes. */
+  virtual void AddElements (unsigned long ulBegin, unsigned long ulEnd, CellFill &rclFill) = 0;
+  /** Counts or stores an element in the given grid using \a rclFill. */
+  inline void AddElement (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulIndex, CellFill &rclFill);
+  //@}
+  /** Returns the index of the grid element in the internal structure. */
+  unsigned long GetCellIndex (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+  { return (ulZ * _ulCtGridsY + ulY) * _ulCtGridsX + ulX; }
   /** Deletes the grid structure. */
   virtual void Clear (void);
   /** Calculates the grid length dependent on maximum number of grids. */
@@ -157,7 +202,9 @@ protected:
   virtual unsigned long HasElements (void) const = 0;
 
 protected:
-  std::vector<std::vector<std::vector<std::set<unsigned long> > > >  _aulGrid;   /**< Grid data structure. */
+  std::vector<unsigned long> _aulGridOffsets;  /**< Start of the elements of each grid in _aulGridElements. */
+  std::vector<unsigned long> _aulGridElements; /**< Element indices of all grids. */
+  CellFill                   _clFill;          /**< Counters or insert positions while filling the grid. */
   const MeshKernel* _pclMesh;     /**< The mesh kernel. */
   unsigned long     _ulCtElements;/**< Number of grid elements for validation issues. */
   unsigned long     _ulCtGridsX;  /**< Number of grid elements in z. */
@@ -224,10 +271,12 @@ protected:
   inline void Pos (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
   /** Returns the grid numbers to the given point \a rclPoint. */
   inline void PosWithCheck (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
-  /** Adds a new facet element to the grid structure. \a rclFacet is the geometric facet and \a ulFacetIndex 
-   * the corresponding index in the mesh kernel. The facet is added to each grid element that intersects 
-   * the facet. */
-  inline void AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, float fEpsilon = 0.0f);
+  /** Adds a new facet element to the grid structure using \a rclFill. \a rclFacet is the geometric facet
+   * and \a ulFacetIndex the corresponding index in the mesh kernel. The facet is added to each grid element
+   * that intersects the facet. */
+  inline void AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, CellFill &rclFill);
+  /** Adds the facets in the range [\a ulBegin, \a ulEnd[ to the grid structure. */
+  virtual void AddElements (unsigned long ulBegin, unsigned long ulEnd, CellFill &rclFill);
   /** Returns the number of stored elements. */
   unsigned long HasElements (void) const
   { return _pclMesh->CountFacets(); }
@@ -260,6 +309,8 @@ public:
 
   /** Finds all points that lie in the same grid as the point \a rclPoint. */
   unsigned long FindElements(const Base::Vector3f &rclPoint, std::set<unsigned long>& aulElements) const;
+  /** Finds all points that lie in the same grid as the point \a rclPoint and appends them to \a aulElements. */
+  unsigned long FindElements(const Base::Vector3f &rclPoint, std::vector<unsigned long>& aulElements) const;
   /** Validates the grid structure and rebuilds it if needed. */
   virtual void Validate (const MeshKernel &rclM);
   /** Validates the grid structure and rebuilds it if needed. */
@@ -268,9 +319,11 @@ public:
   virtual bool Verify() const;
 
 protected:
-  /** Adds a new point element to the grid structure. \a rclPt is the geometric point and \a ulPtIndex 
-   * the corresponding index in the mesh kernel. */
-  void AddPoint (const MeshPoint &rclPt, unsigned long ulPtIndex, float fEpsilon = 0.0f);
+  /** Adds a new point element to the grid structure using \a rclFill. \a rclPt is the geometric point
+   * and \a ulPtIndex the corresponding index in the mesh kernel. */
+  void AddPoint (const MeshPoint &rclPt, unsigned long ulPtIndex, CellFill &rclFill);
+  /** Adds the points in the range [\a ulBegin, \a ulEnd[ to the grid structure. */
+  virtual void AddElements (unsigned long ulBegin, unsigned long ulEnd, CellFill &rclFill);
   /** Returns the grid numbers to the given point \a rclPoint. */
   void Pos(const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
   /** Returns the number of stored elements. */
@@ -295,7 +348,7 @@ public:
   /** Returns indices of the elements in the current grid. */
   void GetElements (std::vector<unsigned long> &raulElements) const
   {
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
   }
   /** Returns the number of elements in the current grid. */
   unsigned long GetCtElements() const
@@ -391,6 +444,17 @@ inline bool MeshGrid::CheckPos (unsigned long ulX, unsigned long ulY, unsigned l
   return ((ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ));
 }
 
+inline void MeshGrid::AddElement (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulIndex,
+                                  CellFill &rclFill)
+{
+  unsigned long ulCell = GetCellIndex(ulX, ulY, ulZ);
+  assert(ulCell < rclFill.aulPos.size()); // only valid between ClearCells() and FinishCells()
+  if (rclFill.bStore)
+    _aulGridElements[rclFill.aulPos[ulCell]++] = ulIndex;
+  else
+    rclFill.aulPos[ulCell]++;
+}
+
 // --------------------------------------------------------------
 
 inline void MeshFacetGrid::Pos (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const
@@ -434,7 +498,7 @@ inline void MeshFacetGrid::PosWithCheck (const Base::Vector3f &rclPoint, unsigne
   assert((rulX < _ulCtGridsX) && (rulY < _ulCtGridsY) && (rulZ < _ulCtGridsZ));
 }
 
-inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, float /*fEpsilon*/)
+inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned long ulFacetIndex, CellFill &rclFill)
 {
 #if 0
   unsigned long  i, ulX, ulY, ulZ, ulX1, ulY1, ulZ1, ulX2, ulY2, ulZ2;
@@ -445,7 +509,7 @@ inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned lon
   for (i = 0; i < 3; i++)
   {
     Pos(rclFacet._aclPoints[i], ulX, ulY, ulZ);
-    _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+    AddElement(ulX, ulY, ulZ, ulFacetIndex, rclFill);
     ulX1 = RSmin<unsigned long>(ulX1, ulX); ulY1 = RSmin<unsigned long>(ulY1, ulY); ulZ1 = RSmin<unsigned long>(ulZ1, ulZ);
     ulX2 = RSmax<unsigned long>(ulX2, ulX); ulY2 = RSmax<unsigned long>(ulY2, ulY); ulZ2 = RSmax<unsigned long>(ulZ2, ulZ);
   }
@@ -460,7 +524,7 @@ inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned lon
         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++)
         {
           if (CMeshFacetFunc::BBoxContainFacet(GetBoundBox(ulX, ulY, ulZ), rclFacet) == true)
-            _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+            AddElement(ulX, ulY, ulZ, ulFacetIndex, rclFill);
         }
       }
     }
@@ -503,13 +567,13 @@ inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned lon
         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++)
         {
           if ( rclFacet.IntersectBoundingBox( GetBoundBox(ulX, ulY, ulZ) ) )
-            _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+            AddElement(ulX, ulY, ulZ, ulFacetIndex, rclFill);
         }
       }
     }
   }
   else
-    _aulGrid[ulX1][ulY1][ulZ1].insert(ulFacetIndex);
+    AddElement(ulX1, ulY1, ulZ1, ulFacetIndex, rclFill);
 
 #endif
 }
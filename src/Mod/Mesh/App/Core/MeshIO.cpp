@@ -38,17 +38,22 @@
 #include <Base/FileInfo.h>
 #include <Base/Sequencer.h>
 #include <Base/Stream.h>
+#include <Base/Swap.h>
 #include <Base/Placement.h>
 #include <Base/Tools.h>
 #include <zipios++/gzipoutputstream.h>
 
 #include <cmath>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
+#include <QFile>
+#include <QThread>
+#include <QtConcurrentMap>
 
 
 using namespace MeshCore;
@@ -137,6 +142,96 @@ struct Color_Less  : public std::binary_function<const App::Color&,
 
 }
 
+namespace MeshCore {
+    namespace STL {
+        enum Type {
+            Invalid, Empty, Ascii, Binary
+        };
+
+        /** Reads the header of an STL file and checks whether the file is binary or ASCII. */
+        Type checkType(std::istream &rstrIn)
+        {
+            char szBuf[200];
+
+            if (!rstrIn || rstrIn.bad() == true)
+                return Invalid;
+
+            // Read in 50 characters from position 80 on and check for keywords like 'SOLID', 'FACET', 'NORMAL',
+            // 'VERTEX', 'ENDFACET' or 'ENDLOOP'.
+            // As the file can be binary with one triangle only we must not read in more than (max.) 54 bytes because
+            // the file size has only 134 bytes in this case. On the other hand we must overread the first 80 bytes
+            // because it can happen that the file is binary but contains one of these keywords.
+            std::streambuf* buf = rstrIn.rdbuf();
+            if (!buf)
+                return Invalid;
+            buf->pubseekoff(80, std::ios::beg, std::ios::in);
+            uint32_t ulCt, ulBytes=50;
+            rstrIn.read((char*)&ulCt, sizeof(ulCt));
+            // if we have a binary STL with a single triangle we can only read-in 50 bytes
+            if (ulCt > 1)
+                ulBytes = 100;
+            // Either it's really an invalid STL file or it's just empty. In this case the number of facets must be 0.
+            if (!rstrIn.read(szBuf, ulBytes))
+                return (ulCt==0) ? Empty : Invalid;
+            szBuf[ulBytes] = 0;
+            upper(szBuf);
+
+            buf->pubseekoff(0, std::ios::beg, std::ios::in);
+            if ((strstr(szBuf, "SOLID") == NULL)  && (strstr(szBuf, "FACET") == NULL)    && (strstr(szBuf, "NORMAL") == NULL) &&
+                (strstr(szBuf, "VERTEX") == NULL) && (strstr(szBuf, "ENDFACET") == NULL) && (strstr(szBuf, "ENDLOOP") == NULL)) {
+                // probably binary STL
+                return Binary;
+            }
+            else {
+                return Ascii;
+            }
+        }
+
+        const std::size_t FacetSize = 50;
+        const uint32_t FacetsPerBlock = 0x10000;
+
+        /** Copies the corner points of a block of binary STL facets. */
+        struct FacetBlock
+        {
+            const char* data;
+            Base::Vector3f* points;
+            uint32_t begin, end;
+
+            void Run()
+            {
+                float v[12];
+                for (uint32_t i = begin; i < end; i++) {
+                    // normal, three points and two bytes attribute
+                    std::memcpy(v, data + i * FacetSize, sizeof(v));
+                    // start with the last point, this is the order used by the former loader
+                    points[3*i  ].Set(v[9], v[10], v[11]);
+                    points[3*i+1].Set(v[3], v[4],  v[5]);
+                    points[3*i+2].Set(v[6], v[7],  v[8]);
+                }
+            }
+        };
+
+        /** Copies the corner points of \a count facets to \a points using several threads. */
+        void readFacets(const char* data, uint32_t count, Base::Vector3f* points)
+        {
+            std::vector<FacetBlock> blocks;
+            for (uint32_t i = 0; i < count; i += FacetsPerBlock) {
+                FacetBlock block;
+                block.data = data;
+                block.points = points;
+                block.begin = i;
+                block.end = std::min<uint32_t>(count, i + FacetsPerBlock);
+                blocks.push_back(block);
+            }
+
+            if (blocks.size() == 1)
+                blocks.front().Run();
+            else if (!blocks.empty())
+                QtConcurrent::blockingMap(blocks, &FacetBlock::Run);
+        }
+    }
+}
+
 // --------------------------------------------------------------
 
 bool MeshInput::LoadAny(const char* FileName)
@@ -158,6 +253,28 @@ bool MeshInput::LoadAny(const char* FileName)
         // read file
         bool ok = false;
         if (fi.hasExtension("stl") || fi.hasExtension("ast")) {
+            // map binary files into memory to avoid copying the data through the stream
+            if (STL::checkType(str) == STL::Binary) {
+                QFile file(QString::fromUtf8(fi.filePath().c_str()));
+                uchar* data = 0;
+                if (file.open(QIODevice::ReadOnly))
+                    data = file.map(0, file.size());
+                if (data) {
+                    try {
+                        ok = LoadBinarySTL(reinterpret_cast<const char*>(data), static_cast<std::size_t>(file.size()));
+                    }
+                    catch (...) {
+                        _rclMesh.Clear();
+                        file.unmap(data);
+                        throw;
+                    }
+                    file.unmap(data);
+                    return ok;
+                }
+            }
+            // checkType() may leave the stream in a failed state, e.g. for an empty binary file
+            str.clear();
+            str.seekg(0, std::ios::beg);
             ok = LoadSTL(str);
         }
         else if (fi.hasExtension("iv")) {
@@ -221,40 +338,18 @@ bool  MeshInput::LoadFormat(std::istream &str, MeshIO::Format fmt)
  */
 bool MeshInput::LoadSTL (std::istream &rstrIn)
 {
-    char szBuf[200];
-
-    if (!rstrIn || rstrIn.bad() == true)
+    STL::Type type = STL::checkType(rstrIn);
+    if (type == STL::Invalid)
         return false;
-
-    // Read in 50 characters from position 80 on and check for keywords like 'SOLID', 'FACET', 'NORMAL',
-    // 'VERTEX', 'ENDFACET' or 'ENDLOOP'.
-    // As the file can be binary with one triangle only we must not read in more than (max.) 54 bytes because
-    // the file size has only 134 bytes in this case. On the other hand we must overread the first 80 bytes
-    // because it can happen that the file is binary but contains one of these keywords.
-    std::streambuf* buf = rstrIn.rdbuf();
-    if (!buf) return false;
-    buf->pubseekoff(80, std::ios::beg, std::ios::in);
-    uint32_t ulCt, ulBytes=50;
-    rstrIn.read((char*)&ulCt, sizeof(ulCt));
-    // if we have a binary STL with a single triangle we can only read-in 50 bytes
-    if (ulCt > 1)
-        ulBytes = 100;
-    // Either it's really an invalid STL file or it's just empty. In this case the number of facets must be 0.
-    if (!rstrIn.read(szBuf, ulBytes))
-        return (ulCt==0);
-    szBuf[ulBytes] = 0;
-    upper(szBuf);
+    if (type == STL::Empty)
+        return true;
 
     try {
-        if ((strstr(szBuf, "SOLID") == NULL)  && (strstr(szBuf, "FACET") == NULL)    && (strstr(szBuf, "NORMAL") == NULL) &&
-            (strstr(szBuf, "VERTEX") == NULL) && (strstr(szBuf, "ENDFACET") == NULL) && (strstr(szBuf, "ENDLOOP") == NULL)) {
-            // probably binary STL
-            buf->pubseekoff(0, std::ios::beg, std::ios::in);
+        if (type == STL::Binary) {
             return LoadBinarySTL(rstrIn);
         }
         else {
             // Ascii STL
-            buf->pubseekoff(0, std::ios::beg, std::ios::in);
             return LoadAsciiSTL(rstrIn);
         }
     }
@@ -669,6 +764,90 @@ namespace MeshCore {
                 return x.first == y;
             }
         };
+
+        std::size_t numberSize(Number number)
+        {
+            switch (number) {
+            case int8:
+            case uint8:
+                return 1;
+            case int16:
+            case uint16:
+                return 2;
+            case int32:
+            case uint32:
+            case float32:
+                return 4;
+            case float64:
+                return 8;
+            default:
+                return 0;
+            }
+        }
+
+        template <typename T>
+        float readValue(const char* data, bool swap)
+        {
+            T v;
+            std::memcpy(&v, data, sizeof(T));
+            if (swap)
+                Base::SwapEndian(v);
+            return static_cast<float>(v);
+        }
+
+        float readNumber(const char* data, Number number, bool swap)
+        {
+            switch (number) {
+            case int8:
+                return readValue<int8_t>(data, false);
+            case uint8:
+                return readValue<uint8_t>(data, false);
+            case int16:
+                return readValue<int16_t>(data, swap);
+            case uint16:
+                return readValue<uint16_t>(data, swap);
+            case int32:
+                return readValue<int32_t>(data, swap);
+            case uint32:
+                return readValue<uint32_t>(data, swap);
+            case float32:
+                return readValue<float>(data, swap);
+            case float64:
+                return readValue<double>(data, swap);
+            default:
+                return 0.0f;
+            }
+        }
+
+        /** Converts a block of binary vertices with the properties x, y, z and optionally red, green, blue. */
+        struct VertexBlock
+        {
+            const char* data;
+            std::size_t stride;
+            std::size_t offset[6];
+            Number type[6];
+            bool swap;
+            MeshPointArray* points;
+            std::vector<App::Color>* colors;
+            std::size_t begin, end;
+
+            void Run()
+            {
+                for (std::size_t i = begin; i < end; i++) {
+                    const char* vertex = data + i * stride;
+                    MeshPoint& pt = (*points)[i];
+                    pt.x = readNumber(vertex + offset[0], type[0], swap);
+                    pt.y = readNumber(vertex + offset[1], type[1], swap);
+                    pt.z = readNumber(vertex + offset[2], type[2], swap);
+                    if (colors) {
+                        float r = readNumber(vertex + offset[3], type[3], swap) / 255.0f;
+                        float g = readNumber(vertex + offset[4], type[4], swap) / 255.0f;
+                        float b = readNumber(vertex + offset[5], type[5], swap) / 255.0f;
+                        (*colors)[i] = App::Color(r, g, b);
+                    }
+                }
+            }
+        };
     }
     using namespace Ply;
 }
@@ -993,76 +1172,53 @@ bool MeshInput::LoadPLY (std::istream &inp)
     }
     // binary
     else {
-        Base::InputStream is(inp);
-        if (format == binary_little_endian)
-            is.setByteOrder(Base::Stream::LittleEndian);
-        else
-            is.setByteOrder(Base::Stream::BigEndian);
-
-        for (std::size_t i = 0; i < v_count; i++) {
-            // go through the vertex properties
-            std::map<std::string, float> prop_values;
-            for (std::vector<std::pair<std::string, Number> >::iterator it = vertex_props.begin(); it != vertex_props.end(); ++it) {
-                switch (it->second) {
-                case int8:
-                    {
-                        int8_t v; is >> v;
-                        prop_values[it->first] = static_cast<float>(v);
-                    } break;
-                case uint8:
-                    {
-                        uint8_t v; is >> v;
-                        prop_values[it->first] = static_cast<float>(v);
-                    } break;
-                case int16:
-                    {
-                        int16_t v; is >> v;
-                        prop_values[it->first] = static_cast<float>(v);
-                    } break;
-                case uint16:
-                    {
-                        uint16_t v; is >> v;
-                        prop_values[it->first] = static_cast<float>(v);
-                    } break;
-                case int32:
-                    {
-                        int32_t v; is >> v;
-                        prop_values[it->first] = static_cast<float>(v);
-                    } break;
-                case uint32:
-                    {
-                        uint32_t v; is >> v;
-                        prop_values[it->first] = static_cast<float>(v);
-                    } break;
-                case float32:
-                    {
-                        float v; is >> v;
-                        prop_values[it->first] = v;
-                    } break;
-                case float64:
-                    {
-                        double v; is >> v;
-                        prop_values[it->first] = static_cast<float>(v);
-                    } break;
-                default:
-                    return false;
+        // all vertex properties have a fixed size, so the vertices are read in one go
+        // and converted by several threads
+        const char* names[6] = {"x", "y", "z", "red", "green", "blue"};
+        VertexBlock vertex;
+        std::size_t stride = 0;
+        for (std::vector<std::pair<std::string, Number> >::iterator it = vertex_props.begin(); it != vertex_props.end(); ++it) {
+            for (int j = 0; j < 6; j++) {
+                if (it->first == names[j]) {
+                    vertex.offset[j] = stride;
+                    vertex.type[j] = it->second;
                 }
             }
+            stride += numberSize(it->second);
+        }
 
-            Base::Vector3f pt;
-            pt.x = (prop_values["x"]);
-            pt.y = (prop_values["y"]);
-            pt.z = (prop_values["z"]);
-            meshPoints.push_back(pt);
+        std::vector<char> data(v_count * stride);
+        if (!data.empty() && !inp.read(&data[0], data.size()))
+            return false;
 
-            if (_material && (rgb_value == MeshIO::PER_VERTEX)) {
-                float r = (prop_values["red"]) / 255.0f;
-                float g = (prop_values["green"]) / 255.0f;
-                float b = (prop_values["blue"]) / 255.0f;
-                _material->diffuseColor.push_back(App::Color(r, g, b));
-            }
+        meshPoints.resize(v_count);
+        vertex.data = data.empty() ? 0 : &data[0];
+        vertex.stride = stride;
+        vertex.swap = (format == binary_big_endian);
+        vertex.points = &meshPoints;
+        vertex.colors = 0;
+        if (_material && (rgb_value == MeshIO::PER_VERTEX)) {
+            _material->diffuseColor.resize(v_count);
+            vertex.colors = &_material->diffuseColor;
         }
 
+        std::vector<VertexBlock> blocks;
+        for (std::size_t i = 0; i < v_count; i += 0x10000) {
+            vertex.begin = i;
+            vertex.end = std::min<std::size_t>(v_count, i + 0x10000);
+            blocks.push_back(vertex);
+        }
+        if (blocks.size() == 1)
+            blocks.front().Run();
+        else if (!blocks.empty())
+            QtConcurrent::blockingMap(blocks, &VertexBlock::Run);
+
+        Base::InputStream is(inp);
+        if (format == binary_little_endian)
+            is.setByteOrder(Base::Stream::LittleEndian);
+        else
+            is.setByteOrder(Base::Stream::BigEndian);
+
         unsigned char n;
         uint32_t f1, f2, f3;
         for (std::size_t i = 0; i < f_count; i++) {
@@ -1266,8 +1422,6 @@ bool MeshInput::LoadAsciiSTL (std::istream &rstrIn)
 bool MeshInput::LoadBinarySTL (std::istream &rstrIn)
 {
     char szInfo[80];
-    Base::Vector3f clVects[4];
-    uint16_t usAtt = 0;
     uint32_t ulCt = 0;
 
     if (!rstrIn || rstrIn.bad() == true)
@@ -1297,24 +1451,47 @@ bool MeshInput::LoadBinarySTL (std::istream &rstrIn)
     if (ulCt > ulFac)
         return false;// not a valid STL file
 
-#if 0
-    MeshBuilder builder(this->_rclMesh);
-#else
+    // read the facets in large blocks, each block is converted by several threads
+    std::vector<Base::Vector3f> points(3 * static_cast<std::size_t>(ulCt));
+    std::vector<char> block(STL::FacetSize * std::min<uint32_t>(ulCt, 16 * STL::FacetsPerBlock));
+    uint32_t ulRead = 0;
+    while (ulRead < ulCt) {
+        uint32_t ulBlock = std::min<uint32_t>(ulCt - ulRead, block.size() / STL::FacetSize);
+        if (!rstrIn.read(&block[0], ulBlock * STL::FacetSize))
+            break;
+        STL::readFacets(&block[0], ulBlock, &points[3 * static_cast<std::size_t>(ulRead)]);
+        ulRead += ulBlock;
+    }
+    points.resize(3 * static_cast<std::size_t>(ulRead));
+
     MeshFastBuilder builder(this->_rclMesh);
-#endif
-    builder.Initialize(ulCt);
+    builder.AddFacets(points);
+    builder.Finish();
 
-    for (uint32_t i = 0; i < ulCt; i++) {
-        // read normal, points
-        rstrIn.read((char*)&clVects, sizeof(clVects));
+    return true;
+}
 
-        std::swap(clVects[0], clVects[3]);
-        builder.AddFacet(clVects);
+/** Loads a binary STL file from a memory block. */
+bool MeshInput::LoadBinarySTL (const char* pData, std::size_t ulSize)
+{
+    uint32_t ulCt = 0;
+    if (ulSize < 80 + sizeof(ulCt))
+        return false;
 
-        // overread 2 bytes attribute
-        rstrIn.read((char*)&usAtt, sizeof(usAtt));
-    }
+    // skip the header and read the number of facets
+    std::memcpy(&ulCt, pData + 80, sizeof(ulCt));
 
+    // compare with the number of facets the size allows
+    std::size_t ulFac = (ulSize - (80 + sizeof(ulCt))) / STL::FacetSize;
+    if (ulCt > ulFac)
+        return false;// not a valid STL file
+
+    std::vector<Base::Vector3f> points(3 * static_cast<std::size_t>(ulCt));
+    if (ulCt > 0)
+        STL::readFacets(pData + 80 + sizeof(ulCt), ulCt, &points[0]);
+
+    MeshFastBuilder builder(this->_rclMesh);
+    builder.AddFacets(points);
     builder.Finish();
 
     return true;
@@ -3215,50 +3392,71 @@ MeshPointFacetAdjacency::~MeshPointFacetAdjacency()
 
 void MeshPointFacetAdjacency::Build()
 {
-    std::vector<std::size_t> numFacetAdjacency(numPoints);
+    pointFacetOffsets.assign(numPoints + 1, 0);
     for (MeshFacetArray::iterator it = facets.begin(); it != facets.end(); ++it) {
-        numFacetAdjacency[it->_aulPoints[0]]++;
-        numFacetAdjacency[it->_aulPoints[1]]++;
-        numFacetAdjacency[it->_aulPoints[2]]++;
+        pointFacetOffsets[it->_aulPoints[0] + 1]++;
+        pointFacetOffsets[it->_aulPoints[1] + 1]++;
+        pointFacetOffsets[it->_aulPoints[2] + 1]++;
     }
 
-    pointFacetAdjacency.resize(numPoints);
     for (std::size_t i = 0; i < numPoints; i++)
-        pointFacetAdjacency[i].reserve(numFacetAdjacency[i]);
+        pointFacetOffsets[i + 1] += pointFacetOffsets[i];
 
+    std::vector<std::size_t> pos(pointFacetOffsets.begin(), pointFacetOffsets.end() - 1);
+    pointFacetAdjacency.resize(pointFacetOffsets.back());
     std::size_t numFacets = facets.size();
     for (std::size_t i = 0; i < numFacets; i++) {
         for (int j = 0; j < 3; j++) {
-            pointFacetAdjacency[facets[i]._aulPoints[j]].push_back(i);
+            pointFacetAdjacency[pos[facets[i]._aulPoints[j]]++] = i;
         }
     }
 }
 
 void MeshPointFacetAdjacency::SetFacetNeighbourhood()
 {
+    // each facet only writes its own neighbours, so the ranges can be handled in parallel
     std::size_t numFacets = facets.size();
-    for (std::size_t index = 0; index < numFacets; index++) {
+    std::size_t numThreads = std::max<int>(1, QThread::idealThreadCount());
+    numThreads = std::min<std::size_t>(numThreads, numFacets / 100000);
+    if (numThreads < 2) {
+        SetFacetNeighbourhood(0, numFacets);
+        return;
+    }
+
+    std::vector<Range> ranges(numThreads);
+    std::size_t step = numFacets / numThreads;
+    for (std::size_t t = 0; t < numThreads; t++) {
+        ranges[t].adjacency = this;
+        ranges[t].begin = t * step;
+        ranges[t].end = (t + 1 < numThreads) ? (t + 1) * step : numFacets;
+    }
+
+    QtConcurrent::blockingMap(ranges, &Range::Run);
+}
+
+void MeshPointFacetAdjacency::SetFacetNeighbourhood(std::size_t begin, std::size_t end)
+{
+    for (std::size_t index = begin; index < end; index++) {
         MeshFacet& facet1 = facets[index];
         for (int i = 0; i < 3; i++) {
             std::size_t n1 = facet1._aulPoints[i];
             std::size_t n2 = facet1._aulPoints[(i+1)%3];
 
-            bool success = false;
-            const std::vector<std::size_t>& refFacets = pointFacetAdjacency[n1];
-            for (std::vector<std::size_t>::const_iterator it = refFacets.begin(); it != refFacets.end(); ++it) {
-                if (*it != index) {
-                    MeshFacet& facet2 = facets[*it];
+            // set the neighbour only if the edge is shared by exactly two facets
+            unsigned long neighbour = ULONG_MAX;
+            int count = 0;
+            for (std::size_t j = pointFacetOffsets[n1]; j < pointFacetOffsets[n1+1]; j++) {
+                std::size_t other = pointFacetAdjacency[j];
+                if (other != index) {
+                    const MeshFacet& facet2 = facets[other];
                     if (facet2.HasPoint(n2)) {
-                        facet1._aulNeighbours[i] = *it;
-                        success = true;
-                        break;
+                        neighbour = other;
+                        count++;
                     }
                 }
             }
 
-            if (!success) {
-                facet1._aulNeighbours[i] = ULONG_MAX;
-            }
+            facet1._aulNeighbours[i] = count == 1 ? neighbour : ULONG_MAX;
         }
     }
 }
@@ -108,6 +108,9 @@ public:
     bool LoadAsciiSTL (std::istream &rstrIn);
     /** Loads a binary STL file. */
     bool LoadBinarySTL (std::istream &rstrIn);
+    /** Loads a binary STL file from the memory block \a pData of \a ulSize bytes,
+     * e.g. a file mapped into memory. */
+    bool LoadBinarySTL (const char* pData, std::size_t ulSize);
     /** Loads an OBJ Mesh file. */
     bool LoadOBJ (std::istream &rstrIn);
     /** Loads an SMF Mesh file. */
@@ -261,6 +264,8 @@ private:
    and set the neighbourhood of the facets.
    At this point the MeshFacetArray only references the points but does not have set
    the neighbourhood of two adjacent facets.
+   An edge shared by more than two facets is non-manifold and gets no neighbour, like
+   in MeshKernel::RebuildNeighbours().
  */
 class MeshPointFacetAdjacency
 {
@@ -274,7 +279,8 @@ public:
     ~MeshPointFacetAdjacency();
 
     /*!
-      \brief Set the neighbourhood of two adjacent facets.
+      \brief Set the neighbourhood of two adjacent facets. Large meshes are
+      handled by several threads.
      */
     void SetFacetNeighbourhood();
 
@@ -283,11 +289,24 @@ private:
       \brief Build up the adjacency information.
      */
     void Build();
+    /*!
+      \brief Set the neighbourhood of the facets in the range [begin, end).
+     */
+    void SetFacetNeighbourhood(std::size_t begin, std::size_t end);
+
+    struct Range
+    {
+        MeshPointFacetAdjacency* adjacency;
+        std::size_t begin, end;
+        void Run() { adjacency->SetFacetNeighbourhood(begin, end); }
+    };
 
 private:
     std::size_t numPoints;
     MeshFacetArray& facets;
-    std::vector< std::vector<std::size_t> > pointFacetAdjacency;
+    // the facets of point i are in [pointFacetOffsets[i], pointFacetOffsets[i+1])
+    std::vector<std::size_t> pointFacetOffsets;
+    std::vector<std::size_t> pointFacetAdjacency;
 };
 
 
@@ -803,18 +803,33 @@ void MeshKernel::Write (std::ostream &rclOut) const
     // write the number of points and facets
     str << (uint32_t)CountPoints() << (uint32_t)CountFacets();
 
-    // write the data
-    for (MeshPointArray::_TConstIterator it = _aclPointArray.begin(); it != _aclPointArray.end(); ++it) {
-        str << it->x << it->y << it->z;
+    // write the data block-wise to avoid a stream call for each value
+    const std::size_t blockSize = 0x4000;
+    std::vector<float> coords;
+    coords.reserve(3 * blockSize);
+    for (MeshPointArray::_TConstIterator it = _aclPointArray.begin(); it != _aclPointArray.end();) {
+        coords.clear();
+        for (std::size_t i = 0; i < blockSize && it != _aclPointArray.end(); ++i, ++it) {
+            coords.push_back(it->x);
+            coords.push_back(it->y);
+            coords.push_back(it->z);
+        }
+        str.write(&coords[0], coords.size());
     }
 
-    for (MeshFacetArray::_TConstIterator it = _aclFacetArray.begin(); it != _aclFacetArray.end(); ++it) {
-        str << (uint32_t)it->_aulPoints[0] 
-            << (uint32_t)it->_aulPoints[1] 
-            << (uint32_t)it->_aulPoints[2];
-        str << (uint32_t)it->_aulNeighbours[0] 
-            << (uint32_t)it->_aulNeighbours[1] 
-            << (uint32_t)it->_aulNeighbours[2];
+    std::vector<uint32_t> indices;
+    indices.reserve(6 * blockSize);
+    for (MeshFacetArray::_TConstIterator it = _aclFacetArray.begin(); it != _aclFacetArray.end();) {
+        indices.clear();
+        for (std::size_t i = 0; i < blockSize && it != _aclFacetArray.end(); ++i, ++it) {
+            indices.push_back((uint32_t)it->_aulPoints[0]);
+            indices.push_back((uint32_t)it->_aulPoints[1]);
+            indices.push_back((uint32_t)it->_aulPoints[2]);
+            indices.push_back((uint32_t)it->_aulNeighbours[0]);
+            indices.push_back((uint32_t)it->_aulNeighbours[1]);
+            indices.push_back((uint32_t)it->_aulNeighbours[2]);
+        }
+        str.write(&indices[0], indices.size());
     }
 
     str << _clBoundBox.MinX << _clBoundBox.MaxX;
@@ -856,42 +871,45 @@ void MeshKernel::Read (std::istream &rclIn)
         str >> uCtPts >> uCtFts;
 
         try {
-            // read the data
+            // read the data block-wise to avoid a stream call for each value
+            const std::size_t blockSize = 0x4000;
             MeshPointArray pointArray;
             pointArray.resize(uCtPts);
-            for (MeshPointArray::_TIterator it = pointArray.begin(); it != pointArray.end(); ++it) {
-                str >> it->x >> it->y >> it->z;
+            std::vector<float> coords(3 * blockSize);
+            for (MeshPointArray::_TIterator it = pointArray.begin(); it != pointArray.end();) {
+                std::size_t num = std::min<std::size_t>(blockSize, pointArray.end() - it);
+                str.read(&coords[0], 3 * num);
+                for (std::size_t i = 0; i < num; ++i, ++it) {
+                    it->x = coords[3*i];
+                    it->y = coords[3*i+1];
+                    it->z = coords[3*i+2];
+                }
             }
           
             MeshFacetArray facetArray;
             facetArray.resize(uCtFts);
 
-            uint32_t v1, v2, v3;
-            for (MeshFacetArray::_TIterator it = facetArray.begin(); it != facetArray.end(); ++it) {
-                str >> v1 >> v2 >> v3;
-                it->_aulPoints[0] = v1;
-                it->_aulPoints[1] = v2;
-                it->_aulPoints[2] = v3;
-
-                // On systems where an 'unsigned long' is a 64-bit value
-                // the empty neighbour must be explicitly set to 'ULONG_MAX'
-                // because in algorithms this value is always used to check
-                // for open edges.
-                str >> v1 >> v2 >> v3;
-                if (v1 < open_edge)
-                    it->_aulNeighbours[0] = v1;
-                else
-                    it->_aulNeighbours[0] = ULONG_MAX;
-
-                if (v2 < open_edge)
-                    it->_aulNeighbours[1] = v2;
-                else
-                    it->_aulNeighbours[1] = ULONG_MAX;
-
-                if (v3 < open_edge)
-                    it->_aulNeighbours[2] = v3;
-                else
-                    it->_aulNeighbours[2] = ULONG_MAX;
+            std::vector<uint32_t> indices(6 * blockSize);
+            for (MeshFacetArray::_TIterator it = facetArray.begin(); it != facetArray.end();) {
+                std::size_t num = std::min<std::size_t>(blockSize, facetArray.end() - it);
+                str.read(&indices[0], 6 * num);
+                for (std::size_t i = 0; i < num; ++i, ++it) {
+                    const uint32_t* v = &indices[6*i];
+                    it->_aulPoints[0] = v[0];
+                    it->_aulPoints[1] = v[1];
+                    it->_aulPoints[2] = v[2];
+
+                    // On systems where an 'unsigned long' is a 64-bit value
+                    // the empty neighbour must be explicitly set to 'ULONG_MAX'
+                    // because in algorithms this value is always used to check
+                    // for open edges.
+                    for (int j = 0; j < 3; j++) {
+                        if (v[3+j] < open_edge)
+                            it->_aulNeighbours[j] = v[3+j];
+                        else
+                            it->_aulNeighbours[j] = ULONG_MAX;
+                    }
+                }
             }
 
             str >> _clBoundBox.MinX >> _clBoundBox.MaxX;
@@ -46,6 +46,7 @@
 #include "Iterator.h"
 #include "Algorithm.h"
 #include "Grid.h"
+#include "BVH.h"
 
 #include <Base/Exception.h>
 #include <Base/Console.h>
@@ -368,12 +369,6 @@ bool MeshProjection::projectLineOnMesh(const MeshFacetGrid& grid,
                                        const Base::Vector3f& vd,
                                        std::vector<Base::Vector3f>& polyline)
 {
-    Base::Vector3f dir(v2 - v1);
-    Base::Vector3f base(v1), normal(vd % dir);
-    normal.Normalize();
-    dir.Normalize();
-
-
     std::vector<unsigned long> facets;
 
     // special case: start and endpoint inside same facet
@@ -394,10 +389,58 @@ bool MeshProjection::projectLineOnMesh(const MeshFacetGrid& grid,
     std::sort(facets.begin(), facets.end());
     facets.erase(std::unique(facets.begin(), facets.end()), facets.end());
 
+    return projectLineOnFacets(facets, v1, f1, v2, f2, vd, polyline);
+}
+
+bool MeshProjection::projectLineOnMesh(const MeshFacetBVH& tree,
+                                       const Base::Vector3f& v1, unsigned long f1,
+                                       const Base::Vector3f& v2, unsigned long f2,
+                                       const Base::Vector3f& vd,
+                                       std::vector<Base::Vector3f>& polyline)
+{
+    std::vector<unsigned long> facets;
+
+    // special case: start and endpoint inside same facet
+    if (f1 == f2) {
+        polyline.push_back(v1);
+        polyline.push_back(v2);
+        return true;
+    }
+
+    // cut all facets between the two endpoints, the boxes of the tree are tested
+    // for the plane and the strip between the endpoints so that no facet is lost
+    Base::Vector3f dir(v2 - v1), normal(vd % dir);
+    normal.Normalize();
+    float len = dir.Length();
+    dir.Normalize();
+    tree.Select([&](const Base::BoundBox3f& bbox) {
+        if (!bbox.IsCutPlane(v1, normal))
+            return false;
+        float center = (bbox.GetCenter() - v1) * dir;
+        float radius = 0.5f * (fabs(dir.x) * bbox.LengthX() + fabs(dir.y) * bbox.LengthY() + fabs(dir.z) * bbox.LengthZ());
+        return (center + radius >= 0.0f) && (center - radius <= len);
+    }, facets);
+
+    std::sort(facets.begin(), facets.end());
+
+    return projectLineOnFacets(facets, v1, f1, v2, f2, vd, polyline);
+}
+
+bool MeshProjection::projectLineOnFacets(const std::vector<unsigned long>& facets,
+                                         const Base::Vector3f& v1, unsigned long f1,
+                                         const Base::Vector3f& v2, unsigned long f2,
+                                         const Base::Vector3f& vd,
+                                         std::vector<Base::Vector3f>& polyline) const
+{
+    Base::Vector3f dir(v2 - v1);
+    Base::Vector3f base(v1), normal(vd % dir);
+    normal.Normalize();
+    dir.Normalize();
+
     // cut all facets with plane
     std::list< std::pair<Base::Vector3f, Base::Vector3f> > cutLine;
     //unsigned long start = 0, end = 0;
-    for (std::vector<unsigned long>::iterator it = facets.begin(); it != facets.end(); ++it) {
+    for (std::vector<unsigned long>::const_iterator it = facets.begin(); it != facets.end(); ++it) {
         Base::Vector3f e1, e2;
         MeshGeomFacet tria = kernel.GetFacet(*it);
         if (bboxInsideRectangle(tria.GetBoundBox(), v1, v2, vd)) {
@@ -39,6 +39,7 @@ namespace MeshCore
 {
 
 class MeshFacetGrid;
+class MeshFacetBVH;
 class MeshKernel;
 class MeshGeomFacet;
 
@@ -51,7 +52,13 @@ public:
     bool projectLineOnMesh(const MeshFacetGrid& grid, const Base::Vector3f& p1, unsigned long f1,
         const Base::Vector3f& p2, unsigned long f2, const Base::Vector3f& view,
         std::vector<Base::Vector3f>& polyline);
+    bool projectLineOnMesh(const MeshFacetBVH& tree, const Base::Vector3f& p1, unsigned long f1,
+        const Base::Vector3f& p2, unsigned long f2, const Base::Vector3f& view,
+        std::vector<Base::Vector3f>& polyline);
 protected:
+    bool projectLineOnFacets(const std::vector<unsigned long>& facets, const Base::Vector3f& p1, unsigned long f1,
+        const Base::Vector3f& p2, unsigned long f2, const Base::Vector3f& view,
+        std::vector<Base::Vector3f>& polyline) const;
     bool bboxInsideRectangle (const Base::BoundBox3f& bbox, const Base::Vector3f& p1, const Base::Vector3f& p2, const Base::Vector3f& view) const;
     bool isPointInsideDistance (const Base::Vector3f& p1, const Base::Vector3f& p2, const Base::Vector3f& pt) const;
     bool connectLines(std::list< std::pair<Base::Vector3f, Base::Vector3f> >& cutLines, const Base::Vector3f& startPoint,
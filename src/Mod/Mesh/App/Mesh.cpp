@@ -37,10 +37,12 @@
 #include <Base/Sequencer.h>
 #include <Base/Tools.h>
 #include <Base/ViewProj.h>
+#include <App/Application.h>
 
 #include "Core/Builder.h"
 #include "Core/MeshKernel.h"
 #include "Core/Grid.h"
+#include "Core/BVH.h"
 #include "Core/Iterator.h"
 #include "Core/Info.h"
 #include "Core/TopoAlgorithm.h"
@@ -986,8 +988,20 @@ std::vector<Base::Vector3d> MeshObject::getPointNormals() const
 void MeshObject::crossSections(const std::vector<MeshObject::TPlane>& planes, std::vector<MeshObject::TPolylines> &sections,
                                float fMinEps, bool bConnectPolygons) const
 {
-    MeshCore::MeshFacetGrid grid(_kernel);
     MeshCore::MeshAlgorithm algo(_kernel);
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Mesh");
+    if (hGrp->GetBool("UseBVH", false)) {
+        MeshCore::MeshFacetBVH tree(_kernel);
+        for (std::vector<MeshObject::TPlane>::const_iterator it = planes.begin(); it != planes.end(); ++it) {
+            MeshObject::TPolylines polylines;
+            algo.CutWithPlane(it->first, it->second, tree, polylines, fMinEps, bConnectPolygons);
+            sections.push_back(polylines);
+        }
+        return;
+    }
+
+    MeshCore::MeshFacetGrid grid(_kernel);
     for (std::vector<MeshObject::TPlane>::const_iterator it = planes.begin(); it != planes.end(); ++it) {
         MeshObject::TPolylines polylines;
         algo.CutWithPlane(it->first, it->second, grid, polylines, fMinEps, bConnectPolygons);
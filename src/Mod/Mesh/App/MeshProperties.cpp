@@ -623,6 +623,12 @@ void PropertyMeshKernel::RestoreDocFile(Base::Reader &reader)
     hasSetValue();
 }
 
+bool PropertyMeshKernel::canDeduplicateDocFile(const Base::Writer &/*writer*/) const
+{
+    // the binary data only depends on the mesh kernel
+    return true;
+}
+
 App::Property *PropertyMeshKernel::Copy(void) const
 {
     // Note: Copy the content, do NOT reference the same mesh object
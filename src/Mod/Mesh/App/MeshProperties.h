@@ -244,6 +244,7 @@ public:
 
     void SaveDocFile (Base::Writer &writer) const;
     void RestoreDocFile(Base::Reader &reader);
+    bool canDeduplicateDocFile(const Base::Writer &writer) const;
 
     App::Property *Copy(void) const;
     void Paste(const App::Property &from);
@@ -41,6 +41,20 @@ class MeshTopoTestCases(unittest.TestCase):
 		planarMeshObject = Mesh.Mesh(self.planarMesh)
 		planarMeshObject.collapseFacets(range(18))
 
+	def testIndices(self):
+		# the 12 border edges have no neighbour, also if indices are stored in 32 bits
+		planarMeshObject = Mesh.Mesh(self.planarMesh)
+		self.assertEqual(planarMeshObject.CountPoints, 16)
+		points = [i for f in planarMeshObject.Facets for i in f.PointIndices]
+		self.assertTrue(max(points) < 16)
+		neighbours = [i for f in planarMeshObject.Facets for i in f.NeighbourIndices]
+		invalid = [i for i in neighbours if i >= 18]
+		self.assertEqual(len(invalid), 12)
+		self.assertEqual(len(set(invalid)), 1)
+		self.assertFalse(planarMeshObject.hasInvalidPoints())
+		planarMeshObject.fixIndices()
+		self.assertEqual(planarMeshObject.CountFacets, 18)
+
 
 class MeshGeoTestCases(unittest.TestCase):
 	def setUp(self):
@@ -225,3 +239,45 @@ class PolynomialFitCases(unittest.TestCase):
 
     def tearDown(self):
         pass
+
+
+class MeshBVHTestCases(unittest.TestCase):
+    def setUp(self):
+        self.grp = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Mod/Mesh")
+        self.useBVH = self.grp.GetBool("UseBVH", False)
+
+    def crossSections(self, mesh, planes, useBVH):
+        self.grp.SetBool("UseBVH", useBVH)
+        sections = mesh.crossSections(planes)
+        return [[[(round(v.x, 5), round(v.y, 5), round(v.z, 5)) for v in poly] for poly in section] for section in sections]
+
+    def testCrossSections(self):
+        # the BVH must find the same facets as the grid
+        mesh = Mesh.createSphere(10.0, 50)
+        mesh.addMesh(Mesh.createBox(2.0, 30.0, 3.0))
+        planes = []
+        for i in range(-9, 10):
+            planes.append((FreeCAD.Vector(0, 0, i + 0.37), FreeCAD.Vector(0, 0, 1)))
+            planes.append((FreeCAD.Vector(i + 0.21, 0, 0), FreeCAD.Vector(1, 0.3, 0.1)))
+        grid = self.crossSections(mesh, planes, False)
+        tree = self.crossSections(mesh, planes, True)
+        self.assertEqual(len(grid), len(planes))
+        self.assertTrue(sum(len(s) for s in grid) > 0)
+        self.assertEqual(grid, tree)
+
+    def tearDown(self):
+        self.grp.SetBool("UseBVH", self.useBVH)
+
+
+class MeshIOTestCases(unittest.TestCase):
+    def testEmptyBinarySTL(self):
+        # 80 bytes header and 0 facets
+        name = tempfile.gettempdir() + os.sep + "empty.stl"
+        with open(name, "wb") as f:
+            f.write(b"\0" * 80)
+            f.write(b"\0" * 4)
+        try:
+            mesh = Mesh.Mesh(name)
+            self.assertEqual(mesh.CountFacets, 0)
+        finally:
+            os.remove(name)
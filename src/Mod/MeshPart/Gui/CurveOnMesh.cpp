@@ -43,6 +43,7 @@
 #endif
 
 #include "CurveOnMesh.h"
+#include <App/Application.h>
 #include <App/Document.h>
 #include <Gui/Document.h>
 #include <Gui/MainWindow.h>
@@ -50,6 +51,7 @@
 #include <Gui/View3DInventor.h>
 #include <Gui/View3DInventorViewer.h>
 #include <Mod/Mesh/App/Core/Algorithm.h>
+#include <Mod/Mesh/App/Core/BVH.h>
 #include <Mod/Mesh/App/Core/Grid.h>
 #include <Mod/Mesh/App/Core/MeshKernel.h>
 #include <Mod/Mesh/App/Core/Projection.h>
@@ -244,6 +246,7 @@ public:
         , curve(new ViewProviderCurveOnMesh)
         , mesh(0)
         , grid(0)
+        , tree(0)
         , kernel(0)
         , viewer(0)
         , editcursor(QPixmap(cursor_curveonmesh), 7, 7)
@@ -253,6 +256,7 @@ public:
     {
         delete curve;
         delete grid;
+        delete tree;
     }
     static void vertexCallback(void * ud, SoEventCallback * n);
     std::vector<SbVec3f> convert(const std::vector<Base::Vector3f>& points) const
@@ -268,10 +272,18 @@ public:
     {
         Mesh::Feature* mf = static_cast<Mesh::Feature*>(mesh->getObject());
         const Mesh::MeshObject& meshObject = mf->Mesh.getValue();
+        kernel = &meshObject;
+
+        ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+            ("User parameter:BaseApp/Preferences/Mod/Mesh");
+        if (hGrp->GetBool("UseBVH", false)) {
+            tree = new MeshCore::MeshFacetBVH(meshObject.getKernel());
+            return;
+        }
+
         MeshCore::MeshAlgorithm alg(meshObject.getKernel());
         float fAvgLen = alg.GetAverageEdgeLength();
         grid = new MeshCore::MeshFacetGrid(meshObject.getKernel(), 5.0f * fAvgLen);
-        kernel = &meshObject;
     }
     bool projectLineOnMesh(const PickedPoint& pick)
     {
@@ -282,7 +294,9 @@ public:
         Base::Vector3f v1 = Base::convertTo<Base::Vector3f>(last.point);
         Base::Vector3f v2 = Base::convertTo<Base::Vector3f>(pick.point);
         Base::Vector3f vd = Base::convertTo<Base::Vector3f>(viewer->getViewer()->getViewDirection());
-        if (meshProjection.projectLineOnMesh(*grid, v1, last.facet, v2, pick.facet, vd, polyline)) {
+        bool ok = tree ? meshProjection.projectLineOnMesh(*tree, v1, last.facet, v2, pick.facet, vd, polyline)
+                       : meshProjection.projectLineOnMesh(*grid, v1, last.facet, v2, pick.facet, vd, polyline);
+        if (ok) {
             if (polyline.size() > 1) {
                 if (cutLines.empty()) {
                     cutLines.push_back(polyline);
@@ -323,6 +337,7 @@ public:
     ViewProviderCurveOnMesh* curve;
     Gui::ViewProviderDocumentObject* mesh;
     MeshCore::MeshFacetGrid* grid;
+    MeshCore::MeshFacetBVH* tree;
     Base::Reference<const Mesh::MeshObject> kernel;
     QPointer<Gui::View3DInventor> viewer;
     QCursor editcursor;
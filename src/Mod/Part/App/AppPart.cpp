@@ -415,6 +415,7 @@ PyMOD_INIT_FUNC(Part)
     Part::AttachExtensionPython ::init();
 
     Part::Feature               ::init();
+    Part::Feature               ::initShapeCache();
     Part::FeatureExt            ::init();
     Part::BodyBase              ::init();
     Part::FeaturePython         ::init();
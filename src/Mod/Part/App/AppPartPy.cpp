@@ -482,6 +482,15 @@ public:
             "If not recursive, then return tuple(sourceObject, sourceElementName, [intermediateNames...]),\n"
             "otherwise return a list of tuple."
         );
+        add_varargs_method("getShapeCacheInfo",&Module::getShapeCacheInfo,
+            "getShapeCacheInfo() -> (memSize,[(obj,subname)...])\n"
+            "Returns the estimated memory of the shapes cached by getShape() and their\n"
+            "objects and sub-object paths, the most recently used first"
+        );
+        add_varargs_method("setShapeCacheSize",&Module::setShapeCacheSize,
+            "setShapeCacheSize(size)\n"
+            "Sets the memory of the shapes cached by getShape() in bytes, 0 disables the cache"
+        );
         add_varargs_method("splitSubname",&Module::splitSubname,
             "splitSubname(subname) -> list(sub,mapped,subElement)\n"
             "Split the given subname into a list\n\n"
@@ -2214,6 +2223,27 @@ private:
         return dict;
     }
 
+    Py::Object getShapeCacheInfo(const Py::Tuple& args) {
+        if (!PyArg_ParseTuple(args.ptr(), ""))
+            throw Py::Exception();
+        std::vector<std::pair<const App::DocumentObject*, std::string> > entries;
+        std::size_t size = Part::Feature::getShapeCacheInfo(entries);
+        Py::List list;
+        for(auto &v : entries) {
+            auto obj = const_cast<App::DocumentObject*>(v.first);
+            list.append(Py::TupleN(Py::Object(obj->getPyObject(),true),Py::String(v.second)));
+        }
+        return Py::TupleN(Py::Long(static_cast<unsigned long>(size)),list);
+    }
+
+    Py::Object setShapeCacheSize(const Py::Tuple& args) {
+        unsigned long size;
+        if (!PyArg_ParseTuple(args.ptr(), "k", &size))
+            throw Py::Exception();
+        Part::Feature::setShapeCacheSize(size);
+        return Py::None();
+    }
+
     Py::Object getElementHistory(const Py::Tuple& args) {
         const char *name;
         PyObject *recursive = Py_True;
@@ -33,6 +33,7 @@
 #include "modelRefine.h"
 #include <App/Application.h>
 #include <App/Document.h>
+#include <Base/Interpreter.h>
 #include <Base/Parameter.h>
 #include "TopoShapeOpCode.h"
 
@@ -69,6 +70,13 @@ short Boolean::mustExecute() const
     return 0;
 }
 
+bool Boolean::canRecomputeConcurrently() const
+{
+    // The input shapes are fetched with the Python lock held, but an
+    // expression may still run arbitrary Python code
+    return ExpressionEngine.numExpressions() == 0;
+}
+
 const char *Boolean::opCode() const {
     return TOPOP_BOOLEAN;
 }
@@ -81,12 +89,22 @@ App::DocumentObjectExecReturn *Boolean::execute(void)
 #endif
         std::vector<TopoShape> shapes;
         shapes.reserve(2);
-        // Now, let's get the TopoDS_Shape
-        shapes.push_back(Feature::getTopoShape(Base.getValue()));
+        bool checkModel;
+        {
+            // getTopoShape() goes through Python, which must be locked in
+            // case of a concurrent recompute
+            Base::PyGILStateLocker lock;
+            // Now, let's get the TopoDS_Shape
+            shapes.push_back(Feature::getTopoShape(Base.getValue()));
+            shapes.push_back(Feature::getTopoShape(Tool.getValue()));
+
+            Base::Reference<ParameterGrp> hGrp = App::GetApplication().GetUserParameter()
+                .GetGroup("BaseApp")->GetGroup("Preferences")->GetGroup("Mod/Part/Boolean");
+            checkModel = hGrp->GetBool("CheckModel", false);
+        }
         auto BaseShape = shapes[0].getShape();
         if (BaseShape.IsNull())
             throw Base::Exception("Base shape is null");
-        shapes.push_back(Feature::getTopoShape(Tool.getValue()));
         auto ToolShape = shapes[1].getShape();
         if (ToolShape.IsNull())
             throw Base::Exception("Tool shape is null");
@@ -99,10 +117,8 @@ App::DocumentObjectExecReturn *Boolean::execute(void)
         if (resShape.IsNull()) {
             return new App::DocumentObjectExecReturn("Resulting shape is null");
         }
-        Base::Reference<ParameterGrp> hGrp = App::GetApplication().GetUserParameter()
-            .GetGroup("BaseApp")->GetGroup("Preferences")->GetGroup("Mod/Part/Boolean");
 
-        if (hGrp->GetBool("CheckModel", false)) {
+        if (checkModel) {
             BRepCheck_Analyzer aChecker(resShape);
             if (! aChecker.IsValid() ) {
                 return new App::DocumentObjectExecReturn("Resulting shape is invalid");
@@ -51,6 +51,9 @@ public:
     short mustExecute() const;
     //@}
 
+    /// The boolean operation itself does not need the main thread
+    virtual bool canRecomputeConcurrently() const override;
+
     /// returns the type name of the ViewProvider
     const char* getViewProviderName(void) const {
         return "PartGui::ViewProviderBoolean";
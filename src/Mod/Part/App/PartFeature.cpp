@@ -47,6 +47,11 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/bind.hpp>
+#include <cstring>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <Base/Console.h>
 #include <Base/Writer.h>
@@ -340,57 +345,218 @@ TopoDS_Shape Feature::getShape(const App::DocumentObject *obj, const char *subna
     return getTopoShape(obj,subname,needSubElement,pmat,powner,resolveLink,transform,true).getShape();
 }
 
-struct ShapeCache {
-    std::map<const App::Document*,std::map<const App::DocumentObject*,TopoShape> > cache;
-    bool inited = false;
+// Cache of the shapes built by Feature::getTopoShape(). The shapes are stored without the
+// transformation of the sub-object path, so that the cached shape of an object and sub-object
+// path doesn't depend on the 'transform' and 'resolveLink' arguments. Each shape records the
+// objects it was built from, and a change of one of these objects removes the shape, unless the
+// changed property can't change any shape. If the estimated memory of the shapes exceeds the size
+// given by the parameter 'ShapeCacheSize' (in MB) the least recently used shapes are removed.
+class ShapeCache {
+public:
+    typedef std::pair<const App::DocumentObject*, std::string> Key;
+    typedef std::set<const App::DocumentObject*> Dependencies;
+
+    ShapeCache() : memSize(0), maxMemSize(0) {
+    }
+
+    // Reads the parameter and connects to the document signals, called in the main thread
     void init() {
-        if(inited)
-            return;
-        inited = true;
+        ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath(
+                "User parameter:BaseApp/Preferences/Mod/Part/General");
+        setMaxMemSize(static_cast<std::size_t>(std::max<long>(hGrp->GetInt("ShapeCacheSize",512),0)) << 20);
         App::GetApplication().signalDeleteDocument.connect(
                 boost::bind(&ShapeCache::slotDeleteDocument, this, _1));
         App::GetApplication().signalDeletedObject.connect(
-                boost::bind(&ShapeCache::slotClear, this, _1));
+                boost::bind(&ShapeCache::slotDeletedObject, this, _1));
         App::GetApplication().signalChangedObject.connect(
-                boost::bind(&ShapeCache::slotClear, this, _1));
+                boost::bind(&ShapeCache::slotChangedObject, this, _1, _2));
     }
 
-    void slotDeleteDocument(const App::Document &doc) {
-        cache.erase(&doc);
+    void setMaxMemSize(std::size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        maxMemSize = size;
+        shrink();
+    }
+
+    std::size_t getInfo(std::vector<Key> &keys) {
+        std::lock_guard<std::mutex> lock(mutex);
+        keys.assign(usage.begin(),usage.end());
+        return memSize;
     }
 
-    void slotClear(const App::DocumentObject &obj) {
-        auto it = cache.find(obj.getDocument());
+    bool getShape(const App::DocumentObject *obj, const char *subname, TopoShape &shape,
+            Dependencies &deps) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(Key(obj,subname?subname:""));
+        if(it==cache.end())
+            return false;
+        usage.splice(usage.begin(),usage,it->second.usage);
+        shape = it->second.shape;
+        deps.insert(it->second.deps.begin(),it->second.deps.end());
+        return true;
+    }
+
+    void setShape(const App::DocumentObject *obj, const char *subname, const TopoShape &shape,
+            const Dependencies &deps) {
+        std::size_t size = estimateMemSize(shape);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Key key(obj,subname?subname:"");
+        auto it = cache.find(key);
         if(it!=cache.end())
-            it->second.erase(&obj);
+            erase(it);
+        if(size > maxMemSize)
+            return;
+
+        usage.push_front(key);
+        it = cache.insert(std::make_pair(key,Entry())).first;
+        Entry &entry = it->second;
+        entry.usage = usage.begin();
+        entry.shape = shape;
+        entry.memSize = size;
+        entry.deps.assign(deps.begin(),deps.end());
+        if(!deps.count(obj))
+            entry.deps.push_back(obj);
+        for(auto dep : entry.deps)
+            dependents.insert(std::make_pair(dep,key));
+        memSize += size;
+        shrink();
+    }
+
+private:
+    struct Entry {
+        TopoShape shape;
+        std::size_t memSize;
+        std::list<Key>::iterator usage;
+        std::vector<const App::DocumentObject*> deps;
+    };
+
+    // A rough estimate of the memory of the geometry and the names of a shape element
+    enum { ElementMemSize = 1024 };
+
+    // Estimates the memory of a shape without walking through it. The shapes built by
+    // getTopoShape() have an element map, whose size is a measure of the number of elements.
+    static std::size_t estimateMemSize(const TopoShape &shape) {
+        std::size_t count = shape.getElementMapSize();
+        if(!count && !shape.isNull())
+            count = shape.countSubShapes(TopAbs_FACE) + shape.countSubShapes(TopAbs_EDGE);
+        return sizeof(TopoShape) + count*ElementMemSize;
+    }
+
+    void shrink() {
+        while(memSize > maxMemSize)
+            erase(cache.find(usage.back()));
+    }
+
+    void erase(std::map<Key,Entry>::iterator it) {
+        for(auto dep : it->second.deps) {
+            auto range = dependents.equal_range(dep);
+            for(auto i=range.first;i!=range.second;++i) {
+                if(i->second == it->first) {
+                    dependents.erase(i);
+                    break;
+                }
+            }
+        }
+        memSize -= it->second.memSize;
+        usage.erase(it->second.usage);
+        cache.erase(it);
     }
 
-    bool getShape(const App::DocumentObject *obj, TopoShape &shape) {
-        init();
-        auto &entry = cache[obj->getDocument()];
-        auto it = entry.find(obj);
-        if(it!=entry.end()) {
-            shape = it->second;
-            return true;
+    void erase(const std::vector<Key> &keys) {
+        for(auto &key : keys) {
+            auto it = cache.find(key);
+            if(it!=cache.end())
+                erase(it);
         }
-        return false;
     }
 
-    void setShape(const App::DocumentObject *obj, const TopoShape &shape) {
-        init();
-        cache[obj->getDocument()][obj] = shape;
+    void slotDeleteDocument(const App::Document &doc) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Key> keys;
+        for(auto &v : dependents) {
+            if(v.first->getDocument() == &doc)
+                keys.push_back(v.second);
+        }
+        erase(keys);
+    }
+
+    void slotDeletedObject(const App::DocumentObject &obj) {
+        invalidate(obj);
+    }
+
+    void slotChangedObject(const App::DocumentObject &obj, const App::Property &prop) {
+        // these properties never change a shape
+        if(&prop == &obj.Label || &prop == &obj.Label2 || &prop == &obj.ExpressionEngine)
+            return;
+        auto feature = dynamic_cast<const Feature*>(&obj);
+        if(feature && &prop == &feature->ColoredElements)
+            return;
+        invalidate(obj);
     }
 
+    // Removes the shapes built from the object
+    void invalidate(const App::DocumentObject &obj) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto range = dependents.equal_range(&obj);
+        if(range.first == range.second)
+            return;
+        std::vector<Key> keys;
+        for(auto it=range.first;it!=range.second;++it)
+            keys.push_back(it->second);
+        erase(keys);
+    }
+
+private:
+    std::map<Key,Entry> cache;
+    std::list<Key> usage; // most recently used first
+    std::multimap<const App::DocumentObject*, Key> dependents;
+    std::size_t memSize;
+    std::size_t maxMemSize;
+    std::mutex mutex;
 };
 static ShapeCache _ShapeCache;
 
-TopoShape Feature::getTopoShape(const App::DocumentObject *obj, const char *subname, 
+void Feature::initShapeCache()
+{
+    _ShapeCache.init();
+}
+
+void Feature::setShapeCacheSize(std::size_t size)
+{
+    _ShapeCache.setMaxMemSize(size);
+}
+
+std::size_t Feature::getShapeCacheInfo(std::vector<std::pair<const App::DocumentObject*, std::string> > &entries)
+{
+    return _ShapeCache.getInfo(entries);
+}
+
+// Adds the objects on the sub-object path to the dependencies of a cached shape
+static void addPathDependencies(const App::DocumentObject *obj, const char *subname,
+        ShapeCache::Dependencies &deps)
+{
+    if(!subname)
+        return;
+    for(const char *dot=strchr(subname,'.');dot;dot=strchr(dot+1,'.')) {
+        auto sobj = obj->getSubObject(std::string(subname,dot+1).c_str());
+        if(!sobj)
+            break;
+        deps.insert(sobj);
+        auto linked = sobj->getLinkedObject(true);
+        if(linked)
+            deps.insert(linked);
+    }
+}
+
+static TopoShape _getTopoShape(const App::DocumentObject *obj, const char *subname, 
         bool needSubElement, Base::Matrix4D *pmat, App::DocumentObject **powner, 
-        bool resolveLink, bool transform, bool noElementMap)
+        bool resolveLink, bool transform, bool noElementMap, ShapeCache::Dependencies &deps)
 {
     TopoShape shape;
 
     if(!obj) return shape;
+    deps.insert(obj);
 
     PyObject *pyobj = 0;
     Base::Matrix4D mat;
@@ -425,6 +591,8 @@ TopoShape Feature::getTopoShape(const App::DocumentObject *obj, const char *subn
         linked = owner;
     if(powner) 
         *powner = resolveLink?linked:owner;
+    deps.insert(owner);
+    deps.insert(linked);
 
     if(pyobj && PyObject_TypeCheck(pyobj,&TopoShapePy::Type)) {
         shape = *static_cast<TopoShapePy*>(pyobj)->getTopoShapePtr();
@@ -446,7 +614,7 @@ TopoShape Feature::getTopoShape(const App::DocumentObject *obj, const char *subn
         return shape;
 
     // Check for cache
-    if(_ShapeCache.getShape(obj,shape)) {
+    if(_ShapeCache.getShape(obj,subname,shape,deps)) {
         if(noElementMap) {
             shape.resetElementMap();
             shape.Tag = 0;
@@ -455,20 +623,21 @@ TopoShape Feature::getTopoShape(const App::DocumentObject *obj, const char *subn
         shape.transformShape(mat,false,true);
         return shape;
     }
-    if(obj!=owner && _ShapeCache.getShape(owner,shape)) {
+    if(obj!=owner && _ShapeCache.getShape(owner,0,shape,deps)) {
         if(noElementMap) {
             shape.resetElementMap();
             shape.Tag = 0;
             shape.Hasher.reset();
         }else if(owner->getDocument()!=obj->getDocument()) {
             shape.reTagElementMap(obj->getID(),obj->getDocument()->getStringHasher());
-            _ShapeCache.setShape(obj,shape);
+            addPathDependencies(obj,subname,deps);
+            _ShapeCache.setShape(obj,subname,shape,deps);
         }
         shape.transformShape(mat,false,true);
         return shape;
     }
     if(owner!=linked) {
-        shape = getTopoShape(linked,0,false,0,0,false,false);
+        shape = _getTopoShape(linked,0,false,0,0,false,false,false,deps);
         if(shape.isNull())
             return shape;
         if(noElementMap) {
@@ -479,10 +648,11 @@ TopoShape Feature::getTopoShape(const App::DocumentObject *obj, const char *subn
         shape.transformShape(linkMat,false,true);
         if(!noElementMap) {
             shape.reTagElementMap(tag,hasher);
-            _ShapeCache.setShape(owner,shape);
+            _ShapeCache.setShape(owner,0,shape,deps);
             if(owner->getDocument()!=obj->getDocument()) {
                 shape.reTagElementMap(obj->getID(),obj->getDocument()->getStringHasher());
-                _ShapeCache.setShape(obj,shape);
+                addPathDependencies(obj,subname,deps);
+                _ShapeCache.setShape(obj,subname,shape,deps);
             }
         }
         shape.transformShape(mat,false,true);
@@ -500,7 +670,7 @@ TopoShape Feature::getTopoShape(const App::DocumentObject *obj, const char *subn
         linked = link->getTrueLinkedObject(false);
         if(linked && linked!=owner) {
             Base::Matrix4D linkMat;
-            baseShape = getTopoShape(linked,0,false,0,0,false,false);
+            baseShape = _getTopoShape(linked,0,false,0,0,false,false,false,deps);
             if(!link->getShowElementValue())
                 baseShape.reTagElementMap(owner->getID(),owner->getDocument()->getStringHasher());
         }
@@ -516,12 +686,13 @@ TopoShape Feature::getTopoShape(const App::DocumentObject *obj, const char *subn
         auto subObj = owner->resolve(sub.c_str(), &parent, &childName,0,0,&mat,false);
         if(!parent && !subObj)
             continue;
+        addPathDependencies(owner,sub.c_str(),deps);
         visible = parent->isElementVisible(childName.c_str());
         if(visible==0)
             continue;
         TopoShape shape;
         if(baseShape.isNull()) {
-            shape = getTopoShape(owner,sub.c_str(),false,0,&subObj,false,false);
+            shape = _getTopoShape(owner,sub.c_str(),false,0,&subObj,false,false,false,deps);
             if(shape.isNull())
                 continue;
         }else{
@@ -541,15 +712,24 @@ TopoShape Feature::getTopoShape(const App::DocumentObject *obj, const char *subn
     shape.Tag = tag;
     shape.Hasher = hasher;
     shape.makECompound(shapes);
-    _ShapeCache.setShape(owner,shape);
+    _ShapeCache.setShape(owner,0,shape,deps);
     if(owner->getDocument()!=obj->getDocument()) {
         shape.reTagElementMap(obj->getID(),obj->getDocument()->getStringHasher());
-        _ShapeCache.setShape(obj,shape);
+        addPathDependencies(obj,subname,deps);
+        _ShapeCache.setShape(obj,subname,shape,deps);
     }
     shape.transformShape(mat,false,true);
     return shape;
 }
 
+TopoShape Feature::getTopoShape(const App::DocumentObject *obj, const char *subname, 
+        bool needSubElement, Base::Matrix4D *pmat, App::DocumentObject **powner, 
+        bool resolveLink, bool transform, bool noElementMap)
+{
+    ShapeCache::Dependencies deps;
+    return _getTopoShape(obj,subname,needSubElement,pmat,powner,resolveLink,transform,noElementMap,deps);
+}
+
 App::DocumentObject *Feature::getShapeOwner(const App::DocumentObject *obj, const char *subname)
 {
     if(!obj) return 0;
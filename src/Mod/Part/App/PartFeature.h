@@ -99,6 +99,17 @@ public:
             App::DocumentObject **owner=0, bool resolveLink=true, bool transform=true, 
             bool noElementMap=false);
 
+    /// Reads the size of the cache of getTopoShape() and connects it to the document signals, called in the main thread
+    static void initShapeCache();
+    /// Sets the memory of the cache of getTopoShape() in bytes, 0 disables the cache
+    static void setShapeCacheSize(std::size_t size);
+    /** Returns the estimated memory of the cache of getTopoShape() in bytes
+     *
+     * @param entries: returns the objects and sub-object paths of the cached
+     * shapes, the most recently used first
+     */
+    static std::size_t getShapeCacheInfo(std::vector<std::pair<const App::DocumentObject*, std::string> > &entries);
+
     struct HistoryItem {
         App::DocumentObject *obj;
         long tag;
@@ -107,6 +107,13 @@ App::DocumentObjectExecReturn* Primitive::execute(void) {
     return Part::Feature::execute();
 }
 
+bool Primitive::canRecomputeConcurrently() const
+{
+    // Expressions and the attacher read other objects through Python
+    return ExpressionEngine.numExpressions() == 0
+        && MapMode.getValue() == Attacher::mmDeactivated;
+}
+
 namespace Part {
     PYTHON_TYPE_DEF(PrimitivePy, PartFeaturePy)
     PYTHON_TYPE_IMP(PrimitivePy, PartFeaturePy)
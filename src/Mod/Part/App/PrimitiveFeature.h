@@ -47,6 +47,9 @@ public:
     PyObject* getPyObject();
     //@}
 
+    /// Unattached primitives without expressions only build their own shape
+    virtual bool canRecomputeConcurrently() const override;
+
 protected:
     void Restore(Base::XMLReader &reader);
     void onChanged (const App::Property* prop);
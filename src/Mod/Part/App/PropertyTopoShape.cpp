@@ -25,6 +25,7 @@
 
 #ifndef _PreComp_
 # include <sstream>
+# include <thread>
 # include <BRepAdaptor_Curve.hxx>
 # include <BRepAdaptor_Surface.hxx>
 # include <BRepBndLib.hxx>
@@ -81,6 +82,7 @@ using namespace Part;
 TYPESYSTEM_SOURCE(Part::PropertyPartShape , App::PropertyComplexGeoData);
 
 PropertyPartShape::PropertyPartShape()
+  : _LazyRestore(false), _RestoredBinary(false), _HasRestoredData(false)
 {
 }
 
@@ -91,6 +93,7 @@ PropertyPartShape::~PropertyPartShape()
 void PropertyPartShape::setValue(const TopoShape& sh)
 {
     aboutToSetValue();
+    dropRestoredData();
     _Shape = sh;
     auto obj = dynamic_cast<App::DocumentObject*>(getContainer());
     if(obj) {
@@ -108,6 +111,7 @@ void PropertyPartShape::setValue(const TopoShape& sh)
 void PropertyPartShape::setValue(const TopoDS_Shape& sh, bool resetElementMap)
 {
     aboutToSetValue();
+    dropRestoredData();
     auto obj = dynamic_cast<App::DocumentObject*>(getContainer());
     if(obj)
         _Shape.Tag = obj->getID();
@@ -118,17 +122,20 @@ void PropertyPartShape::setValue(const TopoDS_Shape& sh, bool resetElementMap)
 
 const TopoDS_Shape& PropertyPartShape::getValue(void)const 
 {
+    loadShape();
     return _Shape.getShape();
 }
 
 const TopoShape& PropertyPartShape::getShape() const
 {
+    loadShape();
     _Shape.initCache(-1);
     return this->_Shape;
 }
 
 const Data::ComplexGeoData* PropertyPartShape::getComplexData() const
 {
+    loadShape();
     _Shape.initCache(-1);
     return &(this->_Shape);
 }
@@ -136,6 +143,7 @@ const Data::ComplexGeoData* PropertyPartShape::getComplexData() const
 Base::BoundBox3d PropertyPartShape::getBoundingBox() const
 {
     Base::BoundBox3d box;
+    loadShape();
     if (_Shape.getShape().IsNull())
         return box;
     try {
@@ -161,6 +169,7 @@ Base::BoundBox3d PropertyPartShape::getBoundingBox() const
 
 void PropertyPartShape::transformGeometry(const Base::Matrix4D &rclTrf)
 {
+    loadShape();
     aboutToSetValue();
     _Shape.transformGeometry(rclTrf);
     hasSetValue();
@@ -168,6 +177,7 @@ void PropertyPartShape::transformGeometry(const Base::Matrix4D &rclTrf)
 
 PyObject *PropertyPartShape::getPyObject(void)
 {
+    loadShape();
     auto prop = static_cast<Base::PyObjectBase*>(Py::new_reference_to(shape2pyshape(_Shape)));
     if (prop) prop->setConst();
     return prop;
@@ -202,17 +212,35 @@ void PropertyPartShape::setPyObject(PyObject *value)
 App::Property *PropertyPartShape::Copy(void) const
 {
     PropertyPartShape *prop = new PropertyPartShape();
+    if (_HasRestoredData) {
+        // a copy of the unread data is read when the copy is accessed
+        std::lock_guard<std::mutex> lock(_RestoredMutex);
+        if (_HasRestoredData) {
+            prop->_Shape = this->_Shape;
+            prop->_RestoredData = this->_RestoredData;
+            prop->_RestoredBinary = this->_RestoredBinary;
+            prop->_HasRestoredData = true;
+            return prop;
+        }
+    }
     prop->_Shape = this->_Shape.makECopy();
     return prop;
 }
 
 void PropertyPartShape::Paste(const App::Property &from)
 {
-    setValue(dynamic_cast<const PropertyPartShape&>(from)._Shape);
+    const PropertyPartShape& prop = dynamic_cast<const PropertyPartShape&>(from);
+    prop.loadShape();
+    setValue(prop._Shape);
 }
 
 unsigned int PropertyPartShape::getMemSize (void) const
 {
+    if (_HasRestoredData) {
+        std::lock_guard<std::mutex> lock(_RestoredMutex);
+        if (_HasRestoredData)
+            return _Shape.getMemSize() + _RestoredData.size();
+    }
     return _Shape.getMemSize();
 }
 
@@ -376,15 +404,16 @@ static Standard_Boolean  BRepTools_Write(const TopoDS_Shape& Sh,
 
 void PropertyPartShape::SaveDocFile (Base::Writer &writer) const
 {
+    if (writeRestoredData(writer))
+        return;
+    loadShape();
     // If the shape is empty we simply store nothing. The file size will be 0 which
     // can be checked when reading in the data.
     if (_Shape.getShape().IsNull())
         return;
     TopoDS_Shape myShape = _Shape.getShape();
     if (writer.getMode("BinaryBrep")) {
-        TopoShape shape;
-        shape.setShape(myShape);
-        shape.exportBinary(writer.Stream());
+        WriteDocFile(writer);
     }
     else {
         bool direct = App::GetApplication().GetParameterGroupByPath
@@ -438,73 +467,153 @@ void PropertyPartShape::SaveDocFile (Base::Writer &writer) const
             fi.deleteFile();
         }
         else {
-            BRepTools_Write(myShape, writer.Stream());
+            WriteDocFile(writer);
         }
     }
 }
 
-void PropertyPartShape::RestoreDocFile(Base::Reader &reader)
+bool PropertyPartShape::canSaveDocFileConcurrently(const Base::Writer &writer) const
 {
-    // save the element map
-    auto elementMap = _Shape.resetElementMap();
-    auto hasher = _Shape.Hasher;
+    // writing through a temporary file is done in the main thread
+    return writer.getMode("BinaryBrep") || App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Part/General")->GetBool("DirectAccess", true);
+}
+
+bool PropertyPartShape::canDeduplicateDocFile(const Base::Writer &writer) const
+{
+    return canSaveDocFileConcurrently(writer);
+}
 
+void PropertyPartShape::WriteDocFile(Base::Writer &writer) const
+{
+    if (writeRestoredData(writer))
+        return;
+    loadShape();
+    TopoDS_Shape myShape = _Shape.getShape();
+    if (myShape.IsNull())
+        return;
+    if (writer.getMode("BinaryBrep")) {
+        TopoShape shape;
+        shape.setShape(myShape);
+        shape.exportBinary(writer.Stream());
+    }
+    else {
+        BRepTools_Write(myShape, writer.Stream());
+    }
+}
+
+void PropertyPartShape::RestoreDocFile(Base::Reader &reader)
+{
     Base::FileInfo brep(reader.getFileName());
-    TopoShape shape;
-    if (brep.hasExtension("bin")) {
-        shape.importBinary(reader);
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Part/General");
+    bool direct = hGrp->GetBool("DirectAccess", true);
+    _LazyRestore = hGrp->GetBool("LazyRestore", true);
+    if (brep.hasExtension("bin") || direct) {
+        ReadDocFile(reader);
     }
     else {
         TopoDS_Shape sh;
-        bool direct = App::GetApplication().GetParameterGroupByPath
-            ("User parameter:BaseApp/Preferences/Mod/Part/General")->GetBool("DirectAccess", true);
-        if (!direct) {
-            BRep_Builder builder;
-            // create a temporary file and copy the content from the zip stream
-            Base::FileInfo fi(App::Application::getTempFileName());
-
-            // read in the ASCII file and write back to the file stream
-            Base::ofstream file(fi, std::ios::out | std::ios::binary);
-            unsigned long ulSize = 0; 
-            if (reader) {
-                std::streambuf* buf = file.rdbuf();
-                reader >> buf;
-                file.flush();
-                ulSize = buf->pubseekoff(0, std::ios::cur, std::ios::in);
-            }
-            file.close();
-
-            // Read the shape from the temp file, if the file is empty the stored shape was already empty.
-            // If it's still empty after reading the (non-empty) file there must occurred an error.
-            if (ulSize > 0) {
-                if (!BRepTools::Read(sh, (Standard_CString)fi.filePath().c_str(), builder)) {
-                    // Note: Do NOT throw an exception here because if the tmp. created file could
-                    // not be read it's NOT an indication for an invalid input stream 'reader'.
-                    // We only print an error message but continue reading the next files from the
-                    // stream...
-                    App::PropertyContainer* father = this->getContainer();
-                    if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
-                        App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
-                        Base::Console().Error("BRep file '%s' with shape of '%s' seems to be empty\n", 
-                            fi.filePath().c_str(),obj->Label.getValue());
-                    }
-                    else {
-                        Base::Console().Warning("Loaded BRep file '%s' seems to be empty\n", fi.filePath().c_str());
-                    }
+        BRep_Builder builder;
+        // create a temporary file and copy the content from the zip stream
+        Base::FileInfo fi(App::Application::getTempFileName());
+
+        // read in the ASCII file and write back to the file stream
+        Base::ofstream file(fi, std::ios::out | std::ios::binary);
+        unsigned long ulSize = 0; 
+        if (reader) {
+            std::streambuf* buf = file.rdbuf();
+            reader >> buf;
+            file.flush();
+            ulSize = buf->pubseekoff(0, std::ios::cur, std::ios::in);
+        }
+        file.close();
+
+        // Read the shape from the temp file, if the file is empty the stored shape was already empty.
+        // If it's still empty after reading the (non-empty) file there must occurred an error.
+        if (ulSize > 0) {
+            if (!BRepTools::Read(sh, (Standard_CString)fi.filePath().c_str(), builder)) {
+                // Note: Do NOT throw an exception here because if the tmp. created file could
+                // not be read it's NOT an indication for an invalid input stream 'reader'.
+                // We only print an error message but continue reading the next files from the
+                // stream...
+                App::PropertyContainer* father = this->getContainer();
+                if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId())) {
+                    App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
+                    Base::Console().Error("BRep file '%s' with shape of '%s' seems to be empty\n", 
+                        fi.filePath().c_str(),obj->Label.getValue());
+                }
+                else {
+                    Base::Console().Warning("Loaded BRep file '%s' seems to be empty\n", fi.filePath().c_str());
                 }
             }
-
-            // delete the temp file
-            fi.deleteFile();
-            shape.setShape(sh);
-        }
-        else {
-            BRep_Builder builder;
-            BRepTools::Read(sh, reader, builder);
-            shape.setShape(sh);
         }
+
+        // delete the temp file
+        fi.deleteFile();
+        _RestoredShape = sh;
     }
 
+    FinishRestoreDocFile();
+}
+
+bool PropertyPartShape::canRestoreDocFileConcurrently() const
+{
+    // ReadDocFile() can't access the parameters in the worker thread
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Part/General");
+    _LazyRestore = hGrp->GetBool("LazyRestore", true);
+    // reading through a temporary file is done in the main thread
+    return hGrp->GetBool("DirectAccess", true);
+}
+
+static TopoDS_Shape readShape(std::istream &str, bool binary)
+{
+    if (binary) {
+        TopoShape shape;
+        shape.importBinary(str);
+        return shape.getShape();
+    }
+    else {
+        TopoDS_Shape sh;
+        BRep_Builder builder;
+        BRepTools::Read(sh, str, builder);
+        return sh;
+    }
+}
+
+void PropertyPartShape::ReadDocFile(Base::Reader &reader)
+{
+    Base::FileInfo brep(reader.getFileName());
+    bool binary = brep.hasExtension("bin");
+    if (_LazyRestore) {
+        // keep the data, the shape is read when it's accessed the first time
+        std::ostringstream str;
+        str << reader.rdbuf();
+        _RestoredData = str.str();
+        _RestoredBinary = binary;
+    }
+    else {
+        _RestoredShape = readShape(reader, binary);
+    }
+}
+
+void PropertyPartShape::FinishRestoreDocFile()
+{
+    if (!_RestoredData.empty()) {
+        // the element map restored by Restore() is kept until loadShape()
+        _HasRestoredData = true;
+        return;
+    }
+
+    // save the element map
+    auto elementMap = _Shape.resetElementMap();
+    auto hasher = _Shape.Hasher;
+
+    TopoShape shape;
+    shape.setShape(_RestoredShape);
+    _RestoredShape.Nullify();
+
     std::string ver = _Ver;
     // restore the element map
     shape.Hasher = hasher;
@@ -513,6 +622,103 @@ void PropertyPartShape::RestoreDocFile(Base::Reader &reader)
     _Ver = ver;
 }
 
+namespace {
+// The shape of an on-demand restore may be read by a worker thread, e.g. during a
+// concurrent recompute. Its errors are reported by the next access in the main thread.
+const std::thread::id MainThreadId = std::this_thread::get_id();
+std::mutex RestoreErrorMutex;
+std::vector<std::string> RestoreErrors;
+std::atomic<bool> HasRestoreErrors(false);
+
+void reportRestoreErrors()
+{
+    if (std::this_thread::get_id() != MainThreadId)
+        return;
+
+    std::vector<std::string> errors;
+    {
+        std::lock_guard<std::mutex> lock(RestoreErrorMutex);
+        errors.swap(RestoreErrors);
+        HasRestoreErrors = false;
+    }
+    for (std::vector<std::string>::const_iterator it = errors.begin(); it != errors.end(); ++it)
+        Base::Console().Error("%s\n", it->c_str());
+}
+}
+
+void PropertyPartShape::loadShape() const
+{
+    if (HasRestoreErrors)
+        reportRestoreErrors();
+    if (!_HasRestoredData)
+        return;
+    std::lock_guard<std::mutex> lock(_RestoredMutex);
+    if (!_HasRestoredData)
+        return;
+
+    TopoDS_Shape sh;
+    try {
+        std::istringstream str(_RestoredData);
+        sh = readShape(str, _RestoredBinary);
+    }
+    catch (Standard_Failure& e) {
+        std::stringstream str;
+        App::PropertyContainer* father = this->getContainer();
+        if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId()) &&
+                static_cast<App::DocumentObject*>(father)->getNameInDocument()) {
+            App::DocumentObject* obj = static_cast<App::DocumentObject*>(father);
+            str << "Cannot read shape of '" << obj->getNameInDocument() << "': " << e.GetMessageString();
+        }
+        else {
+            str << "Cannot read shape: " << e.GetMessageString();
+        }
+        std::lock_guard<std::mutex> lock(RestoreErrorMutex);
+        RestoreErrors.push_back(str.str());
+        HasRestoreErrors = true;
+    }
+    std::string().swap(_RestoredData);
+
+    // Like FinishRestoreDocFile() but without notification, the property is
+    // already restored for the outside
+    PropertyPartShape* self = const_cast<PropertyPartShape*>(this);
+    auto elementMap = self->_Shape.resetElementMap();
+    TopoShape shape;
+    shape.setShape(sh);
+    shape.Hasher = _Shape.Hasher;
+    shape.resetElementMap(elementMap);
+    shape.Tag = _Shape.Tag;
+    App::PropertyContainer* father = this->getContainer();
+    if (father && father->isDerivedFrom(App::DocumentObject::getClassTypeId()))
+        shape.Tag = static_cast<App::DocumentObject*>(father)->getID();
+    self->_Shape = shape;
+    _HasRestoredData = false;
+
+    if (HasRestoreErrors)
+        reportRestoreErrors();
+}
+
+void PropertyPartShape::dropRestoredData()
+{
+    // an undo transaction has already copied the old shape in aboutToSetValue()
+    if (!_HasRestoredData)
+        return;
+    std::lock_guard<std::mutex> lock(_RestoredMutex);
+    std::string().swap(_RestoredData);
+    _HasRestoredData = false;
+}
+
+bool PropertyPartShape::writeRestoredData(Base::Writer &writer) const
+{
+    if (!_HasRestoredData)
+        return false;
+    std::lock_guard<std::mutex> lock(_RestoredMutex);
+    // the data can be written back unchanged if the format didn't change
+    if (!_HasRestoredData || _RestoredBinary != writer.getMode("BinaryBrep"))
+        return false;
+    writer.Stream().write(_RestoredData.c_str(), _RestoredData.size());
+    return true;
+}
+
 // -------------------------------------------------------------------------
 
 ShapeHistory::ShapeHistory(BRepBuilderAPI_MakeShape& mkShape, TopAbs_ShapeEnum type,
@@ -28,7 +28,9 @@
 #include <TopAbs_ShapeEnum.hxx>
 #include <App/DocumentObject.h>
 #include <App/PropertyGeo.h>
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <vector>
 
 class BRepBuilderAPI_MakeShape;
@@ -85,6 +87,13 @@ public:
     void SaveDocFile (Base::Writer &writer) const;
     void RestoreDocFile(Base::Reader &reader);
 
+    bool canRestoreDocFileConcurrently() const;
+    void ReadDocFile(Base::Reader &reader);
+    void FinishRestoreDocFile();
+    bool canSaveDocFileConcurrently(const Base::Writer &writer) const;
+    void WriteDocFile(Base::Writer &writer) const;
+    bool canDeduplicateDocFile(const Base::Writer &writer) const;
+
     App::Property *Copy(void) const;
     void Paste(const App::Property &from);
     unsigned int getMemSize (void) const;
@@ -95,9 +104,30 @@ public:
 
     virtual std::string getElementMapVersion(bool restored=false) const override;
 
+private:
+    /// read the shape of an on-demand restore when it's accessed the first time
+    void loadShape() const;
+    /// discard the data of an on-demand restore when the shape is replaced
+    void dropRestoredData();
+    /// write the data of an on-demand restore if the shape was not accessed yet
+    bool writeRestoredData(Base::Writer &writer) const;
+
 private:
     TopoShape _Shape;
     std::string _Ver;
+    /// shape read by ReadDocFile() until it's set by FinishRestoreDocFile()
+    TopoDS_Shape _RestoredShape;
+    /// the LazyRestore parameter, read in the main thread for ReadDocFile()
+    mutable bool _LazyRestore;
+    /** @name On-demand restore
+     * The data read by ReadDocFile() if the shape is restored when it's accessed the first time.
+     */
+    //@{
+    mutable std::string _RestoredData;
+    mutable bool _RestoredBinary;
+    mutable std::atomic<bool> _HasRestoredData;
+    mutable std::mutex _RestoredMutex;
+    //@}
 };
 
 struct PartExport ShapeHistory {
@@ -20,7 +20,7 @@
 #**************************************************************************
 
 import FreeCAD, os, sys, unittest, Part
-import copy 
+import copy, math 
 from FreeCAD import Units
 App = FreeCAD
 
@@ -38,6 +38,73 @@ class PartTestCases(unittest.TestCase):
         self.Doc.recompute()
         self.failUnless(len(self.Box.Shape.Faces)==6)
 
+    def testParallelRecompute(self):
+        param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+        parallel = param.GetBool("ParallelRecompute", False)
+        param.SetBool("ParallelRecompute", True)
+        try:
+            cuts = []
+            for i in range(8):
+                box = self.Doc.addObject("Part::Box","Box")
+                box.Length = 10 + i
+                cyl = self.Doc.addObject("Part::Cylinder","Cylinder")
+                cyl.Radius = 2
+                cyl.Height = 20
+                cut = self.Doc.addObject("Part::Cut","Cut")
+                cut.Base = box
+                cut.Tool = cyl
+                cuts.append(cut)
+            self.Doc.recompute()
+        finally:
+            param.SetBool("ParallelRecompute", parallel)
+
+        for i, cut in enumerate(cuts):
+            self.assertFalse("Touched" in cut.State or "Invalid" in cut.State)
+            self.assertTrue(cut.Shape.isValid())
+            # a quarter of the cylinder is inside the box
+            volume = (10 + i) * 100 - 10 * math.pi
+            self.assertAlmostEqual(cut.Shape.Volume, volume, places=6)
+
+    def testShapeCache(self):
+        def cached():
+            return [(obj.Name, subname) for obj, subname in Part.getShapeCacheInfo()[1]]
+
+        parts = []
+        for i in range(2):
+            box = self.Doc.addObject("Part::Box","Box")
+            box.Placement = App.Placement(App.Vector(20*i,0,0), App.Rotation())
+            part = self.Doc.addObject("App::Part","Part")
+            part.addObject(box)
+            parts.append(part)
+        self.Doc.recompute()
+
+        param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Mod/Part/General")
+        try:
+            Part.setShapeCacheSize(0)
+            self.assertEqual(Part.getShapeCacheInfo(), (0, []))
+            Part.setShapeCacheSize(1 << 30)
+            Part.getShape(parts[0])
+            Part.getShape(parts[1])
+            self.assertEqual(cached(), [(parts[1].Name, ''), (parts[0].Name, '')])
+
+            # a change of a child removes only the shapes built from it
+            box = parts[0].Group[0]
+            box.Label = "Renamed"
+            self.assertEqual(len(cached()), 2)
+            box.Placement = App.Placement(App.Vector(0,20,0), App.Rotation())
+            self.assertEqual(cached(), [(parts[1].Name, '')])
+            self.assertAlmostEqual(Part.getShape(parts[0]).BoundBox.YMin, 20)
+            self.assertEqual(cached(), [(parts[0].Name, ''), (parts[1].Name, '')])
+
+            # the least recently used shape is removed first
+            memSize = Part.getShapeCacheInfo()[0]
+            Part.setShapeCacheSize(memSize - 1)
+            self.assertEqual(cached(), [(parts[0].Name, '')])
+            Part.getShape(parts[1])
+            self.assertEqual(cached(), [(parts[1].Name, '')])
+        finally:
+            Part.setShapeCacheSize(param.GetInt("ShapeCacheSize", 512) << 20)
+
     def testIssue2985(self):
         v1 = App.Vector(0.0,0.0,0.0)
         v2 = App.Vector(10.0,0.0,0.0)
@@ -26,9 +26,13 @@
 #ifdef FC_OS_LINUX
 # include <unistd.h>
 #endif
+# include <cmath>
+# include <cstdlib>
 # include <sstream>
 #endif
 
+#include <QFile>
+#include <QtConcurrentMap>
 
 #include "PointsAlgos.h"
 #include "Points.h"
@@ -40,7 +44,7 @@
 #include <Base/Stream.h>
 
 #include <boost/shared_ptr.hpp>
-#include <boost/regex.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/math/special_functions/fpclassify.hpp>
@@ -61,59 +65,303 @@ void PointsAlgos::Load(PointKernel &points, const char *FileName)
         throw Base::RuntimeError("Unknown ending");
 }
 
-void PointsAlgos::LoadAscii(PointKernel &points, const char *FileName)
-{
-    boost::regex rx("^\\s*([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                     "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                     "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)\\s*$");
-    //boost::regex rx("(\\b[0-9]+\\.([0-9]+\\b)?|\\.[0-9]+\\b)");
-    //boost::regex rx("^\\s*(-?[0-9]*)\\.([0-9]+)\\s+(-?[0-9]*)\\.([0-9]+)\\s+(-?[0-9]*)\\.([0-9]+)\\s*$");
-    boost::cmatch what;
-
-    Base::Vector3d pt;
-    int LineCnt=0;
-    std::string line;
-    Base::FileInfo fi(FileName);
+namespace Points {
+namespace Ascii {
+    /** The characters that separate the columns of a line. */
+    inline bool isSeparator(char c)
+    {
+        return c == ' ' || c == '\t' || c == ',' || c == ';';
+    }
 
-    Base::ifstream tmp_str(fi, std::ios::in);
+    inline bool isLineEnd(char c)
+    {
+        return c == '\n' || c == '\r';
+    }
 
-    // estimating size
-    while (std::getline(tmp_str,line))
-        LineCnt++;
+    inline bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
 
-    // resize the PointKernel
-    points.resize(LineCnt);
+    /** Parses the number at \a ptr and moves \a ptr behind it. Numbers with not more than
+     * 15 significant digits and a small exponent are converted exactly, all others with strtod().
+     * Returns false if there is no number at \a ptr.
+     */
+    bool parseNumber(const char*& ptr, const char* end, float& value)
+    {
+        static const double pow10[] = {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        const char* p = ptr;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            ++p;
+        }
 
-    Base::SequencerLauncher seq( "Loading points...", LineCnt );
+        boost::uint64_t mantissa = 0;
+        int digits = 0; // significant digits in the mantissa
+        int exponent = 0;
+        bool ok = false;
+        for (; p < end && isDigit(*p); ++p) {
+            ok = true;
+            if (digits < 19) {
+                mantissa = 10 * mantissa + (*p - '0');
+                if (mantissa > 0)
+                    digits++;
+            }
+            else {
+                exponent++;
+            }
+        }
+        if (p < end && *p == '.') {
+            for (++p; p < end && isDigit(*p); ++p) {
+                ok = true;
+                if (digits < 19) {
+                    mantissa = 10 * mantissa + (*p - '0');
+                    if (mantissa > 0)
+                        digits++;
+                    exponent--;
+                }
+            }
+        }
+        if (!ok)
+            return false;
+
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            const char* q = p + 1;
+            bool negExp = false;
+            if (q < end && (*q == '-' || *q == '+')) {
+                negExp = (*q == '-');
+                ++q;
+            }
+            if (q < end && isDigit(*q)) {
+                int exp = 0;
+                for (; q < end && isDigit(*q); ++q) {
+                    if (exp < 10000)
+                        exp = 10 * exp + (*q - '0');
+                }
+                exponent += negExp ? -exp : exp;
+                p = q;
+            }
+        }
 
-    // again to the beginning
-    Base::ifstream file(fi, std::ios::in);
-    LineCnt = 0;
+        double result;
+        if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+            // both the mantissa and the power of ten are exact, so is the result
+            result = static_cast<double>(mantissa);
+            if (exponent < 0)
+                result /= pow10[-exponent];
+            else
+                result *= pow10[exponent];
+            if (negative)
+                result = -result;
+        }
+        else {
+            std::string number(ptr, p);
+            result = std::strtod(number.c_str(), 0);
+        }
 
-    try {
-        // read file
-        while (std::getline(file, line)) {
-            if (boost::regex_match(line.c_str(), what, rx)) {
-                pt.x = std::atof(what[1].first);
-                pt.y = std::atof(what[4].first);
-                pt.z = std::atof(what[7].first);
-
-                points.setPoint(LineCnt,pt);
-                seq.next();
-                LineCnt++;
+        value = static_cast<float>(result);
+        ptr = p;
+        return true;
+    }
+
+    const std::size_t MaxColumns = 16;
+
+    /** Parses the numbers of the line at \a ptr and moves \a ptr to the next line. Returns the
+     * number of columns, or 0 if the line is empty or contains something else than numbers.
+     */
+    std::size_t parseLine(const char*& ptr, const char* end, float* values)
+    {
+        std::size_t count = 0;
+        bool ok = true;
+        while (ptr < end && isSeparator(*ptr))
+            ++ptr;
+        while (ptr < end && !isLineEnd(*ptr)) {
+            if (count == MaxColumns || !parseNumber(ptr, end, values[count])) {
+                ok = false;
+                break;
+            }
+            count++;
+            if (ptr < end && !isSeparator(*ptr) && !isLineEnd(*ptr)) {
+                ok = false;
+                break;
             }
+            while (ptr < end && isSeparator(*ptr))
+                ++ptr;
         }
+
+        while (ptr < end && !isLineEnd(*ptr))
+            ++ptr;
+        while (ptr < end && isLineEnd(*ptr))
+            ++ptr;
+        return ok ? count : 0;
+    }
+
+    /** The rows of a part of the file that are parsed by a worker thread. */
+    struct Block
+    {
+        const char* begin;
+        const char* end;
+        std::size_t columns;
+        std::vector<float> values;
+
+        void Run()
+        {
+            float row[MaxColumns];
+            const char* ptr = begin;
+            while (ptr < end) {
+                if (parseLine(ptr, end, row) == columns)
+                    values.insert(values.end(), row, row + columns);
+            }
+        }
+
+        std::size_t countRows() const
+        {
+            return values.size() / columns;
+        }
+    };
+
+    /** Reads the numeric columns of an ASCII file. All lines that have as many numbers as the
+     * first line with at least three numbers are used, other lines like headers or comments
+     * are skipped. The file is mapped into memory and parsed in blocks with several threads.
+     */
+    class Table
+    {
+    public:
+        Table() : columns(0)
+        {
+        }
+
+        void read(const char* FileName)
+        {
+            QFile file(QString::fromUtf8(FileName));
+            if (!file.open(QIODevice::ReadOnly))
+                throw Base::FileException("Cannot open file", FileName);
+
+            const char* data = 0;
+            std::size_t size = static_cast<std::size_t>(file.size());
+            uchar* mapped = size > 0 ? file.map(0, file.size()) : 0;
+            std::vector<char> buffer;
+            if (mapped) {
+                data = reinterpret_cast<const char*>(mapped);
+            }
+            else if (size > 0) {
+                buffer.resize(size);
+                size = static_cast<std::size_t>(file.read(&buffer[0], buffer.size()));
+                data = &buffer[0];
+            }
+
+            try {
+                parse(data, size);
+            }
+            catch (...) {
+                if (mapped)
+                    file.unmap(mapped);
+                throw;
+            }
+            if (mapped)
+                file.unmap(mapped);
+        }
+
+        std::size_t countColumns() const
+        {
+            return columns;
+        }
+
+        std::size_t countRows() const
+        {
+            std::size_t rows = 0;
+            for (std::vector<Block>::const_iterator it = blocks.begin(); it != blocks.end(); ++it)
+                rows += it->countRows();
+            return rows;
+        }
+
+        std::vector<Block> blocks;
+
+    private:
+        void parse(const char* data, std::size_t size)
+        {
+            const std::size_t BlockSize = 0x100000;
+            const char* end = data + size;
+
+            // the first data line defines the number of columns
+            float row[MaxColumns];
+            for (const char* ptr = data; ptr < end && columns < 3;)
+                columns = parseLine(ptr, end, row);
+            if (columns < 3)
+                return;
+
+            // split the file into blocks of whole lines
+            for (const char* ptr = data; ptr < end;) {
+                Block block;
+                block.begin = ptr;
+                block.end = end - ptr > static_cast<std::ptrdiff_t>(BlockSize) ? ptr + BlockSize : end;
+                while (block.end < end && *(block.end - 1) != '\n')
+                    ++block.end;
+                block.columns = columns;
+                blocks.push_back(block);
+                ptr = block.end;
+            }
+
+            if (blocks.size() == 1)
+                blocks.front().Run();
+            else if (!blocks.empty())
+                QtConcurrent::blockingMap(blocks, &Block::Run);
+        }
+
+        std::size_t columns;
+    };
+
+    /** Copies the first three columns of the table to \a points. */
+    void copyPoints(std::vector<Block>& blocks, PointKernel& points)
+    {
+        std::size_t numRows = 0;
+        for (std::vector<Block>::const_iterator it = blocks.begin(); it != blocks.end(); ++it)
+            numRows += it->countRows();
+
+        Base::Matrix4D mat(points.getTransform());
+        bool transform = !(mat == Base::Matrix4D());
+        mat.inverse();
+
+        std::vector<PointKernel::value_type>& pts = points.getBasicPoints();
+        pts.resize(numRows);
+        Base::SequencerLauncher seq("Loading points...", blocks.size());
+        std::size_t index = 0;
+        for (std::vector<Block>::iterator it = blocks.begin(); it != blocks.end(); ++it) {
+            const std::vector<float>& values = it->values;
+            for (std::size_t i = 0; i < values.size(); i += it->columns, index++) {
+                if (transform) {
+                    Base::Vector3d pnt = mat * Base::Vector3d(values[i], values[i+1], values[i+2]);
+                    pts[index].Set(static_cast<float>(pnt.x), static_cast<float>(pnt.y), static_cast<float>(pnt.z));
+                }
+                else {
+                    pts[index].Set(values[i], values[i+1], values[i+2]);
+                }
+            }
+            seq.next();
+        }
+    }
+}
+}
+
+void PointsAlgos::LoadAscii(PointKernel &points, const char *FileName)
+{
+    Ascii::Table table;
+    try {
+        table.read(FileName);
+        Ascii::copyPoints(table.blocks, points);
+    }
+    catch (const Base::FileException&) {
+        throw;
     }
     catch (...) {
         points.clear();
         throw Base::BadFormatError("Reading in points failed.");
     }
-
-    // now remove the last points from the kernel
-    // Note: first we allocate memory corresponding to the number of lines (points and comments)
-    //       and read in the file twice. But then the size of the kernel is too high
-    if (LineCnt < (int)points.size())
-        points.erase(LineCnt, points.size());
 }
 
 // ----------------------------------------------------------------------------
@@ -202,7 +450,96 @@ AscReader::~AscReader()
 
 void AscReader::read(const std::string& filename)
 {
-    points.load(filename.c_str());
+    clear();
+    points.clear();
+
+    Ascii::Table table;
+    table.read(filename.c_str());
+    std::size_t columns = table.countColumns();
+    if (columns < 3)
+        return;
+    Ascii::copyPoints(table.blocks, points);
+
+    // The meaning of additional columns depends on their number:
+    // 4: intensity, 6: colors or normals, 7: intensity and colors,
+    // 9: colors and normals, 10: intensity, colors and normals
+    std::size_t greyvalue = 0, color = 0, normal = 0;
+    switch (columns) {
+    case 4:
+        greyvalue = 3;
+        break;
+    case 6:
+        {
+            // colors are integers in the range [0, 255]
+            bool isInteger = true, isColor = false;
+            const std::vector<float>& values = table.blocks.front().values;
+            for (std::size_t i = 3; i < values.size() && i < 6 * 100 && isInteger; i++) {
+                float v = values[i];
+                if (i % 6 < 3)
+                    continue;
+                if (v < 0.0f || v > 255.0f || v != std::floor(v))
+                    isInteger = false;
+                else if (v > 1.0f)
+                    isColor = true;
+            }
+            isColor = isColor && isInteger;
+            if (isColor)
+                color = 3;
+            else
+                normal = 3;
+        }
+        break;
+    case 7:
+        greyvalue = 3;
+        color = 4;
+        break;
+    case 9:
+        color = 3;
+        normal = 6;
+        break;
+    case 10:
+        greyvalue = 3;
+        color = 4;
+        normal = 7;
+        break;
+    default:
+        break;
+    }
+
+    // colors are given either as integers or as floats in the range [0, 1]
+    float colorScale = 1.0f;
+    if (color > 0) {
+        for (std::vector<Ascii::Block>::const_iterator it = table.blocks.begin(); it != table.blocks.end() && colorScale == 1.0f; ++it) {
+            for (std::size_t i = 0; i < it->values.size(); i += columns) {
+                if (it->values[i+color] > 1.0f || it->values[i+color+1] > 1.0f || it->values[i+color+2] > 1.0f) {
+                    colorScale = 1.0f / 255.0f;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::size_t numPoints = points.size();
+    if (greyvalue > 0)
+        intensity.reserve(numPoints);
+    if (color > 0)
+        colors.reserve(numPoints);
+    if (normal > 0)
+        normals.reserve(numPoints);
+    for (std::vector<Ascii::Block>::iterator it = table.blocks.begin(); it != table.blocks.end(); ++it) {
+        const std::vector<float>& values = it->values;
+        for (std::size_t i = 0; i < values.size(); i += columns) {
+            if (greyvalue > 0)
+                intensity.push_back(values[i+greyvalue]);
+            if (color > 0)
+                colors.push_back(App::Color(values[i+color] * colorScale,
+                                            values[i+color+1] * colorScale,
+                                            values[i+color+2] * colorScale));
+            if (normal > 0)
+                normals.push_back(Base::Vector3f(values[i+normal], values[i+normal+1], values[i+normal+2]));
+        }
+        std::vector<float>().swap(it->values);
+    }
 }
 
 // ----------------------------------------------------------------------------
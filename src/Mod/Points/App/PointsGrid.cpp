@@ -95,7 +95,9 @@ void PointsGrid::Attach (const PointKernel &rclM)
 
 void PointsGrid::Clear (void)
 {
-  _aulGrid.clear();
+  _aulGridOffsets.clear();
+  _aulGridElements.clear();
+  _aulGridFill.clear();
   _pclPoints = NULL;  
 }
 
@@ -126,8 +128,6 @@ void PointsGrid::InitGrid (void)
 {
   assert(_pclPoints != NULL);
 
-  unsigned long i, j;
-
   // Grid Laengen berechnen wenn nicht initialisiert
   //
   if ((_ulCtGridsX == 0) || (_ulCtGridsY == 0) || (_ulCtGridsZ == 0))
@@ -163,14 +163,28 @@ void PointsGrid::InitGrid (void)
   }
 
   // Daten-Struktur anlegen
-  _aulGrid.clear();
-  _aulGrid.resize(_ulCtGridsX);
-  for (i = 0; i < _ulCtGridsX; i++)
-  {
-    _aulGrid[i].resize(_ulCtGridsY);
-    for (j = 0; j < _ulCtGridsY; j++)
-      _aulGrid[i][j].resize(_ulCtGridsZ);
-  }
+  ClearCells();
+}
+
+void PointsGrid::ClearCells (void)
+{
+  _aulGridOffsets.assign(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ + 1, 0);
+  _aulGridElements.clear();
+  _aulGridFill.clear();
+}
+
+void PointsGrid::StoreCells (void)
+{
+  // the counts become the start positions of each grid
+  for (std::size_t i = 1; i < _aulGridOffsets.size(); i++)
+    _aulGridOffsets[i] += _aulGridOffsets[i-1];
+  _aulGridElements.resize(_aulGridOffsets.back());
+  _aulGridFill.assign(_aulGridOffsets.begin(), _aulGridOffsets.end() - 1);
+}
+
+void PointsGrid::FinishCells (void)
+{
+  std::vector<unsigned long>().swap(_aulGridFill);
 }
 
 unsigned long PointsGrid::InSide (const Base::BoundBox3d &rclBB, std::vector<unsigned long> &raulElements, bool bDelDoubles) const
@@ -189,7 +203,7 @@ unsigned long PointsGrid::InSide (const Base::BoundBox3d &rclBB, std::vector<uns
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -223,7 +237,7 @@ unsigned long PointsGrid::InSide (const Base::BoundBox3d &rclBB, std::vector<uns
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
         if (Base::DistanceP2(GetBoundBox(i, j, k).GetCenter(), rclOrg) < fMinDistP2)
-          raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+          GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -254,7 +268,7 @@ unsigned long PointsGrid::InSide (const Base::BoundBox3d &rclBB, std::set<unsign
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(_aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        GetElements(i, j, k, raulElements);
       }
     }
   }  
@@ -456,6 +470,14 @@ void PointsGrid::CalculateGridLength (int iCtGridPerAxis)
 }
 
 void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<unsigned long> &raclInd) const
+{
+  std::vector<unsigned long> aulInd;
+  SearchNearestFromPoint(rclPt, aulInd);
+  raclInd.clear();
+  raclInd.insert(aulInd.begin(), aulInd.end());
+}
+
+void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::vector<unsigned long> &raclInd) const
 {
   raclInd.clear();
   Base::BoundBox3d  clBB = GetBoundBox();
@@ -465,8 +487,9 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
     unsigned long ulX, ulY, ulZ;
     Position(rclPt, ulX, ulY, ulZ);
     //int nX = ulX, nY = ulY, nZ = ulZ;
+    unsigned long ulMaxLevel = std::max<unsigned long>(_ulCtGridsX, std::max<unsigned long>(_ulCtGridsY, _ulCtGridsZ));
     unsigned long ulLevel = 0;
-    while (raclInd.size() == 0)
+    while (raclInd.empty() && ulLevel <= ulMaxLevel)
       GetHull(ulX, ulY, ulZ, ulLevel++, raclInd);
     GetHull(ulX, ulY, ulZ, ulLevel, raclInd);
   }
@@ -477,13 +500,13 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
     {
       case Base::BoundBox3d::RIGHT:
       {
-        int nX = 0;
-        while (raclInd.size() == 0)
+        unsigned long nX = 0;
+        while (raclInd.empty() && nX < _ulCtGridsX)
         {
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              GetElements(nX, i, j, raclInd);
           }
           nX++;
         }
@@ -492,26 +515,26 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
       case Base::BoundBox3d::LEFT:
       {
         int nX = _ulCtGridsX - 1;
-        while (raclInd.size() == 0)
+        while (raclInd.empty() && nX >= 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              GetElements(nX, i, j, raclInd);
           }
-          nX++;
+          nX--;
         }
         break;
       }
       case Base::BoundBox3d::TOP:
       {
-        int nY = 0;
-        while (raclInd.size() == 0)
+        unsigned long nY = 0;
+        while (raclInd.empty() && nY < _ulCtGridsY)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              GetElements(i, nY, j, raclInd);
           }
           nY++;
         }
@@ -520,12 +543,12 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
       case Base::BoundBox3d::BOTTOM:
       {
         int nY = _ulCtGridsY - 1;
-        while (raclInd.size() == 0)
+        while (raclInd.empty() && nY >= 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              GetElements(i, nY, j, raclInd);
           }
           nY--;
         }
@@ -533,13 +556,13 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
       }
       case Base::BoundBox3d::BACK:
       {
-        int nZ = 0;
-        while (raclInd.size() == 0)
+        unsigned long nZ = 0;
+        while (raclInd.empty() && nZ < _ulCtGridsZ)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              GetElements(i, j, nZ, raclInd);
           }
           nZ++;
         }
@@ -548,12 +571,12 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
       case Base::BoundBox3d::FRONT:
       {
         int nZ = _ulCtGridsZ - 1;
-        while (raclInd.size() == 0)
+        while (raclInd.empty() && nZ >= 0)
         {
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              GetElements(i, j, nZ, raclInd);
           }
           nZ--;
         }
@@ -564,10 +587,22 @@ void PointsGrid::SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<u
         break;
     }
   }
+
+  // an element can lie in several grids
+  std::sort(raclInd.begin(), raclInd.end());
+  raclInd.erase(std::unique(raclInd.begin(), raclInd.end()), raclInd.end());
 }
 
 void PointsGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, 
                         unsigned long ulDistance, std::set<unsigned long> &raclInd) const
+{
+  std::vector<unsigned long> aulInd;
+  GetHull(ulX, ulY, ulZ, ulDistance, aulInd);
+  raclInd.insert(aulInd.begin(), aulInd.end());
+}
+
+void PointsGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, 
+                        unsigned long ulDistance, std::vector<unsigned long> &raclInd) const
 {
   int nX1 = std::max<int>(0, int(ulX) - int(ulDistance));
   int nY1 = std::max<int>(0, int(ulY) - int(ulDistance));
@@ -619,14 +654,19 @@ void PointsGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ul
 unsigned long PointsGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
                                      std::set<unsigned long> &raclInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  if (rclSet.size() > 0)
-  {
-    raclInd.insert(rclSet.begin(), rclSet.end());
-    return rclSet.size();
-  }
+  unsigned long ulCell = GetCellIndex(ulX, ulY, ulZ);
+  unsigned long ulBegin = _aulGridOffsets[ulCell], ulEnd = _aulGridOffsets[ulCell + 1];
+  raclInd.insert(_aulGridElements.begin() + ulBegin, _aulGridElements.begin() + ulEnd);
+  return ulEnd - ulBegin;
+}
 
-  return 0;
+unsigned long PointsGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
+                                     std::vector<unsigned long> &raulInd) const
+{
+  unsigned long ulCell = GetCellIndex(ulX, ulY, ulZ);
+  unsigned long ulBegin = _aulGridOffsets[ulCell], ulEnd = _aulGridOffsets[ulCell + 1];
+  raulInd.insert(raulInd.end(), _aulGridElements.begin() + ulBegin, _aulGridElements.begin() + ulEnd);
+  return ulEnd - ulBegin;
 }
 
 void PointsGrid::AddPoint (const Base::Vector3d &rclPt, unsigned long ulPtIndex, float /*fEpsilon*/)
@@ -634,7 +674,7 @@ void PointsGrid::AddPoint (const Base::Vector3d &rclPt, unsigned long ulPtIndex,
   unsigned long ulX, ulY, ulZ;
   Pos(Base::Vector3d(rclPt.x, rclPt.y, rclPt.z), ulX, ulY, ulZ);
   if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
-    _aulGrid[ulX][ulY][ulZ].insert(ulPtIndex);
+    AddElement(ulX, ulY, ulZ, ulPtIndex);
 }
 
 void PointsGrid::Validate (const PointKernel &rclPoints)
@@ -683,13 +723,21 @@ void PointsGrid::RebuildGrid (void)
 
   InitGrid();
  
-  // Daten-Struktur fuellen
+  // Daten-Struktur fuellen, zuerst zaehlen, dann speichern
 
-  unsigned long i = 0;
-  for (PointKernel::const_iterator it = _pclPoints->begin(); it != _pclPoints->end(); ++it )
+  for (int iPass = 0; iPass < 2; iPass++)
   {
-    AddPoint(*it, i++);
+    if (iPass == 1)
+      StoreCells();
+
+    unsigned long i = 0;
+    for (PointKernel::const_iterator it = _pclPoints->begin(); it != _pclPoints->end(); ++it )
+    {
+      AddPoint(*it, i++);
+    }
   }
+
+  FinishCells();
 }
 
 void PointsGrid::Pos (const Base::Vector3d &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const
@@ -713,6 +761,20 @@ unsigned long PointsGrid::FindElements (const Base::Vector3d &rclPoint, std::set
   return 0;
 }
 
+unsigned long PointsGrid::FindElements (const Base::Vector3d &rclPoint, std::vector<unsigned long>& aulElements) const
+{
+  unsigned long ulX, ulY, ulZ;
+  Pos(rclPoint, ulX, ulY, ulZ);
+
+  // check if the given point is inside the grid structure
+  if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
+  {
+    return GetElements(ulX, ulY, ulZ, aulElements);
+  }
+
+  return 0;
+}
+
 // ----------------------------------------------------------------
 
 PointsGridIterator::PointsGridIterator (const PointsGrid &rclG)
@@ -751,7 +813,7 @@ bool PointsGridIterator::InitOnRay (const Base::Vector3d &rclPt, const Base::Vec
   if ((_rclGrid.GetBoundBox().IsInBox(rclPt)) == true)
   {  // Voxel bestimmen, indem der Startpunkt liegt
     _rclGrid.Position(rclPt, _ulX, _ulY, _ulZ);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
     _bValidRay = true;
   }
   else
@@ -764,7 +826,7 @@ bool PointsGridIterator::InitOnRay (const Base::Vector3d &rclPt, const Base::Vec
       else
         _rclGrid.Position(cP1, _ulX, _ulY, _ulZ);
 
-      raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+      _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
       _bValidRay = true;
     }
   }
@@ -815,7 +877,7 @@ bool PointsGridIterator::NextOnRay (std::vector<unsigned long> &raulElements)
   if ((_bValidRay == true) && (_rclGrid.CheckPos(_ulX, _ulY, _ulZ) == true))
   {
     GridElement pos(_ulX, _ulY, _ulZ); _cSearchPositions.insert(pos);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end()); 
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
   }
   else
     _bValidRay = false;  // Strahl ausgetreten
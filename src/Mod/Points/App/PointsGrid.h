@@ -87,6 +87,9 @@ public:
                                 const Base::Vector3d &rclOrg, double fMaxDist, bool bDelDoubles = true) const;
   /** Searches for the nearest grids that contain elements from a point, the result are grid indices. */
   void SearchNearestFromPoint (const Base::Vector3d &rclPt, std::set<unsigned long> &rclInd) const;
+  /** Searches for the nearest grids that contain elements from a point. The element indices are sorted
+   * and without duplicates. */
+  void SearchNearestFromPoint (const Base::Vector3d &rclPt, std::vector<unsigned long> &raulInd) const;
   //@}
 
   /** Returns the lengths of the grid elements in x,y and z direction. */
@@ -105,9 +108,11 @@ public:
   //@}
   /** Returns the number of elements in a given grid. */
   unsigned long GetCtElements(unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
-  { return _aulGrid[ulX][ulY][ulZ].size(); }
+  { unsigned long ulCell = GetCellIndex(ulX, ulY, ulZ); return _aulGridOffsets[ulCell + 1] - _aulGridOffsets[ulCell]; }
   /** Finds all points that lie in the same grid as the point \a rclPoint. */
   unsigned long FindElements(const Base::Vector3d &rclPoint, std::set<unsigned long>& aulElements) const;
+  /** Finds all points that lie in the same grid as the point \a rclPoint. */
+  unsigned long FindElements(const Base::Vector3d &rclPoint, std::vector<unsigned long>& aulElements) const;
   /** Validates the grid structure and rebuilds it if needed. */
   virtual void Validate (const PointKernel &rclM);
   /** Validates the grid structure and rebuilds it if needed. */
@@ -119,12 +124,32 @@ public:
   virtual void Position (const Base::Vector3d &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const;
   /** Returns the indices of the elements in the given grid. */
   unsigned long GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  std::set<unsigned long> &raclInd) const;
+  /** Appends the indices of the elements in the given grid. */
+  unsigned long GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  std::vector<unsigned long> &raulInd) const;
 
 protected:
   /** Checks if this is a valid grid position. */
   inline bool CheckPos (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const;
   /** Initializes the size of the internal structure. */
   virtual void InitGrid (void);
+  /** @name Filling
+   * The grid is filled in two passes. After ClearCells() AddElement() only counts the elements of each grid,
+   * after StoreCells() it stores them. Both passes must add the same elements in the same order, and 
+   * FinishCells() must be called at the end.
+   */
+  //@{
+  /** Removes all elements and starts counting them for the current number of grids. */
+  void ClearCells (void);
+  /** Allocates the counted elements and starts storing them. */
+  void StoreCells (void);
+  /** Finishes filling the grid. */
+  void FinishCells (void);
+  /** Counts or stores an element in the given grid. */
+  inline void AddElement (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulIndex);
+  //@}
+  /** Returns the index of the grid element in the internal structure. */
+  unsigned long GetCellIndex (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+  { return (ulZ * _ulCtGridsY + ulY) * _ulCtGridsX + ulX; }
   /** Deletes the grid structure. */
   virtual void Clear (void);
   /** Calculates the grid length dependent on maximum number of grids. */
@@ -138,9 +163,14 @@ protected:
   { return _pclPoints->size(); }
   /** Get the indices of all elements lying in the grids around a given grid with distance \a ulDistance. */
   void GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulDistance, std::set<unsigned long> &raclInd) const;
+  /** Appends the indices of all elements lying in the grids around a given grid with distance \a ulDistance.
+   * An element that lies in several of these grids is appended several times. */
+  void GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulDistance, std::vector<unsigned long> &raulInd) const;
 
 protected:
-  std::vector<std::vector<std::vector<std::set<unsigned long> > > >  _aulGrid;   /**< Grid data structure. */
+  std::vector<unsigned long> _aulGridOffsets;  /**< Start of the elements of each grid in _aulGridElements. */
+  std::vector<unsigned long> _aulGridElements; /**< Element indices of all grids. */
+  std::vector<unsigned long> _aulGridFill;     /**< Insert positions while storing the elements. */
   const PointKernel* _pclPoints;  /**< The point kernel. */
   unsigned long     _ulCtElements;/**< Number of grid elements for validation issues. */
   unsigned long     _ulCtGridsX;  /**< Number of grid elements in z. */
@@ -182,7 +212,7 @@ public:
   /** Returns indices of the elements in the current grid. */
   void GetElements (std::vector<unsigned long> &raulElements) const
   {
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    _rclGrid.GetElements(_ulX, _ulY, _ulZ, raulElements);
   }
   /** @name Iteration */
   //@{
@@ -265,6 +295,15 @@ inline bool PointsGrid::CheckPos (unsigned long ulX, unsigned long ulY, unsigned
   return ((ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ));
 }
 
+inline void PointsGrid::AddElement (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulIndex)
+{
+  unsigned long ulCell = GetCellIndex(ulX, ulY, ulZ);
+  if (_aulGridFill.empty())
+    _aulGridOffsets[ulCell + 1]++;
+  else
+    _aulGridElements[_aulGridFill[ulCell]++] = ulIndex;
+}
+
 // --------------------------------------------------------------
 
 } // namespace Points
@@ -0,0 +1,200 @@
+/***************************************************************************
+ *   Copyright (c) 2026 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+#ifndef _PreComp_
+# include <algorithm>
+#endif
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include "PointsOctree.h"
+
+using namespace Points;
+
+namespace {
+
+// The cube of a node that is split into octants at its center
+struct Cube
+{
+    Base::Vector3f clCenter;
+    float          fHalf;
+    int            iDepth;
+};
+
+inline int Octant (const Base::Vector3f& rPt, const Base::Vector3f& rCenter)
+{
+    return (rPt.x < rCenter.x ? 0 : 1) | (rPt.y < rCenter.y ? 0 : 2) | (rPt.z < rCenter.z ? 0 : 4);
+}
+
+}
+
+PointsOctree::PointsOctree (const PointKernel &rclM, unsigned long ulMaxPerLeaf)
+  : _rclPoints(rclM), _ulMaxPerLeaf(std::max<unsigned long>(ulMaxPerLeaf, 1)), _ulCtElements(0)
+{
+    Rebuild();
+}
+
+PointsOctree::~PointsOctree ()
+{
+}
+
+void PointsOctree::Validate ()
+{
+    if (_rclPoints.size() != _ulCtElements)
+        Rebuild();
+}
+
+Base::BoundBox3f PointsOctree::GetBoundBox () const
+{
+    if (_aclNodes.empty())
+        return Base::BoundBox3f();
+    return _aclNodes.front().clBox;
+}
+
+void PointsOctree::Rebuild ()
+{
+    const std::vector<PointKernel::value_type>& rPoints = _rclPoints.getBasicPoints();
+
+    _ulCtElements = rPoints.size();
+    _aclNodes.clear();
+    _aulPoints.clear();
+    _aulLodPoints.clear();
+
+    // the indices are stored with 32 bits like the number of points in the project file
+    Base::BoundBox3f clBox;
+    _aulPoints.reserve(rPoints.size());
+    for (std::size_t i = 0; i < rPoints.size(); i++) {
+        const PointKernel::value_type& rPt = rPoints[i];
+        if (!(boost::math::isnan(rPt.x) || boost::math::isnan(rPt.y) || boost::math::isnan(rPt.z))) {
+            _aulPoints.push_back(static_cast<uint32_t>(i));
+            clBox.Add(rPt);
+        }
+    }
+    if (_aulPoints.empty())
+        return;
+
+    Node clRoot;
+    clRoot.clBox = clBox;
+    clRoot.ulFirst = 0;
+    clRoot.ulCount = static_cast<uint32_t>(_aulPoints.size());
+    clRoot.ulChild = clRoot.ulCtChildren = 0;
+    clRoot.ulLod = clRoot.ulCtLod = 0;
+    _aclNodes.push_back(clRoot);
+
+    Cube clCube;
+    clCube.clCenter = clBox.GetCenter();
+    clCube.fHalf = 0.5f * std::max<float>(clBox.LengthX(), std::max<float>(clBox.LengthY(), clBox.LengthZ()));
+    clCube.iDepth = 0;
+    std::vector<Cube> aclCubes;
+    aclCubes.push_back(clCube);
+
+    // Splits the nodes in breadth-first order, so the children of a node are appended one after
+    // the other. The points of a node are sorted by their octant with a counting sort.
+    std::vector<uint32_t> aulBuffer(_aulPoints.size());
+    for (std::size_t n = 0; n < _aclNodes.size(); n++) {
+        Node clNode = _aclNodes[n];
+        Cube clParent = aclCubes[n];
+        if (clNode.ulCount <= _ulMaxPerLeaf || clParent.iDepth >= POINTS_OCTREE_MAX_DEPTH)
+            continue;
+
+        uint32_t aulCount[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        Base::BoundBox3f aclBoxes[8];
+        uint32_t* pBegin = &_aulPoints[0] + clNode.ulFirst;
+        uint32_t* pEnd = pBegin + clNode.ulCount;
+        for (uint32_t* it = pBegin; it != pEnd; ++it) {
+            const PointKernel::value_type& rPt = rPoints[*it];
+            int iOct = Octant(rPt, clParent.clCenter);
+            aulCount[iOct]++;
+            aclBoxes[iOct].Add(rPt);
+        }
+
+        uint32_t aulOffset[8];
+        uint32_t ulOffset = 0;
+        for (int i = 0; i < 8; i++) {
+            aulOffset[i] = ulOffset;
+            ulOffset += aulCount[i];
+        }
+        uint32_t* pBuffer = &aulBuffer[0] + clNode.ulFirst;
+        for (uint32_t* it = pBegin; it != pEnd; ++it)
+            pBuffer[aulOffset[Octant(rPoints[*it], clParent.clCenter)]++] = *it;
+        std::copy(pBuffer, pBuffer + clNode.ulCount, pBegin);
+
+        _aclNodes[n].ulChild = static_cast<uint32_t>(_aclNodes.size());
+        ulOffset = clNode.ulFirst;
+        for (int i = 0; i < 8; i++) {
+            if (aulCount[i] == 0)
+                continue;
+
+            Node clChild;
+            clChild.clBox = aclBoxes[i];
+            clChild.ulFirst = ulOffset;
+            clChild.ulCount = aulCount[i];
+            clChild.ulChild = clChild.ulCtChildren = 0;
+            clChild.ulLod = clChild.ulCtLod = 0;
+            _aclNodes.push_back(clChild);
+            _aclNodes[n].ulCtChildren++;
+            ulOffset += aulCount[i];
+
+            float fHalf = 0.5f * clParent.fHalf;
+            clCube.clCenter.x = clParent.clCenter.x + ((i & 1) ? fHalf : -fHalf);
+            clCube.clCenter.y = clParent.clCenter.y + ((i & 2) ? fHalf : -fHalf);
+            clCube.clCenter.z = clParent.clCenter.z + ((i & 4) ? fHalf : -fHalf);
+            clCube.fHalf = fHalf;
+            clCube.iDepth = clParent.iDepth + 1;
+            aclCubes.push_back(clCube);
+        }
+    }
+
+    // The subsample of a node takes each k-th of its points. The points of a leaf are interleaved
+    // in the same way, so that its subsample is the beginning of its points and needs no extra space.
+    for (std::vector<Node>::iterator it = _aclNodes.begin(); it != _aclNodes.end(); ++it) {
+        uint32_t ulStride = (it->ulCount + POINTS_OCTREE_CT_LOD - 1) / POINTS_OCTREE_CT_LOD;
+        it->ulCtLod = (it->ulCount + ulStride - 1) / ulStride;
+        if (it->ulCtChildren == 0) {
+            it->ulLod = it->ulFirst;
+            if (ulStride > 1) {
+                uint32_t* pBegin = &_aulPoints[0] + it->ulFirst;
+                uint32_t* pBuffer = &aulBuffer[0];
+                for (uint32_t j = 0; j < ulStride; j++) {
+                    for (uint32_t k = j; k < it->ulCount; k += ulStride)
+                        *pBuffer++ = pBegin[k];
+                }
+                std::copy(aulBuffer.begin(), aulBuffer.begin() + it->ulCount, pBegin);
+            }
+        }
+        else {
+            it->ulLod = static_cast<uint32_t>(_aulLodPoints.size());
+            for (uint32_t k = 0; k < it->ulCount; k += ulStride)
+                _aulLodPoints.push_back(_aulPoints[it->ulFirst + k]);
+        }
+    }
+}
+
+const uint32_t* PointsOctree::GetLodPoints (const Node& rNode) const
+{
+    if (rNode.ulCtChildren == 0)
+        return GetPoints(rNode);
+    return &_aulLodPoints[0] + rNode.ulLod;
+}
+
@@ -0,0 +1,109 @@
+/***************************************************************************
+ *   Copyright (c) 2026 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef POINTS_OCTREE_H
+#define POINTS_OCTREE_H
+
+#include <vector>
+
+#include "Points.h"
+#include <Base/BoundBox.h>
+#include <Base/Vector3D.h>
+
+#define POINTS_OCTREE_CT_LEAF   4096 // Default value for the maximum number of points of a leaf
+#define POINTS_OCTREE_CT_LOD    1024 // Maximum number of sample points of a node
+#define POINTS_OCTREE_MAX_DEPTH 21   // Maximum depth of the tree
+
+namespace Points {
+
+/**
+ * The PointsOctree class sorts the points of a point kernel into an octree. Each node knows the
+ * bounding box of its points and a precomputed subsample of them that represents the node at a
+ * lower level of detail.
+ *
+ * The points of each node are contiguous in the point order of the tree, so the tree can be used
+ * to render only the visible parts of a huge point cloud with a limited number of points.
+ *
+ * The tree works in the coordinates of the point kernel without its transformation. Points with
+ * invalid (NaN) coordinates are not part of the tree.
+ */
+class PointsExport PointsOctree
+{
+public:
+    /** A node of the tree. The children of an inner node are stored one after the other. */
+    struct Node
+    {
+        Base::BoundBox3f clBox;        /**< Bounding box of the points of the node. */
+        uint32_t         ulFirst;      /**< First point of the node in the point order. */
+        uint32_t         ulCount;      /**< Number of points of the node. */
+        uint32_t         ulChild;      /**< First child, 0 for leaves. */
+        uint32_t         ulCtChildren; /**< Number of children, 0 for leaves. */
+        uint32_t         ulLod;        /**< First point of the subsample, in the point order for leaves. */
+        uint32_t         ulCtLod;      /**< Number of points of the subsample. */
+    };
+
+    /// Construction, builds the tree for the points of \a rclM
+    PointsOctree (const PointKernel &rclM, unsigned long ulMaxPerLeaf = POINTS_OCTREE_CT_LEAF);
+    /// Destruction
+    ~PointsOctree ();
+
+    /** Rebuilds the tree. */
+    void Rebuild ();
+    /** Rebuilds the tree if the number of points of the kernel has changed. */
+    void Validate ();
+    /** Returns the bounding box of all points. */
+    Base::BoundBox3f GetBoundBox () const;
+
+    /** @name Nodes */
+    //@{
+    /** Returns the number of nodes, the root has the index 0. */
+    unsigned long CountNodes () const
+    { return _aclNodes.size(); }
+    /** Returns the node with the index \a ulNode. */
+    const Node& GetNode (unsigned long ulNode) const
+    { return _aclNodes[ulNode]; }
+    /** Returns the point indices of all points of the node. */
+    const uint32_t* GetPoints (const Node& rNode) const
+    { return &_aulPoints[0] + rNode.ulFirst; }
+    /** Returns the point indices of the subsample of the node. For leaves these are the first of
+     * their points. */
+    const uint32_t* GetLodPoints (const Node& rNode) const;
+    //@}
+
+private:
+    std::vector<Node>     _aclNodes;     /**< The nodes in breadth-first order. */
+    std::vector<uint32_t> _aulPoints;    /**< Point indices in the order of the tree. */
+    std::vector<uint32_t> _aulLodPoints; /**< Point indices of the subsamples of all nodes. */
+    const PointKernel&    _rclPoints;    /**< The point kernel. */
+    unsigned long         _ulMaxPerLeaf; /**< Maximum number of points of a leaf. */
+    unsigned long         _ulCtElements; /**< Number of points for validation issues. */
+
+    // no copying
+    PointsOctree (const PointsOctree&);
+    void operator= (const PointsOctree&);
+};
+
+} // namespace Points
+
+
+#endif // POINTS_OCTREE_H
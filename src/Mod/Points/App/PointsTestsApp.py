@@ -0,0 +1,111 @@
+#   This file is part of the FreeCAD CAx development system.              *
+#                                                                         *
+#   This program is free software; you can redistribute it and/or modify  *
+#   it under the terms of the GNU Lesser General Public License (LGPL)    *
+#   as published by the Free Software Foundation; either version 2 of     *
+#   the License, or (at your option) any later version.                   *
+#   for detail see the LICENCE text file.                                 *
+#                                                                         *
+#   FreeCAD is distributed in the hope that it will be useful,            *
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+#   GNU Library General Public License for more details.                  *
+#                                                                         *
+#   You should have received a copy of the GNU Library General Public     *
+#   License along with FreeCAD; if not, write to the Free Software        *
+#   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  *
+#   USA                                                                   *
+#**************************************************************************
+
+import FreeCAD, os, unittest, tempfile, Points
+
+
+#---------------------------------------------------------------------------
+# define the functions to test the FreeCAD points module
+#---------------------------------------------------------------------------
+
+
+class PointsAsciiTestCases(unittest.TestCase):
+    def setUp(self):
+        self.Doc = FreeCAD.newDocument("PointsTest")
+        self.Files = []
+
+    def readAscii(self, name, text):
+        fileName = tempfile.gettempdir() + os.sep + name + ".asc"
+        with open(fileName, "wb") as f:
+            f.write(text.encode("ascii"))
+        self.Files.append(fileName)
+        Points.insert(fileName, self.Doc.Name)
+        return self.Doc.getObject(name)
+
+    def checkPoints(self, feature, points):
+        pts = feature.Points.Points
+        self.assertEqual(len(pts), len(points))
+        for p, q in zip(pts, points):
+            self.assertTrue(p.isEqual(FreeCAD.Vector(*q), 1e-6 * max(1.0, FreeCAD.Vector(*q).Length)))
+
+    def testSeparators(self):
+        # blanks, tabs, commas and semicolons, CRLF and no line end at the end
+        text = "1 2 3\r\n4\t5\t6\r\n7,8,9\r\n10;11;12\r\n  13 ,  14 ;\t15  "
+        feature = self.readAscii("Separators", text)
+        self.checkPoints(feature, [(1,2,3), (4,5,6), (7,8,9), (10,11,12), (13,14,15)])
+
+    def testExponents(self):
+        text = ("1e2 -2.5E-1 +3e+0\n"
+                ".5 5. -0.0\n"
+                "1.5e-3 2E1 123456789012345678\n"
+                "1e30 -1e-30 0.1\n")
+        feature = self.readAscii("Exponents", text)
+        self.checkPoints(feature, [(100,-0.25,3), (0.5,5,0), (0.0015,20,123456789012345678),
+                                   (1e30,-1e-30,0.1)])
+
+    def testComments(self):
+        # headers, comments and lines with less than three numbers are skipped
+        text = "# points\nx y z\n\n1 2\n1 2 3\n# 4 5 6\n4 5 6\n"
+        feature = self.readAscii("Comments", text)
+        self.checkPoints(feature, [(1,2,3), (4,5,6)])
+        self.assertFalse(hasattr(feature, "Intensity"))
+
+    def testThreeColumns(self):
+        feature = self.readAscii("ThreeColumns", "0 0 0\n1 0 0\n0 1 0\n")
+        self.checkPoints(feature, [(0,0,0), (1,0,0), (0,1,0)])
+        self.assertFalse(hasattr(feature, "Intensity"))
+        self.assertFalse(hasattr(feature, "Color"))
+        self.assertFalse(hasattr(feature, "Normal"))
+
+    def testFourColumns(self):
+        # the fourth column is the intensity, lines with another column count are skipped
+        text = "0 0 0 0.5\n2 2 2\n1 0 0 0.25\n0 1 0 1\n"
+        feature = self.readAscii("FourColumns", text)
+        self.checkPoints(feature, [(0,0,0), (1,0,0), (0,1,0)])
+        self.assertEqual(feature.Intensity, [0.5, 0.25, 1.0])
+        self.assertFalse(hasattr(feature, "Color"))
+        self.assertFalse(hasattr(feature, "Normal"))
+
+    def testSixColumnsColor(self):
+        # integers in [0,255] are colors
+        text = "0 0 0 255 0 0\n1 0 0 0 255 0\n0 1 0 0 0 51\n"
+        feature = self.readAscii("SixColumnsColor", text)
+        self.checkPoints(feature, [(0,0,0), (1,0,0), (0,1,0)])
+        self.assertFalse(hasattr(feature, "Normal"))
+        colors = [(1,0,0), (0,1,0), (0,0,0.2)]
+        self.assertEqual(len(feature.Color), len(colors))
+        for c, d in zip(feature.Color, colors):
+            for i in range(3):
+                self.assertAlmostEqual(c[i], d[i], 6)
+
+    def testSixColumnsNormal(self):
+        # all other values are normals
+        text = "0 0 0 0 0 1\n1 0 0 0.5 0.5 0.7071\n0 1 0 -1 0 0\n"
+        feature = self.readAscii("SixColumnsNormal", text)
+        self.checkPoints(feature, [(0,0,0), (1,0,0), (0,1,0)])
+        self.assertFalse(hasattr(feature, "Color"))
+        normals = [(0,0,1), (0.5,0.5,0.7071), (-1,0,0)]
+        self.assertEqual(len(feature.Normal), len(normals))
+        for n, m in zip(feature.Normal, normals):
+            self.assertTrue(n.isEqual(FreeCAD.Vector(*m), 1e-6))
+
+    def tearDown(self):
+        FreeCAD.closeDocument("PointsTest")
+        for fileName in self.Files:
+            os.remove(fileName)
@@ -154,9 +154,8 @@ void PropertyGreyValueList::SaveDocFile (Base::Writer &writer) const
     Base::OutputStream str(writer.Stream());
     uint32_t uCt = (uint32_t)getSize();
     str << uCt;
-    for (std::vector<float>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
-        str << *it;
-    }
+    if (uCt > 0)
+        str.write(&_lValueList[0], _lValueList.size());
 }
 
 void PropertyGreyValueList::RestoreDocFile(Base::Reader &reader)
@@ -165,9 +164,8 @@ void PropertyGreyValueList::RestoreDocFile(Base::Reader &reader)
     uint32_t uCt=0;
     str >> uCt;
     std::vector<float> values(uCt);
-    for (std::vector<float>::iterator it = values.begin(); it != values.end(); ++it) {
-        str >> *it;
-    }
+    if (uCt > 0)
+        str.read(&values[0], values.size());
     setValues(values);
 }
 
@@ -328,9 +326,10 @@ void PropertyNormalList::SaveDocFile (Base::Writer &writer) const
     Base::OutputStream str(writer.Stream());
     uint32_t uCt = (uint32_t)getSize();
     str << uCt;
-    for (std::vector<Base::Vector3f>::const_iterator it = _lValueList.begin(); it != _lValueList.end(); ++it) {
-        str << it->x << it->y << it->z;
-    }
+    // the coordinates of the vectors are contiguous
+    static_assert(sizeof(Base::Vector3f) == 3 * sizeof(float), "Unexpected vector layout");
+    if (uCt > 0)
+        str.write(&_lValueList[0].x, 3 * _lValueList.size());
 }
 
 void PropertyNormalList::RestoreDocFile(Base::Reader &reader)
@@ -339,9 +338,8 @@ void PropertyNormalList::RestoreDocFile(Base::Reader &reader)
     uint32_t uCt=0;
     str >> uCt;
     std::vector<Base::Vector3f> values(uCt);
-    for (std::vector<Base::Vector3f>::iterator it = values.begin(); it != values.end(); ++it) {
-        str >> it->x >> it->y >> it->z;
-    }
+    if (uCt > 0)
+        str.read(&values[0].x, 3 * values.size());
     setValues(values);
 }
 
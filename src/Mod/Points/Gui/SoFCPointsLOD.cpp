@@ -0,0 +1,309 @@
+/***************************************************************************
+ *   Copyright (c) 2026 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cmath>
+# include <queue>
+# ifdef FC_OS_WIN32
+# include <windows.h>
+# endif
+# ifdef FC_OS_MACOSX
+# include <OpenGL/gl.h>
+# else
+# include <GL/gl.h>
+# endif
+# include <Inventor/SbViewVolume.h>
+# include <Inventor/SbViewportRegion.h>
+# include <Inventor/actions/SoGetPrimitiveCountAction.h>
+# include <Inventor/actions/SoGLRenderAction.h>
+# include <Inventor/bundles/SoMaterialBundle.h>
+# include <Inventor/details/SoPointDetail.h>
+# include <Inventor/elements/SoGLCacheContextElement.h>
+# include <Inventor/elements/SoLazyElement.h>
+# include <Inventor/elements/SoMaterialBindingElement.h>
+# include <Inventor/elements/SoModelMatrixElement.h>
+# include <Inventor/elements/SoNormalElement.h>
+# include <Inventor/elements/SoPointSizeElement.h>
+# include <Inventor/elements/SoViewportRegionElement.h>
+# include <Inventor/elements/SoViewVolumeElement.h>
+# include <Inventor/misc/SoState.h>
+# include <Inventor/SoPrimitiveVertex.h>
+#endif
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include "SoFCPointsLOD.h"
+#include <Mod/Points/App/Points.h>
+#include <Mod/Points/App/PointsOctree.h>
+
+using namespace PointsGui;
+
+
+SO_NODE_SOURCE(SoFCPointsLOD);
+
+void SoFCPointsLOD::initClass()
+{
+    SO_NODE_INIT_CLASS(SoFCPointsLOD, SoShape, "Shape");
+}
+
+SoFCPointsLOD::SoFCPointsLOD()
+    : renderPointLimit(2000000)
+    , points(0)
+    , octree(0)
+{
+    SO_NODE_CONSTRUCTOR(SoFCPointsLOD);
+    setName(SoFCPointsLOD::getClassTypeId().getName());
+}
+
+SoFCPointsLOD::~SoFCPointsLOD()
+{
+    delete octree;
+}
+
+void SoFCPointsLOD::setPoints(const Points::PointKernel* pts)
+{
+    // the tree is built when it's needed the first time
+    delete octree;
+    octree = 0;
+    points = pts;
+
+    touch();
+}
+
+/**
+ * Returns the tree of the points and builds it if needed.
+ */
+const Points::PointsOctree* SoFCPointsLOD::getTree()
+{
+    if (!octree)
+        octree = new Points::PointsOctree(*points);
+    return octree;
+}
+
+/**
+ * Selects the nodes of the tree to render. The points of the nodes in \a fullNodes are rendered
+ * completely, of the nodes in \a lodNodes only their subsample.
+ */
+void SoFCPointsLOD::selectNodes(SoState * state, std::vector<unsigned long>& lodNodes,
+                                std::vector<unsigned long>& fullNodes) const
+{
+    if (octree->CountNodes() == 0)
+        return;
+
+    const SbViewVolume& vv = SoViewVolumeElement::get(state);
+    const SbMatrix& mat = SoModelMatrixElement::get(state);
+    const SbVec2s& size = SoViewportRegionElement::get(state).getViewportSizePixels();
+    float pixels = static_cast<float>(std::max<short>(size[0], size[1]));
+    float pointSize = std::max<float>(SoPointSizeElement::get(state), 1.0f);
+
+    // Returns the size of the node on the screen in pixels, or a negative value if it is invisible
+    struct ScreenSize {
+        const SbViewVolume& vv;
+        const SbMatrix& mat;
+        float pixels;
+        float operator()(const Points::PointsOctree::Node& node) const {
+            SbBox3f box(node.clBox.MinX, node.clBox.MinY, node.clBox.MinZ,
+                        node.clBox.MaxX, node.clBox.MaxY, node.clBox.MaxZ);
+            box.transform(mat);
+            if (!vv.intersect(box))
+                return -1.0f;
+            float scale = vv.getWorldToScreenScale(box.getCenter(), 1.0f);
+            if (scale <= 0.0f)
+                return pixels;
+            return (box.getMax() - box.getMin()).length() / scale * pixels;
+        }
+    } screenSize = { vv, mat, pixels };
+
+    // refines the nodes with the largest size on the screen first
+    typedef std::pair<float, unsigned long> QueueItem;
+    std::priority_queue<QueueItem> queue;
+    const Points::PointsOctree::Node& root = octree->GetNode(0);
+    float rootSize = screenSize(root);
+    if (rootSize < 0.0f)
+        return;
+    queue.push(QueueItem(rootSize, 0));
+
+    // number of points of the selected and the queued nodes
+    unsigned long numPoints = root.ulCtLod;
+    while (!queue.empty()) {
+        QueueItem item = queue.top();
+        queue.pop();
+
+        // the subsample is enough if its points are not further apart than the point size
+        const Points::PointsOctree::Node& node = octree->GetNode(item.second);
+        bool refine = item.first > pointSize * std::sqrt(static_cast<float>(node.ulCtLod));
+        if (refine && node.ulCtChildren == 0) {
+            unsigned long cost = node.ulCount - node.ulCtLod;
+            if (numPoints + cost <= renderPointLimit) {
+                numPoints += cost;
+                fullNodes.push_back(item.second);
+                continue;
+            }
+        }
+        else if (refine) {
+            std::vector<QueueItem> children;
+            unsigned long cost = 0;
+            for (unsigned long i = node.ulChild; i < node.ulChild + node.ulCtChildren; i++) {
+                const Points::PointsOctree::Node& child = octree->GetNode(i);
+                float childSize = screenSize(child);
+                if (childSize >= 0.0f) {
+                    children.push_back(QueueItem(childSize, i));
+                    cost += child.ulCtLod;
+                }
+            }
+
+            // invisible children are dropped
+            if (numPoints + cost <= renderPointLimit + node.ulCtLod) {
+                numPoints = numPoints + cost - node.ulCtLod;
+                for (std::vector<QueueItem>::iterator it = children.begin(); it != children.end(); ++it)
+                    queue.push(*it);
+                continue;
+            }
+        }
+
+        lodNodes.push_back(item.second);
+    }
+}
+
+/**
+ * Renders the visible points with the level of detail that fits to the view.
+ */
+void SoFCPointsLOD::GLRender(SoGLRenderAction *action)
+{
+    if (!shouldGLRender(action) || !points || points->size() == 0)
+        return;
+
+    getTree();
+
+    SoState*  state = action->getState();
+
+    // the rendered points depend on the camera
+    SoGLCacheContextElement::shouldAutoCache(state, SoGLCacheContextElement::DONT_AUTO_CACHE);
+
+    std::vector<unsigned long> lodNodes, fullNodes;
+    selectNodes(state, lodNodes, fullNodes);
+
+    const std::vector<Points::PointKernel::value_type>& kernel = points->getBasicPoints();
+    int32_t numPoints = static_cast<int32_t>(kernel.size());
+
+    // use the colors and normals of the points if there is one for each of them
+    SoMaterialBindingElement::Binding binding = SoMaterialBindingElement::get(state);
+    bool perVertex = (binding == SoMaterialBindingElement::PER_VERTEX ||
+                      binding == SoMaterialBindingElement::PER_VERTEX_INDEXED) &&
+                      SoLazyElement::getInstance(state)->getNumDiffuse() >= numPoints;
+    const SoNormalElement* normalElement = SoNormalElement::getInstance(state);
+    const SbVec3f* normals = normalElement->getNum() >= numPoints ? normalElement->getArrayPtr() : 0;
+
+    state->push();
+    if (!normals)
+        SoLazyElement::setLightModel(state, SoLazyElement::BASE_COLOR);
+    SoMaterialBundle mb(action);
+    mb.sendFirst();
+
+    struct Vertex {
+        SoMaterialBundle& mb;
+        bool perVertex;
+        const SbVec3f* normals;
+        const std::vector<Points::PointKernel::value_type>& kernel;
+        void operator()(uint32_t index) const {
+            if (perVertex)
+                mb.send(static_cast<int>(index), TRUE);
+            if (normals)
+                glNormal3fv(normals[index].getValue());
+            glVertex3fv(&kernel[index].x);
+        }
+    } vertex = { mb, perVertex, normals, kernel };
+
+    glBegin(GL_POINTS);
+    for (std::vector<unsigned long>::iterator it = lodNodes.begin(); it != lodNodes.end(); ++it) {
+        const Points::PointsOctree::Node& node = octree->GetNode(*it);
+        const uint32_t* index = octree->GetLodPoints(node);
+        for (uint32_t i = 0; i < node.ulCtLod; i++)
+            vertex(index[i]);
+    }
+    for (std::vector<unsigned long>::iterator it = fullNodes.begin(); it != fullNodes.end(); ++it) {
+        const Points::PointsOctree::Node& node = octree->GetNode(*it);
+        const uint32_t* index = octree->GetPoints(node);
+        for (uint32_t i = 0; i < node.ulCount; i++)
+            vertex(index[i]);
+    }
+    glEnd();
+
+    state->pop();
+}
+
+/**
+ * Sets the bounding box of the points to \a box and its center to \a center.
+ */
+void SoFCPointsLOD::computeBBox(SoAction * /*action*/, SbBox3f &box, SbVec3f &center)
+{
+    Base::BoundBox3f bbox;
+    if (points && points->size() > 0)
+        bbox = getTree()->GetBoundBox();
+    if (bbox.IsValid()) {
+        box.setBounds(bbox.MinX, bbox.MinY, bbox.MinZ, bbox.MaxX, bbox.MaxY, bbox.MaxZ);
+        center = box.getCenter();
+    }
+    else {
+        box.setBounds(SbVec3f(0,0,0), SbVec3f(0,0,0));
+        center.setValue(0.0f,0.0f,0.0f);
+    }
+}
+
+/**
+ * Adds the number of the points to the \a SoGetPrimitiveCountAction.
+ */
+void SoFCPointsLOD::getPrimitiveCount(SoGetPrimitiveCountAction * action)
+{
+    if (!this->shouldPrimitiveCount(action) || !points)
+        return;
+    action->addNumPoints(points->size());
+}
+
+/**
+ * Creates all valid points for actions other than rendering.
+ */
+void SoFCPointsLOD::generatePrimitives(SoAction* action)
+{
+    if (!points)
+        return;
+
+    SoPrimitiveVertex vertex;
+    SoPointDetail pointDetail;
+    vertex.setDetail(&pointDetail);
+
+    const std::vector<Points::PointKernel::value_type>& kernel = points->getBasicPoints();
+    beginShape(action, POINTS);
+    for (std::size_t i = 0; i < kernel.size(); i++) {
+        const Points::PointKernel::value_type& pnt = kernel[i];
+        if (boost::math::isnan(pnt.x) || boost::math::isnan(pnt.y) || boost::math::isnan(pnt.z))
+            continue;
+        pointDetail.setCoordinateIndex(static_cast<int>(i));
+        vertex.setPoint(SbVec3f(pnt.x, pnt.y, pnt.z));
+        shapeVertex(&vertex);
+    }
+    endShape();
+}
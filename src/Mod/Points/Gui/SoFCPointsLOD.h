@@ -0,0 +1,89 @@
+/***************************************************************************
+ *   Copyright (c) 2026 FreeCAD Developers                                 *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef POINTSGUI_SOFCPOINTSLOD_H
+#define POINTSGUI_SOFCPOINTSLOD_H
+
+#include <vector>
+#include <Inventor/SbBox3f.h>
+#include <Inventor/nodes/SoSubNode.h>
+#include <Inventor/nodes/SoShape.h>
+
+namespace Points {
+    class PointKernel;
+    class PointsOctree;
+}
+
+namespace PointsGui {
+
+/**
+ * The SoFCPointsLOD class is an Inventor shape node that is designed to render huge point clouds.
+ *
+ * The points are sorted into a Points::PointsOctree when the node is rendered the first time.
+ * The GLRender() method skips all nodes of the tree outside the view volume and renders the
+ * others with the subsample that is enough for their size on the screen, i.e. a node is refined
+ * while its sample points are further apart than the point size. The nodes with the largest size
+ * on the screen are refined first until \a renderPointLimit points would be exceeded. The default
+ * value is 2.000.000.
+ *
+ * The node renders the points of the kernel directly without copying them into an SoCoordinate3.
+ * If the material is bound per vertex and there is a diffuse color for each point, the points are
+ * rendered with their colors. If there is a normal for each point, they are lit.
+ */
+class PointsGuiExport SoFCPointsLOD : public SoShape {
+    typedef SoShape inherited;
+
+    SO_NODE_HEADER(SoFCPointsLOD);
+
+public:
+    static void initClass();
+    SoFCPointsLOD();
+
+    /** Sets the points to render. The kernel must exist as long as it is set to the node,
+     * and this method must be called again if the kernel has changed. The tree is built when
+     * the node is rendered or its bounding box is needed. */
+    void setPoints(const Points::PointKernel* points);
+
+    unsigned int renderPointLimit;
+
+protected:
+    virtual void GLRender(SoGLRenderAction *action);
+    virtual void computeBBox(SoAction *action, SbBox3f &box, SbVec3f &center);
+    virtual void getPrimitiveCount(SoGetPrimitiveCountAction * action);
+    virtual void generatePrimitives(SoAction *action);
+
+private:
+    // Force using the reference count mechanism.
+    virtual ~SoFCPointsLOD();
+    const Points::PointsOctree* getTree();
+    void selectNodes(SoState * state, std::vector<unsigned long>& lodNodes,
+                     std::vector<unsigned long>& fullNodes) const;
+
+private:
+    const Points::PointKernel* points;
+    Points::PointsOctree* octree;
+};
+
+} // namespace PointsGui
+
+
+#endif // POINTSGUI_SOFCPOINTSLOD_H
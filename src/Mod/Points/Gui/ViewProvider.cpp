@@ -58,6 +58,7 @@
 #include <Mod/Points/App/PointsFeature.h>
 
 #include "ViewProvider.h"
+#include "SoFCPointsLOD.h"
 #include "../App/Properties.h"
 
 
@@ -92,6 +93,12 @@ ViewProviderPoints::ViewProviderPoints()
     pcPointStyle->ref();
     pcPointStyle->style = SoDrawStyle::POINTS;
     pcPointStyle->pointSize = PointSize.getValue();
+
+    pcPointsLOD = new SoFCPointsLOD();
+    pcPointsLOD->ref();
+    pcPointsLODAttr = new SoGroup();
+    pcPointsLODAttr->ref();
+    coordsOutdated = false;
 }
 
 ViewProviderPoints::~ViewProviderPoints()
@@ -101,6 +108,9 @@ ViewProviderPoints::~ViewProviderPoints()
     pcPointsNormal->unref();
     pcColorMat->unref();
     pcPointStyle->unref();
+    pcPointsLOD->setPoints(0);
+    pcPointsLOD->unref();
+    pcPointsLODAttr->unref();
 }
 
 void ViewProviderPoints::onChanged(const App::Property* prop)
@@ -160,6 +170,16 @@ void ViewProviderPoints::setVertexNormalMode(Points::PropertyNormalList* pcPrope
 
 void ViewProviderPoints::setDisplayMode(const char* ModeName)
 {
+    // the coordinates are not kept in level of detail mode
+    bool lod = strcmp("Level of detail",ModeName) == 0;
+    if (!lod && coordsOutdated) {
+        App::Property* prop = pcObject->getPropertyByName("Points");
+        if (prop && prop->getTypeId() == Points::PropertyPointKernel::getClassTypeId()) {
+            createCoordinates(prop);
+            coordsOutdated = false;
+        }
+    }
+
     int numPoints = pcPointsCoord->point.getNum();
 
     if (strcmp("Color",ModeName) == 0) {
@@ -234,6 +254,15 @@ void ViewProviderPoints::setDisplayMode(const char* ModeName)
     else if (strcmp("Points",ModeName) == 0) {
         setDisplayMaskMode("Point");
     }
+    else if (lod) {
+        // the points are rendered from the kernel
+        if (!coordsOutdated) {
+            clearCoordinates();
+            coordsOutdated = true;
+        }
+        setLevelOfDetailAttributes();
+        setDisplayMaskMode("LOD");
+    }
 
     ViewProviderGeometryObject::setDisplayMode(ModeName);
 }
@@ -242,6 +271,7 @@ std::vector<std::string> ViewProviderPoints::getDisplayModes(void) const
 {
     std::vector<std::string> StrList;
     StrList.push_back("Points");
+    StrList.push_back("Level of detail");
 
     if (pcObject) {
         std::map<std::string,App::Property*> Map;
@@ -289,6 +319,68 @@ QIcon ViewProviderPoints::getIcon() const
     return px;
 }
 
+void ViewProviderPoints::addLevelOfDetailMode()
+{
+    // renders only the visible points with the needed level of detail, for huge point clouds
+    SoGroup* pcPointLODRoot = new SoGroup();
+    pcPointLODRoot->addChild(pcPointStyle);
+    pcPointLODRoot->addChild(pcShapeMaterial);
+    pcPointLODRoot->addChild(pcPointsLODAttr);
+    pcPointLODRoot->addChild(pcPointsLOD);
+    addDisplayMaskMode(pcPointLODRoot, "LOD");
+}
+
+void ViewProviderPoints::setLevelOfDetailAttributes()
+{
+    // render the points with their colors, or else shaded, if there is one for each point
+    pcPointsLODAttr->removeAllChildren();
+    App::Property* prop = pcObject->getPropertyByName("Points");
+    if (!prop || prop->getTypeId() != Points::PropertyPointKernel::getClassTypeId())
+        return;
+    int numPoints = static_cast<int>(static_cast<Points::PropertyPointKernel*>(prop)->getValue().size());
+
+    App::PropertyColorList* colors = 0;
+    Points::PropertyNormalList* normals = 0;
+    std::map<std::string,App::Property*> Map;
+    pcObject->getPropertyMap(Map);
+    for (std::map<std::string,App::Property*>::iterator it = Map.begin(); it != Map.end(); ++it) {
+        Base::Type type = it->second->getTypeId();
+        if (type == App::PropertyColorList::getClassTypeId()) {
+            if (static_cast<App::PropertyColorList*>(it->second)->getSize() == numPoints)
+                colors = static_cast<App::PropertyColorList*>(it->second);
+        }
+        else if (type == Points::PropertyNormalList::getClassTypeId()) {
+            if (static_cast<Points::PropertyNormalList*>(it->second)->getSize() == numPoints)
+                normals = static_cast<Points::PropertyNormalList*>(it->second);
+        }
+    }
+
+    if (colors) {
+        setVertexColorMode(colors);
+        SoMaterialBinding* pcMatBinding = new SoMaterialBinding;
+        pcMatBinding->value = SoMaterialBinding::PER_VERTEX;
+        pcPointsLODAttr->addChild(pcColorMat);
+        pcPointsLODAttr->addChild(pcMatBinding);
+    }
+    else if (normals) {
+        setVertexNormalMode(normals);
+        pcPointsLODAttr->addChild(pcPointsNormal);
+    }
+}
+
+void ViewProviderPoints::updateCoordinates(const App::Property* prop)
+{
+    pcPointsLOD->setPoints(&static_cast<const Points::PropertyPointKernel*>(prop)->getValue());
+    if (getActiveDisplayMode() == "Level of detail") {
+        clearCoordinates();
+        coordsOutdated = true;
+    }
+    else {
+        createCoordinates(prop);
+        coordsOutdated = false;
+    }
+}
+
 bool ViewProviderPoints::setEdit(int ModNum)
 {
     if (ModNum == ViewProvider::Transform)
@@ -365,6 +457,9 @@ void ViewProviderScattered::attach(App::DocumentObject* pcObj)
     pcPointRoot->addChild(pcHighlight);
     addDisplayMaskMode(pcPointRoot, "Point");
 
+    // points with level of detail ------------------------------
+    addLevelOfDetailMode();
+
     // points shaded ---------------------------------------------
     if (std::find(modes.begin(), modes.end(), std::string("Shaded")) != modes.end()) {
         SoGroup* pcPointShadedRoot = new SoGroup();
@@ -393,8 +488,7 @@ void ViewProviderScattered::updateData(const App::Property* prop)
 {
     ViewProviderPoints::updateData(prop);
     if (prop->getTypeId() == Points::PropertyPointKernel::getClassTypeId()) {
-        ViewProviderPointsBuilder builder;
-        builder.createPoints(prop, pcPointsCoord, pcPoints);
+        updateCoordinates(prop);
 
         // The number of points might have changed, so force also a resize of the Inventor internals
         setActiveMode();
@@ -410,6 +504,18 @@ void ViewProviderScattered::updateData(const App::Property* prop)
     }
 }
 
+void ViewProviderScattered::createCoordinates(const App::Property* prop)
+{
+    ViewProviderPointsBuilder builder;
+    builder.createPoints(prop, pcPointsCoord, pcPoints);
+}
+
+void ViewProviderScattered::clearCoordinates()
+{
+    pcPoints->numPoints = 0;
+    pcPointsCoord->point.setNum(0);
+}
+
 void ViewProviderScattered::cut(const std::vector<SbVec2f>& picked, Gui::View3DInventorViewer &Viewer)
 {
     // create the polygon from the picked points
@@ -526,6 +632,9 @@ void ViewProviderStructured::attach(App::DocumentObject* pcObj)
     pcPointRoot->addChild(pcHighlight);
     addDisplayMaskMode(pcPointRoot, "Point");
 
+    // points with level of detail ------------------------------
+    addLevelOfDetailMode();
+
     // points shaded ---------------------------------------------
     if (std::find(modes.begin(), modes.end(), std::string("Shaded")) != modes.end()) {
         SoGroup* pcPointShadedRoot = new SoGroup();
@@ -554,14 +663,25 @@ void ViewProviderStructured::updateData(const App::Property* prop)
 {
     ViewProviderPoints::updateData(prop);
     if (prop->getTypeId() == Points::PropertyPointKernel::getClassTypeId()) {
-        ViewProviderPointsBuilder builder;
-        builder.createPoints(prop, pcPointsCoord, pcPoints);
+        updateCoordinates(prop);
 
         // The number of points might have changed, so force also a resize of the Inventor internals
         setActiveMode();
     }
 }
 
+void ViewProviderStructured::createCoordinates(const App::Property* prop)
+{
+    ViewProviderPointsBuilder builder;
+    builder.createPoints(prop, pcPointsCoord, pcPoints);
+}
+
+void ViewProviderStructured::clearCoordinates()
+{
+    pcPoints->coordIndex.setNum(0);
+    pcPointsCoord->point.setNum(0);
+}
+
 void ViewProviderStructured::cut(const std::vector<SbVec2f>& picked, Gui::View3DInventorViewer &Viewer)
 {
     // create the polygon from the picked points
@@ -31,6 +31,7 @@
 
 
 class SoSwitch;
+class SoGroup;
 class SoPointSet;
 class SoIndexedPointSet;
 class SoLocateHighlight;
@@ -55,6 +56,8 @@ namespace Points {
 
 namespace PointsGui {
 
+class SoFCPointsLOD;
+
 class ViewProviderPointsBuilder : public Gui::ViewProviderBuilder
 {
 public:
@@ -100,6 +103,13 @@ protected:
     void setVertexGreyvalueMode(Points::PropertyGreyValueList*);
     void setVertexNormalMode(Points::PropertyNormalList*);
     virtual void cut(const std::vector<SbVec2f>& picked, Gui::View3DInventorViewer &Viewer) = 0;
+    void addLevelOfDetailMode();
+    void setLevelOfDetailAttributes();
+    /** Sets the points of the kernel property \a prop to the nodes. In level of detail mode
+     * the coordinates are created not before another mode is set. */
+    void updateCoordinates(const App::Property* prop);
+    virtual void createCoordinates(const App::Property* prop) = 0;
+    virtual void clearCoordinates() = 0;
 
 protected:
     Gui::SoFCSelection  * pcHighlight;
@@ -107,6 +117,9 @@ protected:
     SoMaterial          * pcColorMat;
     SoNormal            * pcPointsNormal;
     SoDrawStyle         * pcPointStyle;
+    SoFCPointsLOD       * pcPointsLOD;
+    SoGroup             * pcPointsLODAttr;
+    bool                  coordsOutdated;
 
 private:
     static App::PropertyFloatConstraint::Constraints floatRange;
@@ -135,6 +148,8 @@ public:
 
 protected:
     virtual void cut(const std::vector<SbVec2f>& picked, Gui::View3DInventorViewer &Viewer);
+    virtual void createCoordinates(const App::Property* prop);
+    virtual void clearCoordinates();
 
 protected:
     SoPointSet          * pcPoints;
@@ -163,6 +178,8 @@ public:
 
 protected:
     virtual void cut(const std::vector<SbVec2f>& picked, Gui::View3DInventorViewer &Viewer);
+    virtual void createCoordinates(const App::Property* prop);
+    virtual void clearCoordinates();
 
 protected:
     SoIndexedPointSet   * pcPoints;
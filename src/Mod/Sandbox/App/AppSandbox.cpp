@@ -24,9 +24,14 @@
 #include "PreCompiled.h"
 #ifndef _PreComp_
 # include <Python.h>
+# include <sstream>
+# include <thread>
 #endif
 
 #include <Base/Console.h>
+#include <Base/Interpreter.h>
+#include <Base/TimeInfo.h>
+#include <App/StringHasher.h>
 #include <App/DocumentPy.h>
 #include <App/DocumentObjectPy.h>
 #include <CXX/Extensions.hxx>
@@ -208,6 +213,11 @@ public:
         add_varargs_method("DocumentObjectProtector",
             &Module::new_DocumentObjectProtector,
             "DocumentObjectProtector(DocumentObject)");
+        add_varargs_method("benchmarkStringHasher",
+            &Module::benchmarkStringHasher,
+            "benchmarkStringHasher([threads=4, count=100000]) -> dict\n"
+            "Measure the throughput of StringHasher.getID() called from\n"
+            "several threads. Half of the strings are shared by all threads.");
         initialize("This module is the Sandbox module"); // register with Python
         
         Py::Dict d( moduleDictionary() );
@@ -234,6 +244,47 @@ private:
         App::DocumentObjectPy* obj = static_cast<App::DocumentObjectPy*>(o);
         return Py::asObject(new Sandbox::DocumentObjectProtectorPy(obj));
     }
+    Py::Object benchmarkStringHasher(const Py::Tuple& args)
+    {
+        int threads = 4;
+        int count = 100000;
+        if (!PyArg_ParseTuple(args.ptr(), "|ii", &threads, &count))
+            throw Py::Exception();
+        if (threads < 1 || count < 1)
+            throw Py::ValueError("expect positive thread number and count");
+
+        App::StringHasherRef hasher(new App::StringHasher);
+        Base::TimeInfo start;
+        {
+            Base::PyGILStateRelease unlock;
+            std::vector<std::thread> workers;
+            for (int t=0; t<threads; ++t) {
+                workers.emplace_back([hasher, count, t]() {
+                    std::ostringstream ss;
+                    for (int i=0; i<count; ++i) {
+                        ss.str("");
+                        if (i % 2)
+                            ss << "Face" << i << ";:M;CUT;:H" << i;
+                        else
+                            ss << "Edge" << i << ";:G;FUS;:H" << t;
+                        std::string name = ss.str();
+                        hasher->getID(name.c_str(), (int)name.size());
+                    }
+                });
+            }
+            for (auto &worker : workers)
+                worker.join();
+        }
+        float seconds = Base::TimeInfo::diffTimeF(start, Base::TimeInfo());
+
+        Py::Dict ret;
+        ret.setItem("threads", Py::Long(threads));
+        ret.setItem("calls", Py::Long((long)threads*count));
+        ret.setItem("seconds", Py::Float(seconds));
+        ret.setItem("callsPerSecond", Py::Float(seconds>0.0f ? threads*(double)count/seconds : 0.0));
+        ret.setItem("size", Py::Long((long)hasher->size()));
+        return ret;
+    }
 };
 
 PyObject* initModule()
@@ -62,6 +62,7 @@
 
 #include <Base/Console.h>
 #include <Base/Sequencer.h>
+#include <Base/TimeInfo.h>
 #include <App/Application.h>
 #include <App/Document.h>
 #include <Gui/Application.h>
@@ -77,6 +78,10 @@
 #include <Mod/Sandbox/App/DocumentProtector.h>
 #include <Mod/Mesh/App/MeshFeature.h>
 #include <Mod/Mesh/App/Core/Degeneration.h>
+#include <Mod/Mesh/App/Core/Algorithm.h>
+#include <Mod/Mesh/App/Core/BVH.h>
+#include <Mod/Mesh/App/Core/Grid.h>
+#include <Mod/Mesh/App/Core/Iterator.h>
 #include "Workbench.h"
 #include "GLGraphicsView.h"
 #include "TaskPanelView.h"
@@ -919,6 +924,99 @@ bool CmdSandboxMeshTestRef::isActive(void)
     return true;
 }
 
+DEF_STD_CMD_A(CmdSandboxMeshQueryBenchmark)
+
+CmdSandboxMeshQueryBenchmark::CmdSandboxMeshQueryBenchmark()
+  : Command("Sandbox_MeshQueryBenchmark")
+{
+    sAppModule    = "Sandbox";
+    sGroup        = QT_TR_NOOP("Sandbox");
+    sMenuText     = QT_TR_NOOP("Benchmark mesh queries");
+    sToolTipText  = QT_TR_NOOP("Compare ray and distance queries of the facet grid and the bounding volume hierarchy");
+    sWhatsThis    = "Sandbox_MeshQueryBenchmark";
+    sStatusTip    = QT_TR_NOOP("Compare ray and distance queries of the facet grid and the bounding volume hierarchy");
+}
+
+void CmdSandboxMeshQueryBenchmark::activated(int)
+{
+    // Select meshes of tessellated CAD models, e.g. a STEP file meshed with MeshPart,
+    // to see the difference between both structures for unevenly sized facets.
+    Gui::WaitCursor wc;
+    std::vector<Mesh::Feature*> meshObj = Gui::Selection().getObjectsOfType<Mesh::Feature>();
+    for (std::vector<Mesh::Feature*>::iterator it = meshObj.begin(); it != meshObj.end(); ++it) {
+        const MeshCore::MeshKernel& kernel = (*it)->Mesh.getValue().getKernel();
+        unsigned long count = kernel.CountFacets();
+        if (count == 0)
+            continue;
+        Base::Console().Message("%s: %lu facets\n", (*it)->Label.getValue(), count);
+
+        Base::TimeInfo start;
+        MeshCore::MeshFacetGrid grid(kernel);
+        Base::Console().Message("  Build grid: %f s\n", Base::TimeInfo::diffTimeF(start, Base::TimeInfo()));
+        start = Base::TimeInfo();
+        MeshCore::MeshFacetBVH tree(kernel);
+        Base::Console().Message("  Build BVH:  %f s\n", Base::TimeInfo::diffTimeF(start, Base::TimeInfo()));
+
+        // shoot rays onto up to 10000 facets from slightly above their centers
+        MeshCore::MeshAlgorithm alg(kernel);
+        float offset = 0.01f * kernel.GetBoundBox().CalcDiagonalLength();
+        unsigned long step = std::max<unsigned long>(1, count / 10000);
+        std::vector<Base::Vector3f> points, dirs;
+        MeshCore::MeshFacetIterator cF(kernel);
+        for (unsigned long i = 0; i < count; i += step) {
+            cF.Set(i);
+            Base::Vector3f normal = cF->GetNormal();
+            points.push_back(cF->GetGravityPoint() + offset * normal);
+            dirs.push_back(-normal);
+        }
+
+        Base::Vector3f res;
+        unsigned long index, gridHits = 0, treeHits = 0, same = 0;
+        std::vector<unsigned long> gridResult(points.size(), ULONG_MAX);
+        start = Base::TimeInfo();
+        for (std::size_t i = 0; i < points.size(); i++) {
+            if (alg.NearestFacetOnRay(points[i], dirs[i], grid, res, index)) {
+                gridResult[i] = index;
+                gridHits++;
+            }
+        }
+        Base::Console().Message("  Rays with grid: %f s, %lu hits\n",
+            Base::TimeInfo::diffTimeF(start, Base::TimeInfo()), gridHits);
+        start = Base::TimeInfo();
+        for (std::size_t i = 0; i < points.size(); i++) {
+            if (alg.NearestFacetOnRay(points[i], dirs[i], tree, res, index)) {
+                treeHits++;
+                if (gridResult[i] == index)
+                    same++;
+            }
+        }
+        Base::Console().Message("  Rays with BVH:  %f s, %lu hits, %lu equal to grid\n",
+            Base::TimeInfo::diffTimeF(start, Base::TimeInfo()), treeHits, same);
+
+        // nearest facets to the ray start points
+        float gridDist = 0.0f, treeDist = 0.0f;
+        start = Base::TimeInfo();
+        for (std::size_t i = 0; i < points.size(); i++) {
+            if (alg.NearestPointFromPoint(points[i], grid, index, res))
+                gridDist += Base::Distance(points[i], res);
+        }
+        Base::Console().Message("  Nearest facet with grid: %f s, mean distance %f\n",
+            Base::TimeInfo::diffTimeF(start, Base::TimeInfo()), gridDist / points.size());
+        start = Base::TimeInfo();
+        for (std::size_t i = 0; i < points.size(); i++) {
+            if (alg.NearestPointFromPoint(points[i], tree, index, res))
+                treeDist += Base::Distance(points[i], res);
+        }
+        Base::Console().Message("  Nearest facet with BVH:  %f s, mean distance %f\n",
+            Base::TimeInfo::diffTimeF(start, Base::TimeInfo()), treeDist / points.size());
+    }
+}
+
+bool CmdSandboxMeshQueryBenchmark::isActive(void)
+{
+    return Gui::Selection().countObjectsOfType(Mesh::Feature::getClassTypeId()) > 0;
+}
+
 //===========================================================================
 // Std_GrabWidget
 //===========================================================================
@@ -1491,6 +1589,7 @@ void CreateSandboxCommands(void)
     rcCmdMgr.addCommand(new CmdSandboxMeshLoaderFuture);
     rcCmdMgr.addCommand(new CmdSandboxMeshTestJob);
     rcCmdMgr.addCommand(new CmdSandboxMeshTestRef);
+    rcCmdMgr.addCommand(new CmdSandboxMeshQueryBenchmark);
     rcCmdMgr.addCommand(new CmdTestGrabWidget());
     rcCmdMgr.addCommand(new CmdTestImageNode());
     rcCmdMgr.addCommand(new CmdTestWidgetShape());
@@ -98,6 +98,7 @@ Gui::MenuItem* Workbench::setupMenuBar() const
           << "Sandbox_MeshLoaderFuture"
           << "Sandbox_MeshTestJob"
           << "Sandbox_MeshTestRef"
+          << "Sandbox_MeshQueryBenchmark"
           << "Sandbox_CryptographicHash"
           << "Sandbox_MengerSponge";
 
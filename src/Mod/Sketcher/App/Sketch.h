@@ -53,6 +53,8 @@ public:
     int solve(void);
     /// resets the solver
     int resetSolver();
+    /// free the factorization the solver keeps to speed up the next diagnosis
+    void clearDiagnosisCache() { GCSsys.clearDiagnosisCache(); }
     /// get standard (aka fine) solver precision
     double getSolverPrecision(){ return GCSsys.getFinePrecision(); }
     /// delete all geometry and constraints, leave an empty sketch
@@ -433,6 +435,7 @@ public:
     GCS::Algorithm defaultSolver;
     GCS::Algorithm defaultSolverRedundant;
     inline void setDogLegGaussStep(GCS::DogLegGaussStep mode){GCSsys.dogLegGaussStep=mode;}
+    inline GCS::DogLegGaussStep getDogLegGaussStep(void) const {return GCSsys.dogLegGaussStep;}
     inline void setDebugMode(GCS::DebugMode mode) {debugMode=mode;GCSsys.debugMode=mode;}
     inline GCS::DebugMode getDebugMode(void) {return debugMode;}
     inline void setMaxIter(int maxiter){GCSsys.maxIter=maxiter;}
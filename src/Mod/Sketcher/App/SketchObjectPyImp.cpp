@@ -1599,6 +1599,33 @@ Py::Long SketchObjectPy::getAxisCount(void) const
     return Py::Long(this->getSketchObjectPtr()->getAxisCount());
 }
 
+Py::Long SketchObjectPy::getDoF(void) const
+{
+    return Py::Long(this->getSketchObjectPtr()->getLastDoF());
+}
+
+Py::Tuple SketchObjectPy::getConflicts(void) const
+{
+    const std::vector<int> &c = this->getSketchObjectPtr()->getLastConflicting();
+    Py::Tuple t(c.size());
+    for (std::size_t i=0; i<c.size(); i++) {
+        t.setItem(i, Py::Long(c[i]));
+    }
+
+    return t;
+}
+
+Py::Tuple SketchObjectPy::getRedundancies(void) const
+{
+    const std::vector<int> &r = this->getSketchObjectPtr()->getLastRedundant();
+    Py::Tuple t(r.size());
+    for (std::size_t i=0; i<r.size(); i++) {
+        t.setItem(i, Py::Long(r[i]));
+    }
+
+    return t;
+}
+
 PyObject *SketchObjectPy::getCustomAttributes(const char* /*attr*/) const
 {
     return 0;
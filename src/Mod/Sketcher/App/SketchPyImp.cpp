@@ -203,6 +203,19 @@ Py::Object SketchPy::getShape(void) const
     return Py::Object(new TopoShapePy(new TopoShape(getSketchPtr()->toShape())));
 }
 
+Py::Long SketchPy::getDogLegGaussStep(void) const
+{
+    return Py::Long(static_cast<int>(getSketchPtr()->getDogLegGaussStep()));
+}
+
+void SketchPy::setDogLegGaussStep(Py::Long arg)
+{
+    long mode = arg;
+    if (mode < GCS::FullPivLU || mode > GCS::LeastNormLdlt)
+        throw Py::ValueError("DogLegGaussStep must be 0, 1 or 2");
+    getSketchPtr()->setDogLegGaussStep(static_cast<GCS::DogLegGaussStep>(mode));
+}
+
 
 // +++ custom attributes implementer ++++++++++++++++++++++++++++++++++++++++
 
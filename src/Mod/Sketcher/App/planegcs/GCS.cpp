@@ -87,6 +87,7 @@
 //#undef EIGEN_SPARSEQR_COMPATIBLE
 
 #include <Eigen/QR>
+#include <Eigen/SparseCholesky>
 
 #ifdef EIGEN_SPARSEQR_COMPATIBLE
 #include <Eigen/Sparse>
@@ -105,6 +106,7 @@
 
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/connected_components.hpp>
+#include <boost/graph/max_cardinality_matching.hpp>
 
 typedef Eigen::FullPivHouseholderQR<Eigen::MatrixXd>::IntDiagSizeVectorType MatrixIndexType;
 
@@ -288,6 +290,230 @@ namespace GCS
 
 typedef boost::adjacency_list <boost::vecS, boost::vecS, boost::undirectedS> Graph;
 
+///////////////////////////////////////
+// Diagnosis
+///////////////////////////////////////
+
+// The maximum number of rows the cached factorization is updated with before
+// the jacobi matrix is factorized again, and the maximum number of non-zero
+// elements of R that are cached
+#define DIAGNOSIS_MAX_UPDATES       64
+#define DIAGNOSIS_MAX_CACHE_NONZEROS 2000000
+
+DiagnosisCache::DiagnosisCache()
+  : cols(0)
+  , updates(0)
+{
+}
+
+void DiagnosisCache::clear()
+{
+    // release the memory, the cache may be kept by an idle system
+    std::vector<Row>().swap(rows);
+    std::vector<Row>().swap(R);
+    cols = 0;
+    updates = 0;
+}
+
+void DiagnosisCache::reset(const Eigen::SparseMatrix<double> &J, const std::vector<int> &order,
+                           const Eigen::SparseMatrix<double> &Rin)
+{
+    clear();
+    if (J.rows() == 0)
+        return;
+
+    Eigen::SparseMatrix<double, Eigen::RowMajor> JR(J);
+    rows.reserve(order.size());
+    for (std::size_t i=0; i < order.size(); i++)
+        rows.push_back(Row(JR.row(order[i]).transpose()));
+
+    int n = static_cast<int>(order.size());
+    Eigen::SparseMatrix<double, Eigen::RowMajor> RR(Rin.topLeftCorner(n, n).triangularView<Eigen::Upper>());
+    R.reserve(n);
+    for (int i=0; i < n; i++)
+        R.push_back(Row(RR.row(i).transpose()));
+    cols = J.cols();
+
+    if (nonZeros() > DIAGNOSIS_MAX_CACHE_NONZEROS)
+        clear();
+}
+
+std::string DiagnosisCache::key(const Row &row)
+{
+    // rows are only reused if they are exactly the same
+    std::string str;
+    str.append(reinterpret_cast<const char*>(row.innerIndexPtr()), row.nonZeros()*sizeof(*row.innerIndexPtr()));
+    str.append(reinterpret_cast<const char*>(row.valuePtr()), row.nonZeros()*sizeof(double));
+    return str;
+}
+
+long DiagnosisCache::nonZeros() const
+{
+    long count = 0;
+    for (std::vector<Row>::const_iterator it=R.begin(); it != R.end(); ++it)
+        count += it->nonZeros();
+    return count;
+}
+
+bool DiagnosisCache::update(const Eigen::SparseMatrix<double> &J)
+{
+    if (rows.empty() || J.cols() != cols)
+        return false;
+
+    // match the rows of J with the cached rows
+    Eigen::SparseMatrix<double, Eigen::RowMajor> JR(J);
+    std::multimap<std::string, int> cached;
+    for (std::size_t i=0; i < rows.size(); i++)
+        cached.insert(std::make_pair(key(rows[i]), static_cast<int>(i)));
+
+    std::vector<bool> keep(rows.size(), false);
+    std::vector<Row> added;
+    for (int i=0; i < JR.rows(); i++) {
+        Row row(JR.row(i).transpose());
+        std::multimap<std::string, int>::iterator it = cached.find(key(row));
+        if (it != cached.end()) {
+            keep[it->second] = true;
+            cached.erase(it);
+        }
+        else
+            added.push_back(row);
+    }
+
+    int changed = static_cast<int>(cached.size() + added.size());
+    if (updates + changed > DIAGNOSIS_MAX_UPDATES) {
+        clear();
+        return false;
+    }
+
+    // removing rows keeps the remaining rows independent
+    for (int k=static_cast<int>(rows.size())-1; k >= 0; k--) {
+        if (!keep[k])
+            removeRow(k);
+    }
+    for (std::vector<Row>::const_iterator it=added.begin(); it != added.end(); ++it) {
+        if (!addRow(*it)) {
+            clear();
+            return false;
+        }
+    }
+
+    updates += changed;
+
+    // the result is valid, but the factorization isn't kept if it got too dense
+    if (nonZeros() > DIAGNOSIS_MAX_CACHE_NONZEROS)
+        clear();
+    return true;
+}
+
+DiagnosisCache::Row DiagnosisCache::combine(double ca, const Row &a, double cb, const Row &b, int drop)
+{
+    Row res(a.size());
+    res.reserve(a.nonZeros() + b.nonZeros());
+    Row::InnerIterator ia(a), ib(b);
+    while (ia || ib) {
+        int index;
+        double value = 0;
+        if (ia && (!ib || ia.index() <= ib.index())) {
+            index = ia.index();
+            value += ca*ia.value();
+            ++ia;
+            if (ib && ib.index() == index) {
+                value += cb*ib.value();
+                ++ib;
+            }
+        }
+        else {
+            index = ib.index();
+            value += cb*ib.value();
+            ++ib;
+        }
+        if (index != drop && value != 0)
+            res.insertBack(index) = value;
+    }
+    return res;
+}
+
+bool DiagnosisCache::addRow(const Row &row)
+{
+    // R^T.w = J.a, the new column of R, and the part of the new row a that is
+    // orthogonal to the other rows, whose norm is the new diagonal element
+    int n = static_cast<int>(rows.size());
+    Eigen::VectorXd w(n);
+    for (int i=0; i < n; i++)
+        w[i] = rows[i].dot(row);
+
+    // forward substitution with the rows of R
+    for (int i=0; i < n; i++) {
+        Row::InnerIterator it(R[i]);
+        w[i] /= it.value(); // the diagonal element is the first one of the row
+        for (++it; it; ++it)
+            w[it.index()] -= it.value()*w[i];
+    }
+
+    // back substitution R.z = w
+    Eigen::VectorXd z(w);
+    for (int i=n-1; i >= 0; i--) {
+        Row::InnerIterator it(R[i]);
+        double diag = it.value();
+        for (++it; it; ++it)
+            z[i] -= it.value()*z[it.index()];
+        z[i] /= diag;
+    }
+
+    Eigen::VectorXd r(row);
+    for (int i=0; i < n; i++) {
+        for (Row::InnerIterator it(rows[i]); it; ++it)
+            r[it.index()] -= z[i]*it.value();
+    }
+    double rho = r.norm();
+
+    // a (nearly) dependent row needs the full diagnosis
+    if (!(rho > 1e-8 * row.norm()))
+        return false;
+
+    for (int i=0; i < n; i++) {
+        R[i].conservativeResize(n+1);
+        if (w[i] != 0)
+            R[i].insertBack(n) = w[i];
+    }
+    R.push_back(Row(n+1));
+    R.back().insertBack(n) = rho;
+    rows.push_back(row);
+    return true;
+}
+
+void DiagnosisCache::removeRow(int k)
+{
+    // Removing the column k of R leaves an upper Hessenberg matrix from
+    // column k on, whose subdiagonal is eliminated by Givens rotations
+    int n = static_cast<int>(rows.size());
+    for (int i=0; i < n; i++) {
+        Row r(n-1);
+        r.reserve(R[i].nonZeros());
+        for (Row::InnerIterator it(R[i]); it; ++it) {
+            if (it.index() < k)
+                r.insertBack(it.index()) = it.value();
+            else if (it.index() > k)
+                r.insertBack(it.index()-1) = it.value();
+        }
+        R[i].swap(r);
+    }
+    for (int i=k; i < n-1; i++) {
+        double a = R[i].coeff(i);
+        double b = R[i+1].coeff(i);
+        double rho = std::sqrt(a*a + b*b);
+        if (b == 0)
+            continue;
+        double c = a/rho, s = b/rho;
+        Row ri = combine(c, R[i], s, R[i+1], -1);
+        Row rj = combine(-s, R[i], c, R[i+1], i);
+        R[i].swap(ri);
+        R[i+1].swap(rj);
+    }
+    R.pop_back();
+    rows.erase(rows.begin() + k);
+}
+
 ///////////////////////////////////////
 // Solver
 ///////////////////////////////////////
@@ -302,6 +528,8 @@ System::System()
   , p2c()
   , subSystems(0)
   , subSystemsAux(0)
+  , subSystemsRigid(0)
+  , rigidSolutions(0)
   , reference(0)
   , dofs(0)
   , hasUnknowns(false)
@@ -414,6 +642,11 @@ System::~System()
     clear();
 }
 
+void System::clearDiagnosisCache()
+{
+    diagnosisCache.clear();
+}
+
 void System::clear()
 {
     plist.clear();
@@ -1352,7 +1585,7 @@ void System::initSolution(Algorithm alg)
         plists[cid].push_back(plist[i]);
     }
 
-    // calculates subSystems and subSystemsAux from clists, plists and reductionmaps
+    // calculates subSystemsRigid, subSystems and subSystemsAux from clists, plists and reductionmaps
     clearSubSystems();
     for (std::size_t cid=0; cid < clists.size(); cid++) {
         std::vector<Constraint *> clist0, clist1;
@@ -1364,17 +1597,176 @@ void System::initSolution(Algorithm alg)
                 clist1.push_back(*constr);
         }
 
+        // split off the rigid cluster, the remaining constraints take its parameters as constants
+        VEC_pD plist0 = plists[cid];
+        std::vector<Constraint *> clistRigid;
+        VEC_pD plistRigid;
+        partitionRigid(clist0, plist0, reductionmaps[cid], clistRigid, plistRigid);
+        SubSystem *subsysRigid = NULL;
+        if (clistRigid.size() > 0) {
+            subsysRigid = new SubSystem(clistRigid, plistRigid, reductionmaps[cid]);
+            if (!isRigid(subsysRigid)) {
+                // solve the whole component together, as without the partition
+                delete subsysRigid;
+                subsysRigid = NULL;
+                clist0.insert(clist0.end(), clistRigid.begin(), clistRigid.end());
+                plist0 = plists[cid];
+                clistRigid.clear();
+                plistRigid.clear();
+            }
+        }
+        if (plistRigid.size() > 0) {
+            // move or distance from reference constraints can't move the rigid cluster
+            SET_pD params0(plist0.begin(), plist0.end());
+            std::vector<Constraint *> clist1Tmp;
+            for (std::vector<Constraint *>::const_iterator constr=clist1.begin();
+                 constr != clist1.end(); ++constr) {
+                VEC_pD &cparams = c2p[*constr];
+                for (VEC_pD::const_iterator param=cparams.begin(); param != cparams.end(); ++param) {
+                    if (params0.count(*param) > 0) {
+                        clist1Tmp.push_back(*constr);
+                        break;
+                    }
+                }
+            }
+            clist1.swap(clist1Tmp);
+        }
+
+        subSystemsRigid.push_back(subsysRigid);
         subSystems.push_back(NULL);
         subSystemsAux.push_back(NULL);
         if (clist0.size() > 0)
-            subSystems[cid] = new SubSystem(clist0, plists[cid], reductionmaps[cid]);
+            subSystems[cid] = new SubSystem(clist0, plist0, reductionmaps[cid]);
         if (clist1.size() > 0)
-            subSystemsAux[cid] = new SubSystem(clist1, plists[cid], reductionmaps[cid]);
+            subSystemsAux[cid] = new SubSystem(clist1, plist0, reductionmaps[cid]);
     }
+    rigidSolutions.resize(clists.size());
 
     isInit = true;
 }
 
+void System::partitionRigid(std::vector<Constraint *> &clist0, VEC_pD &plist0, MAP_pD_pD &reductionmap,
+                            std::vector<Constraint *> &clistRigid, VEC_pD &plistRigid)
+{
+    // The rigid cluster consists of the parameters that are determined by the constraints alone,
+    // i.e. the well- and over-determined blocks of the Dulmage-Mendelsohn decomposition of the
+    // constraint-parameter graph. Constraints of the cluster only depend on parameters of the
+    // cluster, so it can be solved on its own. A maximum matching pairs constraints with parameters,
+    // and the parameters that can be reached from an unmatched parameter over alternating paths
+    // are the ones that can still move.
+    clistRigid.clear();
+    plistRigid.clear();
+
+    MAP_pD_I index; // vertices of the reduced parameters
+    VEC_I pvertex(plist0.size());
+    for (std::size_t i=0; i < plist0.size(); i++) {
+        double *param = plist0[i];
+        MAP_pD_pD::const_iterator itr = reductionmap.find(param);
+        if (itr != reductionmap.end())
+            param = itr->second;
+        MAP_pD_I::const_iterator it = index.find(param);
+        if (it == index.end()) {
+            int v = static_cast<int>(index.size());
+            index[param] = v;
+            pvertex[i] = v;
+        }
+        else
+            pvertex[i] = it->second;
+    }
+
+    int psize = static_cast<int>(index.size());
+    int csize = static_cast<int>(clist0.size());
+    if (psize == 0 || csize == 0)
+        return;
+
+    Graph g(psize + csize);
+    for (int c=0; c < csize; c++) {
+        VEC_pD &cparams = c2p[clist0[c]];
+        for (VEC_pD::const_iterator param=cparams.begin(); param != cparams.end(); ++param) {
+            double *p = *param;
+            MAP_pD_pD::const_iterator itr = reductionmap.find(p);
+            if (itr != reductionmap.end())
+                p = itr->second;
+            MAP_pD_I::const_iterator it = index.find(p);
+            if (it != index.end())
+                boost::add_edge(psize + c, it->second, g);
+        }
+    }
+
+    typedef boost::graph_traits<Graph>::vertex_descriptor Vertex;
+    std::vector<Vertex> mate(psize + csize);
+    boost::edmonds_maximum_cardinality_matching(g, &mate[0]);
+    const Vertex unmatched = boost::graph_traits<Graph>::null_vertex();
+
+    std::vector<bool> movable(psize + csize, false);
+    std::vector<Vertex> stack;
+    for (int v=0; v < psize; v++) {
+        if (mate[v] == unmatched) {
+            movable[v] = true;
+            stack.push_back(v);
+        }
+    }
+    while (!stack.empty()) {
+        Vertex v = stack.back();
+        stack.pop_back();
+        boost::graph_traits<Graph>::adjacency_iterator it, end;
+        for (boost::tie(it, end) = boost::adjacent_vertices(v, g); it != end; ++it) {
+            if (movable[*it])
+                continue;
+            movable[*it] = true;
+            Vertex p = mate[*it];
+            if (p != unmatched && !movable[p]) {
+                movable[p] = true;
+                stack.push_back(p);
+            }
+        }
+    }
+
+    std::vector<Constraint *> clistRest;
+    for (int c=0; c < csize; c++) {
+        if (movable[psize + c])
+            clistRest.push_back(clist0[c]);
+        else
+            clistRigid.push_back(clist0[c]);
+    }
+    VEC_pD plistRest;
+    for (std::size_t i=0; i < plist0.size(); i++) {
+        if (movable[pvertex[i]])
+            plistRest.push_back(plist0[i]);
+        else
+            plistRigid.push_back(plist0[i]);
+    }
+    clist0.swap(clistRest);
+    plist0.swap(plistRest);
+}
+
+bool System::isRigid(SubSystem *subsys)
+{
+    // The partition only looks at the structure of the constraints. In a singular configuration,
+    // e.g. a point on two collinear lines, the jacobi matrix of a structurally rigid cluster has
+    // a lower rank than its number of parameters, so the cluster can still move.
+    subsys->redirectParams();
+    Eigen::SparseMatrix<double> J;
+    subsys->calcJacobi(J);
+    subsys->revertParams();
+
+    int rank;
+#ifdef EIGEN_SPARSEQR_COMPATIBLE
+    Eigen::SparseQR<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > qr;
+    qr.setPivotThreshold(qrpivotThreshold);
+    qr.compute(J);
+    if (qr.info() != Eigen::Success)
+        return false;
+    rank = static_cast<int>(qr.rank());
+#else
+    Eigen::FullPivHouseholderQR<Eigen::MatrixXd> qr(J.rows(), J.cols());
+    qr.setThreshold(qrpivotThreshold);
+    qr.compute(Eigen::MatrixXd(J));
+    rank = static_cast<int>(qr.rank());
+#endif
+    return rank == subsys->pSize();
+}
+
 void System::setReference()
 {
     reference.clear();
@@ -1411,10 +1803,12 @@ int System::solve(bool isFine, Algorithm alg, bool isRedundantsolving)
     // even if no other system has to be solved
     int res = Success;
     for (int cid=0; cid < int(subSystems.size()); cid++) {
-        if ((subSystems[cid] || subSystemsAux[cid]) && !isReset) {
+        if ((subSystemsRigid[cid] || subSystems[cid] || subSystemsAux[cid]) && !isReset) {
              resetToReference();
              isReset = true;
         }
+        if (subSystemsRigid[cid])
+            res = std::max(res, solveRigid(cid, isFine, alg, isRedundantsolving));
         if (subSystems[cid] && subSystemsAux[cid])
             res = std::max(res, solve(subSystems[cid], subSystemsAux[cid], isFine, isRedundantsolving));
         else if (subSystems[cid])
@@ -1438,6 +1832,38 @@ int System::solve(bool isFine, Algorithm alg, bool isRedundantsolving)
     return res;
 }
 
+int System::solveRigid(int cid, bool isFine, Algorithm alg, bool isRedundantsolving)
+{
+    // The rigid cluster has only one solution for the reference configuration. It isn't solved
+    // again as long as its last solution still fulfills the constraints, e.g. while dragging
+    // another part of the sketch.
+    SubSystem *subsys = subSystemsRigid[cid];
+    VEC_D &solution = rigidSolutions[cid];
+    if (static_cast<int>(solution.size()) == subsys->pSize()) {
+        Eigen::VectorXd x = Eigen::Map<Eigen::VectorXd>(&solution[0], solution.size());
+        subsys->setParams(x);
+        subsys->applySolution();
+
+        Eigen::VectorXd r(subsys->cSize());
+        subsys->calcResidual(r);
+        if (r.cwiseAbs2().maxCoeff() <= (isRedundantsolving ? convergenceRedundant : convergence))
+            return Success;
+    }
+
+    int res = solve(subsys, isFine, alg, isRedundantsolving);
+    if (res == Success) {
+        Eigen::VectorXd x;
+        subsys->getParams(x);
+        solution.assign(x.data(), x.data() + x.size());
+    }
+    else
+        solution.clear();
+
+    // the other constraints of the component take the parameters of the cluster as constants
+    subsys->applySolution();
+    return res;
+}
+
 int System::solve(SubSystem *subsys, bool isFine, Algorithm alg, bool isRedundantsolving)
 {
     if (alg == BFGS)
@@ -1586,8 +2012,9 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
         return Success;
 
     Eigen::VectorXd e(csize), e_new(csize); // vector of all function errors (every constraint is one function)
-    Eigen::MatrixXd J(csize, xsize);        // Jacobi of the subsystem
-    Eigen::MatrixXd A(xsize, xsize);
+    Eigen::SparseMatrix<double> J(csize, xsize); // Jacobi of the subsystem
+    Eigen::SparseMatrix<double> A(xsize, xsize);
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > ldlt;
     Eigen::VectorXd x(xsize), h(xsize), x_new(xsize), g(xsize), diag_A(xsize);
 
     subsys->redirectParams();
@@ -1635,11 +2062,15 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
         }
 
         // J^T J, J^T e
-        subsys->calcJacobi(J);;
+        subsys->calcJacobi(J);
 
         A = J.transpose()*J;
         g = J.transpose()*e;
 
+        // the augmentation below only changes the diagonal, so the fill-reducing
+        // ordering of A is computed once per iteration
+        ldlt.analyzePattern(A);
+
         // Compute ||J^T e||_inf
         double g_inf = g.lpNorm<Eigen::Infinity>();
         diag_A = A.diagonal(); // save diagonal entries so that augmentation can be later canceled
@@ -1660,10 +2091,14 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
         while (k < 50) {
             // augment normal equations A = A+uI
             for (int i=0; i < xsize; ++i)
-                A(i,i) += mu;
+                A.coeffRef(i,i) += mu;
 
             //solve augmented functions A*h=-g
-            h = A.fullPivLu().solve(g);
+            ldlt.factorize(A);
+            if (ldlt.info() == Eigen::Success)
+                h = ldlt.solve(g);
+            else
+                h = Eigen::MatrixXd(A).fullPivLu().solve(g);
             double rel_error = (A*h - g).norm() / g.norm();
 
             // check if solving works
@@ -1712,7 +2147,7 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
             mu*=nu;
             nu*=2.0;
             for (int i=0; i < xsize; ++i) // restore diagonal J^T J entries
-                A(i,i) = diag_A(i);
+                A.coeffRef(i,i) = diag_A(i);
 
             k++;
         }
@@ -1743,6 +2178,44 @@ int System::solve_LM(SubSystem* subsys, bool isRedundantsolving)
 }
 
 
+// Computes the Gauss-Newton step h of the sparse jacobi matrix J with the sparse
+// counterpart of dogLegGaussStep. Returns false if the decomposition failed.
+bool System::solveGaussStep(const Eigen::SparseMatrix<double> &J, const Eigen::VectorXd &fx,
+                            Eigen::VectorXd &h)
+{
+    switch (dogLegGaussStep){
+        case FullPivLU:
+        case LeastNormFullPivLU: {
+#ifdef EIGEN_SPARSEQR_COMPATIBLE
+            // The rank revealing QR decomposition of J^T = Q.R.P^T gives the
+            // solution of J.h = -fx of minimal norm without forming J.J^T
+            Eigen::SparseMatrix<double> Jt = J.adjoint();
+            Jt.makeCompressed();
+            Eigen::SparseQR<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > qr(Jt);
+            if (qr.info() != Eigen::Success)
+                return false;
+            int rank = static_cast<int>(qr.rank());
+            Eigen::VectorXd y = qr.colsPermutation().transpose()*(-fx);
+            Eigen::VectorXd z = Eigen::VectorXd::Zero(J.cols());
+            z.head(rank) = qr.matrixR().topLeftCorner(rank, rank).triangularView<Eigen::Upper>()
+                             .transpose().solve(y.head(rank));
+            h = qr.matrixQ()*z;
+            return true;
+#else
+            return false;
+#endif
+        }
+        case LeastNormLdlt: {
+            Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > ldlt(J*J.adjoint());
+            if (ldlt.info() != Eigen::Success)
+                return false;
+            h = J.adjoint()*ldlt.solve(-fx);
+            return ldlt.info() == Eigen::Success;
+        }
+    }
+    return false;
+}
+
 int System::solve_DL(SubSystem* subsys, bool isRedundantsolving)
 {
 #ifdef _GCS_EXTRACT_SOLVER_SUBSYSTEM_
@@ -1780,7 +2253,7 @@ int System::solve_DL(SubSystem* subsys, bool isRedundantsolving)
 
     Eigen::VectorXd x(xsize), x_new(xsize);
     Eigen::VectorXd fx(csize), fx_new(csize);
-    Eigen::MatrixXd Jx(csize, xsize), Jx_new(csize, xsize);
+    Eigen::SparseMatrix<double> Jx(csize, xsize), Jx_new(csize, xsize);
     Eigen::VectorXd g(xsize), h_sd(xsize), h_gn(xsize), h_dl(xsize);
 
     subsys->redirectParams();
@@ -1824,16 +2297,19 @@ int System::solve_DL(SubSystem* subsys, bool isRedundantsolving)
             // get the gauss-newton step
             // http://forum.freecadweb.org/viewtopic.php?f=10&t=12769&start=50#p106220
             // https://forum.kde.org/viewtopic.php?f=74&t=129439#p346104
-            switch (dogLegGaussStep){
-                case FullPivLU:
-                    h_gn = Jx.fullPivLu().solve(-fx);
-                    break;
-                case LeastNormFullPivLU:
-                    h_gn = Jx.adjoint()*(Jx*Jx.adjoint()).fullPivLu().solve(-fx);
-                    break;
-                case LeastNormLdlt:
-                    h_gn = Jx.adjoint()*(Jx*Jx.adjoint()).ldlt().solve(-fx);
-                    break;
+            if (!solveGaussStep(Jx, fx, h_gn)) {
+                Eigen::MatrixXd J(Jx);
+                switch (dogLegGaussStep){
+                    case FullPivLU:
+                        h_gn = J.fullPivLu().solve(-fx);
+                        break;
+                    case LeastNormFullPivLU:
+                        h_gn = J.adjoint()*(J*J.adjoint()).fullPivLu().solve(-fx);
+                        break;
+                    case LeastNormLdlt:
+                        h_gn = J.adjoint()*(J*J.adjoint()).ldlt().solve(-fx);
+                        break;
+                }
             }
 
             double rel_error = (Jx*h_gn + fx).norm() / fx.norm();
@@ -3649,6 +4125,8 @@ int System::solve(SubSystem *subsysA, SubSystem *subsysB, bool /*isFine*/, bool
 void System::applySolution()
 {
     for (int cid=0; cid < int(subSystems.size()); cid++) {
+        if (subSystemsRigid[cid])
+            subSystemsRigid[cid]->applySolution();
         if (subSystemsAux[cid])
             subSystemsAux[cid]->applySolution();
         if (subSystems[cid])
@@ -3716,8 +4194,13 @@ int System::diagnose(Algorithm alg)
     // map tag to a tag multiplicity (the number of solver constraints associated with the same tag)
     std::map< int , int> tagmultiplicity;
     
-    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(clist.size(), pdiagnoselist.size());
-    
+    MAP_pD_I pdiagnoseindex;
+    for (int j=0; j < int(pdiagnoselist.size()); j++)
+        pdiagnoseindex[pdiagnoselist[j]] = j;
+
+    // only the gradients of the parameters of each constraint can be non-zero
+    std::vector< Eigen::Triplet<double> > jacobientries;
+
     // The jacobian has been reduced to only contain driving constraints. Identification
     // of constraint indices from this reduced jacobian requires a mapping.
     std::map<int,int> jacobianconstraintmap;
@@ -3729,8 +4212,13 @@ int System::diagnose(Algorithm alg)
         ++allcount;        
         if ((*constr)->getTag() >= 0 && (*constr)->isDriving()) {
             jacobianconstraintcount++;
-            for (int j=0; j < int(pdiagnoselist.size()); j++) {
-                    J(jacobianconstraintcount-1,j) = (*constr)->grad(pdiagnoselist[j]);
+            VEC_pD constr_params = (*constr)->params();
+            SET_pD constr_params_set(constr_params.begin(), constr_params.end());
+            for (SET_pD::const_iterator param=constr_params_set.begin(); param != constr_params_set.end(); ++param) {
+                MAP_pD_I::const_iterator index = pdiagnoseindex.find(*param);
+                if (index != pdiagnoseindex.end())
+                    jacobientries.push_back(Eigen::Triplet<double>(jacobianconstraintcount-1, index->second,
+                                                                  (*constr)->grad(*param)));
             }
             
             // parallel processing: create tag multiplicity map
@@ -3743,17 +4231,31 @@ int System::diagnose(Algorithm alg)
         }
     }
 
+    Eigen::SparseMatrix<double> SJ(jacobianconstraintcount, pdiagnoselist.size());
+    SJ.setFromTriplets(jacobientries.begin(), jacobientries.end());
+    SJ.makeCompressed();
+
 #ifdef EIGEN_SPARSEQR_COMPATIBLE
-    Eigen::SparseMatrix<double> SJ;
+    if (qrAlgorithm==EigenSparseQR && diagnosisCache.update(SJ)) {
+        // The constraints are still linearly independent, so there are no conflicting
+        // or redundant constraints. Like below the last parameters are dependent.
+        for (int j=jacobianconstraintcount; j < int(pdiagnoselist.size()); j++)
+            pdependentparameters.push_back(pdiagnoselist[j]);
 
-    if(qrAlgorithm==EigenSparseQR){
-        // this creation is not optimized (done using triplets)
-        // however the time this takes is negligible compared to the
-        // time the QR decomposition itself takes
-        SJ = J.sparseView();
-        SJ.makeCompressed();
-    }
+        if(debugMode==IterationLevel) {
+            std::stringstream stream;
+            stream  << "EigenSparseQR, updated factorization"
+                    << ", Params: " << pdiagnoselist.size()
+                    << ", Constr: " << jacobianconstraintcount
+                    << ", Rank: "   << jacobianconstraintcount;
+            const std::string tmp = stream.str();
+            LogString(tmp);
+        }
 
+        hasDiagnosis = true;
+        dofs = pdiagnoselist.size() - jacobianconstraintcount;
+        return dofs;
+    }
     Eigen::SparseQR<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int> > SqrJT;
 #else
     if(qrAlgorithm==EigenSparseQR){
@@ -3761,9 +4263,14 @@ int System::diagnose(Algorithm alg)
         qrAlgorithm=EigenDenseQR;
     }
 #endif
+    diagnosisCache.clear();
+
+    Eigen::MatrixXd J;
+    if(qrAlgorithm==EigenDenseQR)
+        J = SJ;
 
 #ifdef _GCS_DEBUG
-    LogMatrix("J",J);
+    LogMatrix("J",Eigen::MatrixXd(SJ));
 #endif
 
     Eigen::MatrixXd R;
@@ -3779,8 +4286,8 @@ int System::diagnose(Algorithm alg)
     Eigen::FullPivHouseholderQR<Eigen::MatrixXd> qrJT;
 
     if(qrAlgorithm==EigenDenseQR){
-        if (J.rows() > 0) {
-            qrJT.compute(J.topRows(jacobianconstraintcount).transpose());
+        if (!clist.empty()) {
+            qrJT.compute(J.transpose());
             //Eigen::MatrixXd Q = qrJT.matrixQ ();
 
             paramsNum = qrJT.rows();
@@ -3802,8 +4309,8 @@ int System::diagnose(Algorithm alg)
     }
 #ifdef EIGEN_SPARSEQR_COMPATIBLE
     else if(qrAlgorithm==EigenSparseQR){
-        if (SJ.rows() > 0) {
-            SqrJT.compute(SJ.topRows(jacobianconstraintcount).transpose());
+        if (!clist.empty()) {
+            SqrJT.compute(SJ.transpose());
             // Do not ask for Q Matrix!!
             // At Eigen 3.2 still has a bug that this only works for square matrices
             // if enabled it will crash
@@ -3827,6 +4334,13 @@ int System::diagnose(Algorithm alg)
             R2 = SqrJT.matrixR();
             #endif
         }
+
+        // keep the factorization of independent constraints to update it on the next diagnosis
+        if (constrNum > 0 && rank == constrNum) {
+            const Eigen::VectorXi &order = SqrJT.colsPermutation().indices();
+            diagnosisCache.reset(SJ, std::vector<int>(order.data(), order.data() + order.size()),
+                                 SqrJT.matrixR());
+        }
     }
 #endif
 
@@ -3835,7 +4349,7 @@ int System::diagnose(Algorithm alg)
 
         stream  << (qrAlgorithm==EigenSparseQR?"EigenSparseQR":(qrAlgorithm==EigenDenseQR?"DenseQR":""));
 
-        if (J.rows() > 0) {
+        if (!clist.empty()) {
             stream
 #ifdef EIGEN_SPARSEQR_COMPATIBLE
                     << ", Threads: " << Eigen::nbThreads()
@@ -3865,7 +4379,7 @@ int System::diagnose(Algorithm alg)
 
     }
 
-    if (J.rows() > 0) {
+    if (!clist.empty()) {
 #ifdef _GCS_DEBUG_SOLVER_JACOBIAN_QR_DECOMPOSITION_TRIANGULAR_MATRIX
         LogMatrix("R", R);
 
@@ -3993,16 +4507,13 @@ int System::diagnose(Algorithm alg)
 
         // Detecting conflicting or redundant constraints
         if (constrNum > rank) { // conflicting or redundant constraints
-            for (int i=1; i < rank; i++) {
-                // eliminate non zeros above pivot
-                assert(R(i,i) != 0);
-                for (int row=0; row < i; row++) {
-                    if (R(row,i) != 0) {
-                        double coef=R(row,i)/R(i,i);
-                        R.block(row,i+1,1,constrNum-i-1) -= coef * R.block(i,i+1,1,constrNum-i-1);
-                        R(row,i) = 0;
-                    }
-                }
+            // eliminate non zeros above the pivots, i.e. express the dependent columns by
+            // the independent ones: the same as eliminating row by row, but with one solve
+            Eigen::MatrixXd X = R.topLeftCorner(rank, rank).triangularView<Eigen::Upper>()
+                                 .solve(R.block(0, rank, rank, constrNum-rank));
+            for (int row=0; row < rank; row++) {
+                assert(R(row,row) != 0);
+                R.block(row, rank, 1, constrNum-rank) = R(row,row) * X.row(row);
             }
             std::vector< std::vector<Constraint *> > conflictGroups(constrNum-rank);
             for (int j=rank; j < constrNum; j++) {
@@ -4203,10 +4714,13 @@ int System::diagnose(Algorithm alg)
 void System::clearSubSystems()
 {
     isInit = false;
+    free(subSystemsRigid);
     free(subSystems);
     free(subSystemsAux);
+    subSystemsRigid.clear();
     subSystems.clear();
     subSystemsAux.clear();
+    rigidSolutions.clear();
 }
 
 double lineSearch(SubSystem *subsys, Eigen::VectorXd &xdir)
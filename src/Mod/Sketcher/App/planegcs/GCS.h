@@ -69,6 +69,40 @@ namespace GCS
         IterationLevel = 2
     };
 
+    // The factorization J.J^T = R^T.R of the jacobi matrix of the last diagnosis
+    // if its rows are linearly independent. If the rows of the next jacobi matrix
+    // differ only in a few rows, R is updated row by row instead of factorizing
+    // the whole matrix again. R is stored as sparse rows, so that the memory use
+    // follows its fill-in rather than the square of the number of constraints.
+    class DiagnosisCache
+    {
+    public:
+        DiagnosisCache();
+
+        void clear();
+        // stores the factorization of the rows of J in the given order, R is
+        // the upper triangular factor of the sparse QR decomposition of J^T
+        void reset(const Eigen::SparseMatrix<double> &J, const std::vector<int> &order,
+                   const Eigen::SparseMatrix<double> &R);
+        // returns true if J has linearly independent rows and updates the
+        // factorization, returns false if J must be factorized again
+        bool update(const Eigen::SparseMatrix<double> &J);
+
+    private:
+        typedef Eigen::SparseVector<double> Row;
+        static std::string key(const Row &row);
+        // returns ca*a + cb*b without the entry at index drop
+        static Row combine(double ca, const Row &a, double cb, const Row &b, int drop);
+        bool addRow(const Row &row);
+        void removeRow(int k);
+        long nonZeros() const;
+
+        std::vector<Row> rows; // the rows of J in the order of the columns of R
+        std::vector<Row> R;    // the rows of the upper triangular factor
+        int cols;
+        int updates;           // number of updated rows since the last reset()
+    };
+
     class System
     {
     // This is the main class. It holds all constraints and information
@@ -85,7 +119,13 @@ namespace GCS
         std::map<double *,std::vector<Constraint *> > p2c; // parameter to constraint adjacency list
 
         std::vector<SubSystem *> subSystems, subSystemsAux;
+        std::vector<SubSystem *> subSystemsRigid; // well-constrained part of each component, solved first
+        std::vector<VEC_D> rigidSolutions;        // last solution of each rigid subsystem
         void clearSubSystems();
+        void partitionRigid(std::vector<Constraint *> &clist0, VEC_pD &plist0, MAP_pD_pD &reductionmap,
+                            std::vector<Constraint *> &clistRigid, VEC_pD &plistRigid);
+        bool isRigid(SubSystem *subsys);
+        int solveRigid(int cid, bool isFine, Algorithm alg, bool isRedundantsolving);
 
         VEC_D reference;
         void setReference();     // copies the current parameter values to reference
@@ -102,10 +142,13 @@ namespace GCS
         bool hasUnknowns;  // if plist is filled with the unknown parameters
         bool hasDiagnosis; // if dofs, conflictingTags, redundantTags are up to date
         bool isInit;       // if plists, clists, reductionmaps are up to date
+        DiagnosisCache diagnosisCache; // kept by clear() to diagnose the next system incrementally
 
         int solve_BFGS(SubSystem *subsys, bool isFine=true, bool isRedundantsolving=false);
         int solve_LM(SubSystem *subsys, bool isRedundantsolving=false);
         int solve_DL(SubSystem *subsys, bool isRedundantsolving=false);
+        bool solveGaussStep(const Eigen::SparseMatrix<double> &J, const Eigen::VectorXd &fx,
+                            Eigen::VectorXd &h);
 
         #ifdef _GCS_EXTRACT_SOLVER_SUBSYSTEM_
         void extractSubsystem(SubSystem *subsys, bool isRedundantsolving);
@@ -141,6 +184,8 @@ namespace GCS
 
         void clear();
         void clearByTag(int tagId);
+        // frees the factorization kept for the next diagnosis
+        void clearDiagnosisCache();
 
         int addConstraint(Constraint *constr);
         void removeConstraint(Constraint *constr);
@@ -126,6 +126,29 @@ void SubSystem::initialize(VEC_pD &params, MAP_pD_pD &reductionmap)
         }
 //        (*constr)->redirectParams(pmap); // redirect parameters to pvec
     }
+
+    // The columns of the jacobi matrix only have entries for the constraints
+    // of their parameter. p2c keeps the order of clist, so the rows of each
+    // column are sorted.
+    std::map<Constraint *,int> rows;
+    for (int i=0; i < csize; i++)
+        rows[clist[i]] = i;
+    std::vector<Eigen::Triplet<double> > entries;
+    jacobiConstr.clear();
+    for (int j=0; j < psize; j++) {
+        std::map<double *,std::vector<Constraint *> >::const_iterator
+          p2cfind = p2c.find(&pvals[j]);
+        if (p2cfind == p2c.end())
+            continue;
+        for (std::vector<Constraint *>::const_iterator constr=p2cfind->second.begin();
+             constr != p2cfind->second.end(); ++constr) {
+            entries.push_back(Eigen::Triplet<double>(rows[*constr], j, 0.));
+            jacobiConstr.push_back(*constr);
+        }
+    }
+    jacobiPattern.resize(csize, psize);
+    jacobiPattern.setFromTriplets(entries.begin(), entries.end());
+    jacobiPattern.makeCompressed();
 }
 
 void SubSystem::redirectParams()
@@ -275,6 +298,21 @@ void SubSystem::calcJacobi(Eigen::MatrixXd &jacobi)
     calcJacobi(plist, jacobi);
 }
 
+void SubSystem::calcJacobi(Eigen::SparseMatrix<double> &jacobi)
+{
+    // only the gradients of the non-zeros are evaluated
+    if (jacobi.rows() != csize || jacobi.cols() != psize ||
+        jacobi.nonZeros() != jacobiPattern.nonZeros() || !jacobi.isCompressed())
+        jacobi = jacobiPattern;
+
+    double *values = jacobi.valuePtr();
+    const int *outer = jacobi.outerIndexPtr();
+    for (int j=0; j < psize; j++) {
+        for (int k=outer[j]; k < outer[j+1]; k++)
+            values[k] = jacobiConstr[k]->grad(&pvals[j]);
+    }
+}
+
 void SubSystem::calcGrad(VEC_pD &params, Eigen::VectorXd &grad)
 {
     assert(grad.size() == int(params.size()));
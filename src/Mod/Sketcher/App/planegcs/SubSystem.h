@@ -27,6 +27,7 @@
 #undef max
 
 #include <Eigen/Core>
+#include <Eigen/SparseCore>
 #include "Constraints.h"
 
 namespace GCS
@@ -43,6 +44,8 @@ namespace GCS
 //        JacobianMatrix jacobi;  // jacobi matrix of the residuals
         std::map<Constraint *,VEC_pD > c2p; // constraint to parameter adjacency list
         std::map<double *,std::vector<Constraint *> > p2c; // parameter to constraint adjacency list
+        Eigen::SparseMatrix<double> jacobiPattern; // non-zero pattern of the jacobi matrix (csize x psize)
+        std::vector<Constraint *> jacobiConstr;    // constraint of each non-zero of jacobiPattern
         void initialize(VEC_pD &params, MAP_pD_pD &reductionmap); // called by the constructors
     public:
         SubSystem(std::vector<Constraint *> &clist_, VEC_pD &params);
@@ -71,6 +74,7 @@ namespace GCS
         void calcResidual(Eigen::VectorXd &r, double &err);
         void calcJacobi(VEC_pD &params, Eigen::MatrixXd &jacobi);
         void calcJacobi(Eigen::MatrixXd &jacobi);
+        void calcJacobi(Eigen::SparseMatrix<double> &jacobi);
         void calcGrad(VEC_pD &params, Eigen::VectorXd &grad);
         void calcGrad(Eigen::VectorXd &grad);
 
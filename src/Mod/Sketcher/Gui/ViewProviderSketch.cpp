@@ -5926,6 +5926,9 @@ void ViewProviderSketch::unsetEdit(int ModNum)
         }
         catch (...) {
         }
+
+        // the solver of a sketch that is not edited doesn't need the cached diagnosis
+        getSketchObject()->getSolvedSketch().clearDiagnosisCache();
     }
 
     // clear the selection and set the new/edited sketch(convenience)
@@ -209,7 +209,107 @@ class SketcherSolverTestCases(unittest.TestCase):
 		self.Doc2.recompute()
 		self.failUnless(len(values) == 0)
 		FreeCAD.closeDocument("Issue3245")
-	
+
+	def checkDiagnosis(self, sketch, result):
+		# the incrementally updated diagnosis must match the one of a new sketch
+		fresh = self.Doc.addObject('Sketcher::SketchObject','Fresh')
+		fresh.Geometry = sketch.Geometry
+		fresh.Constraints = sketch.Constraints
+		self.assertEqual(result, fresh.solve())
+		self.assertEqual(sketch.DoF, fresh.DoF)
+		self.assertEqual(sketch.Conflicts, fresh.Conflicts)
+		self.assertEqual(sketch.Redundancies, fresh.Redundancies)
+		self.Doc.removeObject(fresh.Name)
+
+	def testIncrementalDiagnosis(self):
+		sketch = self.Doc.addObject('Sketcher::SketchObject','Sketch')
+		CreateRectangleSketch(sketch, [0, 0], [20, 10])
+		self.assertEqual(sketch.solve(), 0)
+		self.assertEqual(sketch.DoF, 0)
+		# remove and add back satisfied constraints, the geometry doesn't move
+		distance = sketch.Constraints[11]
+		sketch.delConstraint(11)
+		result = sketch.solve()
+		self.assertEqual(result, 0)
+		self.assertEqual(sketch.DoF, 1)
+		self.checkDiagnosis(sketch, result)
+		sketch.delConstraint(8)
+		result = sketch.solve()
+		self.assertEqual(sketch.DoF, 2)
+		self.checkDiagnosis(sketch, result)
+		sketch.addConstraint(distance)
+		result = sketch.solve()
+		self.assertEqual(sketch.DoF, 1)
+		self.checkDiagnosis(sketch, result)
+		# a redundant constraint needs the full diagnosis
+		sketch.addConstraint(Sketcher.Constraint('Horizontal',0))
+		result = sketch.solve()
+		self.assertEqual(result, -2)
+		self.assertTrue(len(sketch.Redundancies) > 0)
+		self.checkDiagnosis(sketch, result)
+		sketch.delConstraint(sketch.ConstraintCount - 1)
+		result = sketch.solve()
+		self.assertEqual(result, 0)
+		self.assertEqual(sketch.Redundancies, ())
+		self.checkDiagnosis(sketch, result)
+
+	def testDogLegGaussSteps(self):
+		# dragging solves with DogLeg only, without falling back to other solvers
+		corners = [App.Vector(0,10,0), App.Vector(20,10,0), App.Vector(20,0,0), App.Vector(0,0,0)]
+		for step in range(3):
+			sketch = Sketcher.Sketch()
+			sketch.DogLegGaussStep = step
+			self.assertEqual(sketch.DogLegGaussStep, step)
+			# a rectangle that doesn't fulfill its constraints yet
+			sketch.addGeometry([Part.LineSegment(App.Vector(0.5,10.3,0),App.Vector(19,10,0)),
+				Part.LineSegment(App.Vector(20.2,10.1,0),App.Vector(20.4,-0.2,0)),
+				Part.LineSegment(App.Vector(20,-0.3,0),App.Vector(0.3,0.2,0)),
+				Part.LineSegment(App.Vector(0,0.1,0),App.Vector(-0.2,9.8,0)),
+				Part.LineSegment(App.Vector(21,11,0),App.Vector(30,20,0))])
+			sketch.addConstraint([Sketcher.Constraint('Coincident',0,2,1,1),
+				Sketcher.Constraint('Coincident',1,2,2,1),
+				Sketcher.Constraint('Coincident',2,2,3,1),
+				Sketcher.Constraint('Coincident',3,2,0,1),
+				Sketcher.Constraint('Horizontal',0),
+				Sketcher.Constraint('Horizontal',2),
+				Sketcher.Constraint('Vertical',1),
+				Sketcher.Constraint('Vertical',3),
+				Sketcher.Constraint('DistanceX',2,2,0.0),
+				Sketcher.Constraint('DistanceY',2,2,0.0),
+				Sketcher.Constraint('Distance',1,10.0),
+				Sketcher.Constraint('Distance',0,20.0),
+				Sketcher.Constraint('Coincident',4,1,0,2)])
+			self.assertEqual(sketch.movePoint(4,2,App.Vector(35,25,0)), 0)
+			geometries = sketch.Geometries
+			for i in range(4):
+				self.assertAlmostEqual(geometries[i].StartPoint.distanceToPoint(corners[i]), 0)
+				self.assertAlmostEqual(geometries[i].EndPoint.distanceToPoint(corners[(i+1)%4]), 0)
+			self.assertAlmostEqual(geometries[4].StartPoint.distanceToPoint(corners[1]), 0)
+			self.assertAlmostEqual(geometries[4].EndPoint.distanceToPoint(App.Vector(35,25,0)), 0)
+
+	def testDragNextToRigid(self):
+		sketch = self.Doc.addObject('Sketcher::SketchObject','Sketch')
+		CreateRectangleSketch(sketch, [0, 0], [20, 10])
+		# a line from the top right corner, only its start is constrained
+		line = sketch.addGeometry(Part.LineSegment(App.Vector(20,10,0),App.Vector(30,20,0)))
+		sketch.addConstraint(Sketcher.Constraint('Coincident',line,1,0,2))
+		self.assertEqual(sketch.solve(), 0)
+		self.assertEqual(sketch.DoF, 2)
+		corners = [sketch.getPoint(i,1) for i in range(4)]
+
+		# the free end follows, the fully constrained rectangle stays
+		sketch.movePoint(line,2,App.Vector(35,25,0))
+		self.assertAlmostEqual(sketch.getPoint(line,2).distanceToPoint(App.Vector(35,25,0)), 0)
+		self.assertAlmostEqual(sketch.getPoint(line,1).distanceToPoint(App.Vector(20,10,0)), 0)
+		for i in range(4):
+			self.assertAlmostEqual(sketch.getPoint(i,1).distanceToPoint(corners[i]), 0)
+
+		# dragging the rectangle doesn't move anything
+		sketch.movePoint(0,1,App.Vector(-5,15,0))
+		self.assertAlmostEqual(sketch.getPoint(line,2).distanceToPoint(App.Vector(35,25,0)), 0)
+		for i in range(4):
+			self.assertAlmostEqual(sketch.getPoint(i,1).distanceToPoint(corners[i]), 0)
+
 	def tearDown(self):
 		#closing doc
 		FreeCAD.closeDocument("SketchSolverTest")
@@ -82,6 +82,7 @@ Cell::Cell(const CellAddress &_address, PropertySheet *_owner)
     , owner(_owner)
     , used(0)
     , expression(0)
+    , program(0)
     , alignment(ALIGNMENT_HIMPLIED | ALIGNMENT_LEFT | ALIGNMENT_VIMPLIED | ALIGNMENT_VCENTER)
     , style()
     , foregroundColor(0, 0, 0, 1)
@@ -101,6 +102,7 @@ Cell::Cell(PropertySheet *_owner, const Cell &other)
     , owner(_owner)
     , used(other.used)
     , expression(other.expression ? other.expression->copy() : 0)
+    , program(0)
     , alignment(other.alignment)
     , style(other.style)
     , foregroundColor(other.foregroundColor)
@@ -112,6 +114,7 @@ Cell::Cell(PropertySheet *_owner, const Cell &other)
     , colSpan(other.colSpan)
 {
     setUsed(MARK_SET, false);
+    compileExpression();
 }
 
 Cell &Cell::operator =(const Cell &rhs)
@@ -144,6 +147,7 @@ Cell::~Cell()
 {
     if (expression)
         delete expression;
+    delete program;
 }
 
 /**
@@ -162,6 +166,7 @@ void Cell::setExpression(App::Expression *expr)
         delete expression;
     expression = expr;
     setUsed(EXPRESSION_SET, expression != 0);
+    compileExpression();
 
     /* Update dependencies */
     owner->addDependencies(address);
@@ -179,6 +184,35 @@ const App::Expression *Cell::getExpression() const
     return expression;
 }
 
+/**
+  * Get the compiled expression, or 0 if the expression doesn't evaluate to a number.
+  *
+  */
+
+const App::ExpressionProgram *Cell::getProgram() const
+{
+    return program;
+}
+
+/**
+  * Compile the expression tree, if it is a numeric one.
+  *
+  */
+
+void Cell::compileExpression()
+{
+    delete program;
+    program = 0;
+
+    if (expression) {
+        program = new App::ExpressionProgram(expression);
+        if (!program->isValid()) {
+            delete program;
+            program = 0;
+        }
+    }
+}
+
 /**
   * Get string content.
   *
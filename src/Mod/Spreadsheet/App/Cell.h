@@ -38,6 +38,7 @@ class Writer;
 
 namespace App {
 class Expression;
+class ExpressionProgram;
 class ExpressionVisitor;
 }
 
@@ -61,6 +62,8 @@ public:
 
     const App::Expression * getExpression() const;
 
+    const App::ExpressionProgram * getProgram() const;
+
     bool getStringContent(std::string & s) const;
 
     void setContent(const char * value);
@@ -150,6 +153,8 @@ private:
 
     void setExpression(App::Expression *expr);
 
+    void compileExpression();
+
     void setUsed(int mask, bool state = true);
 
     bool isUsed(int mask) const;
@@ -179,6 +184,7 @@ private:
 
     int used;
     App::Expression * expression;
+    App::ExpressionProgram * program;
     int alignment;
     std::set<std::string> style;
     App::Color foregroundColor;
@@ -101,6 +101,8 @@ void PropertySheet::clear()
 
     propertyNameToCellMap.clear();
     documentObjectToCellMap.clear();
+    cellToDependantCellMap.clear();
+    cellToReferencedCellMap.clear();
     docDeps.clear();
     aliasProp.clear();
     revAliasProp.clear();
@@ -218,6 +220,8 @@ PropertySheet::PropertySheet(const PropertySheet &other)
     , cellToPropertyNameMap(other.cellToPropertyNameMap)
     , documentObjectToCellMap(other.documentObjectToCellMap)
     , cellToDocumentObjectMap(other.cellToDocumentObjectMap)
+    , cellToDependantCellMap(other.cellToDependantCellMap)
+    , cellToReferencedCellMap(other.cellToReferencedCellMap)
     , docDeps(other.docDeps)
     , documentObjectName(other.documentObjectName)
     , documentName(other.documentName)
@@ -985,8 +989,23 @@ void PropertySheet::addDependencies(CellAddress key)
         propertyNameToCellMap[propName].insert(key);
         cellToPropertyNameMap[key].insert(propName);
 
-        // Also an alias?
         if (docObj == owner) {
+            // A cell of this sheet?
+            if (propName == docObjName + "." + i->getPropertyName()) {
+                try {
+                    CellAddress address = stringToAddress(i->getPropertyName().c_str(), true);
+
+                    if (address.isValid()) {
+                        cellToDependantCellMap[address].insert(key);
+                        cellToReferencedCellMap[key].insert(address);
+                    }
+                }
+                catch (const Base::IndexError &) {
+                    /* Ignore this error here */
+                }
+            }
+
+            // Also an alias?
             std::map<std::string, CellAddress>::const_iterator j = revAliasProp.find(i->getPropertyName());
 
             if (j != revAliasProp.end()) {
@@ -995,6 +1014,8 @@ void PropertySheet::addDependencies(CellAddress key)
                 // Insert into maps
                 propertyNameToCellMap[propName].insert(key);
                 cellToPropertyNameMap[key].insert(propName);
+                cellToDependantCellMap[j->second].insert(key);
+                cellToReferencedCellMap[key].insert(j->second);
             }
         }
 
@@ -1056,6 +1077,29 @@ void PropertySheet::removeDependencies(CellAddress key)
 
         cellToDocumentObjectMap.erase(i2);
     }
+
+    /* Remove from Cell <-> Key maps */
+
+    std::map<CellAddress, std::set< CellAddress > >::iterator i3 = cellToReferencedCellMap.find(key);
+
+    if (i3 != cellToReferencedCellMap.end()) {
+        std::set< CellAddress >::const_iterator j = i3->second.begin();
+
+        while (j != i3->second.end()) {
+            std::map<CellAddress, std::set< CellAddress > >::iterator k = cellToDependantCellMap.find(*j);
+
+            assert(k != cellToDependantCellMap.end());
+
+            k->second.erase(key);
+
+            if (k->second.size() == 0)
+                cellToDependantCellMap.erase(k);
+
+            ++j;
+        }
+
+        cellToReferencedCellMap.erase(i3);
+    }
 }
 
 /**
@@ -1207,6 +1251,22 @@ const std::set<std::string> &PropertySheet::getDeps(CellAddress pos) const
         return empty;
 }
 
+/**
+  * Get the cells of the sheet that depend on the cell at \a pos, directly or through its alias.
+  *
+  */
+
+const std::set<CellAddress> &PropertySheet::getDependantCells(CellAddress pos) const
+{
+    static std::set<CellAddress> empty;
+    std::map<CellAddress, std::set< CellAddress > >::const_iterator i = cellToDependantCellMap.find(pos);
+
+    if (i != cellToDependantCellMap.end())
+        return i->second;
+    else
+        return empty;
+}
+
 void PropertySheet::recomputeDependencies(CellAddress key)
 {
     AtomicPropertyChange signaller(*this);
@@ -127,6 +127,8 @@ public:
 
     const std::set<std::string> &getDeps(App::CellAddress pos) const;
 
+    const std::set<App::CellAddress> &getDependantCells(App::CellAddress pos) const;
+
     const std::set<App::DocumentObject*> & getDocDeps() const { return docDeps; }
 
     void recomputeDependencies(App::CellAddress key);
@@ -211,6 +213,14 @@ private:
     /*! DocumentObject this cell depends on */
     std::map<App::CellAddress, std::set< std::string > > cellToDocumentObjectMap;
 
+    /*! Cell dependencies within the sheet, i.e when the cell given in key changes,
+      the set of addresses needs to be recomputed.
+      */
+    std::map<App::CellAddress, std::set< App::CellAddress > > cellToDependantCellMap;
+
+    /*! Cells of the sheet this cell depends on */
+    std::map<App::CellAddress, std::set< App::CellAddress > > cellToReferencedCellMap;
+
     /*! Other document objects the sheet depends on */
     std::set<App::DocumentObject*> docDeps;
 
@@ -29,7 +29,7 @@
 #include <boost/range/adaptor/map.hpp>
 #include <boost/range/algorithm/copy.hpp>
 #include <boost/assign.hpp>
-#include <boost/graph/topological_sort.hpp>
+#include <boost/graph/strong_components.hpp>
 #include <App/Application.h>
 #include <App/Document.h>
 #include <App/DynamicProperty.h>
@@ -635,6 +635,18 @@ void Sheet::updateProperty(CellAddress key)
     if (cell != 0) {
         Expression * output;
         const Expression * input = cell->getExpression();
+        const ExpressionProgram * program = cell->getProgram();
+
+        /* Numeric expressions are evaluated by their compiled program */
+        if (program) {
+            Base::Quantity value = program->eval();
+            if (value.getUnit().isEmpty())
+                setFloatProperty(key, value.getValue());
+            else
+                setQuantityProperty(key, value.getValue(), value.getUnit());
+            cellUpdated(key);
+            return;
+        }
 
         if (input) {
             output = input->eval();
@@ -766,78 +778,124 @@ DocumentObjectExecReturn *Sheet::execute(void)
          dirtyCells.insert(*i);
     }
 
-    // Push dirty cells onto queue
-    for (std::set<CellAddress>::const_iterator i = dirtyCells.begin(); i != dirtyCells.end(); ++i) {
-        // Create queue and a graph structure to compute order of evaluation
-        std::deque<CellAddress> workQueue;
-        DependencyList graph;
-        std::map<CellAddress, Vertex> VertexList;
-        std::map<Vertex, CellAddress> VertexIndexList;
+    // Create a single graph of the dirty cells and all cells that depend on them,
+    // so that each cell is recomputed once even if the dirty cells share dependants
+    DependencyList graph;
+    std::map<CellAddress, Vertex> VertexList;
+    std::vector<CellAddress> VertexIndexList;
+    std::deque<CellAddress> workQueue;
 
+    for (std::set<CellAddress>::const_iterator i = dirtyCells.begin(); i != dirtyCells.end(); ++i) {
+        VertexList[*i] = add_vertex(graph);
+        VertexIndexList.push_back(*i);
         workQueue.push_back(*i);
+    }
 
-        while (workQueue.size() > 0) {
-            CellAddress currPos = workQueue.front();
-            std::set<CellAddress> s;
-
-            // Get other cells that depends on the current cell (currPos)
-            providesTo(currPos, s);
-            workQueue.pop_front();
+    while (workQueue.size() > 0) {
+        CellAddress currPos = workQueue.front();
+        workQueue.pop_front();
 
+        // Process cells that depend on the current cell (currPos)
+        const std::set<CellAddress> & s = cells.getDependantCells(currPos);
+        std::set<CellAddress>::const_iterator i = s.begin();
+        while (i != s.end()) {
             // Insert into map of CellPos -> Index, if it doesn't exist already
-            if (VertexList.find(currPos) == VertexList.end()) {
-                VertexList[currPos] = add_vertex(graph);
-                VertexIndexList[VertexList[currPos]] = currPos;
+            std::map<CellAddress, Vertex>::const_iterator j = VertexList.find(*i);
+            if (j == VertexList.end()) {
+                j = VertexList.insert(std::make_pair(*i, add_vertex(graph))).first;
+                VertexIndexList.push_back(*i);
+                workQueue.push_back(*i);
             }
+            // Add edge to graph to signal dependency
+            add_edge(VertexList[currPos], j->second, graph);
+            ++i;
+        }
+    }
 
-            // Process cells that depend on the current cell
-            std::set<CellAddress>::const_iterator i = s.begin();
-            while (i != s.end()) {
-                // Insert into map of CellPos -> Index, if it doesn't exist already
-                if (VertexList.find(*i) == VertexList.end()) {
-                    VertexList[*i] = add_vertex(graph);
-                    VertexIndexList[VertexList[*i]] = *i;
-                    workQueue.push_back(*i);
-                }
-                // Add edge to graph to signal dependency
-                add_edge(VertexList[currPos], VertexList[*i], graph);
-                ++i;
-            }
+    // Cells of a strongly connected component with more than one cell, or that depend
+    // on themselves, are part of a cycle. These and all cells that depend on them can't
+    // be computed.
+    std::size_t numVertices = num_vertices(graph);
+    std::vector<int> component(numVertices);
+    int numComponents = boost::strong_components(graph,
+        boost::make_iterator_property_map(component.begin(), get(boost::vertex_index, graph)));
+    std::vector<int> componentSize(numComponents, 0);
+    std::vector<bool> circular(numVertices, false);
+    std::deque<Vertex> circularQueue;
+
+    for (Vertex v = 0; v < numVertices; ++v)
+        componentSize[component[v]]++;
+
+    Traits::edge_iterator ei, ei_end;
+    for (boost::tie(ei, ei_end) = edges(graph); ei != ei_end; ++ei) {
+        Vertex u = source(*ei, graph);
+        if (u == target(*ei, graph) && !circular[u]) {
+            circular[u] = true;
+            circularQueue.push_back(u);
         }
+    }
 
-        // Compute cells
-        std::list<Vertex> make_order;
+    for (Vertex v = 0; v < numVertices; ++v) {
+        if (componentSize[component[v]] > 1 && !circular[v]) {
+            circular[v] = true;
+            circularQueue.push_back(v);
+        }
+    }
 
-        // Sort graph topologically to find evaluation order
-        try {
-            boost::topological_sort(graph, std::front_inserter(make_order));
+    while (circularQueue.size() > 0) {
+        Vertex u = circularQueue.front();
+        circularQueue.pop_front();
 
-            // Recompute cells
-            std::list<Vertex>::const_iterator i = make_order.begin();
-            while (i != make_order.end()) {
-                recomputeCell(VertexIndexList[*i]);
-                ++i;
+        Traits::adjacency_iterator ai, ai_end;
+        for (boost::tie(ai, ai_end) = adjacent_vertices(u, graph); ai != ai_end; ++ai) {
+            if (!circular[*ai]) {
+                circular[*ai] = true;
+                circularQueue.push_back(*ai);
             }
         }
-        catch (std::exception&) {
-            // Cycle detected; flag all with errors
+    }
 
-            std::map<CellAddress, Vertex>::const_iterator i = VertexList.begin();
-            while (i != VertexList.end()) {
-                Cell * cell = cells.getValue(i->first);
+    // Recompute the other cells in topological order; a cell is ready when all cells
+    // of the graph it depends on are computed
+    std::vector<int> inDegree(numVertices, 0);
+    std::deque<Vertex> readyQueue;
 
-                // Mark as erroneous
-                cellErrors.insert(i->first);
+    for (boost::tie(ei, ei_end) = edges(graph); ei != ei_end; ++ei)
+        inDegree[target(*ei, graph)]++;
 
-                if (cell)
-                    cell->setException("Circular dependency.");
-                updateProperty(i->first);
-                updateAlias(i->first);
+    for (Vertex v = 0; v < numVertices; ++v) {
+        if (inDegree[v] == 0 && !circular[v])
+            readyQueue.push_back(v);
+    }
 
-                ++i;
-            }
+    while (readyQueue.size() > 0) {
+        Vertex u = readyQueue.front();
+        readyQueue.pop_front();
+
+        recomputeCell(VertexIndexList[u]);
+
+        Traits::adjacency_iterator ai, ai_end;
+        for (boost::tie(ai, ai_end) = adjacent_vertices(u, graph); ai != ai_end; ++ai) {
+            if (--inDegree[*ai] == 0)
+                readyQueue.push_back(*ai);
         }
+    }
+
+    // Flag cells of cycles and their dependants with errors
+    for (Vertex v = 0; v < numVertices; ++v) {
+        if (!circular[v])
+            continue;
 
+        CellAddress p = VertexIndexList[v];
+        Cell * cell = cells.getValue(p);
+
+        // Mark as erroneous
+        cellErrors.insert(p);
+
+        if (cell)
+            cell->setException("Circular dependency.");
+        updateProperty(p);
+        updateAlias(p);
     }
 
     // Signal update of column widths
@@ -1284,10 +1342,7 @@ void Sheet::providesTo(CellAddress address, std::set<std::string> & result) cons
 
 void Sheet::providesTo(CellAddress address, std::set<CellAddress> & result) const
 {
-    const char * docName = getDocument()->Label.getValue();
-    const char * docObjName = getNameInDocument();
-    std::string fullName = std::string(docName) + "#" + std::string(docObjName) + "." + address.toString();
-    result = cells.getDeps(fullName);
+    result = cells.getDependantCells(address);
 }
 
 void Sheet::onDocumentRestored()
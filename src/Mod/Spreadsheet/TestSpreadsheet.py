@@ -15,6 +15,16 @@ from FreeCAD import Units
 
 v = Base.Vector
 
+class CellUpdateCounter:
+    """ Document observer counting how often the property of each cell of a sheet is set """
+    def __init__(self, sheet):
+        self.name = sheet.Name
+        self.counts = {}
+
+    def slotChangedObject(self, obj, prop):
+        if obj.Name == self.name:
+            self.counts[prop] = self.counts.get(prop, 0) + 1
+
 #----------------------------------------------------------------------------------
 # define the functions to test the FreeCAD Spreadsheet module and expression engine
 #----------------------------------------------------------------------------------
@@ -861,6 +871,200 @@ class SpreadsheetCases(unittest.TestCase):
         self.assertEqual(sheet.get('C1'), Units.Quantity('3 mm'))
 
 
+    def assertCompiledEqualsTree(self, sheet, expressions):
+        """ Evaluate the expressions compiled in column A and as tree in column B and compare the results """
+        sheet.set('Z1', '0')
+        for i, expr in enumerate(expressions, 1):
+            sheet.set('A{}'.format(i), '=' + expr)
+            # a variable as result of a conditional can't be compiled
+            sheet.set('B{}'.format(i), '=1 ? ({}) : Z1'.format(expr))
+        self.doc.recompute()
+        for i, expr in enumerate(expressions, 1):
+            self.assertEqual(sheet.get('A{}'.format(i)), sheet.get('B{}'.format(i)), expr)
+
+    def testCompiledUnits(self):
+        """ Compiled expressions -- units give the same results as the expression tree """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        sheet.set('C1', '3mm')
+        sheet.set('C2', '2')
+        self.assertCompiledEqualsTree(sheet, ['2mm + 3mm', '2mm * 3mm', '(4mm)^2', '9.8 m/s^2',
+                                              '1 m + 2 mm', 'C1 * C2 + 1 mm', 'C1 / C2 / 1 s',
+                                              'sqrt(C1 * C1)', 'mod(7kg;C1)', '2mm + 3',
+                                              '(2mm)^C1'])
+        self.assertEqual(sheet.A7, Units.Quantity('1.5 mm/s'))
+        self.assertEqual(sheet.A10, u'ERR: Incompatible units for + operator')
+
+    def testCompiledComparisons(self):
+        """ Compiled expressions -- relational operators give the same results as the expression tree """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        sheet.set('C1', '3mm')
+        self.assertCompiledEqualsTree(sheet, ['1 == 1', '1 != 1', '2 > 1', '1 < 1', '1 >= 1.000000000000001',
+                                              '1 <= 1.0000000000000001', 'C1 == 3mm', 'C1 > 1 m', 'C1 < 2'])
+        self.assertEqual(sheet.A1, 1)
+        self.assertEqual(sheet.A8, 0)
+
+    def testCompiledConditionals(self):
+        """ Compiled expressions -- conditionals give the same results as the expression tree """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        sheet.set('C1', '1')
+        sheet.set('C2', '2mm')
+        self.assertCompiledEqualsTree(sheet, ['C1 == 1 ? 11 : (C1 == 2 ? 12 : 13)',
+                                              'C1 == 1 ? (C1 == 2 ? 12 : 13) : 11',
+                                              'C1 < 2 ? C2 * 2 : C2',
+                                              '(C1 > 0 ? 1mm : 2mm) + C2',
+                                              'C2 ? 1 : 0',
+                                              'C1 == 1 ? 1 : 1mm + 1'])
+        self.assertEqual(sheet.A3, Units.Quantity('4 mm'))
+        sheet.set('C1', '2')
+        self.doc.recompute()
+        for i in range(1, 7):
+            self.assertEqual(sheet.get('A{}'.format(i)), sheet.get('B{}'.format(i)))
+        self.assertEqual(sheet.A1, 12)
+        self.assertEqual(sheet.A6, u'ERR: Incompatible units for + operator')
+
+    def testCompiledAggregates(self):
+        """ Compiled expressions -- aggregates over ranges give the same results as the expression tree """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        sheet.set('C13', '4')
+        sheet.set('C14', '5')
+        sheet.set('C15', '6')
+        sheet.set('D13', '4mm')
+        sheet.set('D14', '5mm')
+        sheet.set('D15', '6mm')
+        sheet.set('D16', '6')
+        self.assertCompiledEqualsTree(sheet, ['sum(1;2;3;C13:C15)', 'min(1;2;3;C13:C15)', 'max(C13:C15) * 2',
+                                              'average(C13:C15)', 'stddev(C13:C15)', 'count(C13:D16)',
+                                              'sum(D13:D15)', 'max(D13:D15;3mm)', 'sum(D13:D16)',
+                                              'sum(C13:C15) + sum(C13:C14; 1)', 'stddev(1)'])
+        self.assertEqual(sheet.A1, 21)
+        self.assertEqual(sheet.A7, Units.Quantity('15 mm'))
+        self.assertEqual(sheet.A9, u'ERR: Quantity::operator +=(): Unit mismatch in plus operation')
+
+    def testCompiledStringVariables(self):
+        """ Compiled expressions -- string valued variables can't be used in operators """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        sheet.set('C1', 'abc')
+        sheet.set('C2', '1')
+        self.assertCompiledEqualsTree(sheet, ['C1 + 1', '1 * C1', 'C1 == C1', 'C1 ? 1 : 0', 'C2 == 1 ? C1 + 1 : 0',
+                                              'C2 == 1 ? 0 : C1 + 1'])
+        for cell in ['A1', 'A2', 'A3', 'A4', 'A5']:
+            self.assertEqual(sheet.get(cell), u'ERR: Invalid expression', cell)
+        self.assertEqual(sheet.A6, 0)
+
+    def testCompiledRename(self):
+        """ Compiled expressions -- renamed objects and aliases are still resolved """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        box = self.doc.addObject('Part::Box', 'Box')
+        box.Length = 10
+        sheet.set('C1', '2')
+        sheet.setAlias('C1', 'alias1')
+        self.assertCompiledEqualsTree(sheet, ['Box.Length * alias1', 'Box.Length + alias1 * 1mm'])
+        self.assertEqual(sheet.A1, Units.Quantity('20 mm'))
+
+        box2 = self.doc.addObject('Part::Box', 'Box001')
+        box2.setExpression('Height', 'Spreadsheet.A1 / 4')
+        self.doc.recompute()
+        self.assertEqual(box2.Height, Units.Quantity('5 mm'))
+
+        box.Label = 'Cube'
+        sheet.setAlias('C1', 'alias2')
+        sheet.Label = 'Params'
+        self.assertEqual(sheet.getContents('A1'), '=Cube.Length * alias2')
+        self.assertEqual(box2.ExpressionEngine[0][1], 'Params.A1 / 4')
+
+        box.Length = 20
+        sheet.set('C1', '3')
+        self.doc.recompute()
+        self.assertEqual(sheet.A1, Units.Quantity('60 mm'))
+        self.assertEqual(sheet.A1, sheet.B1)
+        self.assertEqual(sheet.A2, Units.Quantity('23 mm'))
+        self.assertEqual(sheet.A2, sheet.B2)
+        self.assertEqual(box2.Height, Units.Quantity('15 mm'))
+
+    def recomputeCounted(self, sheet):
+        """ Recompute the document and return how often each cell of the sheet was updated """
+        counter = CellUpdateCounter(sheet)
+        FreeCAD.addDocumentObserver(counter)
+        try:
+            self.doc.recompute()
+        finally:
+            FreeCAD.removeDocumentObserver(counter)
+        return counter.counts
+
+    def testRecomputeDiamond(self):
+        """ Cells depending on a dirty cell along several paths are recomputed once """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        sheet.set('A1', '1')
+        sheet.set('B1', '=A1 + 1')
+        sheet.set('C1', '=A1 * 2')
+        sheet.set('D1', '=B1 + C1')
+        self.doc.recompute()
+        self.assertEqual(sheet.D1, 4)
+
+        sheet.set('A1', '2')
+        counts = self.recomputeCounted(sheet)
+        self.assertEqual(sheet.D1, 7)
+        for cell in ['A1', 'B1', 'C1', 'D1']:
+            self.assertEqual(counts.get(cell), 1, cell)
+
+        # dirty cells sharing their dependants
+        sheet.set('A1', '3')
+        sheet.set('C1', '=A1 * 3')
+        counts = self.recomputeCounted(sheet)
+        self.assertEqual(sheet.D1, 13)
+        for cell in ['A1', 'B1', 'C1', 'D1']:
+            self.assertEqual(counts.get(cell), 1, cell)
+
+    def testRecomputeCycle(self):
+        """ A cycle doesn't prevent unrelated dirty cells from being recomputed """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        sheet.set('A1', '=B1 + 1')
+        sheet.set('B1', '=A1 + 1')
+        sheet.set('C1', '=2 * 3')
+        sheet.set('D1', '=C1 + 1')
+        self.doc.recompute()
+        self.assertIn('Invalid', sheet.State)
+        self.assertEqual(sheet.C1, 6)
+        self.assertEqual(sheet.D1, 7)
+
+        sheet.set('C1', '=3 * 3')
+        counts = self.recomputeCounted(sheet)
+        self.assertIn('Invalid', sheet.State)
+        self.assertEqual(sheet.C1, 9)
+        self.assertEqual(sheet.D1, 10)
+        self.assertEqual(counts.get('C1'), 1)
+        self.assertEqual(counts.get('D1'), 1)
+
+        sheet.set('B1', '5')
+        self.doc.recompute()
+        self.assertNotIn('Invalid', sheet.State)
+        self.assertEqual(sheet.A1, 6)
+
+    def testRecomputeAlias(self):
+        """ Cells referencing a dirty cell through its alias are recomputed once """
+        sheet = self.doc.addObject('Spreadsheet::Sheet','Spreadsheet')
+        sheet.set('A1', '2mm')
+        sheet.setAlias('A1', 'width')
+        sheet.set('B1', '=width * 2')
+        sheet.set('C1', '=B1 + width')
+        self.doc.recompute()
+        self.assertEqual(sheet.C1, Units.Quantity('6 mm'))
+
+        sheet.set('A1', '3mm')
+        counts = self.recomputeCounted(sheet)
+        self.assertEqual(sheet.B1, Units.Quantity('6 mm'))
+        self.assertEqual(sheet.C1, Units.Quantity('9 mm'))
+        self.assertEqual(counts.get('B1'), 1)
+        self.assertEqual(counts.get('C1'), 1)
+
+        sheet.setAlias('A1', 'height')
+        sheet.set('A1', '4mm')
+        counts = self.recomputeCounted(sheet)
+        self.assertEqual(sheet.getContents('C1'), '=B1 + height')
+        self.assertEqual(sheet.C1, Units.Quantity('12 mm'))
+        self.assertEqual(counts.get('B1'), 1)
+        self.assertEqual(counts.get('C1'), 1)
+
     def tearDown(self):
         #closing doc
         FreeCAD.closeDocument(self.doc.Name)
@@ -540,6 +540,90 @@ class DocumentRecomputeCases(unittest.TestCase):
     #closing doc
     FreeCAD.closeDocument("RecomputeTests")
 
+class PartialLoadFeature():
+  def __init__(self, obj):
+    obj.addProperty("App::PropertyLink","Source")
+    obj.addProperty("App::PropertyInteger","ExecCount")
+    obj.Proxy = self
+
+  def execute(self, obj):
+    obj.ExecCount = obj.ExecCount + 1
+
+  def canLoadPartial(self, obj):
+    # create the linked objects without restoring them
+    return 1
+
+  def __getstate__(self):
+    return None
+
+  def __setstate__(self, state):
+    return None
+
+class PartialLoadObserver():
+  def __init__(self):
+    self.Created = []
+
+  def slotCreatedDocument(self, doc):
+    self.Created.append(doc.Name)
+
+class DocumentPartialLoadCases(unittest.TestCase):
+  def setUp(self):
+    self.TempPath = tempfile.gettempdir()
+    Doc = FreeCAD.newDocument("PartialA")
+    Deferred = Doc.addObject("App::FeatureTest","Deferred")
+    Holder = Doc.addObject("App::FeaturePython","Holder")
+    PartialLoadFeature(Holder)
+    Holder.Source = Deferred
+    Doc.recompute()
+    Doc.saveAs(self.TempPath + os.sep + "PartialA.FCStd")
+    # PartialB only needs the holder, PartialC the deferred object
+    DocB = FreeCAD.newDocument("PartialB")
+    DocB.addObject("App::Link","Link").LinkedObject = Holder
+    DocB.saveAs(self.TempPath + os.sep + "PartialB.FCStd")
+    DocC = FreeCAD.newDocument("PartialC")
+    DocC.addObject("App::Link","Link").LinkedObject = Deferred
+    DocC.saveAs(self.TempPath + os.sep + "PartialC.FCStd")
+    for name in ("PartialC","PartialB","PartialA"):
+      FreeCAD.closeDocument(name)
+
+  def testLoadDeferred(self):
+    DocB = FreeCAD.openDocument(self.TempPath + os.sep + "PartialB.FCStd")
+    Doc = FreeCAD.getDocument("PartialA")
+    self.failUnless(Doc.Partial)
+    self.failUnless("Partial" in Doc.Deferred.State)
+    self.failUnless(DocB.Link.LinkedObject == Doc.Holder)
+
+    # the holder depends on a deferred object and must be skipped
+    count = Doc.Holder.ExecCount
+    Doc.Holder.touch()
+    Doc.recompute()
+    self.failUnless(Doc.Holder.ExecCount == count)
+
+    # linking to the deferred object reopens PartialA once to load it
+    observer = PartialLoadObserver()
+    FreeCAD.addDocumentObserver(observer)
+    DocC = FreeCAD.openDocument(self.TempPath + os.sep + "PartialC.FCStd")
+    FreeCAD.removeDocumentObserver(observer)
+    self.failUnless(observer.Created.count("PartialA") == 1)
+    Doc = FreeCAD.getDocument("PartialA")
+    self.failIf(Doc.Partial)
+    self.failIf("Partial" in Doc.Deferred.State)
+    self.failUnless(DocB.Link.LinkedObject == Doc.Holder)
+    self.failUnless(DocC.Link.LinkedObject == Doc.Deferred)
+
+    # the loaded object and its dependent are recomputed exactly once
+    count = Doc.Deferred.ExecCount
+    countHolder = Doc.Holder.ExecCount
+    Doc.Deferred.touch()
+    Doc.recompute()
+    self.failUnless(Doc.Deferred.ExecCount == count + 1)
+    self.failUnless(Doc.Holder.ExecCount == countHolder + 1)
+
+  def tearDown(self):
+    for name in ("PartialC","PartialB","PartialA"):
+      if name in FreeCAD.listDocuments():
+        FreeCAD.closeDocument(name)
+
 class UndoRedoCases(unittest.TestCase):
   def setUp(self):
     self.Doc = FreeCAD.newDocument("UndoTest")
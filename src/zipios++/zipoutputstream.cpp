@@ -56,6 +56,12 @@ void ZipOutputStream::putNextEntry(const std::string& entryName) {
 }
 
 
+void ZipOutputStream::putDeflatedEntry( const std::string &entryName, const char *data,
+                                        uint32 compressed_size, uint32 size, uint32 crc ) {
+  ozf->putDeflatedEntry( ZipCDirEntry( entryName ), data, compressed_size, size, crc ) ;
+}
+
+
 void ZipOutputStream::setComment( const std::string &comment ) {
   ozf->setComment( comment ) ;
 }
@@ -71,6 +77,16 @@ void ZipOutputStream::setMethod( StorageMethod method ) {
 }
 
 
+int ZipOutputStream::getLevel() const {
+  return ozf->getLevel() ;
+}
+
+
+StorageMethod ZipOutputStream::getMethod() const {
+  return ozf->getMethod() ;
+}
+
+
 ZipOutputStream::~ZipOutputStream() {
   // It's ok to call delete with a Null pointer.
   delete ozf ;
@@ -54,6 +54,11 @@ public:
   */
   void putNextEntry(const std::string& entryName);
 
+  /** Writes a complete entry whose data has already been compressed
+      with raw deflate. See ZipOutputStreambuf::putDeflatedEntry(). */
+  void putDeflatedEntry( const std::string &entryName, const char *data,
+                         uint32 compressed_size, uint32 size, uint32 crc ) ;
+
   /** Sets the global comment for the Zip archive. */
   void setComment( const std::string& comment ) ;
 
@@ -64,6 +69,12 @@ public:
       supported. */
   void setMethod( StorageMethod method ) ;
 
+  /** Returns the compression level used for subsequent entries. */
+  int getLevel() const ;
+
+  /** Returns the compression method used for subsequent entries. */
+  StorageMethod getMethod() const ;
+
   /** Destructor. */
   virtual ~ZipOutputStream() ;
 
@@ -49,6 +49,16 @@ public:
       entry. */
   void putNextEntry( const ZipCDirEntry &entry ) ;
 
+  /** Writes a complete entry whose data has already been compressed
+      with raw deflate, i.e. a zlib stream without header as produced
+      with negative window bits.
+      @param data the compressed data.
+      @param compressed_size the number of bytes of the compressed data.
+      @param size the size of the uncompressed data.
+      @param crc the CRC32 of the uncompressed data. */
+  void putDeflatedEntry( const ZipCDirEntry &entry, const char *data,
+                         uint32 compressed_size, uint32 size, uint32 crc ) ;
+
   /** Sets the global comment for the Zip archive. */
   void setComment( const string &comment ) ;
 
@@ -59,6 +69,12 @@ public:
       supported. */
   void setMethod( StorageMethod method ) ;
 
+  /** Returns the compression level used for subsequent entries. */
+  int getLevel() const { return _level ; }
+
+  /** Returns the compression method used for subsequent entries. */
+  StorageMethod getMethod() const { return _method ; }
+
   /** Destructor. */
   virtual ~ZipOutputStreambuf() ;
 
@@ -68,6 +84,7 @@ protected:
 
   void setEntryClosedState() ;
   void updateEntryHeaderInfo() ;
+  static int currentDosTime() ;
 
   // Should/could be moved to zipheadio.h ?!
   static void writeCentralDirectory( const vector< ZipCDirEntry > &entries, 